@@ -13,6 +13,8 @@
 #include <AnKi/Collision/ConvexHullShape.h>
 #include <AnKi/Collision/Ray.h>
 #include <AnKi/Collision/Cone.h>
+#include <AnKi/Collision/Bvh.h>
+#include <AnKi/Collision/MortonCode.h>
 
 #include <AnKi/Collision/Functions.h>
 
@@ -0,0 +1,683 @@
+// Copyright (C) 2009-2022, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <AnKi/Collision/Bvh.h>
+#include <AnKi/Collision/MortonCode.h>
+#include <AnKi/Util/ThreadHive.h>
+#include <AnKi/Util/RadixSort.h>
+#include <AnKi/Util/Tracer.h>
+#include <algorithm>
+
+namespace anki {
+
+/// Primitive ranges bigger than that will be built in a different ThreadHive task.
+constexpr U32 kParallelBuildThreshold = 2 * 1024;
+
+/// After that depth the build will stop using SAH and it will split at the median to keep the tree depth bounded.
+constexpr U32 kMaxSahDepth = Bvh::kMaxDepth / 2;
+
+static F32 computeHalfArea(const Vec3& aabbMin, const Vec3& aabbMax)
+{
+	const Vec3 e = (aabbMax - aabbMin).max(0.0f);
+	return e.x() * e.y() + e.y() * e.z() + e.z() * e.x();
+}
+
+class Bvh::BuildContext
+{
+public:
+	ConstWeakArray<BvhPrimitive> m_primitives;
+	WeakArray<Vec3> m_centroids;
+	Atomic<U32> m_nodeCount = {0};
+};
+
+class Bvh::BuildTask
+{
+public:
+	Bvh* m_bvh = nullptr;
+	BuildContext* m_ctx = nullptr;
+	U32 m_nodeIdx = 0;
+	U32 m_begin = 0;
+	U32 m_end = 0;
+	U32 m_depth = 0;
+};
+
+/// Holds the binary radix tree of the LBVH build. See "Maximizing Parallelism in the Construction of BVHs, Octrees, and
+/// k-d Trees" by Tero Karras.
+class Bvh::LinearBuildContext
+{
+public:
+	ConstWeakArray<U32> m_codes; ///< Sorted Morton codes.
+
+	/// The children of every inner node. If kLeafBit is set it's a single primitive else it's another inner node.
+	WeakArray<Array<U32, 2>> m_children;
+
+	/// The range of sorted primitives each inner node covers.
+	WeakArray<Array<U32, 2>> m_ranges;
+
+	U32 m_chunkSize = 0;
+	Atomic<U32> m_nextChunk = {0};
+
+	/// The length of the common prefix of two keys. Equal codes are disambiguated by their position.
+	I32 delta(I32 i, I32 j) const
+	{
+		if(j < 0 || j >= I32(m_codes.getSize()))
+		{
+			return -1;
+		}
+
+		const U32 a = m_codes[i];
+		const U32 b = m_codes[j];
+		return (a != b) ? I32(__builtin_clz(a ^ b)) : I32(32 + __builtin_clz(U32(i) ^ U32(j)));
+	}
+
+	void buildInnerNode(I32 i)
+	{
+		// Find the direction of the range
+		const I32 d = (delta(i, i + 1) - delta(i, i - 1) >= 0) ? 1 : -1;
+
+		// Find the other end of the range using binary search
+		const I32 deltaMin = delta(i, i - d);
+		I32 lmax = 2;
+		while(delta(i, i + lmax * d) > deltaMin)
+		{
+			lmax *= 2;
+		}
+
+		I32 l = 0;
+		for(I32 t = lmax / 2; t >= 1; t /= 2)
+		{
+			if(delta(i, i + (l + t) * d) > deltaMin)
+			{
+				l += t;
+			}
+		}
+		const I32 j = i + l * d;
+
+		// Find the split position using binary search
+		const I32 deltaNode = delta(i, j);
+		I32 s = 0;
+		for(I32 div = 2;; div *= 2)
+		{
+			const I32 t = (l + div - 1) / div;
+			if(delta(i, i + (s + t) * d) > deltaNode)
+			{
+				s += t;
+			}
+
+			if(t <= 1)
+			{
+				break;
+			}
+		}
+		const I32 split = i + s * d + min(d, 0);
+
+		const U32 first = U32(min(i, j));
+		const U32 last = U32(max(i, j));
+		m_ranges[i] = {first, last};
+		m_children[i][0] = (first == U32(split)) ? (kLeafBit | U32(split)) : U32(split);
+		m_children[i][1] = (last == U32(split + 1)) ? (kLeafBit | U32(split + 1)) : U32(split + 1);
+	}
+
+	static void buildInnerNodesTaskCallback(void* ud, [[maybe_unused]] U32 threadId, [[maybe_unused]] ThreadHive& hive,
+											[[maybe_unused]] ThreadHiveSemaphore* sem)
+	{
+		LinearBuildContext& ctx = *static_cast<LinearBuildContext*>(ud);
+		const U32 begin = ctx.m_nextChunk.fetchAdd(1) * ctx.m_chunkSize;
+		const U32 end = min(begin + ctx.m_chunkSize, ctx.m_children.getSize());
+		for(U32 i = begin; i < end; ++i)
+		{
+			ctx.buildInnerNode(I32(i));
+		}
+	}
+};
+
+void Bvh::destroy()
+{
+	m_nodes.destroy(*m_pool);
+	m_primitiveIndices.destroy(*m_pool);
+	m_refitScratch.destroy(*m_pool);
+}
+
+void Bvh::setQuantizationBounds(const Vec3& aabbMin, const Vec3& aabbMax)
+{
+	// Pad the bounds a bit to keep the quantization conservative
+	const Vec3 pad = (aabbMax - aabbMin) * 1.0e-4f + kEpsilonf;
+	m_aabbMin = aabbMin - pad;
+	m_aabbMax = aabbMax + pad;
+
+	const Vec3 extend = m_aabbMax - m_aabbMin;
+	m_quantizationScale = F32(kMaxU16) / extend;
+	m_dequantizationScale = extend / F32(kMaxU16);
+}
+
+void Bvh::quantize(const Vec3& aabbMin, const Vec3& aabbMax, BvhNode& node, U32 child) const
+{
+	const Vec3 qmin = (aabbMin - m_aabbMin) * m_quantizationScale;
+	const Vec3 qmax = (aabbMax - m_aabbMin) * m_quantizationScale;
+
+	for(U32 i = 0; i < 3; ++i)
+	{
+		// Round down the min and up the max. Also make sure that the box is never degenerate
+		const U32 mn = U32(clamp(std::floor(qmin[i]), 0.0f, F32(kMaxU16 - 1)));
+		const U32 mx = U32(clamp(std::ceil(qmax[i]), F32(mn + 1), F32(kMaxU16)));
+		node.m_childAabbMins[child][i] = U16(mn);
+		node.m_childAabbMaxs[child][i] = U16(mx);
+	}
+}
+
+void Bvh::computeTrianglePrimitives(ConstWeakArray<Vec3> positions, ConstWeakArray<U32> indices,
+									WeakArray<BvhPrimitive> primitives)
+{
+	ANKI_ASSERT((indices.getSize() % 3) == 0 && primitives.getSize() == indices.getSize() / 3);
+
+	for(U32 i = 0; i < primitives.getSize(); ++i)
+	{
+		const Vec3& a = positions[indices[i * 3 + 0]];
+		const Vec3& b = positions[indices[i * 3 + 1]];
+		const Vec3& c = positions[indices[i * 3 + 2]];
+		primitives[i].m_aabbMin = a.min(b).min(c);
+		primitives[i].m_aabbMax = a.max(b).max(c);
+	}
+}
+
+void Bvh::build(ConstWeakArray<BvhPrimitive> primitives, ThreadHive* hive)
+{
+	ANKI_TRACE_SCOPED_EVENT(COLLISION_BVH_BUILD);
+
+	destroy();
+
+	const U32 primitiveCount = primitives.getSize();
+	if(primitiveCount == 0)
+	{
+		return;
+	}
+
+	ANKI_ASSERT(primitiveCount <= kLeafOffsetMask);
+
+	// Compute the centroids and the bounds
+	BuildContext ctx;
+	ctx.m_primitives = primitives;
+	ctx.m_centroids = WeakArray<Vec3>(newArray<Vec3>(*m_pool, primitiveCount), primitiveCount);
+
+	Vec3 aabbMin(kMaxF32);
+	Vec3 aabbMax(kMinF32);
+	for(U32 i = 0; i < primitiveCount; ++i)
+	{
+		const BvhPrimitive& prim = primitives[i];
+		ANKI_ASSERT(prim.m_aabbMin <= prim.m_aabbMax);
+		ctx.m_centroids[i] = (prim.m_aabbMin + prim.m_aabbMax) * 0.5f;
+		aabbMin = aabbMin.min(prim.m_aabbMin);
+		aabbMax = aabbMax.max(prim.m_aabbMax);
+	}
+
+	setQuantizationBounds(aabbMin, aabbMax);
+
+	m_primitiveIndices.create(*m_pool, primitiveCount);
+	for(U32 i = 0; i < primitiveCount; ++i)
+	{
+		m_primitiveIndices[i] = i;
+	}
+
+	// A binary tree with N leafs has N-1 inner nodes. Every leaf has at least one primitive so that's an upper bound
+	m_nodes.create(*m_pool, max(primitiveCount, 2u));
+	ctx.m_nodeCount.setNonAtomically(1);
+
+	// Build
+	if(primitiveCount <= kMaxPrimitivesPerLeaf)
+	{
+		BvhNode& root = m_nodes[0];
+		quantize(aabbMin, aabbMax, root, 0);
+		root.m_children[0] = encodeLeaf(0, primitiveCount);
+		quantize(aabbMin, aabbMax, root, 1);
+		root.m_children[1] = kEmptyChild;
+	}
+	else if(hive && primitiveCount > kParallelBuildThreshold)
+	{
+		buildRecursive(ctx, 0, 0, primitiveCount, 0, hive);
+		hive->waitAllTasks();
+	}
+	else
+	{
+		buildRecursive(ctx, 0, 0, primitiveCount, 0, nullptr);
+	}
+
+	// Shrink
+	m_nodes.resize(*m_pool, ctx.m_nodeCount.load());
+	deleteArray(*m_pool, ctx.m_centroids.getBegin(), primitiveCount);
+}
+
+void Bvh::buildFromTriangles(ConstWeakArray<Vec3> positions, ConstWeakArray<U32> indices, ThreadHive* hive)
+{
+	const U32 triangleCount = indices.getSize() / 3;
+	DynamicArrayRaii<BvhPrimitive> primitives(m_pool, triangleCount);
+	computeTrianglePrimitives(positions, indices, WeakArray<BvhPrimitive>(primitives));
+	build(primitives, hive);
+}
+
+void Bvh::buildLinear(ConstWeakArray<BvhPrimitive> primitives, ThreadHive* hive)
+{
+	ANKI_TRACE_SCOPED_EVENT(COLLISION_BVH_BUILD);
+
+	destroy();
+
+	const U32 primitiveCount = primitives.getSize();
+	if(primitiveCount == 0)
+	{
+		return;
+	}
+
+	ANKI_ASSERT(primitiveCount <= kLeafOffsetMask);
+
+	// Compute the centroids and their bounds
+	DynamicArrayRaii<Vec3> centroids(m_pool, primitiveCount);
+	Vec3 centroidMin(kMaxF32);
+	Vec3 centroidMax(kMinF32);
+	for(U32 i = 0; i < primitiveCount; ++i)
+	{
+		const BvhPrimitive& prim = primitives[i];
+		ANKI_ASSERT(prim.m_aabbMin <= prim.m_aabbMax);
+		centroids[i] = (prim.m_aabbMin + prim.m_aabbMax) * 0.5f;
+		centroidMin = centroidMin.min(centroids[i]);
+		centroidMax = centroidMax.max(centroids[i]);
+	}
+
+	// Sort the primitives using the Morton codes of the centroids
+	DynamicArrayRaii<U32> codes(m_pool, primitiveCount);
+	computeMortonCodes30(centroids, centroidMin, centroidMax, WeakArray<U32>(codes));
+
+	m_primitiveIndices.create(*m_pool, primitiveCount);
+	for(U32 i = 0; i < primitiveCount; ++i)
+	{
+		m_primitiveIndices[i] = i;
+	}
+
+	{
+		DynamicArrayRaii<U32> tmpCodes(m_pool, primitiveCount);
+		DynamicArrayRaii<U32> tmpIndices(m_pool, primitiveCount);
+		radixSort(WeakArray<U32>(codes), WeakArray<U32>(m_primitiveIndices), WeakArray<U32>(tmpCodes),
+				  WeakArray<U32>(tmpIndices), hive, 30);
+	}
+
+	if(primitiveCount <= kMaxPrimitivesPerLeaf)
+	{
+		m_nodes.create(*m_pool, 1);
+		m_nodes[0].m_children[0] = encodeLeaf(0, primitiveCount);
+		m_nodes[0].m_children[1] = kEmptyChild;
+	}
+	else
+	{
+		// Build the binary radix tree. Every inner node can be built independently
+		const U32 innerNodeCount = primitiveCount - 1;
+		DynamicArrayRaii<Array<U32, 2>> children(m_pool, innerNodeCount);
+		DynamicArrayRaii<Array<U32, 2>> ranges(m_pool, innerNodeCount);
+
+		LinearBuildContext ctx;
+		ctx.m_codes = codes;
+		ctx.m_children = WeakArray<Array<U32, 2>>(children);
+		ctx.m_ranges = WeakArray<Array<U32, 2>>(ranges);
+
+		if(hive && primitiveCount > kParallelBuildThreshold)
+		{
+			const U32 taskCount = hive->getThreadCount();
+			ctx.m_chunkSize = (innerNodeCount + taskCount - 1) / taskCount;
+			for(U32 i = 0; i < taskCount; ++i)
+			{
+				hive->submitTask(LinearBuildContext::buildInnerNodesTaskCallback, &ctx);
+			}
+			hive->waitAllTasks();
+		}
+		else
+		{
+			for(U32 i = 0; i < innerNodeCount; ++i)
+			{
+				ctx.buildInnerNode(I32(i));
+			}
+		}
+
+		// Flatten the radix tree depth first so the children have bigger indices than their parents. Also collapse the
+		// small subtrees to leafs. Every level of the radix tree has a longer common prefix than its parent so the
+		// depth is bounded by the 30 bits of the codes plus the bits needed to disambiguate equal codes
+		class StackEntry
+		{
+		public:
+			U32 m_innerNode;
+			U32 m_node;
+			U32 m_depth;
+		};
+
+		DynamicArrayRaii<StackEntry> stack(m_pool);
+		stack.emplaceBack(StackEntry{0, 0, 0});
+
+		m_nodes.create(*m_pool, innerNodeCount);
+		U32 nodeCount = 1;
+		while(stack.getSize())
+		{
+			const StackEntry entry = stack.getBack();
+			stack.popBack();
+
+			for(U32 c = 0; c < 2; ++c)
+			{
+				const U32 innerChild = children[entry.m_innerNode][c];
+				const U32 first = (innerChild & kLeafBit) ? (innerChild & ~kLeafBit) : ranges[innerChild][0];
+				const U32 last = (innerChild & kLeafBit) ? (innerChild & ~kLeafBit) : ranges[innerChild][1];
+				const U32 count = last - first + 1;
+
+				if(count <= kMaxPrimitivesPerLeaf)
+				{
+					m_nodes[entry.m_node].m_children[c] = encodeLeaf(first, count);
+				}
+				else
+				{
+					ANKI_ASSERT(entry.m_depth + 1 < kMaxDepth);
+					const U32 nodeIdx = nodeCount++;
+					m_nodes[entry.m_node].m_children[c] = nodeIdx;
+					stack.emplaceBack(StackEntry{innerChild, nodeIdx, entry.m_depth + 1});
+				}
+			}
+		}
+
+		m_nodes.resize(*m_pool, nodeCount);
+	}
+
+	// The bounds are computed bottom-up
+	refit(primitives);
+}
+
+void Bvh::buildTaskCallback(void* ud, [[maybe_unused]] U32 threadId, ThreadHive& hive,
+							[[maybe_unused]] ThreadHiveSemaphore* sem)
+{
+	BuildTask& task = *static_cast<BuildTask*>(ud);
+	task.m_bvh->buildRecursive(*task.m_ctx, task.m_nodeIdx, task.m_begin, task.m_end, task.m_depth, &hive);
+}
+
+void Bvh::buildRecursive(BuildContext& ctx, U32 nodeIdx, U32 begin, U32 end, U32 depth, ThreadHive* hive)
+{
+	ANKI_ASSERT(end - begin > kMaxPrimitivesPerLeaf);
+	ANKI_ASSERT(depth + 1 < kMaxDepth);
+
+	const U32 mid = splitPrimitives(ctx, begin, end, depth);
+	ANKI_ASSERT(mid > begin && mid < end);
+
+	const Array<U32, 3> ranges = {begin, mid, end};
+	for(U32 c = 0; c < 2; ++c)
+	{
+		const U32 childBegin = ranges[c];
+		const U32 childEnd = ranges[c + 1];
+
+		// Compute the bounds of the child
+		Vec3 aabbMin(kMaxF32);
+		Vec3 aabbMax(kMinF32);
+		for(U32 i = childBegin; i < childEnd; ++i)
+		{
+			const BvhPrimitive& prim = ctx.m_primitives[m_primitiveIndices[i]];
+			aabbMin = aabbMin.min(prim.m_aabbMin);
+			aabbMax = aabbMax.max(prim.m_aabbMax);
+		}
+
+		quantize(aabbMin, aabbMax, m_nodes[nodeIdx], c);
+
+		const U32 childCount = childEnd - childBegin;
+		if(childCount <= kMaxPrimitivesPerLeaf)
+		{
+			m_nodes[nodeIdx].m_children[c] = encodeLeaf(childBegin, childCount);
+			continue;
+		}
+
+		const U32 childIdx = ctx.m_nodeCount.fetchAdd(1);
+		ANKI_ASSERT(childIdx < m_nodes.getSize());
+		m_nodes[nodeIdx].m_children[c] = childIdx;
+
+		if(hive && childCount > kParallelBuildThreshold)
+		{
+			BuildTask* task =
+				static_cast<BuildTask*>(hive->allocateScratchMemory(sizeof(BuildTask), alignof(BuildTask)));
+			task->m_bvh = this;
+			task->m_ctx = &ctx;
+			task->m_nodeIdx = childIdx;
+			task->m_begin = childBegin;
+			task->m_end = childEnd;
+			task->m_depth = depth + 1;
+
+			hive->submitTask(buildTaskCallback, task);
+		}
+		else
+		{
+			buildRecursive(ctx, childIdx, childBegin, childEnd, depth + 1, nullptr);
+		}
+	}
+}
+
+U32 Bvh::splitPrimitives(BuildContext& ctx, U32 begin, U32 end, U32 depth)
+{
+	// Compute the bounds of the centroids
+	Vec3 centroidMin(kMaxF32);
+	Vec3 centroidMax(kMinF32);
+	for(U32 i = begin; i < end; ++i)
+	{
+		const Vec3& c = ctx.m_centroids[m_primitiveIndices[i]];
+		centroidMin = centroidMin.min(c);
+		centroidMax = centroidMax.max(c);
+	}
+
+	const Vec3 extend = centroidMax - centroidMin;
+
+	if(depth < kMaxSahDepth)
+	{
+		class Bin
+		{
+		public:
+			Vec3 m_aabbMin = Vec3(kMaxF32);
+			Vec3 m_aabbMax = Vec3(kMinF32);
+			U32 m_count = 0;
+		};
+
+		Array2d<Bin, 3, kBinCount> bins;
+		Vec3 binScale;
+		for(U32 axis = 0; axis < 3; ++axis)
+		{
+			binScale[axis] = (extend[axis] > kEpsilonf) ? F32(kBinCount) * 0.9999f / extend[axis] : 0.0f;
+		}
+
+		// Populate the bins of all axis in one go
+		for(U32 i = begin; i < end; ++i)
+		{
+			const U32 primIdx = m_primitiveIndices[i];
+			const BvhPrimitive& prim = ctx.m_primitives[primIdx];
+			const Vec3 binf = (ctx.m_centroids[primIdx] - centroidMin) * binScale;
+
+			for(U32 axis = 0; axis < 3; ++axis)
+			{
+				Bin& bin = bins[axis][min(U32(binf[axis]), kBinCount - 1)];
+				bin.m_aabbMin = bin.m_aabbMin.min(prim.m_aabbMin);
+				bin.m_aabbMax = bin.m_aabbMax.max(prim.m_aabbMax);
+				++bin.m_count;
+			}
+		}
+
+		// Sweep and find the split with the lowest cost
+		F32 bestCost = kMaxF32;
+		U32 bestAxis = kMaxU32;
+		U32 bestBin = kMaxU32;
+		for(U32 axis = 0; axis < 3; ++axis)
+		{
+			if(binScale[axis] == 0.0f)
+			{
+				continue;
+			}
+
+			Array<F32, kBinCount - 1> leftCosts;
+			Vec3 aabbMin(kMaxF32);
+			Vec3 aabbMax(kMinF32);
+			U32 count = 0;
+			for(U32 b = 0; b < kBinCount - 1; ++b)
+			{
+				const Bin& bin = bins[axis][b];
+				aabbMin = aabbMin.min(bin.m_aabbMin);
+				aabbMax = aabbMax.max(bin.m_aabbMax);
+				count += bin.m_count;
+				leftCosts[b] = (count) ? computeHalfArea(aabbMin, aabbMax) * F32(count) : kMaxF32;
+			}
+
+			aabbMin = Vec3(kMaxF32);
+			aabbMax = Vec3(kMinF32);
+			count = 0;
+			for(U32 b = kBinCount - 1; b > 0; --b)
+			{
+				const Bin& bin = bins[axis][b];
+				aabbMin = aabbMin.min(bin.m_aabbMin);
+				aabbMax = aabbMax.max(bin.m_aabbMax);
+				count += bin.m_count;
+
+				if(count == 0 || leftCosts[b - 1] == kMaxF32)
+				{
+					continue;
+				}
+
+				const F32 cost = leftCosts[b - 1] + computeHalfArea(aabbMin, aabbMax) * F32(count);
+				if(cost < bestCost)
+				{
+					bestCost = cost;
+					bestAxis = axis;
+					bestBin = b - 1;
+				}
+			}
+		}
+
+		if(bestAxis != kMaxU32)
+		{
+			const F32 axisMin = centroidMin[bestAxis];
+			const F32 axisScale = binScale[bestAxis];
+			U32* const mid = std::partition(&m_primitiveIndices[begin], &m_primitiveIndices[0] + end, [&](U32 primIdx) {
+				const U32 b = min(U32((ctx.m_centroids[primIdx][bestAxis] - axisMin) * axisScale), kBinCount - 1);
+				return b <= bestBin;
+			});
+
+			const U32 out = U32(mid - &m_primitiveIndices[0]);
+			if(out > begin && out < end)
+			{
+				return out;
+			}
+		}
+	}
+
+	// SAH failed or not allowed, split at the median of the largest axis
+	U32 axis = (extend.x() > extend.y()) ? 0 : 1;
+	axis = (extend.z() > extend[axis]) ? 2 : axis;
+	const U32 mid = (begin + end) / 2;
+	std::nth_element(&m_primitiveIndices[begin], &m_primitiveIndices[mid], &m_primitiveIndices[0] + end,
+					 [&](U32 a, U32 b) {
+						 return ctx.m_centroids[a][axis] < ctx.m_centroids[b][axis];
+					 });
+	return mid;
+}
+
+void Bvh::refit(ConstWeakArray<BvhPrimitive> primitives)
+{
+	ANKI_TRACE_SCOPED_EVENT(COLLISION_BVH_REFIT);
+	ANKI_ASSERT(primitives.getSize() == m_primitiveIndices.getSize());
+
+	if(isEmpty())
+	{
+		return;
+	}
+
+	// New bounds means new quantization
+	Vec3 aabbMin(kMaxF32);
+	Vec3 aabbMax(kMinF32);
+	for(const BvhPrimitive& prim : primitives)
+	{
+		aabbMin = aabbMin.min(prim.m_aabbMin);
+		aabbMax = aabbMax.max(prim.m_aabbMax);
+	}
+	setQuantizationBounds(aabbMin, aabbMax);
+
+	// The children always have bigger indices than their parents so iterate backwards to update them bottom-up. Keep
+	// the full precision bounds of the nodes in a scratch buffer
+	const U32 nodeCount = m_nodes.getSize();
+	if(m_refitScratch.getSize() != nodeCount * 2)
+	{
+		m_refitScratch.resize(*m_pool, nodeCount * 2);
+	}
+
+	for(U32 nodeIdx = nodeCount; nodeIdx-- > 0;)
+	{
+		BvhNode& node = m_nodes[nodeIdx];
+		Vec3 nodeMin(kMaxF32);
+		Vec3 nodeMax(kMinF32);
+
+		for(U32 c = 0; c < 2; ++c)
+		{
+			const U32 child = node.m_children[c];
+			if(child == kEmptyChild)
+			{
+				continue;
+			}
+
+			Vec3 childMin(kMaxF32);
+			Vec3 childMax(kMinF32);
+			if(isLeaf(child))
+			{
+				U32 first, count;
+				decodeLeaf(child, first, count);
+				for(U32 i = first; i < first + count; ++i)
+				{
+					const BvhPrimitive& prim = primitives[m_primitiveIndices[i]];
+					childMin = childMin.min(prim.m_aabbMin);
+					childMax = childMax.max(prim.m_aabbMax);
+				}
+			}
+			else
+			{
+				ANKI_ASSERT(child > nodeIdx);
+				childMin = m_refitScratch[child * 2];
+				childMax = m_refitScratch[child * 2 + 1];
+			}
+
+			quantize(childMin, childMax, node, c);
+			nodeMin = nodeMin.min(childMin);
+			nodeMax = nodeMax.max(childMax);
+		}
+
+		if(node.m_children[1] == kEmptyChild)
+		{
+			quantize(nodeMin, nodeMax, node, 1);
+		}
+
+		m_refitScratch[nodeIdx * 2] = nodeMin;
+		m_refitScratch[nodeIdx * 2 + 1] = nodeMax;
+	}
+}
+
+void Bvh::refitFromTriangles(ConstWeakArray<Vec3> positions, ConstWeakArray<U32> indices)
+{
+	const U32 triangleCount = indices.getSize() / 3;
+	DynamicArrayRaii<BvhPrimitive> primitives(m_pool, triangleCount);
+	computeTrianglePrimitives(positions, indices, WeakArray<BvhPrimitive>(primitives));
+	refit(primitives);
+}
+
+Bool Bvh::castRayTriangles(ConstWeakArray<Vec3> positions, ConstWeakArray<U32> indices, const Ray& ray,
+						   F32 maxDistance, F32& hitDistance, U32& hitTriangleIdx) const
+{
+	ANKI_ASSERT(indices.getSize() / 3 == getPrimitiveCount());
+
+	Bool hit = false;
+	rayQuery(ray, maxDistance, [&](U32 triangleIdx, F32& crntMaxDistance) {
+		F32 t;
+		if(testCollision(ray, positions[indices[triangleIdx * 3]], positions[indices[triangleIdx * 3 + 1]],
+						 positions[indices[triangleIdx * 3 + 2]], t)
+		   && t < crntMaxDistance)
+		{
+			crntMaxDistance = t;
+			hitDistance = t;
+			hitTriangleIdx = triangleIdx;
+			hit = true;
+		}
+	});
+
+	return hit;
+}
+
+} // end namespace anki
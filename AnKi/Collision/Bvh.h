@@ -0,0 +1,426 @@
+// Copyright (C) 2009-2022, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#pragma once
+
+#include <AnKi/Collision/Common.h>
+#include <AnKi/Collision/Aabb.h>
+#include <AnKi/Collision/Plane.h>
+#include <AnKi/Collision/Ray.h>
+#include <AnKi/Collision/Functions.h>
+#include <AnKi/Util/DynamicArray.h>
+#include <AnKi/Util/WeakArray.h>
+
+namespace anki {
+
+// Forward
+class ThreadHive;
+class ThreadHiveSemaphore;
+
+/// @addtogroup collision
+/// @{
+
+/// The bounds of a primitive that will be inserted into a Bvh.
+class BvhPrimitive
+{
+public:
+	Vec3 m_aabbMin;
+	Vec3 m_aabbMax;
+};
+
+/// A Bvh node. It holds the bounding boxes of both of its children quantized relative to the bounds of the Bvh.
+/// @warning Keep it 32 bytes.
+class BvhNode
+{
+public:
+	Array2d<U16, 2, 3> m_childAabbMins;
+	Array2d<U16, 2, 3> m_childAabbMaxs;
+
+	/// If the top bit is set then the child is a leaf. In that case the next 4 bits are the primitive count minus one
+	/// and the rest are the offset of the first primitive. If the top bit is not set then it's the index of the child
+	/// node. If it's kMaxU32 then the child slot is empty.
+	Array<U32, 2> m_children;
+};
+static_assert(sizeof(BvhNode) == 32, "Wrong size");
+
+/// Bounding volume hierarchy built using binned SAH. It stores only indices to primitives so it can be used for
+/// triangles, for scene objects or anything else that can be bounded by an AABB.
+class Bvh
+{
+public:
+	static constexpr U32 kMaxPrimitivesPerLeaf = 4;
+	static constexpr U32 kBinCount = 16;
+	static constexpr U32 kMaxDepth = 64;
+
+	Bvh(BaseMemoryPool* pool)
+		: m_pool(pool)
+	{
+		ANKI_ASSERT(pool);
+	}
+
+	Bvh(const Bvh&) = delete; // Non-copyable
+
+	~Bvh()
+	{
+		destroy();
+	}
+
+	Bvh& operator=(const Bvh&) = delete; // Non-copyable
+
+	/// Build the tree.
+	/// @param primitives The bounds of the primitives.
+	/// @param hive If not nullptr the build will be spread across the ThreadHive's threads.
+	/// @note If hive is not nullptr the method will call ThreadHive::waitAllTasks.
+	void build(ConstWeakArray<BvhPrimitive> primitives, ThreadHive* hive = nullptr);
+
+	/// Build the tree from an indexed triangle list. The primitive indices are the triangle indices.
+	/// @copydetails build
+	void buildFromTriangles(ConstWeakArray<Vec3> positions, ConstWeakArray<U32> indices, ThreadHive* hive = nullptr);
+
+	/// Build the tree by sorting the primitives on the Morton codes of their centroids (LBVH). It's O(n) and way faster
+	/// than build but the quality of the tree is lower. Use it for structures that are rebuilt every frame.
+	/// @copydetails build
+	void buildLinear(ConstWeakArray<BvhPrimitive> primitives, ThreadHive* hive = nullptr);
+
+	/// Update the bounds of the tree without changing its topology. The primitives should be the same (and in the same
+	/// order) with the ones passed to build but their bounds can change. It's way faster than a full build but the
+	/// quality of the tree will degrade if the primitives move a lot.
+	void refit(ConstWeakArray<BvhPrimitive> primitives);
+
+	/// @copydoc refit
+	void refitFromTriangles(ConstWeakArray<Vec3> positions, ConstWeakArray<U32> indices);
+
+	void destroy();
+
+	Bool isEmpty() const
+	{
+		return m_nodes.isEmpty();
+	}
+
+	U32 getNodeCount() const
+	{
+		return m_nodes.getSize();
+	}
+
+	U32 getPrimitiveCount() const
+	{
+		return m_primitiveIndices.getSize();
+	}
+
+	/// Get the bounds of everything that is in the tree.
+	void getBounds(Vec3& aabbMin, Vec3& aabbMax) const
+	{
+		ANKI_ASSERT(!isEmpty());
+		aabbMin = m_aabbMin;
+		aabbMax = m_aabbMax;
+	}
+
+	/// Find the primitives whose bounds are intersected by a ray.
+	/// @tparam TFunc The lambda that will be called for each candidate primitive. Signature:
+	///               void(U32 primitiveIdx, F32& maxDistance). The lambda can decrease the maxDistance (eg when it
+	///               finds a hit) and the traversal will take it into account.
+	template<typename TFunc>
+	void rayQuery(const Ray& ray, F32 maxDistance, TFunc func) const;
+
+	/// Find the primitives whose bounds overlap with an AABB.
+	/// @tparam TFunc The lambda that will be called for each candidate primitive. Signature: void(U32 primitiveIdx).
+	template<typename TFunc>
+	void aabbQuery(const Aabb& aabb, TFunc func) const;
+
+	/// Find the primitives whose bounds are inside or intersect a frustum.
+	/// @tparam TFunc The lambda that will be called for each candidate primitive. Signature: void(U32 primitiveIdx).
+	template<typename TFunc>
+	void frustumQuery(ConstWeakArray<Plane> frustumPlanes, TFunc func) const;
+
+	/// Cast a ray against a tree that was built with buildFromTriangles.
+	/// @return True if the ray hits a triangle.
+	Bool castRayTriangles(ConstWeakArray<Vec3> positions, ConstWeakArray<U32> indices, const Ray& ray, F32 maxDistance,
+						  F32& hitDistance, U32& hitTriangleIdx) const;
+
+private:
+	class BuildContext;
+	class BuildTask;
+	class LinearBuildContext;
+
+	static constexpr U32 kEmptyChild = kMaxU32;
+	static constexpr U32 kLeafBit = 1u << 31u;
+	static constexpr U32 kLeafCountShift = 27;
+	static constexpr U32 kLeafOffsetMask = (1u << kLeafCountShift) - 1;
+
+	BaseMemoryPool* m_pool;
+
+	DynamicArray<BvhNode> m_nodes;
+	DynamicArray<U32> m_primitiveIndices;
+	DynamicArray<Vec3> m_refitScratch;
+
+	Vec3 m_aabbMin = Vec3(0.0f);
+	Vec3 m_aabbMax = Vec3(0.0f);
+	Vec3 m_quantizationScale = Vec3(0.0f);
+	Vec3 m_dequantizationScale = Vec3(0.0f);
+
+	static Bool isLeaf(U32 child)
+	{
+		return child != kEmptyChild && !!(child & kLeafBit);
+	}
+
+	static U32 encodeLeaf(U32 firstPrimitive, U32 primitiveCount)
+	{
+		ANKI_ASSERT(primitiveCount > 0 && primitiveCount <= (1u << (31u - kLeafCountShift)));
+		ANKI_ASSERT(firstPrimitive <= kLeafOffsetMask);
+		return kLeafBit | ((primitiveCount - 1) << kLeafCountShift) | firstPrimitive;
+	}
+
+	static void decodeLeaf(U32 child, U32& firstPrimitive, U32& primitiveCount)
+	{
+		ANKI_ASSERT(isLeaf(child));
+		firstPrimitive = child & kLeafOffsetMask;
+		primitiveCount = ((child & ~kLeafBit) >> kLeafCountShift) + 1;
+	}
+
+	void setQuantizationBounds(const Vec3& aabbMin, const Vec3& aabbMax);
+
+	void quantize(const Vec3& aabbMin, const Vec3& aabbMax, BvhNode& node, U32 child) const;
+
+	Aabb dequantize(const BvhNode& node, U32 child) const
+	{
+		const Vec3 qmin(node.m_childAabbMins[child][0], node.m_childAabbMins[child][1],
+						node.m_childAabbMins[child][2]);
+		const Vec3 qmax(node.m_childAabbMaxs[child][0], node.m_childAabbMaxs[child][1],
+						node.m_childAabbMaxs[child][2]);
+		return Aabb(m_aabbMin + qmin * m_dequantizationScale, m_aabbMin + qmax * m_dequantizationScale);
+	}
+
+	static void computeTrianglePrimitives(ConstWeakArray<Vec3> positions, ConstWeakArray<U32> indices,
+										  WeakArray<BvhPrimitive> primitives);
+
+	static void buildTaskCallback(void* ud, U32 threadId, ThreadHive& hive, ThreadHiveSemaphore* sem);
+
+	void buildRecursive(BuildContext& ctx, U32 nodeIdx, U32 begin, U32 end, U32 depth, ThreadHive* hive);
+
+	/// Split a range of primitives in two. Returns the first primitive of the 2nd range.
+	U32 splitPrimitives(BuildContext& ctx, U32 begin, U32 end, U32 depth);
+
+	/// Ray vs AABB slab test.
+	static Bool intersectRayAabb(const Vec3& origin, const Vec3& invDir, const Aabb& aabb, F32 maxDistance,
+								 F32& nearDistance)
+	{
+		const Vec3 t0 = (aabb.getMin().xyz() - origin) * invDir;
+		const Vec3 t1 = (aabb.getMax().xyz() - origin) * invDir;
+		const Vec3 tmin = t0.min(t1);
+		const Vec3 tmax = t0.max(t1);
+		nearDistance = max(max(tmin.x(), tmin.y()), max(tmin.z(), 0.0f));
+		const F32 farDistance = min(min(tmax.x(), tmax.y()), min(tmax.z(), maxDistance));
+		return nearDistance <= farDistance;
+	}
+
+	template<typename TFunc>
+	void visitLeaf(U32 child, TFunc& func) const
+	{
+		U32 first, count;
+		decodeLeaf(child, first, count);
+		for(U32 i = first; i < first + count; ++i)
+		{
+			func(m_primitiveIndices[i]);
+		}
+	}
+
+	/// Visit all the primitives under a node without any test.
+	template<typename TFunc>
+	void visitSubtree(U32 child, TFunc& func) const;
+};
+
+template<typename TFunc>
+inline void Bvh::rayQuery(const Ray& ray, F32 maxDistance, TFunc func) const
+{
+	if(isEmpty())
+	{
+		return;
+	}
+
+	const Vec3 origin = ray.getOrigin().xyz();
+	const Vec3 dir = ray.getDirection().xyz();
+	Vec3 invDir;
+	for(U32 i = 0; i < 3; ++i)
+	{
+		invDir[i] = (dir[i] != 0.0f) ? 1.0f / dir[i] : ((std::signbit(dir[i])) ? kMinF32 : kMaxF32);
+	}
+
+	Array<U32, kMaxDepth> stack;
+	U32 stackSize = 0;
+	stack[stackSize++] = 0;
+
+	while(stackSize)
+	{
+		const BvhNode& node = m_nodes[stack[--stackSize]];
+
+		Array<F32, 2> nearDistances;
+		Array<Bool, 2> hits;
+		for(U32 c = 0; c < 2; ++c)
+		{
+			hits[c] = node.m_children[c] != kEmptyChild
+					  && intersectRayAabb(origin, invDir, dequantize(node, c), maxDistance, nearDistances[c]);
+		}
+
+		// Visit the closest child first. Leafs are visited immediately, nodes are pushed in reverse order
+		const U32 first = (hits[0] && hits[1] && nearDistances[1] < nearDistances[0]) ? 1 : 0;
+		const Array<U32, 2> order = {first, 1 - first};
+
+		for(U32 c : order)
+		{
+			if(hits[c] && isLeaf(node.m_children[c]) && nearDistances[c] <= maxDistance)
+			{
+				U32 firstPrim, count;
+				decodeLeaf(node.m_children[c], firstPrim, count);
+				for(U32 i = firstPrim; i < firstPrim + count; ++i)
+				{
+					func(m_primitiveIndices[i], maxDistance);
+				}
+			}
+		}
+
+		for(U32 i = 2; i-- > 0;)
+		{
+			const U32 c = order[i];
+			if(hits[c] && !isLeaf(node.m_children[c]))
+			{
+				ANKI_ASSERT(stackSize < stack.getSize());
+				stack[stackSize++] = node.m_children[c];
+			}
+		}
+	}
+}
+
+template<typename TFunc>
+inline void Bvh::aabbQuery(const Aabb& aabb, TFunc func) const
+{
+	if(isEmpty())
+	{
+		return;
+	}
+
+	Array<U32, kMaxDepth> stack;
+	U32 stackSize = 0;
+	stack[stackSize++] = 0;
+
+	while(stackSize)
+	{
+		const BvhNode& node = m_nodes[stack[--stackSize]];
+
+		for(U32 c = 0; c < 2; ++c)
+		{
+			const U32 child = node.m_children[c];
+			if(child == kEmptyChild || !testCollision(aabb, dequantize(node, c)))
+			{
+				continue;
+			}
+
+			if(isLeaf(child))
+			{
+				visitLeaf(child, func);
+			}
+			else
+			{
+				ANKI_ASSERT(stackSize < stack.getSize());
+				stack[stackSize++] = child;
+			}
+		}
+	}
+}
+
+template<typename TFunc>
+inline void Bvh::frustumQuery(ConstWeakArray<Plane> frustumPlanes, TFunc func) const
+{
+	if(isEmpty())
+	{
+		return;
+	}
+
+	Array<U32, kMaxDepth> stack;
+	U32 stackSize = 0;
+	stack[stackSize++] = 0;
+
+	while(stackSize)
+	{
+		const BvhNode& node = m_nodes[stack[--stackSize]];
+
+		for(U32 c = 0; c < 2; ++c)
+		{
+			const U32 child = node.m_children[c];
+			if(child == kEmptyChild)
+			{
+				continue;
+			}
+
+			const Aabb box = dequantize(node, c);
+			Bool outside = false;
+			Bool insideAll = true;
+			for(const Plane& plane : frustumPlanes)
+			{
+				const F32 dist = testPlane(plane, box);
+				if(dist < 0.0f)
+				{
+					outside = true;
+					break;
+				}
+
+				insideAll = insideAll && dist > 0.0f;
+			}
+
+			if(outside)
+			{
+				continue;
+			}
+
+			if(isLeaf(child))
+			{
+				visitLeaf(child, func);
+			}
+			else if(insideAll)
+			{
+				// No need to test anything else
+				visitSubtree(child, func);
+			}
+			else
+			{
+				ANKI_ASSERT(stackSize < stack.getSize());
+				stack[stackSize++] = child;
+			}
+		}
+	}
+}
+
+template<typename TFunc>
+inline void Bvh::visitSubtree(U32 child, TFunc& func) const
+{
+	Array<U32, kMaxDepth> stack;
+	U32 stackSize = 0;
+	stack[stackSize++] = child;
+
+	while(stackSize)
+	{
+		const BvhNode& node = m_nodes[stack[--stackSize]];
+		for(U32 c = 0; c < 2; ++c)
+		{
+			const U32 grandChild = node.m_children[c];
+			if(grandChild == kEmptyChild)
+			{
+				continue;
+			}
+
+			if(isLeaf(grandChild))
+			{
+				visitLeaf(grandChild, func);
+			}
+			else
+			{
+				ANKI_ASSERT(stackSize < stack.getSize());
+				stack[stackSize++] = grandChild;
+			}
+		}
+	}
+}
+/// @}
+
+} // end namespace anki
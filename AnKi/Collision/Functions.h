@@ -190,6 +190,9 @@ Bool testCollision(const Plane& plane, const Ray& ray, Vec4& intersection);
 Bool testCollision(const Plane& plane, const Vec4& vector, Vec4& intersection);
 Bool testCollision(const Sphere& sphere, const Ray& ray, Array<Vec4, 2>& intersectionPoints, U& intersectionPointCount);
 
+/// Intersect a ray against a triangle (Moller-Trumbore). If there is a hit the hit point is rayOrigin + rayDir * t.
+Bool testCollision(const Ray& ray, const Vec3& v0, const Vec3& v1, const Vec3& v2, F32& t);
+
 // Intersect a ray against an AABB. The ray is inside the AABB. The function returns the distance 'a' where the
 // intersection point is rayOrigin + rayDir * a
 // https://community.arm.com/graphics/b/blog/posts/reflections-based-on-local-cubemaps-in-unity
@@ -415,4 +415,38 @@ Bool intersect(const Sphere& sphere, const Ray& ray, Array<Vec4, 2>& intersectio
 	}
 }
 
+Bool testCollision(const Ray& ray, const Vec3& v0, const Vec3& v1, const Vec3& v2, F32& t)
+{
+	const Vec3 origin = ray.getOrigin().xyz();
+	const Vec3 dir = ray.getDirection().xyz();
+
+	const Vec3 edge1 = v1 - v0;
+	const Vec3 edge2 = v2 - v0;
+	const Vec3 p = dir.cross(edge2);
+	const F32 det = edge1.dot(p);
+	if(absolute(det) < kEpsilonf)
+	{
+		// Parallel to the triangle
+		return false;
+	}
+
+	const F32 invDet = 1.0f / det;
+	const Vec3 s = origin - v0;
+	const F32 u = s.dot(p) * invDet;
+	if(u < 0.0f || u > 1.0f)
+	{
+		return false;
+	}
+
+	const Vec3 q = s.cross(edge1);
+	const F32 v = dir.dot(q) * invDet;
+	if(v < 0.0f || u + v > 1.0f)
+	{
+		return false;
+	}
+
+	t = edge2.dot(q) * invDet;
+	return t >= 0.0f;
+}
+
 } // end namespace anki
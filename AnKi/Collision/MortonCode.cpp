@@ -0,0 +1,96 @@
+// Copyright (C) 2009-2022, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <AnKi/Collision/MortonCode.h>
+
+namespace anki {
+
+static Vec3 computeInvExtend(const Vec3& boundsMin, const Vec3& boundsMax)
+{
+	Vec3 invExtend;
+	for(U32 i = 0; i < 3; ++i)
+	{
+		const F32 extend = boundsMax[i] - boundsMin[i];
+		invExtend[i] = (extend > kEpsilonf) ? 1.0f / extend : 0.0f;
+	}
+	return invExtend;
+}
+
+#if ANKI_SIMD_SSE
+static inline __m128i expandBitsMorton30Simd(__m128 coord)
+{
+	__m128i v = _mm_cvttps_epi32(coord);
+	v = _mm_and_si128(_mm_or_si128(v, _mm_slli_epi32(v, 16)), _mm_set1_epi32(0x030000FF));
+	v = _mm_and_si128(_mm_or_si128(v, _mm_slli_epi32(v, 8)), _mm_set1_epi32(0x0300F00F));
+	v = _mm_and_si128(_mm_or_si128(v, _mm_slli_epi32(v, 4)), _mm_set1_epi32(0x030C30C3));
+	v = _mm_and_si128(_mm_or_si128(v, _mm_slli_epi32(v, 2)), _mm_set1_epi32(0x09249249));
+	return v;
+}
+#elif ANKI_SIMD_NEON
+static inline uint32x4_t expandBitsMorton30Simd(float32x4_t coord)
+{
+	uint32x4_t v = vcvtq_u32_f32(coord);
+	v = vandq_u32(vorrq_u32(v, vshlq_n_u32(v, 16)), vdupq_n_u32(0x030000FF));
+	v = vandq_u32(vorrq_u32(v, vshlq_n_u32(v, 8)), vdupq_n_u32(0x0300F00F));
+	v = vandq_u32(vorrq_u32(v, vshlq_n_u32(v, 4)), vdupq_n_u32(0x030C30C3));
+	v = vandq_u32(vorrq_u32(v, vshlq_n_u32(v, 2)), vdupq_n_u32(0x09249249));
+	return v;
+}
+#endif
+
+void computeMortonCodes30(ConstWeakArray<Vec3> positions, const Vec3& boundsMin, const Vec3& boundsMax,
+						  WeakArray<U32> codes)
+{
+	ANKI_ASSERT(positions.getSize() == codes.getSize());
+	const Vec3 invExtend = computeInvExtend(boundsMin, boundsMax);
+	const U32 count = positions.getSize();
+	U32 i = 0;
+
+#if ANKI_SIMD_SSE || ANKI_SIMD_NEON
+	// Transpose 4 positions to SoA and interleave the bits of all 4 at once
+	const Vec3 scale = invExtend * 1024.0f;
+	for(; i + 4 <= count; i += 4)
+	{
+		Array<Vec4, 3> soa;
+		for(U32 axis = 0; axis < 3; ++axis)
+		{
+			soa[axis] = Vec4(positions[i][axis], positions[i + 1][axis], positions[i + 2][axis],
+							 positions[i + 3][axis]);
+			soa[axis] = ((soa[axis] - boundsMin[axis]) * scale[axis]).clamp(0.0f, 1023.0f);
+		}
+
+#	if ANKI_SIMD_SSE
+		const __m128i x = _mm_slli_epi32(expandBitsMorton30Simd(soa[0].getSimd()), 2);
+		const __m128i y = _mm_slli_epi32(expandBitsMorton30Simd(soa[1].getSimd()), 1);
+		const __m128i z = expandBitsMorton30Simd(soa[2].getSimd());
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(&codes[i]), _mm_or_si128(_mm_or_si128(x, y), z));
+#	else
+		const uint32x4_t x = vshlq_n_u32(expandBitsMorton30Simd(soa[0].getSimd()), 2);
+		const uint32x4_t y = vshlq_n_u32(expandBitsMorton30Simd(soa[1].getSimd()), 1);
+		const uint32x4_t z = expandBitsMorton30Simd(soa[2].getSimd());
+		vst1q_u32(&codes[i], vorrq_u32(vorrq_u32(x, y), z));
+#	endif
+	}
+#endif
+
+	// Remaining
+	for(; i < count; ++i)
+	{
+		codes[i] = computeMortonCode30(positions[i], boundsMin, invExtend);
+	}
+}
+
+void computeMortonCodes63(ConstWeakArray<Vec3> positions, const Vec3& boundsMin, const Vec3& boundsMax,
+						  WeakArray<U64> codes)
+{
+	ANKI_ASSERT(positions.getSize() == codes.getSize());
+	const Vec3 invExtend = computeInvExtend(boundsMin, boundsMax);
+	for(U32 i = 0; i < positions.getSize(); ++i)
+	{
+		codes[i] = computeMortonCode63(positions[i], boundsMin, invExtend);
+	}
+}
+
+} // end namespace anki
@@ -0,0 +1,80 @@
+// Copyright (C) 2009-2022, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#pragma once
+
+#include <AnKi/Collision/Common.h>
+#include <AnKi/Math.h>
+#include <AnKi/Util/WeakArray.h>
+
+namespace anki {
+
+/// @addtogroup collision
+/// @{
+
+/// Insert 2 zero bits between each of the lower 10 bits of a number.
+inline constexpr U32 expandBitsMorton30(U32 v)
+{
+	v &= 0x3FFu;
+	v = (v | (v << 16u)) & 0x030000FFu;
+	v = (v | (v << 8u)) & 0x0300F00Fu;
+	v = (v | (v << 4u)) & 0x030C30C3u;
+	v = (v | (v << 2u)) & 0x09249249u;
+	return v;
+}
+
+/// Insert 2 zero bits between each of the lower 21 bits of a number.
+inline constexpr U64 expandBitsMorton63(U64 v)
+{
+	v &= 0x1FFFFFu;
+	v = (v | (v << 32u)) & 0x001F00000000FFFFull;
+	v = (v | (v << 16u)) & 0x001F0000FF0000FFull;
+	v = (v | (v << 8u)) & 0x100F00F00F00F00Full;
+	v = (v | (v << 4u)) & 0x10C30C30C30C30C3ull;
+	v = (v | (v << 2u)) & 0x1249249249249249ull;
+	return v;
+}
+
+/// Compute a 30 bit Morton code (10 bits per axis) of a position that lies inside some bounds.
+/// @param pos The position.
+/// @param boundsMin The min corner of the bounds.
+/// @param invBoundsExtend The inverse of the size of the bounds.
+inline U32 computeMortonCode30(const Vec3& pos, const Vec3& boundsMin, const Vec3& invBoundsExtend)
+{
+	const Vec3 q = ((pos - boundsMin) * invBoundsExtend * 1024.0f).clamp(0.0f, 1023.0f);
+	return (expandBitsMorton30(U32(q.x())) << 2u) | (expandBitsMorton30(U32(q.y())) << 1u)
+		   | expandBitsMorton30(U32(q.z()));
+}
+
+/// Compute a 63 bit Morton code (21 bits per axis) of a position that lies inside some bounds.
+/// @param pos The position.
+/// @param boundsMin The min corner of the bounds.
+/// @param invBoundsExtend The inverse of the size of the bounds.
+inline U64 computeMortonCode63(const Vec3& pos, const Vec3& boundsMin, const Vec3& invBoundsExtend)
+{
+	constexpr F32 kMaxCoord = F32((1u << 21u) - 1u);
+	const Vec3 q = ((pos - boundsMin) * invBoundsExtend * (kMaxCoord + 1.0f)).clamp(0.0f, kMaxCoord);
+	return (expandBitsMorton63(U64(q.x())) << 2u) | (expandBitsMorton63(U64(q.y())) << 1u)
+		   | expandBitsMorton63(U64(q.z()));
+}
+
+/// Compute the 30 bit Morton codes of many positions. It uses SIMD to process 4 positions at a time.
+/// @param positions The positions.
+/// @param boundsMin The min corner of the bounds of all positions.
+/// @param boundsMax The max corner of the bounds of all positions.
+/// @param[out] codes The Morton codes. It should be the same size as the positions.
+void computeMortonCodes30(ConstWeakArray<Vec3> positions, const Vec3& boundsMin, const Vec3& boundsMax,
+						  WeakArray<U32> codes);
+
+/// Compute the 63 bit Morton codes of many positions.
+/// @param positions The positions.
+/// @param boundsMin The min corner of the bounds of all positions.
+/// @param boundsMax The max corner of the bounds of all positions.
+/// @param[out] codes The Morton codes. It should be the same size as the positions.
+void computeMortonCodes63(ConstWeakArray<Vec3> positions, const Vec3& boundsMin, const Vec3& boundsMax,
+						  WeakArray<U64> codes);
+/// @}
+
+} // end namespace anki
@@ -206,9 +206,18 @@
 #	include <intrin.h>
 #	define __builtin_popcount __popcnt
 #	define __builtin_popcountl(x) int(__popcnt64(x))
+#	define __builtin_popcountll(x) int(__popcnt64(x))
+#	define __builtin_clz(x) int(__lzcnt(x))
 #	define __builtin_clzll(x) int(__lzcnt64(x))
 
 #pragma intrinsic(_BitScanForward)
+inline int __builtin_ctz(unsigned int x)
+{
+	unsigned long o;
+	_BitScanForward(&o, x);
+	return o;
+}
+
 inline int __builtin_ctzll(unsigned long long x)
 {
 	unsigned long o;
@@ -10,12 +10,16 @@
 #include <AnKi/Util/StringList.h>
 #include <AnKi/Util/File.h>
 #include <AnKi/Util/HashMap.h>
+#include <AnKi/Util/WeakArray.h>
 #include <AnKi/Resource/Common.h>
 #include <AnKi/Math.h>
 #include <Cgltf/cgltf.h>
 
 namespace anki {
 
+// Forward
+class GltfAnimChannel;
+
 /// @addtogroup importer
 /// @{
 
@@ -29,6 +33,7 @@ public:
 	CString m_texrpath;
 	Bool m_optimizeMeshes = true;
 	Bool m_optimizeAnimations = true;
+	Bool m_compressAnimations = false; ///< Write animation binaries instead of XML.
 	F32 m_lodFactor = 1.0f;
 	U32 m_lodCount = 1;
 	F32 m_lightIntensityScale = 1.0f;
@@ -84,6 +89,7 @@ private:
 	F32 m_lightIntensityScale = 1.0f;
 	Bool m_optimizeMeshes = false;
 	Bool m_optimizeAnimations = false;
+	Bool m_compressAnimations = false;
 	StringRaii m_comment = {m_pool};
 
 	/// Don't generate LODs for meshes with less vertices than this number.
@@ -188,6 +194,7 @@ private:
 	Error writeMaterial(const cgltf_material& mtl, Bool writeRayTracing) const;
 	Error writeModel(const cgltf_mesh& mesh) const;
 	Error writeAnimation(const cgltf_animation& anim);
+	Error writeCompressedAnimation(CString fname, ConstWeakArray<GltfAnimChannel> channels) const;
 	Error writeSkeleton(const cgltf_skin& skin) const;
 
 	// Scene
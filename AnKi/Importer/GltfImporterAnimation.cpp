@@ -4,6 +4,7 @@
 // http://www.anki3d.org/LICENSE
 
 #include <AnKi/Importer/GltfImporter.h>
+#include <AnKi/Resource/AnimationBinary.h>
 #include <AnKi/Util/Xml.h>
 
 namespace anki {
@@ -115,6 +116,40 @@ static void optimizeChannel(DynamicArrayRaii<GltfAnimKey<T>>& arr, const T& iden
 	ANKI_IMPORTER_LOGV("Channel optimization iteration count: %u", iterationCount);
 }
 
+/// Sample a channel at some time. The value is clamped outside of the keys.
+/// @param[in,out] cursor The key that the last sampling used. Sampling forward in time starts searching from there.
+template<typename T, typename TLerpFunc>
+static T sampleChannel(const DynamicArrayRaii<GltfAnimKey<T>>& keys, Second time, const T& identity, U32& cursor,
+					   TLerpFunc lerpFunc)
+{
+	if(keys.getSize() == 0)
+	{
+		return identity;
+	}
+
+	if(time <= keys[0].m_time)
+	{
+		cursor = 0;
+		return keys[0].m_value;
+	}
+
+	if(time >= keys.getBack().m_time)
+	{
+		return keys.getBack().m_value;
+	}
+
+	cursor = (keys[cursor].m_time <= time) ? cursor : 0;
+	while(keys[cursor + 1].m_time < time)
+	{
+		++cursor;
+	}
+
+	const GltfAnimKey<T>& left = keys[cursor];
+	const GltfAnimKey<T>& right = keys[cursor + 1];
+	const F32 u = F32((time - left.m_time) / (right.m_time - left.m_time));
+	return lerpFunc(left.m_value, right.m_value, u);
+}
+
 Error GltfImporter::writeAnimation(const cgltf_animation& anim)
 {
 	StringRaii fname(m_pool);
@@ -303,57 +338,64 @@ Error GltfImporter::writeAnimation(const cgltf_animation& anim)
 	}
 
 	// Write file
-	File file;
-	ANKI_CHECK(file.open(fname.toCString(), FileOpenFlag::kWrite));
-
-	ANKI_CHECK(file.writeTextf("%s\n<animation>\n", XmlDocument::kXmlHeader.cstr()));
-	ANKI_CHECK(file.writeText("\t<channels>\n"));
-
-	for(const GltfAnimChannel& channel : tempChannels)
+	if(m_compressAnimations)
+	{
+		ANKI_CHECK(writeCompressedAnimation(fname, ConstWeakArray<GltfAnimChannel>(tempChannels)));
+	}
+	else
 	{
-		ANKI_CHECK(file.writeTextf("\t\t<channel name=\"%s\">\n", channel.m_name.cstr()));
+		File file;
+		ANKI_CHECK(file.open(fname.toCString(), FileOpenFlag::kWrite));
 
-		// Positions
-		if(channel.m_positions.getSize())
+		ANKI_CHECK(file.writeTextf("%s\n<animation>\n", XmlDocument::kXmlHeader.cstr()));
+		ANKI_CHECK(file.writeText("\t<channels>\n"));
+
+		for(const GltfAnimChannel& channel : tempChannels)
 		{
-			ANKI_CHECK(file.writeText("\t\t\t<positionKeys>\n"));
-			for(const GltfAnimKey<Vec3>& key : channel.m_positions)
+			ANKI_CHECK(file.writeTextf("\t\t<channel name=\"%s\">\n", channel.m_name.cstr()));
+
+			// Positions
+			if(channel.m_positions.getSize())
 			{
-				ANKI_CHECK(file.writeTextf("\t\t\t\t<key time=\"%f\">%f %f %f</key>\n", key.m_time, key.m_value.x(),
-										   key.m_value.y(), key.m_value.z()));
+				ANKI_CHECK(file.writeText("\t\t\t<positionKeys>\n"));
+				for(const GltfAnimKey<Vec3>& key : channel.m_positions)
+				{
+					ANKI_CHECK(file.writeTextf("\t\t\t\t<key time=\"%f\">%f %f %f</key>\n", key.m_time, key.m_value.x(),
+											   key.m_value.y(), key.m_value.z()));
+				}
+				ANKI_CHECK(file.writeText("\t\t\t</positionKeys>\n"));
 			}
-			ANKI_CHECK(file.writeText("\t\t\t</positionKeys>\n"));
-		}
 
-		// Rotations
-		if(channel.m_rotations.getSize())
-		{
-			ANKI_CHECK(file.writeText("\t\t\t<rotationKeys>\n"));
-			for(const GltfAnimKey<Quat>& key : channel.m_rotations)
+			// Rotations
+			if(channel.m_rotations.getSize())
 			{
-				ANKI_CHECK(file.writeTextf("\t\t\t\t<key time=\"%f\">%f %f %f %f</key>\n", key.m_time, key.m_value.x(),
-										   key.m_value.y(), key.m_value.z(), key.m_value.w()));
+				ANKI_CHECK(file.writeText("\t\t\t<rotationKeys>\n"));
+				for(const GltfAnimKey<Quat>& key : channel.m_rotations)
+				{
+					ANKI_CHECK(file.writeTextf("\t\t\t\t<key time=\"%f\">%f %f %f %f</key>\n", key.m_time,
+											   key.m_value.x(), key.m_value.y(), key.m_value.z(), key.m_value.w()));
+				}
+				ANKI_CHECK(file.writeText("\t\t\t</rotationKeys>\n"));
 			}
-			ANKI_CHECK(file.writeText("\t\t\t</rotationKeys>\n"));
-		}
 
-		// Scales
-		if(channel.m_scales.getSize())
-		{
-			ANKI_CHECK(file.writeText("\t\t\t<scaleKeys>\n"));
-			for(const GltfAnimKey<F32>& key : channel.m_scales)
+			// Scales
+			if(channel.m_scales.getSize())
 			{
-				ANKI_CHECK(file.writeTextf("\t\t\t\t<key time=\"%f\">%f</key>\n", key.m_time, key.m_value));
+				ANKI_CHECK(file.writeText("\t\t\t<scaleKeys>\n"));
+				for(const GltfAnimKey<F32>& key : channel.m_scales)
+				{
+					ANKI_CHECK(file.writeTextf("\t\t\t\t<key time=\"%f\">%f</key>\n", key.m_time, key.m_value));
+				}
+				ANKI_CHECK(file.writeText("\t\t\t</scaleKeys>\n"));
 			}
-			ANKI_CHECK(file.writeText("\t\t\t</scaleKeys>\n"));
+
+			ANKI_CHECK(file.writeText("\t\t</channel>\n"));
 		}
 
-		ANKI_CHECK(file.writeText("\t\t</channel>\n"));
+		ANKI_CHECK(file.writeText("\t</channels>\n"));
+		ANKI_CHECK(file.writeText("</animation>\n"));
 	}
 
-	ANKI_CHECK(file.writeText("\t</channels>\n"));
-	ANKI_CHECK(file.writeText("</animation>\n"));
-
 	// Hook up the animation to the scene
 	for(const GltfAnimChannel& channel : tempChannels)
 	{
@@ -377,4 +419,233 @@ Error GltfImporter::writeAnimation(const cgltf_animation& anim)
 	return Error::kNone;
 }
 
+Error GltfImporter::writeCompressedAnimation(CString fname, ConstWeakArray<GltfAnimChannel> channels) const
+{
+	constexpr F32 kFrameRate = 30.0f;
+	constexpr F32 kQuantizationMax = F32(kMaxU16);
+	constexpr F32 kConstantEpsilon = 1.0e-5f;
+
+	// Find the time range of all channels
+	Second startTime = kMaxSecond;
+	Second endTime = kMinSecond;
+	auto updateTimeRange = [&](const auto& keys) {
+		if(keys.getSize())
+		{
+			startTime = min(startTime, keys[0].m_time);
+			endTime = max(endTime, keys.getBack().m_time);
+		}
+	};
+
+	for(const GltfAnimChannel& channel : channels)
+	{
+		updateTimeRange(channel.m_positions);
+		updateTimeRange(channel.m_rotations);
+		updateTimeRange(channel.m_scales);
+	}
+
+	if(startTime > endTime)
+	{
+		startTime = endTime = 0.0;
+	}
+
+	const U32 frameCount = U32(ceil((endTime - startTime) * kFrameRate)) + 1;
+	const F32 frameRate = (frameCount > 1) ? F32(Second(frameCount - 1) / (endTime - startTime)) : kFrameRate;
+	auto frameTime = [&](U32 frame) {
+		return startTime + Second(frame) / Second(frameRate);
+	};
+
+	// Resample the channels uniformly and quantize. Channels that don't change store a single value
+	DynamicArrayRaii<AnimationBinaryChannel> outChannels(m_pool, channels.getSize());
+	DynamicArrayRaii<Char> names(m_pool);
+	DynamicArrayRaii<Array<U16, 3>> quantizedPositions(m_pool); ///< frameCount per sampled position.
+	DynamicArrayRaii<Array<U16, 3>> quantizedRotations(m_pool); ///< frameCount per sampled rotation.
+	DynamicArrayRaii<U16> quantizedScales(m_pool); ///< frameCount per sampled scale.
+	U32 positionCount = 0;
+	U32 rotationCount = 0;
+	U32 scaleCount = 0;
+
+	for(U32 c = 0; c < channels.getSize(); ++c)
+	{
+		const GltfAnimChannel& in = channels[c];
+		AnimationBinaryChannel& out = outChannels[c];
+
+		out.m_nameOffset = names.getSize();
+		out.m_nameLength = in.m_name.getLength();
+		for(Char ch : in.m_name)
+		{
+			names.emplaceBack(ch);
+		}
+
+		out.m_flags = AnimationBinaryChannelFlag::kNone;
+		out.m_positionIndex = kMaxU32;
+		out.m_rotationIndex = kMaxU32;
+		out.m_scaleIndex = kMaxU32;
+
+		// Positions
+		{
+			DynamicArrayRaii<Vec3> values(m_pool, frameCount);
+			Vec3 minv(kMaxF32);
+			Vec3 maxv(kMinF32);
+			U32 cursor = 0;
+			for(U32 f = 0; f < frameCount; ++f)
+			{
+				values[f] = sampleChannel(in.m_positions, frameTime(f), Vec3(0.0f), cursor,
+										  [](const Vec3& a, const Vec3& b, F32 u) {
+											  return linearInterpolate(a, b, u);
+										  });
+				minv = minv.min(values[f]);
+				maxv = maxv.max(values[f]);
+			}
+
+			const Vec3 range = maxv - minv;
+			if(max(range.x(), max(range.y(), range.z())) > kConstantEpsilon)
+			{
+				out.m_flags |= AnimationBinaryChannelFlag::kPositions;
+				out.m_positionIndex = positionCount++;
+				out.m_positionMin = minv;
+				out.m_positionScale = range / kQuantizationMax;
+
+				for(const Vec3& v : values)
+				{
+					Array<U16, 3> q;
+					for(U32 k = 0; k < 3; ++k)
+					{
+						q[k] = (range[k] > 0.0f) ? U16(round((v[k] - minv[k]) / range[k] * kQuantizationMax)) : 0;
+					}
+					quantizedPositions.emplaceBack(q);
+				}
+			}
+			else
+			{
+				out.m_positionMin = values[0];
+				out.m_positionScale = Vec3(0.0f);
+			}
+		}
+
+		// Rotations
+		{
+			DynamicArrayRaii<Quat> values(m_pool, frameCount);
+			Bool constant = true;
+			U32 cursor = 0;
+			for(U32 f = 0; f < frameCount; ++f)
+			{
+				values[f] = sampleChannel(in.m_rotations, frameTime(f), Quat::getIdentity(), cursor,
+										  [](const Quat& a, const Quat& b, F32 u) {
+											  return a.slerp(b, u);
+										  });
+				values[f].normalize();
+				constant = constant && absolute(values[f].dot(values[0])) >= 1.0f - kConstantEpsilon;
+			}
+
+			if(!constant)
+			{
+				out.m_flags |= AnimationBinaryChannelFlag::kRotations;
+				out.m_rotationIndex = rotationCount++;
+				out.m_rotation = Quat::getIdentity();
+
+				for(const Quat& v : values)
+				{
+					quantizedRotations.emplaceBack(packAnimationRotation(v));
+				}
+			}
+			else
+			{
+				out.m_rotation = values[0];
+			}
+		}
+
+		// Scales
+		{
+			DynamicArrayRaii<F32> values(m_pool, frameCount);
+			F32 minv = kMaxF32;
+			F32 maxv = kMinF32;
+			U32 cursor = 0;
+			for(U32 f = 0; f < frameCount; ++f)
+			{
+				values[f] = sampleChannel(in.m_scales, frameTime(f), 1.0f, cursor, [](F32 a, F32 b, F32 u) {
+					return linearInterpolate(a, b, u);
+				});
+				minv = min(minv, values[f]);
+				maxv = max(maxv, values[f]);
+			}
+
+			if(maxv - minv > kConstantEpsilon)
+			{
+				out.m_flags |= AnimationBinaryChannelFlag::kScales;
+				out.m_scaleIndex = scaleCount++;
+				out.m_scaleMin = minv;
+				out.m_scaleScale = (maxv - minv) / kQuantizationMax;
+
+				for(F32 v : values)
+				{
+					quantizedScales.emplaceBack(U16(round((v - minv) / (maxv - minv) * kQuantizationMax)));
+				}
+			}
+			else
+			{
+				out.m_scaleMin = values[0];
+				out.m_scaleScale = 0.0f;
+			}
+		}
+	}
+
+	// Interleave the channels in frames
+	const U32 frameSize = positionCount * 3 + rotationCount * 3 + scaleCount;
+	DynamicArrayRaii<U16> frames(m_pool, frameSize * frameCount);
+	U32 count = 0;
+	for(U32 f = 0; f < frameCount; ++f)
+	{
+		for(U32 i = 0; i < positionCount; ++i)
+		{
+			for(U16 v : quantizedPositions[i * frameCount + f])
+			{
+				frames[count++] = v;
+			}
+		}
+
+		for(U32 i = 0; i < rotationCount; ++i)
+		{
+			for(U16 v : quantizedRotations[i * frameCount + f])
+			{
+				frames[count++] = v;
+			}
+		}
+
+		for(U32 i = 0; i < scaleCount; ++i)
+		{
+			frames[count++] = quantizedScales[i * frameCount + f];
+		}
+	}
+	ANKI_ASSERT(count == frames.getSize());
+
+	// Write the file
+	AnimationBinaryHeader header;
+	memcpy(&header.m_magic[0], kAnimationMagic, sizeof(header.m_magic));
+	header.m_channelCount = outChannels.getSize();
+	header.m_namesSize = names.getSize();
+	header.m_frameCount = frameCount;
+	header.m_sampledPositionCount = positionCount;
+	header.m_sampledRotationCount = rotationCount;
+	header.m_sampledScaleCount = scaleCount;
+	header.m_startTime = F32(startTime);
+	header.m_frameRate = frameRate;
+
+	File file;
+	ANKI_CHECK(file.open(fname, FileOpenFlag::kWrite | FileOpenFlag::kBinary));
+	ANKI_CHECK(file.write(&header, sizeof(header)));
+	ANKI_CHECK(file.write(&outChannels[0], outChannels.getSizeInBytes()));
+	if(names.getSize())
+	{
+		ANKI_CHECK(file.write(&names[0], names.getSizeInBytes()));
+	}
+	if(frames.getSize())
+	{
+		ANKI_CHECK(file.write(&frames[0], frames.getSizeInBytes()));
+	}
+
+	ANKI_IMPORTER_LOGV("Animation compressed to %u frames of %u bytes", frameCount, U32(frameSize * sizeof(U16)));
+
+	return Error::kNone;
+}
+
 } // end namespace anki
@@ -0,0 +1,522 @@
+// Copyright (C) 2009-2022, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <AnKi/Importer/SceneConverter.h>
+#include <AnKi/Scene/SceneBinary.h>
+#include <AnKi/Util/File.h>
+#include <AnKi/Util/Serializer.h>
+#include <Lua/lua.hpp>
+#include <algorithm>
+
+namespace anki {
+
+static const Array<const Char*, U32(SceneBinaryNodeType::kCount)> kNodeTypeNames = {
+	"kModel",
+	"kStaticCollision",
+	"kPointLight",
+	"kSpotLight",
+	"kDirectionalLight",
+	"kReflectionProbe",
+	"kGlobalIlluminationProbe",
+	"kSkybox",
+	"kDecal",
+	"kParticleEmitter",
+	"kGpuParticleEmitter",
+	"kPerspectiveCamera"};
+
+static const Array<const Char*, U32(SceneBinaryPropertyType::kCount)> kPropertyTypeNames = {
+	"kModelResource",
+	"kSkeletonResource",
+	"kBodyMeshResource",
+	"kBodyWorldTransform",
+	"kParticleEmitterResource",
+	"kLightDiffuseColor",
+	"kLightRadius",
+	"kLightDistance",
+	"kLightInnerAngle",
+	"kLightOuterAngle",
+	"kLightShadowEnabled",
+	"kLightEvent",
+	"kLightEventFrequency",
+	"kLightEventIntensityMultiplier",
+	"kReflectionProbeBoxVolumeSize",
+	"kGlobalIlluminationProbeBoxVolumeSize",
+	"kGlobalIlluminationProbeCellSize",
+	"kGlobalIlluminationProbeFadeDistance",
+	"kSkyboxImage",
+	"kSkyboxSolidColor",
+	"kSkyboxMinFogDensity",
+	"kSkyboxMaxFogDensity",
+	"kSkyboxHeightOfMinFogDensity",
+	"kSkyboxHeightOfMaxFogDensity",
+	"kDecalDiffuse",
+	"kDecalSpecularRoughness",
+	"kDecalBoxVolumeSize",
+	"kLensFlareImage",
+	"kLensFlareFirstFlareSize",
+	"kLensFlareColorMultiplier",
+	"kPerspective"};
+
+/// It replaces the engine's bindings with functions that record what the level script does in the ankiScene table.
+/// Only the part of the bindings that the level scripts use is there. Everything else fails the conversion.
+static constexpr const char* kPrelude = R"(
+local N = SceneBinaryNodeType
+local P = SceneBinaryPropertyType
+local scene = {nodes = {}}
+ankiScene = scene
+
+local function num(x)
+	if type(x) == "boolean" then
+		return x and 1 or 0
+	end
+	return assert(tonumber(x), "Expecting a number")
+end
+
+local function nums(...)
+	local v = {}
+	for i = 1, select("#", ...) do
+		v[i] = num(select(i, ...))
+	end
+	return v
+end
+
+local function newVec(...)
+	return nums(...)
+end
+
+Vec2 = {new = newVec}
+Vec3 = {new = newVec}
+Vec4 = {new = newVec}
+
+Mat3x4 = {new = function()
+	local m = {1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0}
+	function m:setAll(...)
+		local v = nums(...)
+		for i = 1, 12 do
+			self[i] = v[i]
+		end
+	end
+	return m
+end}
+
+Transform = {new = function()
+	local t = {origin = {0, 0, 0}, rotation = Mat3x4.new(), scale = 1}
+	function t:setOrigin(v)
+		self.origin = {v[1], v[2], v[3]}
+	end
+	function t:setRotation(m)
+		self.rotation = {table.unpack(m, 1, 12)}
+	end
+	function t:setScale(s)
+		self.scale = num(s)
+	end
+	return t
+end}
+
+-- The origin, the rotation and the scale in a single array
+local function flattenTransform(t)
+	local f = {t.origin[1], t.origin[2], t.origin[3]}
+	for i = 1, 12 do
+		f[3 + i] = t.rotation[i]
+	end
+	f[16] = t.scale
+	return f
+end
+
+local function newComponents(node)
+	local function prop(type, p)
+		p.type = type
+		table.insert(node.props, p)
+	end
+
+	local function numSetter(type)
+		return function(self, ...)
+			prop(type, {v = nums(...)})
+		end
+	end
+
+	local function vecSetter(type)
+		return function(self, v)
+			prop(type, {v = nums(table.unpack(v))})
+		end
+	end
+
+	local function fileSetter(type)
+		return function(self, filename)
+			prop(type, {s0 = filename})
+		end
+	end
+
+	local function decalSetter(type)
+		return function(self, atlas, subtexture, blendFactor)
+			prop(type, {s0 = atlas, s1 = subtexture, v = {num(blendFactor)}})
+		end
+	end
+
+	local c = {}
+	c.model = {loadModelResource = fileSetter(P.kModelResource)}
+	c.skin = {loadSkeletonResource = fileSetter(P.kSkeletonResource)}
+	c.body = {loadMeshResource = fileSetter(P.kBodyMeshResource),
+		setWorldTransform = function(self, t)
+			prop(P.kBodyWorldTransform, {trf = flattenTransform(t)})
+		end}
+	c.particleEmitter = {loadParticleEmitterResource = fileSetter(P.kParticleEmitterResource)}
+	c.light = {setDiffuseColor = vecSetter(P.kLightDiffuseColor), setRadius = numSetter(P.kLightRadius),
+		setDistance = numSetter(P.kLightDistance), setInnerAngle = numSetter(P.kLightInnerAngle),
+		setOuterAngle = numSetter(P.kLightOuterAngle), setShadowEnabled = numSetter(P.kLightShadowEnabled)}
+	c.lensFlare = {loadImageResource = fileSetter(P.kLensFlareImage),
+		setFirstFlareSize = vecSetter(P.kLensFlareFirstFlareSize),
+		setColorMultiplier = vecSetter(P.kLensFlareColorMultiplier)}
+	c.reflectionProbe = {setBoxVolumeSize = vecSetter(P.kReflectionProbeBoxVolumeSize)}
+	c.giProbe = {setBoxVolumeSize = vecSetter(P.kGlobalIlluminationProbeBoxVolumeSize),
+		setCellSize = numSetter(P.kGlobalIlluminationProbeCellSize),
+		setFadeDistance = numSetter(P.kGlobalIlluminationProbeFadeDistance)}
+	c.skybox = {setImage = fileSetter(P.kSkyboxImage), setSolidColor = vecSetter(P.kSkyboxSolidColor),
+		setMinFogDensity = numSetter(P.kSkyboxMinFogDensity), setMaxFogDensity = numSetter(P.kSkyboxMaxFogDensity),
+		setHeightOfMinFogDensity = numSetter(P.kSkyboxHeightOfMinFogDensity),
+		setHeightOfMaxFogDensity = numSetter(P.kSkyboxHeightOfMaxFogDensity)}
+	c.decal = {setDiffuseDecal = decalSetter(P.kDecalDiffuse),
+		setSpecularRoughnessDecal = decalSetter(P.kDecalSpecularRoughness),
+		setBoxVolumeSize = vecSetter(P.kDecalBoxVolumeSize)}
+	c.frustum = {setPerspective = numSetter(P.kPerspective)}
+	c.move = {setLocalTransform = function(self, t)
+		node.trf = flattenTransform(t)
+	end}
+	return c
+end
+
+local function newNode(type, name)
+	local node = {type = type, name = name, props = {}, index = #scene.nodes + 1}
+	local c = newComponents(node)
+
+	function node:getSceneNodeBase() return self end
+	function node:getModelComponent() return c.model end
+	function node:getSkinComponent() return c.skin end
+	function node:getBodyComponent() return c.body end
+	function node:getParticleEmitterComponent() return c.particleEmitter end
+	function node:getGpuParticleEmitterComponent() return c.particleEmitter end
+	function node:getLightComponent() return c.light end
+	function node:getLensFlareComponent() return c.lensFlare end
+	function node:getReflectionProbeComponent() return c.reflectionProbe end
+	function node:getGlobalIlluminationProbeComponent() return c.giProbe end
+	function node:getSkyboxComponent() return c.skybox end
+	function node:getDecalComponent() return c.decal end
+	function node:getFrustumComponent() return c.frustum end
+	function node:getMoveComponent() return c.move end
+	function node:addChild(child)
+		child.parent = self.index
+	end
+
+	scene.nodes[node.index] = node
+	return node
+end
+
+local sceneGraph = {}
+function sceneGraph:newModelNode(name) return newNode(N.kModel, name) end
+function sceneGraph:newStaticCollisionNode(name) return newNode(N.kStaticCollision, name) end
+function sceneGraph:newPointLightNode(name) return newNode(N.kPointLight, name) end
+function sceneGraph:newSpotLightNode(name) return newNode(N.kSpotLight, name) end
+function sceneGraph:newDirectionalLightNode(name) return newNode(N.kDirectionalLight, name) end
+function sceneGraph:newReflectionProbeNode(name) return newNode(N.kReflectionProbe, name) end
+function sceneGraph:newGlobalIlluminationProbeNode(name) return newNode(N.kGlobalIlluminationProbe, name) end
+function sceneGraph:newSkyboxNode(name) return newNode(N.kSkybox, name) end
+function sceneGraph:newDecalNode(name) return newNode(N.kDecal, name) end
+function sceneGraph:newParticleEmitterNode(name) return newNode(N.kParticleEmitter, name) end
+function sceneGraph:newGpuParticleEmitterNode(name) return newNode(N.kGpuParticleEmitter, name) end
+function sceneGraph:newPerspectiveCameraNode(name) return newNode(N.kPerspectiveCamera, name) end
+
+function sceneGraph:setActiveCameraNode(node)
+	scene.camera = node.index
+end
+
+function sceneGraph:tryFindSceneNode(name)
+	for _, node in ipairs(scene.nodes) do
+		if node.name == name then
+			return node
+		end
+	end
+	return nil
+end
+
+function getSceneGraph()
+	return sceneGraph
+end
+
+local eventManager = {}
+function eventManager:newLightEvent(startTime, duration, node)
+	local function prop(type, v)
+		table.insert(node.props, {type = type, v = v})
+	end
+
+	prop(P.kLightEvent, {num(startTime), num(duration)})
+
+	local event = {}
+	function event:setFrequency(freq, deviation)
+		prop(P.kLightEventFrequency, {num(freq), num(deviation)})
+	end
+	function event:setIntensityMultiplier(v)
+		prop(P.kLightEventIntensityMultiplier, nums(table.unpack(v)))
+	end
+	return event
+end
+
+function getEventManager()
+	return eventManager
+end
+
+-- The loader multiplies with the real aspect ratio
+local mainRenderer = {}
+function mainRenderer:getAspectRatio()
+	return 1
+end
+
+function getMainRenderer()
+	return mainRenderer
+end
+)";
+
+/// The SceneBinary and the memory it points to.
+class SceneData
+{
+public:
+	HeapMemoryPool* m_pool;
+	DynamicArrayRaii<SceneBinaryNode> m_nodes = {m_pool};
+	DynamicArrayRaii<SceneBinaryProperty> m_properties = {m_pool};
+	DynamicArrayRaii<SceneBinaryTransform> m_transforms = {m_pool};
+	DynamicArrayRaii<Char> m_strings = {m_pool};
+	U32 m_activeCameraNode = kMaxU32;
+
+	SceneData(HeapMemoryPool* pool)
+		: m_pool(pool)
+	{
+	}
+};
+
+static void pushEnumTable(lua_State* l, const char* name, ConstWeakArray<const Char*> names)
+{
+	lua_newtable(l);
+	for(U32 i = 0; i < names.getSize(); ++i)
+	{
+		lua_pushnumber(l, lua_Number(i));
+		lua_setfield(l, -2, names[i]);
+	}
+	lua_setglobal(l, name);
+}
+
+/// Get a field of the table at the top of the stack. It returns kMaxU32 if the field is nil.
+static U32 getU32Field(lua_State* l, const char* name)
+{
+	lua_getfield(l, -1, name);
+	const U32 out = lua_isnil(l, -1) ? kMaxU32 : U32(lua_tonumber(l, -1));
+	lua_pop(l, 1);
+	return out;
+}
+
+/// Append a string field of the table at the top of the stack to the string table. It returns kMaxU32 if the field is
+/// nil.
+static U32 appendStringField(lua_State* l, const char* name, SceneData& data)
+{
+	lua_getfield(l, -1, name);
+	U32 out = kMaxU32;
+	if(!lua_isnil(l, -1))
+	{
+		const CString str = lua_tostring(l, -1);
+		out = data.m_strings.getSize();
+		for(Char c : str)
+		{
+			data.m_strings.emplaceBack(c);
+		}
+		data.m_strings.emplaceBack('\0');
+	}
+	lua_pop(l, 1);
+	return out;
+}
+
+/// Append a flattened transform field of the table at the top of the stack to the transforms. It returns kMaxU32 if the
+/// field is nil.
+static U32 appendTransformField(lua_State* l, const char* name, SceneData& data)
+{
+	lua_getfield(l, -1, name);
+	U32 out = kMaxU32;
+	if(!lua_isnil(l, -1))
+	{
+		Array<F32, 16> values;
+		for(U32 i = 0; i < values.getSize(); ++i)
+		{
+			lua_rawgeti(l, -1, I32(i + 1));
+			values[i] = F32(lua_tonumber(l, -1));
+			lua_pop(l, 1);
+		}
+
+		out = data.m_transforms.getSize();
+		SceneBinaryTransform& trf = *data.m_transforms.emplaceBack();
+		memcpy(&trf.m_origin[0], &values[0], sizeof(trf.m_origin));
+		memcpy(&trf.m_rotation[0], &values[3], sizeof(trf.m_rotation));
+		trf.m_scale = values[15];
+	}
+	lua_pop(l, 1);
+	return out;
+}
+
+/// Read the ankiScene table of the prelude.
+static Error readScene(lua_State* l, SceneData& data)
+{
+	lua_getglobal(l, "ankiScene");
+	lua_getfield(l, -1, "nodes");
+	const U32 nodeCount = U32(lua_rawlen(l, -1));
+
+	for(U32 i = 0; i < nodeCount; ++i)
+	{
+		lua_rawgeti(l, -1, I32(i + 1));
+
+		SceneBinaryNode& node = *data.m_nodes.emplaceBack();
+		node.m_type = SceneBinaryNodeType(getU32Field(l, "type"));
+		node.m_name = appendStringField(l, "name", data);
+		node.m_parent = getU32Field(l, "parent");
+		if(node.m_parent != kMaxU32)
+		{
+			--node.m_parent; // Lua indices start from 1
+		}
+		node.m_localTransform = appendTransformField(l, "trf", data);
+
+		lua_getfield(l, -1, "props");
+		node.m_firstProperty = data.m_properties.getSize();
+		node.m_propertyCount = U32(lua_rawlen(l, -1));
+		for(U32 p = 0; p < node.m_propertyCount; ++p)
+		{
+			lua_rawgeti(l, -1, I32(p + 1));
+
+			SceneBinaryProperty& prop = *data.m_properties.emplaceBack();
+			prop.m_type = SceneBinaryPropertyType(getU32Field(l, "type"));
+			prop.m_strings[0] = appendStringField(l, "s0", data);
+			prop.m_strings[1] = appendStringField(l, "s1", data);
+			prop.m_transform = appendTransformField(l, "trf", data);
+
+			memset(&prop.m_values[0], 0, sizeof(prop.m_values));
+			lua_getfield(l, -1, "v");
+			if(!lua_isnil(l, -1))
+			{
+				const U32 valueCount = min<U32>(U32(lua_rawlen(l, -1)), 4);
+				for(U32 v = 0; v < valueCount; ++v)
+				{
+					lua_rawgeti(l, -1, I32(v + 1));
+					prop.m_values[v] = F32(lua_tonumber(l, -1));
+					lua_pop(l, 1);
+				}
+			}
+			lua_pop(l, 2);
+		}
+		lua_pop(l, 2);
+	}
+	lua_pop(l, 1);
+
+	data.m_activeCameraNode = getU32Field(l, "camera");
+	if(data.m_activeCameraNode != kMaxU32)
+	{
+		--data.m_activeCameraNode;
+	}
+	lua_pop(l, 1);
+
+	return Error::kNone;
+}
+
+/// Put the nodes of the same type next to each other so the loader can create them in bulk.
+static void sortNodes(SceneData& data)
+{
+	const U32 nodeCount = data.m_nodes.getSize();
+	DynamicArrayRaii<U32> order(data.m_pool, nodeCount);
+	for(U32 i = 0; i < nodeCount; ++i)
+	{
+		order[i] = i;
+	}
+
+	std::stable_sort(order.getBegin(), order.getEnd(), [&](U32 a, U32 b) {
+		return data.m_nodes[a].m_type < data.m_nodes[b].m_type;
+	});
+
+	DynamicArrayRaii<U32> newIndices(data.m_pool, nodeCount);
+	for(U32 i = 0; i < nodeCount; ++i)
+	{
+		newIndices[order[i]] = i;
+	}
+
+	DynamicArrayRaii<SceneBinaryNode> nodes(data.m_pool);
+	DynamicArrayRaii<SceneBinaryProperty> properties(data.m_pool);
+	for(U32 i = 0; i < nodeCount; ++i)
+	{
+		SceneBinaryNode node = data.m_nodes[order[i]];
+		if(node.m_parent != kMaxU32)
+		{
+			node.m_parent = newIndices[node.m_parent];
+		}
+
+		const U32 firstProperty = properties.getSize();
+		for(U32 p = node.m_firstProperty; p < node.m_firstProperty + node.m_propertyCount; ++p)
+		{
+			properties.emplaceBack(data.m_properties[p]);
+		}
+		node.m_firstProperty = firstProperty;
+
+		nodes.emplaceBack(node);
+	}
+
+	data.m_nodes = std::move(nodes);
+	data.m_properties = std::move(properties);
+
+	if(data.m_activeCameraNode != kMaxU32)
+	{
+		data.m_activeCameraNode = newIndices[data.m_activeCameraNode];
+	}
+}
+
+Error convertScene(const SceneConverterConfig& config)
+{
+	const CString inputFname = config.m_inputFilename;
+	const CString outputFname = config.m_outFilename;
+	ANKI_ASSERT(inputFname && outputFname);
+
+	HeapMemoryPool pool(allocAligned, nullptr, "SceneConverterPool");
+
+	// Run the script
+	lua_State* l = luaL_newstate();
+	luaL_openlibs(l);
+	pushEnumTable(l, "SceneBinaryNodeType", ConstWeakArray<const Char*>(kNodeTypeNames));
+	pushEnumTable(l, "SceneBinaryPropertyType", ConstWeakArray<const Char*>(kPropertyTypeNames));
+
+	if(luaL_dostring(l, kPrelude) || luaL_dofile(l, inputFname.cstr()))
+	{
+		ANKI_IMPORTER_LOGE("Lua error: %s", lua_tostring(l, -1));
+		lua_close(l);
+		return Error::kUserData;
+	}
+
+	SceneData data(&pool);
+	const Error err = readScene(l, data);
+	lua_close(l);
+	ANKI_CHECK(err);
+
+	sortNodes(data);
+
+	// Write the binary
+	SceneBinary binary;
+	memcpy(&binary.m_magic[0], kSceneBinaryMagic, sizeof(binary.m_magic));
+	binary.m_nodes = WeakArray<SceneBinaryNode>(data.m_nodes);
+	binary.m_properties = WeakArray<SceneBinaryProperty>(data.m_properties);
+	binary.m_transforms = WeakArray<SceneBinaryTransform>(data.m_transforms);
+	binary.m_strings = WeakArray<Char>(data.m_strings);
+	binary.m_activeCameraNode = data.m_activeCameraNode;
+
+	File file;
+	ANKI_CHECK(file.open(outputFname, FileOpenFlag::kWrite | FileOpenFlag::kBinary));
+	BinarySerializer serializer;
+	ANKI_CHECK(serializer.serialize(binary, pool, file));
+
+	ANKI_IMPORTER_LOGI("Wrote %u nodes and %u properties to %s", data.m_nodes.getSize(),
+					   data.m_properties.getSize(), outputFname.cstr());
+
+	return Error::kNone;
+}
+
+} // end namespace anki
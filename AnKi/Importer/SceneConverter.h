@@ -0,0 +1,30 @@
+// Copyright (C) 2009-2022, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#pragma once
+
+#include <AnKi/Importer/Common.h>
+#include <AnKi/Util/String.h>
+
+namespace anki {
+
+/// @addtogroup importer
+/// @{
+
+/// Config for convertScene().
+/// @relates convertScene.
+class SceneConverterConfig
+{
+public:
+	CString m_inputFilename; ///< The level script.
+	CString m_outFilename; ///< The SceneBinary.
+};
+
+/// Converts a level script to a SceneBinary that the SceneBinaryLoader can load. The script runs against a stand-in of
+/// the scene bindings that records the nodes it creates.
+Error convertScene(const SceneConverterConfig& config);
+/// @}
+
+} // end namespace anki
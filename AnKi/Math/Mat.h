@@ -243,8 +243,13 @@ public:
 
 	ANKI_ENABLE_METHOD(kTRowCount == 3 && kTColumnCount == 4)
 	explicit constexpr TMat(const TTransform<T>& t)
-		: TMat(t.getOrigin().xyz(), t.getRotation().getRotationPart(), t.getScale())
 	{
+		// Work on whole rows to use SIMD if it's available
+		for(U i = 0; i < 3; i++)
+		{
+			m_rows[i] = t.getRotation().getRow(i) * t.getScale();
+			m_arr2[i][3] = t.getOrigin()[i];
+		}
 	}
 	/// @}
 
@@ -1235,6 +1240,75 @@ public:
 	}
 #endif
 
+	/// Get the inverse of an affine transformation that contains rotation, uniform scale and translation. It's way
+	/// faster than a generic inversion.
+	ANKI_ENABLE_METHOD(kTRowCount == 3 && kTColumnCount == 4 && !kHasSIMD)
+	TMat getInverseTransformation() const
+	{
+		const auto& m = *this;
+		const T invScale2 = T(1) / (m(0, 0) * m(0, 0) + m(1, 0) * m(1, 0) + m(2, 0) * m(2, 0));
+
+		TMat out;
+		for(U j = 0; j < 3; j++)
+		{
+			for(U i = 0; i < 3; i++)
+			{
+				out(j, i) = m(i, j) * invScale2;
+			}
+		}
+
+		for(U j = 0; j < 3; j++)
+		{
+			out(j, 3) = -(out(j, 0) * m(0, 3) + out(j, 1) * m(1, 3) + out(j, 2) * m(2, 3));
+		}
+
+		return out;
+	}
+
+#if ANKI_ENABLE_SIMD
+	ANKI_ENABLE_METHOD(kTRowCount == 3 && kTColumnCount == 4 && kHasSIMD)
+	TMat getInverseTransformation() const
+	{
+		TMat out;
+#	if ANKI_SIMD_SSE
+		// After the transpose c0, c1, c2 hold the columns of the rotation part (with w=0) and t the translation
+		__m128 c0 = m_simd[0];
+		__m128 c1 = m_simd[1];
+		__m128 c2 = m_simd[2];
+		__m128 t = _mm_setzero_ps();
+		_MM_TRANSPOSE4_PS(c0, c1, c2, t);
+
+		const __m128 invScale2 = _mm_div_ps(_mm_set1_ps(1.0f), _mm_dp_ps(c0, c0, 0x7F));
+		c0 = _mm_mul_ps(c0, invScale2);
+		c1 = _mm_mul_ps(c1, invScale2);
+		c2 = _mm_mul_ps(c2, invScale2);
+
+		// The new translation is -(R^T * t). Compute the dot products and store them in the w
+		t = _mm_sub_ps(_mm_setzero_ps(), t);
+		out.m_simd[0] = _mm_blend_ps(c0, _mm_dp_ps(c0, t, 0x78), 0x8);
+		out.m_simd[1] = _mm_blend_ps(c1, _mm_dp_ps(c1, t, 0x78), 0x8);
+		out.m_simd[2] = _mm_blend_ps(c2, _mm_dp_ps(c2, t, 0x78), 0x8);
+#	else
+		const float32x4x2_t row01 = vtrnq_f32(m_simd[0], m_simd[1]);
+		const float32x4x2_t row23 = vtrnq_f32(m_simd[2], vdupq_n_f32(0.0f));
+		float32x4_t c0 = vcombine_f32(vget_low_f32(row01.val[0]), vget_low_f32(row23.val[0]));
+		float32x4_t c1 = vcombine_f32(vget_low_f32(row01.val[1]), vget_low_f32(row23.val[1]));
+		float32x4_t c2 = vcombine_f32(vget_high_f32(row01.val[0]), vget_high_f32(row23.val[0]));
+		const float32x4_t t = vcombine_f32(vget_high_f32(row01.val[1]), vget_high_f32(row23.val[1]));
+
+		const float32x4_t invScale2 = vdupq_n_f32(1.0f / RowVec(c0).dot(RowVec(c0)));
+		c0 *= invScale2;
+		c1 *= invScale2;
+		c2 *= invScale2;
+
+		out.m_simd[0] = vsetq_lane_f32(-RowVec(c0).dot(RowVec(t)), c0, 3);
+		out.m_simd[1] = vsetq_lane_f32(-RowVec(c1).dot(RowVec(t)), c1, 3);
+		out.m_simd[2] = vsetq_lane_f32(-RowVec(c2).dot(RowVec(t)), c2, 3);
+#	endif
+		return out;
+	}
+#endif
+
 	/// Calculate a perspective projection matrix. The z is mapped in [0, 1] range just like DX and Vulkan.
 	ANKI_ENABLE_METHOD(kTColumnCount == 4 && kTRowCount == 4)
 	[[nodiscard]] static TMat calculatePerspectiveProjectionMatrix(T fovX, T fovY, T near, T far)
@@ -1360,8 +1434,9 @@ public:
 		return TMat(invertedTsl.xyz0(), invertedRot);
 	}
 
+	/// Transform a point. Works for Mat4 and Mat3x4.
 	/// @note 9 muls, 9 adds
-	ANKI_ENABLE_METHOD(kTColumnCount == 4 && kTRowCount == 4)
+	ANKI_ENABLE_METHOD(kTColumnCount == 4)
 	TVec<T, 3> transform(const TVec<T, 3>& v) const
 	{
 		const auto& m = *this;
@@ -1370,6 +1445,17 @@ public:
 						  m(2, 0) * v.x() + m(2, 1) * v.y() + m(2, 2) * v.z() + m(2, 3));
 	}
 
+	/// Transform a direction. It ignores the translation. Works for Mat4 and Mat3x4.
+	/// @note 9 muls, 6 adds
+	ANKI_ENABLE_METHOD(kTColumnCount == 4)
+	TVec<T, 3> transformVector(const TVec<T, 3>& v) const
+	{
+		const auto& m = *this;
+		return TVec<T, 3>(m(0, 0) * v.x() + m(0, 1) * v.y() + m(0, 2) * v.z(),
+						  m(1, 0) * v.x() + m(1, 1) * v.y() + m(1, 2) * v.z(),
+						  m(2, 0) * v.x() + m(2, 1) * v.y() + m(2, 2) * v.z());
+	}
+
 	/// Create a new transform matrix position at eye and looking at refPoint.
 	template<U VEC_DIMS, ANKI_ENABLE(kTRowCount == 3 && kTColumnCount == 4 && VEC_DIMS >= 3)>
 	static TMat lookAt(const TVec<T, VEC_DIMS>& eye, const TVec<T, VEC_DIMS>& refPoint, const TVec<T, VEC_DIMS>& up)
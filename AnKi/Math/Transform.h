@@ -202,7 +202,13 @@ public:
 	TVec<T, 3> transform(const TVec<T, 3>& b) const
 	{
 		checkW();
-		return (m_rotation.getRotationPart() * (b * m_scale)) + m_origin.xyz();
+		return m_rotation.transformVector(b * m_scale) + m_origin.xyz();
+	}
+
+	/// Transform a direction. The origin is ignored.
+	TVec<T, 3> transformVector(const TVec<T, 3>& b) const
+	{
+		return m_rotation.transformVector(b * m_scale);
 	}
 
 	/// Transform a TVec4. SIMD optimized
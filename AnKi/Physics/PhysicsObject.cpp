@@ -10,19 +10,10 @@ namespace anki {
 
 PhysicsFilteredObject::~PhysicsFilteredObject()
 {
-	for(PhysicsTriggerFilteredPair* pair : m_triggerFilteredPairs)
+	// The triggers will delete the pairs the next time they process their contacts
+	while(!m_triggerFilteredPairs.isEmpty())
 	{
-		if(pair == nullptr)
-		{
-			continue;
-		}
-
-		pair->m_filteredObject = nullptr;
-
-		if(pair->shouldDelete())
-		{
-			deleteInstance(getMemoryPool(), pair);
-		}
+		getWorld().unlinkPhysicsTriggerFilteredPair(m_triggerFilteredPairs.getFront());
 	}
 }
 
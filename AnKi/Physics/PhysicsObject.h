@@ -123,23 +123,13 @@ public:
 	virtual Bool needsCollision(const PhysicsFilteredObject& a, const PhysicsFilteredObject& b) = 0;
 };
 
-/// A pair of a trigger and a filtered object.
-class PhysicsTriggerFilteredPair
+/// A trigger and a filtered object that touch. The PhysicsWorld owns it and finds it with a hash map.
+class PhysicsTriggerFilteredPair : public IntrusiveListEnabled<PhysicsTriggerFilteredPair>
 {
 public:
-	PhysicsFilteredObject* m_filteredObject = nullptr;
+	PhysicsFilteredObject* m_filteredObject = nullptr; ///< It's nullptr if the object died while inside the trigger.
 	PhysicsTrigger* m_trigger = nullptr;
-	U64 m_frame = 0;
-
-	Bool isAlive() const
-	{
-		return m_filteredObject && m_trigger;
-	}
-
-	Bool shouldDelete() const
-	{
-		return m_filteredObject == nullptr && m_trigger == nullptr;
-	}
+	U64 m_generation = 0; ///< The PhysicsTrigger::processContacts() that last saw the contact.
 };
 
 /// A PhysicsObject that takes part into collision detection. Has functionality to filter the broad phase detection.
@@ -203,8 +193,7 @@ private:
 
 	PhysicsBroadPhaseFilterCallback* m_filter = nullptr;
 
-	static constexpr U32 kMaxTriggerFilteredPairs = 4;
-	Array<PhysicsTriggerFilteredPair*, kMaxTriggerFilteredPairs> m_triggerFilteredPairs = {};
+	IntrusiveList<PhysicsTriggerFilteredPair> m_triggerFilteredPairs; ///< The triggers the object is inside.
 };
 /// @}
 
@@ -30,20 +30,7 @@ PhysicsTrigger::PhysicsTrigger(PhysicsWorld* world, PhysicsCollisionShapePtr sha
 
 PhysicsTrigger::~PhysicsTrigger()
 {
-	for(PhysicsTriggerFilteredPair* pair : m_pairs)
-	{
-		ANKI_ASSERT(pair);
-
-		pair->m_trigger = nullptr;
-
-		if(pair->shouldDelete())
-		{
-			deleteInstance(getMemoryPool(), pair);
-		}
-	}
-
-	m_pairs.destroy(getMemoryPool());
-
+	destroyPairs();
 	m_ghostShape.destroy();
 }
 
@@ -57,17 +44,28 @@ void PhysicsTrigger::unregisterFromWorld()
 	getWorld().getBtWorld().removeCollisionObject(m_ghostShape.get());
 }
 
+void PhysicsTrigger::destroyPairs()
+{
+	for(PhysicsTriggerFilteredPair* pair : m_pairs)
+	{
+		ANKI_ASSERT(pair->m_trigger == this);
+		getWorld().destroyPhysicsTriggerFilteredPair(pair);
+	}
+
+	m_pairs.destroy(getMemoryPool());
+}
+
 void PhysicsTrigger::processContacts()
 {
-	++m_processContactsFrame;
+	++m_generation;
 
 	if(m_contactCallback == nullptr)
 	{
-		m_pairs.destroy(getMemoryPool());
+		destroyPairs();
 		return;
 	}
 
-	// Gather the new pairs
+	// Gather the pairs of the current contacts. The world finds them with a hash map so this is linear to the contacts
 	DynamicArrayRaii<PhysicsTriggerFilteredPair*> newPairs(&getWorld().getTempMemoryPool());
 	newPairs.resizeStorage(m_ghostShape->getOverlappingPairs().size());
 	for(U32 i = 0; i < U32(m_ghostShape->getOverlappingPairs().size()); ++i)
@@ -82,7 +80,7 @@ void PhysicsTrigger::processContacts()
 		PhysicsTriggerFilteredPair* pair = getWorld().getOrCreatePhysicsTriggerFilteredPair(this, obj, isNew);
 		if(pair)
 		{
-			ANKI_ASSERT(pair->isAlive());
+			ANKI_ASSERT(pair->m_trigger == this && pair->m_filteredObject == obj);
 			newPairs.emplaceBack(pair);
 
 			if(isNew)
@@ -94,33 +92,32 @@ void PhysicsTrigger::processContacts()
 				m_contactCallback->onTriggerInside(*this, *obj);
 			}
 
-			pair->m_frame = m_processContactsFrame;
+			pair->m_generation = m_generation;
 		}
 	}
 
-	// Remove stale pairs
-	for(U32 i = 0; i < m_pairs.getSize(); ++i)
+	// The old pairs that didn't get the new generation stopped touching
+	for(PhysicsTriggerFilteredPair* pair : m_pairs)
 	{
-		PhysicsTriggerFilteredPair* pair = m_pairs[i];
 		ANKI_ASSERT(pair->m_trigger == this);
 
-		if(pair->m_filteredObject == nullptr)
+		if(pair->m_generation == m_generation)
 		{
-			// Filtered object died while inside the tigger, destroy the pair
-			deleteInstance(getMemoryPool(), pair);
+			// Still touching
+			continue;
 		}
-		else if(pair->m_frame == m_processContactsFrame)
+
+		ANKI_ASSERT(pair->m_generation < m_generation);
+		if(pair->m_filteredObject)
 		{
-			// Was updated this frame so don't touch it
+			m_contactCallback->onTriggerExit(*this, *pair->m_filteredObject);
 		}
 		else
 		{
-			// Was updated in some previous frame, notify and brake the link to the pair
-			ANKI_ASSERT(pair->isAlive());
-			ANKI_ASSERT(pair->m_frame < m_processContactsFrame);
-			m_contactCallback->onTriggerExit(*this, *pair->m_filteredObject);
-			pair->m_trigger = nullptr;
+			// Filtered object died while inside the trigger, don't notify
 		}
+
+		getWorld().destroyPhysicsTriggerFilteredPair(pair);
 	}
 
 	// Store the new contacts
@@ -61,11 +61,11 @@ private:
 	PhysicsCollisionShapePtr m_shape;
 	ClassWrapper<btGhostObject> m_ghostShape;
 
-	DynamicArray<PhysicsTriggerFilteredPair*> m_pairs;
+	DynamicArray<PhysicsTriggerFilteredPair*> m_pairs; ///< The contacts of the last processContacts().
 
 	PhysicsTriggerProcessContactCallback* m_contactCallback = nullptr;
 
-	U64 m_processContactsFrame = 0;
+	U64 m_generation = 0; ///< Incremented on every processContacts().
 
 	PhysicsTrigger(PhysicsWorld* world, PhysicsCollisionShapePtr shape);
 
@@ -76,6 +76,8 @@ private:
 	void unregisterFromWorld() override;
 
 	void processContacts();
+
+	void destroyPairs();
 };
 /// @}
 
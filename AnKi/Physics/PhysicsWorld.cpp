@@ -139,6 +139,18 @@ public:
 	}
 };
 
+class PhysicsWorld::TriggerFilteredPairKey
+{
+public:
+	PhysicsTrigger* m_trigger;
+	PhysicsFilteredObject* m_filteredObject;
+
+	U64 computeHash() const
+	{
+		return anki::computeHash(this, sizeof(*this));
+	}
+};
+
 PhysicsWorld::PhysicsWorld()
 {
 }
@@ -148,6 +160,8 @@ PhysicsWorld::~PhysicsWorld()
 	destroyMarkedForDeletion();
 
 	ANKI_ASSERT(m_objectsCreatedCount.load() == 0 && "Forgot to delete some objects");
+	ANKI_ASSERT(m_triggerFilteredPairs.isEmpty());
+	m_triggerFilteredPairs.destroy(m_pool);
 
 	m_world.destroy();
 	m_solver.destroy();
@@ -279,9 +293,12 @@ void PhysicsWorld::destroyObject(PhysicsObject* obj)
 
 void PhysicsWorld::rayCast(WeakArray<PhysicsWorldRayCastCallback*> rayCasts) const
 {
-	MyRaycastCallback callback;
+	LockGuard<Mutex> lock(m_rayCastMtx);
+
 	for(PhysicsWorldRayCastCallback* cb : rayCasts)
 	{
+		// A new callback per ray because Bullet clips the ray using the closest hit fraction of the callback
+		MyRaycastCallback callback;
 		callback.m_raycast = cb;
 		m_world->rayTest(toBt(cb->m_from), toBt(cb->m_to), callback);
 	}
@@ -293,52 +310,63 @@ PhysicsTriggerFilteredPair* PhysicsWorld::getOrCreatePhysicsTriggerFilteredPair(
 {
 	ANKI_ASSERT(trigger && filtered);
 
-	U32 emptySlot = kMaxU32;
-	for(U32 i = 0; i < filtered->m_triggerFilteredPairs.getSize(); ++i)
-	{
-		PhysicsTriggerFilteredPair* pair = filtered->m_triggerFilteredPairs[i];
+	TriggerFilteredPairKey key;
+	key.m_trigger = trigger;
+	key.m_filteredObject = filtered;
 
-		if(pair && pair->m_trigger == trigger)
-		{
-			// Found it
-			ANKI_ASSERT(pair->m_filteredObject == filtered);
-			isNew = false;
-			return pair;
-		}
-		else if(pair == nullptr)
-		{
-			// Empty slot, save it for later
-			emptySlot = i;
-		}
-		else if(pair && pair->m_trigger == nullptr)
+	auto it = m_triggerFilteredPairs.find(key);
+	if(it != m_triggerFilteredPairs.getEnd())
+	{
+		PhysicsTriggerFilteredPair* pair = *it;
+		if(pair->m_trigger != trigger || pair->m_filteredObject != filtered)
 		{
-			// Pair exists but it's invalid, repurpose it
-			ANKI_ASSERT(pair->m_filteredObject == filtered);
-			emptySlot = i;
+			ANKI_PHYS_LOGW("Contact ignored. Another trigger-object pair has the same hash");
+			return nullptr;
 		}
-	}
 
-	if(emptySlot == kMaxU32)
-	{
-		ANKI_PHYS_LOGW("Contact ignored. Too many active contacts for the filtered object");
-		return nullptr;
+		isNew = false;
+		return pair;
 	}
 
 	// Not found, create a new one
 	isNew = true;
 
-	PhysicsTriggerFilteredPair* newPair;
-	if(filtered->m_triggerFilteredPairs[emptySlot] == nullptr)
-	{
-		filtered->m_triggerFilteredPairs[emptySlot] = anki::newInstance<PhysicsTriggerFilteredPair>(m_pool);
-	}
-	newPair = filtered->m_triggerFilteredPairs[emptySlot];
-
+	PhysicsTriggerFilteredPair* newPair = anki::newInstance<PhysicsTriggerFilteredPair>(m_pool);
 	newPair->m_filteredObject = filtered;
 	newPair->m_trigger = trigger;
-	newPair->m_frame = 0;
+
+	m_triggerFilteredPairs.emplace(m_pool, key, newPair);
+	filtered->m_triggerFilteredPairs.pushBack(newPair);
 
 	return newPair;
 }
 
+void PhysicsWorld::destroyPhysicsTriggerFilteredPair(PhysicsTriggerFilteredPair* pair)
+{
+	ANKI_ASSERT(pair && pair->m_trigger);
+
+	if(pair->m_filteredObject)
+	{
+		unlinkPhysicsTriggerFilteredPair(*pair);
+	}
+
+	deleteInstance(m_pool, pair);
+}
+
+void PhysicsWorld::unlinkPhysicsTriggerFilteredPair(PhysicsTriggerFilteredPair& pair)
+{
+	ANKI_ASSERT(pair.m_filteredObject && pair.m_trigger);
+
+	TriggerFilteredPairKey key;
+	key.m_trigger = pair.m_trigger;
+	key.m_filteredObject = pair.m_filteredObject;
+
+	auto it = m_triggerFilteredPairs.find(key);
+	ANKI_ASSERT(it != m_triggerFilteredPairs.getEnd() && *it == &pair);
+	m_triggerFilteredPairs.erase(m_pool, it);
+
+	pair.m_filteredObject->m_triggerFilteredPairs.erase(&pair);
+	pair.m_filteredObject = nullptr;
+}
+
 } // end namespace anki
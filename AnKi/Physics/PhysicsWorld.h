@@ -8,6 +8,7 @@
 #include <AnKi/Physics/Common.h>
 #include <AnKi/Physics/PhysicsObject.h>
 #include <AnKi/Util/List.h>
+#include <AnKi/Util/HashMap.h>
 #include <AnKi/Util/WeakArray.h>
 #include <AnKi/Util/ClassWrapper.h>
 
@@ -74,6 +75,7 @@ public:
 		return m_tmpPool;
 	}
 
+	/// Cast a batch of rays. It's thread-safe.
 	void rayCast(WeakArray<PhysicsWorldRayCastCallback*> rayCasts) const;
 
 	void rayCast(PhysicsWorldRayCastCallback& raycast) const
@@ -100,12 +102,20 @@ public:
 
 	ANKI_INTERNAL void destroyObject(PhysicsObject* obj);
 
+	/// Find the pair of a trigger and a filtered object or create a new one if they didn't touch.
 	ANKI_INTERNAL PhysicsTriggerFilteredPair*
 	getOrCreatePhysicsTriggerFilteredPair(PhysicsTrigger* trigger, PhysicsFilteredObject* filtered, Bool& isNew);
 
+	/// Delete a pair that getOrCreatePhysicsTriggerFilteredPair() returned.
+	ANKI_INTERNAL void destroyPhysicsTriggerFilteredPair(PhysicsTriggerFilteredPair* pair);
+
+	/// Detach a pair from its filtered object because the object dies. The trigger deletes the pair later.
+	ANKI_INTERNAL void unlinkPhysicsTriggerFilteredPair(PhysicsTriggerFilteredPair& pair);
+
 private:
 	class MyOverlapFilterCallback;
 	class MyRaycastCallback;
+	class TriggerFilteredPairKey;
 
 	HeapMemoryPool m_pool;
 	StackMemoryPool m_tmpPool;
@@ -124,6 +134,10 @@ private:
 	IntrusiveList<PhysicsObject> m_markedForDeletion;
 	Mutex m_markedMtx; ///< Locks the above
 
+	mutable Mutex m_rayCastMtx; ///< The ray tests of the broadphase share a stack.
+
+	HashMap<TriggerFilteredPairKey, PhysicsTriggerFilteredPair*> m_triggerFilteredPairs;
+
 #if ANKI_ENABLE_ASSERTIONS
 	Atomic<I32> m_objectsCreatedCount = {0};
 #endif
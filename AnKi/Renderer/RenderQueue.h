@@ -68,6 +68,23 @@ public:
 	RenderableQueueElement()
 	{
 	}
+
+	/// Key that sorts front to back. The bits of positive floats sort the same way the floats do.
+	U32 computeDistanceSortKey() const
+	{
+		ANKI_ASSERT(m_distanceFromCamera >= 0.0f);
+		return floatBitsToUint(m_distanceFromCamera);
+	}
+
+	/// Key that sorts by LOD, then by m_mergeKey and then front to back using a quantized distance. The merge key is
+	/// folded to fit so different merge keys might interleave. That only costs some merging.
+	U64 computeMaterialSortKey() const
+	{
+		ANKI_ASSERT(m_lod < 4);
+		constexpr U64 kMergeKeyMask = (1_U64 << 46) - 1;
+		const U64 mergeKey = (m_mergeKey ^ (m_mergeKey >> 46)) & kMergeKeyMask;
+		return (U64(m_lod) << 62) | (mergeKey << 16) | U64(computeDistanceSortKey() >> 16);
+	}
 };
 
 static_assert(std::is_trivially_destructible<RenderableQueueElement>::value == true,
@@ -0,0 +1,207 @@
+// Copyright (C) 2009-2022, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+// WARNING: This file is auto generated.
+
+#pragma once
+
+#include <AnKi/Resource/Common.h>
+#include <AnKi/Math.h>
+
+namespace anki {
+
+/// @addtogroup resource
+/// @{
+
+inline constexpr const Char* kAnimationMagic = "ANKIANI1";
+
+/// The max value of a quantized rotation component.
+inline constexpr U32 kAnimationRotationQuantizationMax = (1u << 15u) - 1u;
+
+/// The 3 smallest components of a normalized quaternion are in the [-1/sqrt(2), 1/sqrt(2)] range.
+inline constexpr F32 kAnimationRotationComponentMax = 0.70710678118f;
+
+/// @memberof AnimationBinaryChannel
+enum class AnimationBinaryChannelFlag : U32
+{
+	kNone = 0,
+	kPositions = 1 << 0, ///< The positions are sampled in every frame.
+	kRotations = 1 << 1, ///< The rotations are sampled in every frame.
+	kScales = 1 << 2, ///< The scales are sampled in every frame.
+
+	kAll = kPositions | kRotations | kScales,
+};
+ANKI_ENUM_ALLOW_NUMERIC_OPERATIONS(AnimationBinaryChannelFlag)
+
+/// Quantize a rotation using the smallest three method. The largest component is dropped and the rest are quantized to
+/// 15 bits. The index of the dropped component is stored in the top bits of the 1st and the 2nd words.
+inline Array<U16, 3> packAnimationRotation(Quat q)
+{
+	U32 largest = 0;
+	for(U32 i = 1; i < 4; ++i)
+	{
+		largest = (absolute(q[i]) > absolute(q[largest])) ? i : largest;
+	}
+
+	// q and -q are the same rotation. Make the dropped component positive so it can be reconstructed
+	q = (q[largest] < 0.0f) ? Quat(-q) : q;
+
+	Array<U16, 3> out;
+	U32 count = 0;
+	for(U32 i = 0; i < 4; ++i)
+	{
+		if(i != largest)
+		{
+			const F32 f = clamp(q[i] * kAnimationRotationComponentMax + 0.5f, 0.0f, 1.0f);
+			out[count++] = U16(round(f * F32(kAnimationRotationQuantizationMax)));
+		}
+	}
+
+	out[0] = U16(out[0] | ((largest & 1u) << 15u));
+	out[1] = U16(out[1] | ((largest >> 1u) << 15u));
+	return out;
+}
+
+/// The opposite of packAnimationRotation.
+inline Quat unpackAnimationRotation(const U16* packed)
+{
+	const U32 largest = (packed[0] >> 15u) | ((packed[1] >> 15u) << 1u);
+
+	constexpr F32 kScale = 2.0f * kAnimationRotationComponentMax / F32(kAnimationRotationQuantizationMax);
+	const Vec3 smallest = Vec3(F32(packed[0] & kAnimationRotationQuantizationMax),
+							   F32(packed[1] & kAnimationRotationQuantizationMax),
+							   F32(packed[2] & kAnimationRotationQuantizationMax))
+							  * kScale
+						  - kAnimationRotationComponentMax;
+	const F32 dropped = sqrt(max(0.0f, 1.0f - smallest.dot(smallest)));
+
+	Quat out;
+	U32 count = 0;
+	for(U32 i = 0; i < 4; ++i)
+	{
+		out[i] = (i == largest) ? dropped : smallest[count++];
+	}
+
+	return out;
+}
+
+/// The description of an animation channel.
+class AnimationBinaryChannel
+{
+public:
+	/// Offset in the names that follow the channels.
+	U32 m_nameOffset;
+
+	U32 m_nameLength;
+	AnimationBinaryChannelFlag m_flags;
+
+	/// The index of the position in a frame. Valid if the positions are sampled.
+	U32 m_positionIndex;
+
+	/// The index of the rotation in a frame. Valid if the rotations are sampled.
+	U32 m_rotationIndex;
+
+	/// The index of the scale in a frame. Valid if the scales are sampled.
+	U32 m_scaleIndex;
+
+	/// The dequantized position is m_positionMin + quantized * m_positionScale. If the positions are not sampled it's
+	/// the constant position.
+	Vec3 m_positionMin;
+
+	Vec3 m_positionScale;
+
+	/// The constant rotation if the rotations are not sampled.
+	Quat m_rotation;
+
+	/// Same as m_positionMin but for scale.
+	F32 m_scaleMin;
+
+	F32 m_scaleScale;
+
+	template<typename TSerializer, typename TClass>
+	static void serializeCommon(TSerializer& s, TClass self)
+	{
+		s.doValue("m_nameOffset", offsetof(AnimationBinaryChannel, m_nameOffset), self.m_nameOffset);
+		s.doValue("m_nameLength", offsetof(AnimationBinaryChannel, m_nameLength), self.m_nameLength);
+		s.doValue("m_flags", offsetof(AnimationBinaryChannel, m_flags), self.m_flags);
+		s.doValue("m_positionIndex", offsetof(AnimationBinaryChannel, m_positionIndex), self.m_positionIndex);
+		s.doValue("m_rotationIndex", offsetof(AnimationBinaryChannel, m_rotationIndex), self.m_rotationIndex);
+		s.doValue("m_scaleIndex", offsetof(AnimationBinaryChannel, m_scaleIndex), self.m_scaleIndex);
+		s.doValue("m_positionMin", offsetof(AnimationBinaryChannel, m_positionMin), self.m_positionMin);
+		s.doValue("m_positionScale", offsetof(AnimationBinaryChannel, m_positionScale), self.m_positionScale);
+		s.doValue("m_rotation", offsetof(AnimationBinaryChannel, m_rotation), self.m_rotation);
+		s.doValue("m_scaleMin", offsetof(AnimationBinaryChannel, m_scaleMin), self.m_scaleMin);
+		s.doValue("m_scaleScale", offsetof(AnimationBinaryChannel, m_scaleScale), self.m_scaleScale);
+	}
+
+	template<typename TDeserializer>
+	void deserialize(TDeserializer& deserializer)
+	{
+		serializeCommon<TDeserializer, AnimationBinaryChannel&>(deserializer, *this);
+	}
+
+	template<typename TSerializer>
+	void serialize(TSerializer& serializer) const
+	{
+		serializeCommon<TSerializer, const AnimationBinaryChannel&>(serializer, *this);
+	}
+};
+
+/// The 1st thing that appears in an animation binary. It's followed by the AnimationBinaryChannel array, then the
+/// channel names and then the frames. A frame contains 3 U16 for every sampled position, 3 U16 for every sampled
+/// rotation and 1 U16 for every sampled scale.
+class AnimationBinaryHeader
+{
+public:
+	Array<U8, 8> m_magic;
+	U32 m_channelCount;
+
+	/// The size of the channel names in bytes.
+	U32 m_namesSize;
+
+	U32 m_frameCount;
+	U32 m_sampledPositionCount;
+	U32 m_sampledRotationCount;
+	U32 m_sampledScaleCount;
+
+	/// The time of the 1st frame.
+	F32 m_startTime;
+
+	/// Frames per second.
+	F32 m_frameRate;
+
+	template<typename TSerializer, typename TClass>
+	static void serializeCommon(TSerializer& s, TClass self)
+	{
+		s.doArray("m_magic", offsetof(AnimationBinaryHeader, m_magic), &self.m_magic[0], self.m_magic.getSize());
+		s.doValue("m_channelCount", offsetof(AnimationBinaryHeader, m_channelCount), self.m_channelCount);
+		s.doValue("m_namesSize", offsetof(AnimationBinaryHeader, m_namesSize), self.m_namesSize);
+		s.doValue("m_frameCount", offsetof(AnimationBinaryHeader, m_frameCount), self.m_frameCount);
+		s.doValue("m_sampledPositionCount", offsetof(AnimationBinaryHeader, m_sampledPositionCount),
+				  self.m_sampledPositionCount);
+		s.doValue("m_sampledRotationCount", offsetof(AnimationBinaryHeader, m_sampledRotationCount),
+				  self.m_sampledRotationCount);
+		s.doValue("m_sampledScaleCount", offsetof(AnimationBinaryHeader, m_sampledScaleCount),
+				  self.m_sampledScaleCount);
+		s.doValue("m_startTime", offsetof(AnimationBinaryHeader, m_startTime), self.m_startTime);
+		s.doValue("m_frameRate", offsetof(AnimationBinaryHeader, m_frameRate), self.m_frameRate);
+	}
+
+	template<typename TDeserializer>
+	void deserialize(TDeserializer& deserializer)
+	{
+		serializeCommon<TDeserializer, AnimationBinaryHeader&>(deserializer, *this);
+	}
+
+	template<typename TSerializer>
+	void serialize(TSerializer& serializer) const
+	{
+		serializeCommon<TSerializer, const AnimationBinaryHeader&>(serializer, *this);
+	}
+};
+
+/// @}
+
+} // end namespace anki
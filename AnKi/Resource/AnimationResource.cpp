@@ -4,7 +4,10 @@
 // http://www.anki3d.org/LICENSE
 
 #include <AnKi/Resource/AnimationResource.h>
+#include <AnKi/Resource/AnimationBinary.h>
+#include <AnKi/Resource/ResourceFilesystem.h>
 #include <AnKi/Util/Xml.h>
+#include <algorithm>
 
 namespace anki {
 
@@ -21,10 +24,30 @@ AnimationResource::~AnimationResource()
 	}
 
 	m_channels.destroy(getMemoryPool());
+	m_binaryChannels.destroy(getMemoryPool());
+	m_frames.destroy(getMemoryPool());
 }
 
 Error AnimationResource::load(const ResourceFilename& filename, [[maybe_unused]] Bool async)
 {
+	// Check if it's a binary
+	{
+		ResourceFilePtr file;
+		ANKI_CHECK(openFile(filename, file));
+
+		Array<U8, 8> magic = {};
+		if(file->getSize() >= sizeof(AnimationBinaryHeader))
+		{
+			ANKI_CHECK(file->read(&magic[0], sizeof(magic)));
+		}
+
+		if(memcmp(&magic[0], kAnimationMagic, sizeof(magic)) == 0)
+		{
+			ANKI_CHECK(file->seek(0, FileSeekOrigin::kBeginning));
+			return loadBinary(*file);
+		}
+	}
+
 	XmlElement el;
 
 	m_startTime = kMaxSecond;
@@ -202,75 +225,259 @@ Error AnimationResource::load(const ResourceFilename& filename, [[maybe_unused]]
 	return Error::kNone;
 }
 
-void AnimationResource::interpolate(U32 channelIndex, Second time, Vec3& pos, Quat& rot, F32& scale) const
+Error AnimationResource::loadBinary(ResourceFile& file)
 {
-	pos = Vec3(0.0f);
-	rot = Quat::getIdentity();
-	scale = 1.0f;
+	AnimationBinaryHeader header;
+	ANKI_CHECK(file.read(&header, sizeof(header)));
+
+	if(memcmp(&header.m_magic[0], kAnimationMagic, sizeof(header.m_magic)) != 0 || header.m_channelCount == 0
+	   || header.m_frameCount == 0 || (header.m_frameCount > 1 && header.m_frameRate <= 0.0f))
+	{
+		ANKI_RESOURCE_LOGE("Wrong animation binary header");
+		return Error::kUserData;
+	}
+
+	// Channels
+	m_binaryChannels.create(getMemoryPool(), header.m_channelCount);
+	ANKI_CHECK(file.read(&m_binaryChannels[0], m_binaryChannels.getSizeInBytes()));
+
+	DynamicArrayRaii<Char> names(&getTempMemoryPool(), header.m_namesSize);
+	if(header.m_namesSize)
+	{
+		ANKI_CHECK(file.read(&names[0], names.getSizeInBytes()));
+	}
+
+	m_channels.create(getMemoryPool(), header.m_channelCount);
+	for(U32 i = 0; i < header.m_channelCount; ++i)
+	{
+		const AnimationBinaryChannel& in = m_binaryChannels[i];
+
+		if(in.m_nameLength == 0 || PtrSize(in.m_nameOffset) + in.m_nameLength > header.m_namesSize
+		   || (!!(in.m_flags & AnimationBinaryChannelFlag::kPositions)
+			   && in.m_positionIndex >= header.m_sampledPositionCount)
+		   || (!!(in.m_flags & AnimationBinaryChannelFlag::kRotations)
+			   && in.m_rotationIndex >= header.m_sampledRotationCount)
+		   || (!!(in.m_flags & AnimationBinaryChannelFlag::kScales) && in.m_scaleIndex >= header.m_sampledScaleCount)
+		   || (in.m_flags & ~AnimationBinaryChannelFlag::kAll) != AnimationBinaryChannelFlag::kNone)
+		{
+			ANKI_RESOURCE_LOGE("Wrong animation binary channel");
+			return Error::kUserData;
+		}
+
+		const Char* name = &names[in.m_nameOffset];
+		m_channels[i].m_name.create(getMemoryPool(), name, name + in.m_nameLength);
+	}
+
+	// Frames
+	m_rotationsOffset = header.m_sampledPositionCount * 3;
+	m_scalesOffset = m_rotationsOffset + header.m_sampledRotationCount * 3;
+	m_frameSize = m_scalesOffset + header.m_sampledScaleCount;
+	m_frameCount = header.m_frameCount;
+	m_frameRate = header.m_frameRate;
 
+	if(m_frameSize)
+	{
+		m_frames.create(getMemoryPool(), m_frameSize * m_frameCount);
+		ANKI_CHECK(file.read(&m_frames[0], m_frames.getSizeInBytes()));
+	}
+
+	m_startTime = header.m_startTime;
+	m_duration = (m_frameCount > 1) ? Second(m_frameCount - 1) / Second(m_frameRate) : 0.0;
+
+	return Error::kNone;
+}
+
+Bool AnimationResource::adjustTime(Second& time) const
+{
 	if(ANKI_UNLIKELY(time < m_startTime))
 	{
-		return;
+		return false;
 	}
 
 	// Audjust time
 	if(time > m_startTime + m_duration)
 	{
-		time = mod(time - m_startTime, m_duration) + m_startTime;
+		time = (m_duration > 0.0) ? mod(time - m_startTime, m_duration) + m_startTime : m_startTime;
 	}
 
 	ANKI_ASSERT(time >= m_startTime && time <= m_startTime + m_duration);
+	return true;
+}
+
+void AnimationResource::findFrames(Second time, const U16*& frame0, const U16*& frame1, F32& factor) const
+{
+	ANKI_ASSERT(isCompressed());
+
+	const Second frame = (time - m_startTime) * m_frameRate;
+	const U32 frameIdx = min(U32(frame), (m_frameCount > 1) ? m_frameCount - 2 : 0);
+	const U32 nextFrameIdx = min(frameIdx + 1, m_frameCount - 1);
+
+	frame0 = m_frames.getBegin() + frameIdx * m_frameSize;
+	frame1 = m_frames.getBegin() + nextFrameIdx * m_frameSize;
+	factor = clamp(F32(frame - Second(frameIdx)), 0.0f, 1.0f);
+}
+
+void AnimationResource::decodeChannel(const AnimationBinaryChannel& channel, const U16* frame0, const U16* frame1,
+									  F32 factor, AnimationChannelTransform& trf) const
+{
+	// Position
+	if(!!(channel.m_flags & AnimationBinaryChannelFlag::kPositions))
+	{
+		const U16* a = frame0 + channel.m_positionIndex * 3;
+		const U16* b = frame1 + channel.m_positionIndex * 3;
+		const Vec4 quantizedA = Vec4(F32(a[0]), F32(a[1]), F32(a[2]), 0.0f);
+		const Vec4 quantizedB = Vec4(F32(b[0]), F32(b[1]), F32(b[2]), 0.0f);
+		const Vec4 quantized = linearInterpolate(quantizedA, quantizedB, factor);
+		trf.m_position = (channel.m_positionMin.xyz0() + quantized * channel.m_positionScale.xyz0()).xyz();
+	}
+	else
+	{
+		trf.m_position = channel.m_positionMin;
+	}
+
+	// Rotation. The frames are close so nlerp is good enough
+	if(!!(channel.m_flags & AnimationBinaryChannelFlag::kRotations))
+	{
+		const Vec4 a = unpackAnimationRotation(frame0 + m_rotationsOffset + channel.m_rotationIndex * 3);
+		Vec4 b = unpackAnimationRotation(frame1 + m_rotationsOffset + channel.m_rotationIndex * 3);
+		b = (a.dot(b) < 0.0f) ? -b : b;
+		trf.m_rotation = Quat(linearInterpolate(a, b, factor).getNormalized());
+	}
+	else
+	{
+		trf.m_rotation = channel.m_rotation;
+	}
+
+	// Scale
+	if(!!(channel.m_flags & AnimationBinaryChannelFlag::kScales))
+	{
+		const F32 a = F32(frame0[m_scalesOffset + channel.m_scaleIndex]);
+		const F32 b = F32(frame1[m_scalesOffset + channel.m_scaleIndex]);
+		trf.m_scale = channel.m_scaleMin + linearInterpolate(a, b, factor) * channel.m_scaleScale;
+	}
+	else
+	{
+		trf.m_scale = channel.m_scaleMin;
+	}
+}
+
+void AnimationResource::interpolate(U32 channelIndex, Second time, AnimationChannelCursor& cursor, Vec3& pos,
+									Quat& rot, F32& scale) const
+{
+	pos = Vec3(0.0f);
+	rot = Quat::getIdentity();
+	scale = 1.0f;
+
+	if(!adjustTime(time))
+	{
+		return;
+	}
+
 	ANKI_ASSERT(channelIndex < m_channels.getSize());
 
+	if(isCompressed())
+	{
+		const U16* frame0;
+		const U16* frame1;
+		F32 factor;
+		findFrames(time, frame0, frame1, factor);
+
+		AnimationChannelTransform trf;
+		decodeChannel(m_binaryChannels[channelIndex], frame0, frame1, factor, trf);
+		pos = trf.m_position;
+		rot = trf.m_rotation;
+		scale = trf.m_scale;
+		return;
+	}
+
 	const AnimationChannel& channel = m_channels[channelIndex];
 
 	// Position
-	if(channel.m_positions.getSize() > 1)
+	if(findKeyframes(channel.m_positions, time, cursor.m_positionKey))
 	{
-		for(U32 i = 0; i < channel.m_positions.getSize() - 1; ++i)
-		{
-			const AnimationKeyframe<Vec3>& left = channel.m_positions[i];
-			const AnimationKeyframe<Vec3>& right = channel.m_positions[i + 1];
-			if(time >= left.m_time && time <= right.m_time)
-			{
-				const Second u = (time - left.m_time) / (right.m_time - left.m_time);
-				pos = linearInterpolate(left.m_value, right.m_value, F32(u));
-				break;
-			}
-		}
+		const AnimationKeyframe<Vec3>& left = channel.m_positions[cursor.m_positionKey];
+		const AnimationKeyframe<Vec3>& right = channel.m_positions[cursor.m_positionKey + 1];
+		const Second u = (time - left.m_time) / (right.m_time - left.m_time);
+		pos = linearInterpolate(left.m_value, right.m_value, F32(u));
 	}
 
 	// Rotation
-	if(channel.m_rotations.getSize() > 1)
+	if(findKeyframes(channel.m_rotations, time, cursor.m_rotationKey))
+	{
+		const AnimationKeyframe<Quat>& left = channel.m_rotations[cursor.m_rotationKey];
+		const AnimationKeyframe<Quat>& right = channel.m_rotations[cursor.m_rotationKey + 1];
+		const Second u = (time - left.m_time) / (right.m_time - left.m_time);
+		rot = left.m_value.slerp(right.m_value, F32(u));
+	}
+
+	// Scale
+	if(findKeyframes(channel.m_scales, time, cursor.m_scaleKey))
 	{
-		for(U32 i = 0; i < channel.m_rotations.getSize() - 1; ++i)
+		const AnimationKeyframe<F32>& left = channel.m_scales[cursor.m_scaleKey];
+		const AnimationKeyframe<F32>& right = channel.m_scales[cursor.m_scaleKey + 1];
+		const Second u = (time - left.m_time) / (right.m_time - left.m_time);
+		scale = linearInterpolate(left.m_value, right.m_value, F32(u));
+	}
+}
+
+void AnimationResource::samplePose(Second time, WeakArray<AnimationChannelTransform> pose) const
+{
+	ANKI_ASSERT(pose.getSize() >= m_channels.getSize());
+
+	if(!isCompressed() || !adjustTime(time))
+	{
+		for(U32 i = 0; i < m_channels.getSize(); ++i)
 		{
-			const AnimationKeyframe<Quat>& left = channel.m_rotations[i];
-			const AnimationKeyframe<Quat>& right = channel.m_rotations[i + 1];
-			if(time >= left.m_time && time <= right.m_time)
-			{
-				const Second u = (time - left.m_time) / (right.m_time - left.m_time);
-				rot = left.m_value.slerp(right.m_value, F32(u));
-				break;
-			}
+			AnimationChannelCursor cursor;
+			interpolate(i, time, cursor, pose[i].m_position, pose[i].m_rotation, pose[i].m_scale);
 		}
+		return;
 	}
 
-	// Scale
-	if(channel.m_scales.getSize() > 1)
+	const U16* frame0;
+	const U16* frame1;
+	F32 factor;
+	findFrames(time, frame0, frame1, factor);
+
+	for(U32 i = 0; i < m_binaryChannels.getSize(); ++i)
 	{
-		for(U32 i = 0; i < channel.m_scales.getSize() - 1; ++i)
+		decodeChannel(m_binaryChannels[i], frame0, frame1, factor, pose[i]);
+	}
+}
+
+template<typename T>
+Bool AnimationResource::findKeyframes(const DynamicArray<AnimationKeyframe<T>>& keys, Second time, U32& cursor)
+{
+	const U32 count = keys.getSize();
+	if(count < 2 || time < keys[0].m_time || time > keys[count - 1].m_time)
+	{
+		return false;
+	}
+
+	// Try the cached segment and the one after it. That's the common case when the animation moves forward
+	const U32 crnt = min(cursor, count - 2);
+	if(time >= keys[crnt].m_time)
+	{
+		if(time <= keys[crnt + 1].m_time)
 		{
-			const AnimationKeyframe<F32>& left = channel.m_scales[i];
-			const AnimationKeyframe<F32>& right = channel.m_scales[i + 1];
-			if(time >= left.m_time && time <= right.m_time)
-			{
-				const Second u = (time - left.m_time) / (right.m_time - left.m_time);
-				scale = linearInterpolate(left.m_value, right.m_value, F32(u));
-				break;
-			}
+			cursor = crnt;
+			return true;
+		}
+
+		if(crnt + 2 < count && time <= keys[crnt + 2].m_time)
+		{
+			cursor = crnt + 1;
+			return true;
 		}
 	}
+
+	// Seek. Find the 1st keyframe that is after the time. It can't be the 1st keyframe
+	const AnimationKeyframe<T>* it =
+		std::upper_bound(keys.getBegin(), keys.getEnd(), time, [](Second t, const AnimationKeyframe<T>& key) {
+			return t < key.m_time;
+		});
+	cursor = min(U32(it - keys.getBegin()) - 1, count - 2);
+	return true;
 }
 
 } // end namespace anki
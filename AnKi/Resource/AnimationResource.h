@@ -14,6 +14,7 @@ namespace anki {
 
 // Forward
 class XmlElement;
+class AnimationBinaryChannel;
 
 /// @addtogroup resource
 /// @{
@@ -63,7 +64,27 @@ public:
 	}
 };
 
-/// Animation consists of keyframe data.
+/// Caches the keyframes that AnimationResource::interpolate() used the last time. When the animation is sampled forward
+/// in time the next keyframes are found in constant time. On seeks it falls back to binary search.
+class AnimationChannelCursor
+{
+public:
+	U32 m_positionKey = 0;
+	U32 m_rotationKey = 0;
+	U32 m_scaleKey = 0;
+};
+
+/// The interpolated transform of an animation channel.
+class AnimationChannelTransform
+{
+public:
+	Vec3 m_position;
+	Quat m_rotation;
+	F32 m_scale;
+};
+
+/// Animation consists of keyframe data. It can be loaded from XML that has keyframes with arbitrary times or from an
+/// animation binary that has uniformly sampled and quantized frames (see AnimationBinary.h).
 class AnimationResource : public ResourceObject
 {
 public:
@@ -91,13 +112,63 @@ public:
 		return m_startTime;
 	}
 
+	/// True if it was loaded from an animation binary.
+	Bool isCompressed() const
+	{
+		return m_binaryChannels.getSize() > 0;
+	}
+
 	/// Get the interpolated data
-	void interpolate(U32 channelIndex, Second time, Vec3& position, Quat& rotation, F32& scale) const;
+	void interpolate(U32 channelIndex, Second time, Vec3& position, Quat& rotation, F32& scale) const
+	{
+		AnimationChannelCursor cursor;
+		interpolate(channelIndex, time, cursor, position, rotation, scale);
+	}
+
+	/// Get the interpolated data using a cursor to find the keyframes faster.
+	/// @param[in,out] cursor The cursor of the channel. It will be updated.
+	void interpolate(U32 channelIndex, Second time, AnimationChannelCursor& cursor, Vec3& position, Quat& rotation,
+					 F32& scale) const;
+
+	/// Interpolate all channels at once. For compressed animations the frames are located once and the whole pose is
+	/// decoded in one pass.
+	/// @param time The time of the animation.
+	/// @param[out] pose The transform of every channel. It should be as big as the channels.
+	void samplePose(Second time, WeakArray<AnimationChannelTransform> pose) const;
 
 private:
 	DynamicArray<AnimationChannel> m_channels;
 	Second m_duration;
 	Second m_startTime;
+
+	/// @name Compressed data
+	/// @{
+	DynamicArray<AnimationBinaryChannel> m_binaryChannels;
+	DynamicArray<U16> m_frames;
+	U32 m_frameSize = 0; ///< In U16.
+	U32 m_frameCount = 0;
+	F32 m_frameRate = 0.0f;
+	U32 m_rotationsOffset = 0; ///< Where the rotations start in a frame (in U16).
+	U32 m_scalesOffset = 0; ///< Where the scales start in a frame (in U16).
+	/// @}
+
+	Error loadBinary(ResourceFile& file);
+
+	/// Wrap the time inside the animation.
+	/// @return False if the animation hasn't started.
+	Bool adjustTime(Second& time) const;
+
+	/// Find the 2 frames that surround the time and the interpolation factor between them.
+	void findFrames(Second time, const U16*& frame0, const U16*& frame1, F32& factor) const;
+
+	void decodeChannel(const AnimationBinaryChannel& channel, const U16* frame0, const U16* frame1, F32 factor,
+					   AnimationChannelTransform& trf) const;
+
+	/// Find the 2 keyframes that surround the time.
+	/// @param[in,out] cursor The index of the left keyframe.
+	/// @return False if there are not enough keyframes or the time is outside of them.
+	template<typename T>
+	static Bool findKeyframes(const DynamicArray<AnimationKeyframe<T>>& keys, Second time, U32& cursor);
 };
 /// @}
 
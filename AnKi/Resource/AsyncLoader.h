@@ -77,6 +77,39 @@ public:
 		return *m_pool;
 	}
 
+	/// Remove from the queue the tasks that the callback accepts and delete them. It doesn't touch the task that is
+	/// running and it works even if the loader is paused or stopped because a task failed.
+	/// @param func A callback with signature Bool(AsyncLoaderTask&). Return true to remove the task.
+	/// @return The number of removed tasks.
+	template<typename TFunc>
+	U32 removeTasks(TFunc func)
+	{
+		IntrusiveList<AsyncLoaderTask> removedTasks;
+		{
+			LockGuard<Mutex> lock(m_mtx);
+			auto it = m_taskQueue.getBegin();
+			while(it != m_taskQueue.getEnd())
+			{
+				AsyncLoaderTask* task = &(*it);
+				++it;
+				if(func(*task))
+				{
+					m_taskQueue.erase(task);
+					removedTasks.pushBack(task);
+				}
+			}
+		}
+
+		U32 count = 0;
+		while(!removedTasks.isEmpty())
+		{
+			deleteInstance(*m_pool, removedTasks.popFront());
+			++count;
+		}
+
+		return count;
+	}
+
 	/// Get the total number of completed tasks.
 	U64 getCompletedTaskCount() const
 	{
@@ -13,9 +13,12 @@ namespace anki {
 template<typename T>
 void ResourcePtrDeleter<T>::operator()(T* ptr)
 {
-	ptr->getManager().unregisterResource(ptr);
+	ResourceManager& manager = ptr->getManager();
+	manager.lockResources();
+	manager.unregisterResource(ptr);
 	HeapMemoryPool& pool = ptr->getMemoryPool();
 	deleteInstance(pool, ptr);
+	manager.unlockResources();
 }
 
 #define ANKI_INSTANTIATE_RESOURCE(rsrc_, ptr_) template void ResourcePtrDeleter<rsrc_>::operator()(rsrc_* ptr);
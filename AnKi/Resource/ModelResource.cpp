@@ -90,6 +90,12 @@ Error ModelPatch::init([[maybe_unused]] ModelResource* model, CString meshFName,
 		IndexType indexType;
 		m_mesh->getIndexBufferInfo(l, lod.m_indexBufferOffset, totalIndexCount, indexType);
 
+		// Estimate the error. Assume that the triangles cover the surface of the box
+		const Vec3 size = (m_aabb.getMax() - m_aabb.getMin()).xyz();
+		const F32 surface = 2.0f * (size.x() * size.y() + size.y() * size.z() + size.z() * size.x());
+		const F32 radius = max(size.getLength() * 0.5f, kEpsilonf);
+		lod.m_error = sqrt(surface / F32(max(lod.m_indexCount / 3, 1u))) / radius;
+
 		for(VertexStreamId stream : EnumIterable(VertexStreamId::kMeshRelatedFirst, VertexStreamId::kMeshRelatedCount))
 		{
 			if(m_mesh->isVertexStreamPresent(stream))
@@ -63,6 +63,25 @@ public:
 		return m_aabb;
 	}
 
+	U32 getLodCount() const
+	{
+		return m_meshLodCount;
+	}
+
+	U32 getTriangleCount(U32 lod) const
+	{
+		ANKI_ASSERT(lod < m_meshLodCount);
+		return m_lodInfos[lod].m_indexCount / 3;
+	}
+
+	/// An estimation of the geometric error of a LOD relative to the radius of the bounding sphere of the patch. The
+	/// mesh doesn't store the error so it's the average edge length of the LOD's triangles.
+	F32 getLodError(U32 lod) const
+	{
+		ANKI_ASSERT(lod < m_meshLodCount);
+		return m_lodInfos[lod].m_error;
+	}
+
 	/// Get information for rendering.
 	void getRenderingInfo(const RenderingKey& key, ModelRenderingInfo& inf) const;
 
@@ -76,6 +95,7 @@ private:
 		PtrSize m_indexBufferOffset = kMaxPtrSize;
 		U32 m_firstIndex = kMaxU32;
 		U32 m_indexCount = kMaxU32;
+		F32 m_error = 0.0f;
 
 		Array<PtrSize, U32(VertexStreamId::kMeshRelatedCount)> m_vertexBufferOffsets = {};
 	};
@@ -73,6 +73,15 @@ Error ParticleEmitterResource::load(const ResourceFilename& filename, Bool async
 		ANKI_CHECK(el.getAttributeNumber("value", m_usePhysicsEngine));
 	}
 
+	ANKI_CHECK(rootEl.getChildElementOptional("worldCollisions", el));
+	if(el)
+	{
+		ANKI_CHECK(el.getAttributeNumber("value", m_worldCollisions));
+
+		Bool found;
+		ANKI_CHECK(el.getAttributeNumberOptional("bounciness", m_bounciness, found));
+	}
+
 	ANKI_CHECK(rootEl.getChildElementOptional("emitterBoundingVolume", el));
 	if(el)
 	{
@@ -68,6 +68,12 @@ public:
 
 	Bool m_usePhysicsEngine = false; ///< Use bullet for the simulation
 
+	/// Bounce the particles off the static geometry of the physics world without creating a body per particle. Ignored
+	/// if m_usePhysicsEngine is set.
+	Bool m_worldCollisions = false;
+
+	F32 m_bounciness = 0.5f; ///< The part of the velocity that is kept after a bounce.
+
 	Vec3 m_emitterBoundingVolumeMin = Vec3(0.0f); ///< Limit the size of the emitter. Mainly for visibility tests.
 
 	Vec3 m_emitterBoundingVolumeMax = Vec3(0.0f); ///< Limit the size of the emitter. Mainly for visibility tests.
@@ -83,7 +83,7 @@ public:
 		}
 	}
 
-	Error open(const CString& archive, const CString& archivedFname)
+	Error open(const CString& archive, const unz64_file_pos& archivedFilePos)
 	{
 		// Open archive
 		m_archive = unzOpen(&archive[0]);
@@ -93,9 +93,8 @@ public:
 			return Error::kFileAccess;
 		}
 
-		// Locate archived
-		const int caseSensitive = 1;
-		if(unzLocateFile(m_archive, &archivedFname[0], caseSensitive) != UNZ_OK)
+		// Locate archived. Go straight to the position that was found when the archive was added
+		if(unzGoToFilePos64(m_archive, &archivedFilePos) != UNZ_OK)
 		{
 			ANKI_RESOURCE_LOGE("Failed to locate file in archive");
 			return Error::kFileAccess;
@@ -205,6 +204,8 @@ ResourceFilesystem::~ResourceFilesystem()
 
 	m_paths.destroy(m_pool);
 	m_cacheDir.destroy(m_pool);
+	m_fileIndex.destroy(m_pool);
+	m_collidingFiles.destroy(m_pool);
 }
 
 Error ResourceFilesystem::init(const ConfigSet& config, AllocAlignedCallback allocCallback, void* allocCallbackUserData)
@@ -281,6 +282,7 @@ Error ResourceFilesystem::addNewPath(const CString& filepath, const StringListRa
 
 	PtrSize pos;
 	Path path;
+	DynamicArrayRaii<unz64_file_pos> archivedFilePositions(&m_pool); // One for each of the path.m_files
 	if((pos = filepath.find(extension)) != CString::kNpos && pos == filepath.getLength() - extension.getLength())
 	{
 		// It's an archive
@@ -316,7 +318,16 @@ Error ResourceFilesystem::addNewPath(const CString& filepath, const StringListRa
 			const Bool itsADir = info.uncompressed_size == 0;
 			if(!itsADir && !rejectPath(&filename[0]))
 			{
+				unz64_file_pos filePos;
+				if(unzGetFilePos64(zfile, &filePos) != UNZ_OK)
+				{
+					unzClose(zfile);
+					ANKI_RESOURCE_LOGE("unzGetFilePos64() failed");
+					return Error::kFileAccess;
+				}
+
 				path.m_files.pushBackSprintf(m_pool, "%s", &filename[0]);
+				archivedFilePositions.emplaceBack(filePos);
 				++fileCount;
 			}
 		} while(unzGoToNextFile(zfile) == UNZ_OK);
@@ -350,6 +361,24 @@ Error ResourceFilesystem::addNewPath(const CString& filepath, const StringListRa
 		path.m_path.sprintf(m_pool, "%s", &filepath[0]);
 		m_paths.emplaceFront(m_pool, std::move(path));
 
+		// Index the files. They replace the files with the same name of the older paths
+		const Path& newPath = m_paths.getFront();
+		U32 fileIdx = 0;
+		for(const String& fname : newPath.m_files)
+		{
+			IndexedFile file;
+			file.m_filename = &fname;
+			file.m_path = &newPath;
+			if(newPath.m_isArchive)
+			{
+				file.m_archiveDirectoryOffset = archivedFilePositions[fileIdx].pos_in_zip_directory;
+				file.m_archiveFileNumber = archivedFilePositions[fileIdx].num_of_file;
+			}
+
+			indexFile(file);
+			++fileIdx;
+		}
+
 		ANKI_RESOURCE_LOGI("Added new data path \"%s\" that contains %u files", &filepath[0], fileCount);
 	}
 
@@ -364,6 +393,59 @@ Error ResourceFilesystem::addNewPath(const CString& filepath, const StringListRa
 	return Error::kNone;
 }
 
+void ResourceFilesystem::indexFile(const IndexedFile& file)
+{
+	const U64 hash = file.m_filename->toCString().computeHash();
+	auto it = m_fileIndex.find(hash);
+	if(it == m_fileIndex.getEnd())
+	{
+		m_fileIndex.emplace(m_pool, hash, file);
+	}
+	else if(*it->m_filename == *file.m_filename)
+	{
+		*it = file;
+	}
+	else
+	{
+		// Collision, rare enough to store it aside
+		for(IndexedFile& other : m_collidingFiles)
+		{
+			if(*other.m_filename == *file.m_filename)
+			{
+				other = file;
+				return;
+			}
+		}
+
+		ANKI_RESOURCE_LOGV("Filename hash collision: %s and %s", file.m_filename->cstr(), it->m_filename->cstr());
+		m_collidingFiles.pushBack(m_pool, file);
+	}
+}
+
+const ResourceFilesystem::IndexedFile* ResourceFilesystem::findIndexedFile(const CString& filename) const
+{
+	auto it = m_fileIndex.find(filename.computeHash());
+	if(it == m_fileIndex.getEnd())
+	{
+		return nullptr;
+	}
+
+	if(it->m_filename->toCString() == filename)
+	{
+		return &(*it);
+	}
+
+	for(const IndexedFile& file : m_collidingFiles)
+	{
+		if(file.m_filename->toCString() == filename)
+		{
+			return &file;
+		}
+	}
+
+	return nullptr;
+}
+
 Error ResourceFilesystem::openFile(const ResourceFilename& filename, ResourceFilePtr& filePtr)
 {
 	ResourceFile* rfile;
@@ -387,44 +469,34 @@ Error ResourceFilesystem::openFileInternal(const ResourceFilename& filename, Res
 {
 	rfile = nullptr;
 
-	// Search for the fname in reverse order
-	for(const Path& p : m_paths)
+	const IndexedFile* indexedFile = findIndexedFile(filename);
+	if(indexedFile)
 	{
-		for(const String& pfname : p.m_files)
+		const Path& p = *indexedFile->m_path;
+		if(p.m_isArchive)
 		{
-			if(pfname != filename)
-			{
-				continue;
-			}
+			ZipResourceFile* file = newInstance<ZipResourceFile>(m_pool, &m_pool);
+			rfile = file;
 
-			// Found
-			if(p.m_isArchive)
-			{
-				ZipResourceFile* file = newInstance<ZipResourceFile>(m_pool, &m_pool);
-				rfile = file;
-
-				ANKI_CHECK(file->open(p.m_path.toCString(), filename));
-			}
-			else
-			{
-				StringRaii newFname(&m_pool);
-				newFname.sprintf("%s/%s", &p.m_path[0], &filename[0]);
+			unz64_file_pos filePos;
+			filePos.pos_in_zip_directory = indexedFile->m_archiveDirectoryOffset;
+			filePos.num_of_file = indexedFile->m_archiveFileNumber;
+			ANKI_CHECK(file->open(p.m_path.toCString(), filePos));
+		}
+		else
+		{
+			StringRaii newFname(&m_pool);
+			newFname.sprintf("%s/%s", &p.m_path[0], &filename[0]);
 
-				CResourceFile* file = newInstance<CResourceFile>(m_pool, &m_pool);
-				rfile = file;
-				ANKI_CHECK(file->m_file.open(newFname, FileOpenFlag::kRead));
+			CResourceFile* file = newInstance<CResourceFile>(m_pool, &m_pool);
+			rfile = file;
+			ANKI_CHECK(file->m_file.open(newFname, FileOpenFlag::kRead));
 
 #if 0
-				printf("Opening asset %s\n", &newFname[0]);
+			printf("Opening asset %s\n", &newFname[0]);
 #endif
-			}
-		}
-
-		if(rfile)
-		{
-			break;
 		}
-	} // end for all paths
+	}
 
 	// File not found? On Win/Linux try to find it outside the resource dirs. On Android try the archive
 	if(!rfile)
@@ -8,6 +8,7 @@
 #include <AnKi/Resource/Common.h>
 #include <AnKi/Util/String.h>
 #include <AnKi/Util/StringList.h>
+#include <AnKi/Util/HashMap.h>
 #include <AnKi/Util/File.h>
 #include <AnKi/Util/Ptr.h>
 
@@ -141,13 +142,31 @@ private:
 		}
 	};
 
+	/// Where a filename resolves to.
+	class IndexedFile
+	{
+	public:
+		const String* m_filename = nullptr; ///< Points to one of the Path::m_files.
+		const Path* m_path = nullptr;
+		U64 m_archiveDirectoryOffset = 0; ///< The position of the file inside the archive's directory.
+		U64 m_archiveFileNumber = 0; ///< The index of the file inside the archive.
+	};
+
 	HeapMemoryPool m_pool;
 	List<Path> m_paths;
 	String m_cacheDir;
+	HashMap<U64, IndexedFile> m_fileIndex; ///< All the filenames of all paths. Key is the hash of the filename.
+	List<IndexedFile> m_collidingFiles; ///< Files with the same hash as a file in m_fileIndex.
 
-	/// Add a filesystem path or an archive. The path is read-only.
+	/// Add a filesystem path or an archive. The path is read-only. Its files take precedence over the files of the
+	/// paths added before it.
 	Error addNewPath(const CString& path, const StringListRaii& excludedStrings);
 
+	/// Add or replace a file in the index.
+	void indexFile(const IndexedFile& file);
+
+	const IndexedFile* findIndexedFile(const CString& filename) const;
+
 	Error openFileInternal(const ResourceFilename& filename, ResourceFile*& rfile);
 };
 /// @}
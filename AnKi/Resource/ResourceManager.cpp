@@ -25,13 +25,17 @@
 
 namespace anki {
 
+/// How many times the current thread has locked the resources.
+static thread_local U32 g_resourcesLockDepth = 0;
+
 ResourceManager::ResourceManager()
 {
 }
 
 ResourceManager::~ResourceManager()
 {
-	ANKI_RESOURCE_LOGI("Destroying resource manager");
+	ANKI_RESOURCE_LOGI("Destroying resource manager. Cache hits %" PRIu64 ", cache misses %" PRIu64,
+					   getCacheHitCount(), getCacheMissCount());
 
 	deleteInstance(m_pool, m_asyncLoader);
 	deleteInstance(m_pool, m_shaderProgramSystem);
@@ -77,20 +81,71 @@ U64 ResourceManager::getAsyncTaskCompletedCount() const
 	return m_asyncLoader->getCompletedTaskCount();
 }
 
+U64 ResourceManager::getCacheHitCount() const
+{
+	U64 count = 0;
+#define ANKI_INSTANTIATE_RESOURCE(rsrc_, ptr_) count += TypeResourceManager<rsrc_>::getHitCount();
+#define ANKI_INSTANSIATE_RESOURCE_DELIMITER()
+#include <AnKi/Resource/InstantiationMacros.h>
+#undef ANKI_INSTANTIATE_RESOURCE
+#undef ANKI_INSTANSIATE_RESOURCE_DELIMITER
+	return count;
+}
+
+U64 ResourceManager::getCacheMissCount() const
+{
+	U64 count = 0;
+#define ANKI_INSTANTIATE_RESOURCE(rsrc_, ptr_) count += TypeResourceManager<rsrc_>::getMissCount();
+#define ANKI_INSTANSIATE_RESOURCE_DELIMITER()
+#include <AnKi/Resource/InstantiationMacros.h>
+#undef ANKI_INSTANTIATE_RESOURCE
+#undef ANKI_INSTANSIATE_RESOURCE_DELIMITER
+	return count;
+}
+
+void ResourceManager::lockResources()
+{
+	if(g_resourcesLockDepth++ == 0)
+	{
+		m_resourcesMtx.lock();
+	}
+}
+
+void ResourceManager::unlockResources()
+{
+	ANKI_ASSERT(g_resourcesLockDepth > 0);
+	if(--g_resourcesLockDepth == 0)
+	{
+		m_resourcesMtx.unlock();
+	}
+}
+
 template<typename T>
 Error ResourceManager::loadResource(const CString& filename, ResourcePtr<T>& out, Bool async)
 {
 	ANKI_ASSERT(!out.isCreated() && "Already loaded");
 
+	m_loadRequestCount.fetchAdd(1);
+
+	// Try without the resources lock first so a load in another thread won't block the resources that are loaded
+	T* other = TypeResourceManager<T>::findLoadedResource(filename);
+	if(other)
+	{
+		out.reset(other);
+		other->release(); // Release the reference findLoadedResource() took
+		return Error::kNone;
+	}
+
+	lockResources();
 	Error err = Error::kNone;
-	++m_loadRequestCount;
 
-	T* const other = findLoadedResource<T>(filename);
+	other = TypeResourceManager<T>::findLoadedResourceOrReserve(filename);
 
 	if(other)
 	{
 		// Found
 		out.reset(other);
+		other->release();
 	}
 	else
 	{
@@ -111,7 +166,9 @@ Error ResourceManager::loadResource(const CString& filename, ResourcePtr<T>& out
 			if(err)
 			{
 				ANKI_RESOURCE_LOGE("Failed to load resource: %s", &filename[0]);
+				TypeResourceManager<T>::cancelResourceLoad(filename);
 				deleteInstance(m_pool, ptr);
+				unlockResources();
 				return err;
 			}
 
@@ -129,13 +186,14 @@ Error ResourceManager::loadResource(const CString& filename, ResourcePtr<T>& out
 		}
 
 		// Register resource
-		registerResource(ptr);
+		TypeResourceManager<T>::registerResource(ptr);
 		out.reset(ptr);
 
 		// Decrement because of the increment happened a few lines above
 		ptr->release();
 	}
 
+	unlockResources();
 	return err;
 }
 
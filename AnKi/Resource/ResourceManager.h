@@ -6,9 +6,11 @@
 #pragma once
 
 #include <AnKi/Resource/TransferGpuAllocator.h>
-#include <AnKi/Util/List.h>
+#include <AnKi/Util/HashMap.h>
 #include <AnKi/Util/Functions.h>
 #include <AnKi/Util/String.h>
+#include <AnKi/Util/Thread.h>
+#include <AnKi/Util/Atomic.h>
 
 namespace anki {
 
@@ -26,7 +28,7 @@ class UnifiedGeometryMemoryPool;
 /// @addtogroup resource
 /// @{
 
-/// Manage resources of a certain type
+/// Manage resources of a certain type. The resources are indexed by the hash of their filename. It's thread-safe.
 template<typename Type>
 class TypeResourceManager
 {
@@ -37,27 +39,116 @@ protected:
 
 	~TypeResourceManager()
 	{
-		ANKI_ASSERT(m_ptrs.isEmpty() && "Forgot to delete some resources");
-		m_ptrs.destroy(*m_pool);
+		ANKI_ASSERT(m_entries.isEmpty() && "Forgot to delete some resources");
+		m_entries.destroy(*m_pool);
 	}
 
+	/// Find a loaded resource. If another thread is loading it wait for that load to finish. It doesn't need the
+	/// resources lock.
+	/// @return The resource retained or nullptr if it's not loaded.
 	Type* findLoadedResource(const CString& filename)
 	{
-		auto it = find(filename);
-		return (it != m_ptrs.end()) ? *it : nullptr;
+		const U64 hash = filename.computeHash();
+		LockGuard<Mutex> lock(m_mtx);
+
+		Entry* entry = find(filename, hash);
+		while(entry && entry->m_resource == nullptr && entry->m_loadingThread != Thread::getCurrentThreadId())
+		{
+			m_loadCond.wait(m_mtx);
+			entry = find(filename, hash);
+		}
+
+		if(entry && entry->m_resource && entry->m_resource->tryRetain())
+		{
+			m_hitCount.fetchAdd(1);
+			return entry->m_resource;
+		}
+
+		return nullptr;
 	}
 
+	/// Same as findLoadedResource() but if the resource is not loaded reserve a place for it. The caller needs to hold
+	/// the resources lock and it's the one that should load the resource and then call registerResource() or
+	/// cancelResourceLoad().
+	/// @return The resource retained or nullptr if the caller should load it.
+	Type* findLoadedResourceOrReserve(const CString& filename)
+	{
+		const U64 hash = filename.computeHash();
+		LockGuard<Mutex> lock(m_mtx);
+
+		Entry* entry = find(filename, hash);
+		if(entry)
+		{
+			// The loading thread holds the resources lock so only the current thread can be loading it
+			ANKI_ASSERT(entry->m_resource && "Resources that depend on each other in a loop");
+
+			if(entry->m_resource->tryRetain())
+			{
+				m_hitCount.fetchAdd(1);
+				return entry->m_resource;
+			}
+
+			// The resource is waiting for the resources lock to be deleted. Take its place
+			entry->m_resource = nullptr;
+		}
+		else
+		{
+			entry = newInstance<Entry>(*m_pool);
+			entry->m_filename.create(*m_pool, filename);
+
+			auto it = m_entries.find(hash);
+			if(it != m_entries.getEnd())
+			{
+				entry->m_next = *it;
+				*it = entry;
+			}
+			else
+			{
+				m_entries.emplace(*m_pool, hash, entry);
+			}
+		}
+
+		entry->m_loadingThread = Thread::getCurrentThreadId();
+		m_missCount.fetchAdd(1);
+		return nullptr;
+	}
+
+	/// Fill the place that findLoadedResourceOrReserve() reserved and wake the threads that wait for it.
 	void registerResource(Type* ptr)
 	{
-		ANKI_ASSERT(find(ptr->getFilename()) == m_ptrs.getEnd());
-		m_ptrs.pushBack(*m_pool, ptr);
+		const CString filename = ptr->getFilename();
+		LockGuard<Mutex> lock(m_mtx);
+
+		Entry* entry = find(filename, filename.computeHash());
+		ANKI_ASSERT(entry && entry->m_resource == nullptr
+					&& entry->m_loadingThread == Thread::getCurrentThreadId());
+		entry->m_resource = ptr;
+		m_loadCond.notifyAll();
+	}
+
+	/// Drop the place that findLoadedResourceOrReserve() reserved because the load failed.
+	void cancelResourceLoad(const CString& filename)
+	{
+		LockGuard<Mutex> lock(m_mtx);
+
+		[[maybe_unused]] Entry* entry = find(filename, filename.computeHash());
+		ANKI_ASSERT(entry && entry->m_resource == nullptr
+					&& entry->m_loadingThread == Thread::getCurrentThreadId());
+		erase(filename);
+		m_loadCond.notifyAll();
 	}
 
 	void unregisterResource(Type* ptr)
 	{
-		auto it = find(ptr->getFilename());
-		ANKI_ASSERT(it != m_ptrs.end());
-		m_ptrs.erase(*m_pool, it);
+		const CString filename = ptr->getFilename();
+		LockGuard<Mutex> lock(m_mtx);
+
+		// If the entry points to something else then a new load took its place while this one was waiting to be deleted
+		const Entry* entry = find(filename, filename.computeHash());
+		if(entry && entry->m_resource == ptr)
+		{
+			erase(filename);
+		}
 	}
 
 	void init(HeapMemoryPool* pool)
@@ -66,25 +157,74 @@ protected:
 		m_pool = pool;
 	}
 
+	U64 getHitCount() const
+	{
+		return m_hitCount.load();
+	}
+
+	U64 getMissCount() const
+	{
+		return m_missCount.load();
+	}
+
 private:
-	using Container = List<Type*>;
+	/// A resource or a resource that is being loaded.
+	class Entry
+	{
+	public:
+		String m_filename;
+		Type* m_resource = nullptr; ///< It's nullptr while the resource is being loaded.
+		ThreadId m_loadingThread = 0;
+		Entry* m_next = nullptr; ///< The next entry with the same filename hash.
+	};
 
 	HeapMemoryPool* m_pool = nullptr;
-	Container m_ptrs;
+	HashMap<U64, Entry*> m_entries; ///< Key is the hash of the filename.
+	Mutex m_mtx; ///< Protects m_entries.
+	ConditionVariable m_loadCond; ///< Signaled when a load finishes.
+	Atomic<U64> m_hitCount = {0};
+	Atomic<U64> m_missCount = {0};
 
-	typename Container::Iterator find(const CString& filename)
+	Entry* find(const CString& filename, U64 hash)
 	{
-		typename Container::Iterator it;
+		auto it = m_entries.find(hash);
+		Entry* entry = (it != m_entries.getEnd()) ? *it : nullptr;
+		while(entry && entry->m_filename.toCString() != filename)
+		{
+			entry = entry->m_next;
+		}
 
-		for(it = m_ptrs.getBegin(); it != m_ptrs.getEnd(); ++it)
+		return entry;
+	}
+
+	void erase(const CString& filename)
+	{
+		auto it = m_entries.find(filename.computeHash());
+		ANKI_ASSERT(it != m_entries.getEnd());
+
+		Entry* prev = nullptr;
+		Entry* entry = *it;
+		while(entry->m_filename.toCString() != filename)
 		{
-			if((*it)->getFilename() == filename)
-			{
-				break;
-			}
+			prev = entry;
+			entry = entry->m_next;
 		}
 
-		return it;
+		if(prev)
+		{
+			prev->m_next = entry->m_next;
+		}
+		else if(entry->m_next)
+		{
+			*it = entry->m_next;
+		}
+		else
+		{
+			m_entries.erase(*m_pool, it);
+		}
+
+		entry->m_filename.destroy(*m_pool);
+		deleteInstance(*m_pool, entry);
 	}
 };
 
@@ -124,7 +264,7 @@ public:
 
 	Error init(ResourceManagerInitInfo& init);
 
-	/// Load a resource.
+	/// Load a resource. It's thread-safe.
 	template<typename T>
 	Error loadResource(const CString& filename, ResourcePtr<T>& out, Bool async = true);
 
@@ -163,18 +303,6 @@ public:
 		return *m_fs;
 	}
 
-	template<typename T>
-	ANKI_INTERNAL T* findLoadedResource(const CString& filename)
-	{
-		return TypeResourceManager<T>::findLoadedResource(filename);
-	}
-
-	template<typename T>
-	ANKI_INTERNAL void registerResource(T* ptr)
-	{
-		TypeResourceManager<T>::registerResource(ptr);
-	}
-
 	template<typename T>
 	ANKI_INTERNAL void unregisterResource(T* ptr)
 	{
@@ -186,12 +314,26 @@ public:
 		return *m_asyncLoader;
 	}
 
+	/// Serialize the loading and the deletion of resources so they can happen from any thread. It's recursive because
+	/// resources load and release other resources. The load() of the resources and the m_tmpPool are not thread-safe
+	/// so loads of different resources can't run in parallel. Only the lookups of loaded resources skip the lock.
+	ANKI_INTERNAL void lockResources();
+
+	ANKI_INTERNAL void unlockResources();
+
 	/// Get the number of times loadResource() was called.
 	ANKI_INTERNAL U64 getLoadingRequestCount() const
 	{
-		return m_loadRequestCount;
+		return m_loadRequestCount.load();
 	}
 
+	/// Get the number of times loadResource() found the resource already loaded or waited for another thread to load
+	/// it.
+	ANKI_INTERNAL U64 getCacheHitCount() const;
+
+	/// Get the number of times loadResource() had to load a resource.
+	ANKI_INTERNAL U64 getCacheMissCount() const;
+
 	/// Get the total number of completed async tasks.
 	ANKI_INTERNAL U64 getAsyncTaskCompletedCount() const;
 
@@ -224,7 +366,8 @@ private:
 	ShaderProgramResourceSystem* m_shaderProgramSystem = nullptr;
 	UnifiedGeometryMemoryPool* m_unifiedGometryMemoryPool = nullptr;
 	U64 m_uuid = 0;
-	U64 m_loadRequestCount = 0;
+	Atomic<U64> m_loadRequestCount = {0};
+	Mutex m_resourcesMtx; ///< Protects the TypeResourceManagers and the m_tmpPool.
 	TransferGpuAllocator* m_transferGpuAlloc = nullptr;
 };
 /// @}
@@ -42,6 +42,17 @@ public:
 		m_refcount.fetchAdd(1);
 	}
 
+	/// Retain only if the refcount hasn't reached zero. A zero refcount means that the resource is about to be deleted.
+	Bool tryRetain() const
+	{
+		I32 refcount = m_refcount.load();
+		while(refcount > 0 && !m_refcount.compareExchange(refcount, refcount + 1))
+		{
+		}
+
+		return refcount > 0;
+	}
+
 	I32 release() const
 	{
 		return m_refcount.fetchSub(1);
@@ -4,6 +4,7 @@
 // http://www.anki3d.org/LICENSE
 
 #include <AnKi/Resource/SkeletonResource.h>
+#include <AnKi/Resource/AnimationResource.h>
 #include <AnKi/Util/Xml.h>
 #include <AnKi/Util/StringList.h>
 
@@ -17,6 +18,16 @@ SkeletonResource::~SkeletonResource()
 	}
 
 	m_bones.destroy(getMemoryPool());
+	m_hierarchyOrder.destroy(getMemoryPool());
+	m_parentIndices.destroy(getMemoryPool());
+
+	for(auto it : m_animationBindings)
+	{
+		AnimationBinding* binding = it;
+		binding->m_channelBoneIndices.destroy(getMemoryPool());
+		deleteInstance(getMemoryPool(), binding);
+	}
+	m_animationBindings.destroy(getMemoryPool());
 }
 
 Error SkeletonResource::load(const ResourceFilename& filename, [[maybe_unused]] Bool async)
@@ -53,11 +64,14 @@ Error SkeletonResource::load(const ResourceFilename& filename, [[maybe_unused]]
 		ANKI_CHECK(boneEl.getAttributeText("name", name));
 		bone.m_name.create(getMemoryPool(), name);
 
-		// transform
-		ANKI_CHECK(boneEl.getAttributeNumbers("transform", bone.m_transform));
+		// transform. The files store full 4x4 matrices but only the affine part is needed
+		Mat4 m4;
+		ANKI_CHECK(boneEl.getAttributeNumbers("transform", m4));
+		bone.m_transform = Mat3x4(m4);
 
 		// boneTransform
-		ANKI_CHECK(boneEl.getAttributeNumbers("boneTransform", bone.m_vertTrf));
+		ANKI_CHECK(boneEl.getAttributeNumbers("boneTransform", m4));
+		bone.m_vertTrf = Mat3x4(m4);
 
 		// parent
 		CString parent;
@@ -122,7 +136,79 @@ Error SkeletonResource::load(const ResourceFilename& filename, [[maybe_unused]]
 		++it;
 	}
 
+	// Flatten the hierarchy. Breadth-first from the root puts the parents before their children
+	if(m_rootBoneIdx == kMaxU32)
+	{
+		ANKI_RESOURCE_LOGE("Skeleton doesn't have a root bone");
+		return Error::kUserData;
+	}
+
+	m_hierarchyOrder.create(getMemoryPool(), m_bones.getSize());
+	m_parentIndices.create(getMemoryPool(), m_bones.getSize());
+	U32 orderedCount = 0;
+	m_hierarchyOrder[orderedCount++] = m_rootBoneIdx;
+	for(U32 i = 0; i < orderedCount; ++i)
+	{
+		const Bone& bone = m_bones[m_hierarchyOrder[i]];
+		m_parentIndices[bone.m_idx] = (bone.m_parent) ? bone.m_parent->m_idx : kMaxU32;
+
+		for(const Bone* child : bone.getChildren())
+		{
+			m_hierarchyOrder[orderedCount++] = child->m_idx;
+		}
+	}
+
+	if(orderedCount != m_bones.getSize())
+	{
+		ANKI_RESOURCE_LOGE("Some bones are not connected to the root bone");
+		return Error::kUserData;
+	}
+
 	return Error::kNone;
 }
 
+const AnimationBinding& SkeletonResource::getAnimationBinding(const AnimationResource& anim) const
+{
+	// Check if the binding is in the cache
+	{
+		RLockGuard<RWMutex> lock(m_animationBindingsMtx);
+
+		auto it = m_animationBindings.find(anim.getUuid());
+		if(it != m_animationBindings.getEnd())
+		{
+			return **it;
+		}
+	}
+
+	WLockGuard<RWMutex> lock(m_animationBindingsMtx);
+
+	// Check again
+	auto it = m_animationBindings.find(anim.getUuid());
+	if(it != m_animationBindings.getEnd())
+	{
+		return **it;
+	}
+
+	// Create
+	AnimationBinding* binding = newInstance<AnimationBinding>(getMemoryPool());
+	binding->m_channelBoneIndices.create(getMemoryPool(), anim.getChannels().getSize());
+
+	for(U32 i = 0; i < anim.getChannels().getSize(); ++i)
+	{
+		const AnimationChannel& channel = anim.getChannels()[i];
+		const Bone* bone = tryFindBone(channel.m_name.toCString());
+		if(!bone)
+		{
+			ANKI_RESOURCE_LOGW("Animation %s is referencing unknown bone \"%s\" of skeleton %s",
+							   anim.getFilename().cstr(), channel.m_name.cstr(), getFilename().cstr());
+		}
+
+		binding->m_channelBoneIndices[i] = (bone) ? bone->getIndex() : kMaxU32;
+	}
+
+	m_animationBindings.emplace(getMemoryPool(), anim.getUuid(), binding);
+
+	return *binding;
+}
+
 } // end namespace anki
@@ -8,9 +8,14 @@
 #include <AnKi/Resource/ResourceObject.h>
 #include <AnKi/Math.h>
 #include <AnKi/Util/WeakArray.h>
+#include <AnKi/Util/HashMap.h>
+#include <AnKi/Util/Thread.h>
 
 namespace anki {
 
+// Forward
+class AnimationResource;
+
 /// @addtogroup resource
 /// @{
 
@@ -31,12 +36,12 @@ public:
 		return m_name;
 	}
 
-	const Mat4& getTransform() const
+	const Mat3x4& getTransform() const
 	{
 		return m_transform;
 	}
 
-	const Mat4& getVertexTransform() const
+	const Mat3x4& getVertexTransform() const
 	{
 		return m_vertTrf;
 	}
@@ -59,8 +64,8 @@ public:
 private:
 	String m_name; ///< The name of the bone
 
-	Mat4 m_transform; ///< See the class notes.
-	Mat4 m_vertTrf;
+	Mat3x4 m_transform; ///< See the class notes.
+	Mat3x4 m_vertTrf;
 
 	U32 m_idx;
 
@@ -74,6 +79,24 @@ private:
 	}
 };
 
+/// Maps the channels of an AnimationResource to the bones of a SkeletonResource. It's built once per skeleton and
+/// animation pair so the bones don't have to be searched by name every frame.
+/// @see SkeletonResource::getAnimationBinding
+class AnimationBinding
+{
+	friend class SkeletonResource;
+
+public:
+	/// The index of the bone that every channel animates. kMaxU32 if the skeleton doesn't have such bone.
+	ConstWeakArray<U32> getChannelBoneIndices() const
+	{
+		return m_channelBoneIndices;
+	}
+
+private:
+	DynamicArray<U32> m_channelBoneIndices;
+};
+
 /// It contains the bones with their position and hierarchy
 ///
 /// XML file format:
@@ -128,9 +151,31 @@ public:
 		return m_bones[m_rootBoneIdx];
 	}
 
+	/// The indices of the bones sorted so that every bone comes after its parent. Walking the bones in that order
+	/// replaces the recursive visit of the hierarchy.
+	ConstWeakArray<U32> getBonesInHierarchyOrder() const
+	{
+		return m_hierarchyOrder;
+	}
+
+	/// The index of the parent of every bone or kMaxU32 for the root.
+	ConstWeakArray<U32> getBoneParentIndices() const
+	{
+		return m_parentIndices;
+	}
+
+	/// Get the binding of an animation to this skeleton. It will be created the 1st time it's requested.
+	/// @note It's thread-safe.
+	const AnimationBinding& getAnimationBinding(const AnimationResource& anim) const;
+
 private:
 	DynamicArray<Bone> m_bones;
 	U32 m_rootBoneIdx = kMaxU32;
+	DynamicArray<U32> m_hierarchyOrder;
+	DynamicArray<U32> m_parentIndices;
+
+	mutable HashMap<U64, AnimationBinding*> m_animationBindings; ///< Indexed by the UUID of the AnimationResource.
+	mutable RWMutex m_animationBindingsMtx;
 };
 /// @}
 
@@ -0,0 +1,190 @@
+// Copyright (C) 2009-2022, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <AnKi/Scene/AnimationSystem.h>
+#include <AnKi/Scene/SceneComponentStorage.h>
+#include <AnKi/Scene/Components/SkinComponent.h>
+#include <AnKi/Resource/AnimationResource.h>
+#include <AnKi/Resource/SkeletonResource.h>
+#include <AnKi/Core/GpuMemoryPools.h>
+#include <AnKi/Util/Tracer.h>
+#include <algorithm>
+
+namespace anki {
+
+class AnimationSystem::UpdateCtx
+{
+public:
+	AnimationSystem* m_system = nullptr;
+	Second m_dt = 0.0;
+	U8* m_palettes = nullptr; ///< The mapped memory of the bone palettes.
+	PtrSize m_palettesOffset = 0; ///< The offset of m_palettes in the staging buffer.
+	Atomic<U32> m_nextBatch = {0};
+};
+
+AnimationSystem::~AnimationSystem()
+{
+	if(m_pool)
+	{
+		m_components.destroy(*m_pool);
+
+		for(DynamicArray<AnimationChannelTransform>& pose : m_poses)
+		{
+			pose.destroy(*m_pool);
+		}
+	}
+}
+
+void AnimationSystem::updateTaskCallback(void* ud, U32 threadId, [[maybe_unused]] ThreadHive& hive,
+										 [[maybe_unused]] ThreadHiveSemaphore* sem)
+{
+	UpdateCtx& ctx = *static_cast<UpdateCtx*>(ud);
+	AnimationSystem& self = *ctx.m_system;
+	const U32 count = self.m_components.getSize();
+	const WeakArray<AnimationChannelTransform> pose(self.m_poses[threadId]);
+
+	U32 begin;
+	while((begin = ctx.m_nextBatch.fetchAdd(1) * kBatchSize) < count)
+	{
+		const U32 end = min(begin + kBatchSize, count);
+		for(U32 i = begin; i < end; ++i)
+		{
+			SkinComponent& skinc = *self.m_components[i];
+			skinc.animate(ctx.m_dt, pose);
+
+			if(ctx.m_palettes)
+			{
+				memcpy(ctx.m_palettes + (skinc.m_boneTrfsToken.m_offset - ctx.m_palettesOffset),
+					   skinc.getBoneTransforms().getBegin(), skinc.m_boneTrfsToken.m_range);
+				memcpy(ctx.m_palettes + (skinc.m_prevBoneTrfsToken.m_offset - ctx.m_palettesOffset),
+					   skinc.getPreviousFrameBoneTransforms().getBegin(), skinc.m_prevBoneTrfsToken.m_range);
+			}
+		}
+	}
+}
+
+U8* AnimationSystem::allocatePalettes(PtrSize& palettesOffset)
+{
+	PtrSize size = 0;
+	for(const SkinComponent* skinc : m_components)
+	{
+		size += 2 * getAlignedRoundUp(m_storageBufferAlignment, skinc->getBoneTransforms().getSizeInBytes());
+	}
+
+	StagingGpuMemoryToken token;
+	U8* palettes = nullptr;
+	if(m_stagingMem)
+	{
+		palettes = static_cast<U8*>(m_stagingMem->tryAllocateFrame(size, StagingGpuMemoryType::kStorage, token));
+		if(!palettes)
+		{
+			ANKI_SCENE_LOGW("Out of staging memory for the bone palettes. The draws will upload them");
+		}
+	}
+
+	PtrSize offset = token.m_offset;
+	for(SkinComponent* skinc : m_components)
+	{
+		if(!palettes)
+		{
+			skinc->m_boneTrfsToken.markUnused();
+			skinc->m_prevBoneTrfsToken.markUnused();
+			continue;
+		}
+
+		const PtrSize range = skinc->getBoneTransforms().getSizeInBytes();
+		const Array<StagingGpuMemoryToken*, 2> outTokens = {&skinc->m_boneTrfsToken, &skinc->m_prevBoneTrfsToken};
+		for(StagingGpuMemoryToken* out : outTokens)
+		{
+			out->m_buffer = token.m_buffer;
+			out->m_offset = offset;
+			out->m_range = range;
+			out->m_type = StagingGpuMemoryType::kStorage;
+			offset += getAlignedRoundUp(m_storageBufferAlignment, range);
+		}
+	}
+
+	palettesOffset = token.m_offset;
+	return palettes;
+}
+
+void AnimationSystem::update(const SceneComponentStorage& storage, Second dt, ThreadHive& hive)
+{
+	ANKI_ASSERT(m_pool);
+	ANKI_TRACE_SCOPED_EVENT(SCENE_ANIMATION_UPDATE);
+
+	// Gather the components that have a skeleton
+	const ConstWeakArray<SceneComponent*> comps = storage.getComponents(SkinComponent::getStaticClassId());
+	m_components.resize(*m_pool, comps.getSize());
+	U32 count = 0;
+	U32 maxChannelCount = 0;
+	for(SceneComponent* comp : comps)
+	{
+		SkinComponent& skinc = static_cast<SkinComponent&>(*comp);
+		if(skinc.isEnabled())
+		{
+			m_components[count++] = &skinc;
+			maxChannelCount = max(maxChannelCount, skinc.getMaxChannelCount());
+		}
+		else
+		{
+			skinc.m_bonesUpdated = false;
+			skinc.m_boneTrfsToken.markUnused();
+			skinc.m_prevBoneTrfsToken.markUnused();
+		}
+	}
+
+	m_components.resize(*m_pool, count);
+	if(count == 0)
+	{
+		return;
+	}
+
+	// Group by skeleton and then by the animation of the 1st track
+	std::sort(m_components.getBegin(), m_components.getEnd(),
+			  [](const SkinComponent* a, const SkinComponent* b) {
+				  const SkeletonResource* skeletonA = a->m_skeleton.get();
+				  const SkeletonResource* skeletonB = b->m_skeleton.get();
+				  if(skeletonA != skeletonB)
+				  {
+					  return skeletonA < skeletonB;
+				  }
+
+				  return a->m_tracks[0].m_anim.get() < b->m_tracks[0].m_anim.get();
+			  });
+
+	// Make sure every thread can decode the biggest pose. The tasks may run in any thread
+	for(U32 i = 0; i < hive.getThreadCount(); ++i)
+	{
+		if(m_poses[i].getSize() < maxChannelCount)
+		{
+			m_poses[i].resize(*m_pool, maxChannelCount);
+		}
+	}
+
+	UpdateCtx ctx;
+	ctx.m_system = this;
+	ctx.m_dt = dt;
+	ctx.m_palettes = allocatePalettes(ctx.m_palettesOffset);
+
+	const U32 taskCount = min(hive.getThreadCount(), (count + kBatchSize - 1) / kBatchSize);
+	if(taskCount <= 1)
+	{
+		updateTaskCallback(&ctx, 0, hive, nullptr);
+		return;
+	}
+
+	Array<ThreadHiveTask, ThreadHive::kMaxThreads> tasks;
+	for(U32 i = 0; i < taskCount; ++i)
+	{
+		tasks[i].m_argument = &ctx;
+		tasks[i].m_callback = updateTaskCallback;
+	}
+
+	hive.submitTasks(&tasks[0], taskCount);
+	hive.waitAllTasks();
+}
+
+} // end namespace anki
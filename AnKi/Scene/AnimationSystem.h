@@ -0,0 +1,76 @@
+// Copyright (C) 2009-2022, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#pragma once
+
+#include <AnKi/Scene/Common.h>
+#include <AnKi/Util/DynamicArray.h>
+#include <AnKi/Util/ThreadHive.h>
+
+namespace anki {
+
+// Forward
+class SkinComponent;
+class SceneComponentStorage;
+class AnimationChannelTransform;
+class StagingGpuMemoryPool;
+
+/// @addtogroup scene
+/// @{
+
+/// Animates all SkinComponents before the scene nodes get updated. The components are grouped by skeleton and split in
+/// batches that the ThreadHive processes in parallel. Neighbouring components share the same skeleton and animation
+/// data so a batch stays warm in the caches. The bone palettes of all components are written once per frame to a single
+/// block of staging GPU memory and the draws bind ranges of it.
+class AnimationSystem
+{
+public:
+	/// The number of SkinComponents a task processes at a time.
+	static constexpr U32 kBatchSize = 8;
+
+	AnimationSystem() = default;
+
+	AnimationSystem(const AnimationSystem&) = delete; // Non-copyable
+
+	~AnimationSystem();
+
+	AnimationSystem& operator=(const AnimationSystem&) = delete; // Non-copyable
+
+	/// @param pool The pool for the internal structures.
+	/// @param stagingMem Where the bone palettes will be uploaded. If it's nullptr there will be no uploads.
+	/// @param storageBufferAlignment The alignment of the storage buffer bindings.
+	void init(HeapMemoryPool* pool, StagingGpuMemoryPool* stagingMem, U32 storageBufferAlignment)
+	{
+		ANKI_ASSERT(pool && storageBufferAlignment > 0);
+		m_pool = pool;
+		m_stagingMem = stagingMem;
+		m_storageBufferAlignment = storageBufferAlignment;
+	}
+
+	/// Animate all SkinComponents. Don't call it from a ThreadHive task.
+	/// @param dt The time since the last update.
+	void update(const SceneComponentStorage& storage, Second dt, ThreadHive& hive);
+
+private:
+	class UpdateCtx;
+
+	HeapMemoryPool* m_pool = nullptr;
+	StagingGpuMemoryPool* m_stagingMem = nullptr;
+	U32 m_storageBufferAlignment = 1;
+
+	DynamicArray<SkinComponent*> m_components; ///< The enabled components sorted by skeleton.
+
+	/// Scratch memory to decode poses. One per thread.
+	Array<DynamicArray<AnimationChannelTransform>, ThreadHive::kMaxThreads> m_poses;
+
+	/// Allocate the bone palettes of this frame and give every component its ranges.
+	/// @return The CPU address of the palettes or nullptr if there is no staging memory.
+	U8* allocatePalettes(PtrSize& palettesOffset);
+
+	static void updateTaskCallback(void* ud, U32 threadId, ThreadHive& hive, ThreadHiveSemaphore* sem);
+};
+/// @}
+
+} // end namespace anki
@@ -73,8 +73,8 @@ void CameraNode::initCommon(FrustumType frustumType)
 	frc->setShadowCascadeDistance(3, getConfig().getSceneShadowCascade3Distance());
 
 	// Extended frustum for RT
-	if(getSceneGraph().getGrManager().getDeviceCapabilities().m_rayTracingEnabled
-	   && getConfig().getSceneRayTracedShadows())
+	if(getConfig().getSceneRayTracedShadows() && getSceneGraph().hasResourceManager()
+	   && getSceneGraph().getGrManager().getDeviceCapabilities().m_rayTracingEnabled)
 	{
 		FrustumComponent* rtFrustumComponent = newComponent<FrustumComponent>();
 		rtFrustumComponent->setFrustumType(FrustumType::kOrthographic);
@@ -35,6 +35,7 @@ FrustumComponent::FrustumComponent(SceneNode* node)
 FrustumComponent::~FrustumComponent()
 {
 	m_coverageBuff.m_depthMap.destroy(m_node->getMemoryPool());
+	m_visibleSpatialsCache.m_spatials.destroy(m_node->getMemoryPool());
 }
 
 Bool FrustumComponent::updateInternal()
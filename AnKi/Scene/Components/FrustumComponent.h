@@ -329,6 +329,23 @@ public:
 		}
 	}
 
+	/// The spatials that were not rejected by the last visibility tests. Used by the incremental visibility.
+	class VisibleSpatialsCache
+	{
+	public:
+		DynamicArray<SpatialComponent*> m_spatials;
+		Timestamp m_timestamp = 0; ///< The update that the cache was built. Zero if it wasn't.
+		U32 m_spatialRemovalCount = 0; ///< See SceneGraph::getSpatialRemovalCount.
+		FrustumComponentVisibilityTestFlag m_flags = FrustumComponentVisibilityTestFlag::kNone;
+		U32 m_reusedSpatialCount = 0; ///< How many spatials the last update re-used without testing them.
+	};
+
+	/// It's a cache so the visibility tests can update it even if they see a const component.
+	ANKI_INTERNAL VisibleSpatialsCache& getVisibleSpatialsCache() const
+	{
+		return m_visibleSpatialsCache;
+	}
+
 	void setShadowCascadeDistance(U32 cascade, F32 distance)
 	{
 		m_misc.m_shadowCascadeDistances[cascade] = distance;
@@ -467,6 +484,8 @@ private:
 		U32 m_depthMapHeight = 0;
 	} m_coverageBuff; ///< Coverage buffer for extra visibility tests.
 
+	mutable VisibleSpatialsCache m_visibleSpatialsCache;
+
 	FrustumComponentVisibilityTestFlag m_flags = FrustumComponentVisibilityTestFlag::kNone;
 	Bool m_shapeMarkedForUpdate : 1;
 	Bool m_trfMarkedForUpdate : 1;
@@ -28,8 +28,11 @@ LightComponent::LightComponent(SceneNode* node)
 	ANKI_ASSERT(m_uuid > 0);
 	m_point.m_radius = 1.0f;
 
-	if(node->getSceneGraph().getResourceManager().loadResource("EngineAssets/LightBulb.ankitex", m_pointDebugImage)
-	   || node->getSceneGraph().getResourceManager().loadResource("EngineAssets/SpotLight.ankitex", m_spotDebugImage))
+	// The debug images are only for drawing so a graph without resources can do without them
+	SceneGraph& scene = node->getSceneGraph();
+	if(scene.hasResourceManager()
+	   && (scene.getResourceManager().loadResource("EngineAssets/LightBulb.ankitex", m_pointDebugImage)
+		   || scene.getResourceManager().loadResource("EngineAssets/SpotLight.ankitex", m_spotDebugImage)))
 	{
 		ANKI_SCENE_LOGF("Failed to load resources");
 	}
@@ -14,6 +14,7 @@ MoveComponent::MoveComponent(SceneNode* node)
 	: SceneComponent(node, getStaticClassId())
 	, m_ignoreLocalTransform(false)
 	, m_ignoreParentTransform(false)
+	, m_worldTransformUpdated(false)
 {
 	markForUpdate();
 }
@@ -30,42 +31,21 @@ Error MoveComponent::update(SceneComponentUpdateInfo& info, Bool& updated)
 
 Bool MoveComponent::updateWorldTransform(SceneNode& node)
 {
-	m_prevWTrf = m_wtrf;
+	// The TransformHierarchy might have already updated the transform this frame. In that case only catch the moves
+	// that happened after it
+	const Bool updatedByHierarchy = m_hierarchyUpdateTimestamp == node.getGlobalTimestamp();
+	if(!updatedByHierarchy)
+	{
+		m_prevWTrf = m_wtrf;
+	}
+
 	const Bool dirty = m_markedForUpdate;
 
 	// If dirty then update world transform
 	if(dirty)
 	{
 		const SceneNode* parent = node.getParent();
-
-		if(parent)
-		{
-			const MoveComponent* parentMove = parent->tryGetFirstComponentOfType<MoveComponent>();
-
-			if(parentMove == nullptr)
-			{
-				// Parent not movable
-				m_wtrf = m_ltrf;
-			}
-			else if(m_ignoreParentTransform)
-			{
-				m_wtrf = m_ltrf;
-			}
-			else if(m_ignoreLocalTransform)
-			{
-				m_wtrf = parentMove->getWorldTransform();
-			}
-			else
-			{
-				m_wtrf = parentMove->getWorldTransform().combineTransformations(m_ltrf);
-			}
-		}
-		else
-		{
-			// No parent
-
-			m_wtrf = m_ltrf;
-		}
+		computeWorldTransform((parent) ? parent->tryGetFirstComponentOfType<MoveComponent>() : nullptr);
 
 		// Now it's a good time to cleanse parent
 		m_markedForUpdate = false;
@@ -82,7 +62,7 @@ Bool MoveComponent::updateWorldTransform(SceneNode& node)
 		});
 	}
 
-	return dirty;
+	return dirty || (updatedByHierarchy && m_worldTransformUpdated);
 }
 
 } // end namespace anki
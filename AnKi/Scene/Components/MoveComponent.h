@@ -20,6 +20,8 @@ class MoveComponent : public SceneComponent
 {
 	ANKI_SCENE_COMPONENT(MoveComponent)
 
+	friend class TransformHierarchy;
+
 public:
 	MoveComponent(SceneNode* node);
 
@@ -151,9 +153,15 @@ private:
 	/// Keep the previous transformation for checking if it moved
 	Transform m_prevWTrf = Transform::getIdentity();
 
+	/// When the TransformHierarchy updated the world transform.
+	Timestamp m_hierarchyUpdateTimestamp = 0;
+
+	U32 m_hierarchyIndex = kMaxU32; ///< Index in the TransformHierarchy arrays.
+
 	Bool m_markedForUpdate : 1;
 	Bool m_ignoreLocalTransform : 1;
 	Bool m_ignoreParentTransform : 1;
+	Bool m_worldTransformUpdated : 1; ///< The TransformHierarchy changed the world transform.
 
 	void markForUpdate()
 	{
@@ -162,6 +170,24 @@ private:
 
 	/// Called every frame. It updates the @a m_wtrf if @a shouldUpdateWTrf is true. Then it moves to the children.
 	Bool updateWorldTransform(SceneNode& node);
+
+	/// Compute the world transform from the local and the parent's world transform.
+	void computeWorldTransform(const MoveComponent* parentMove)
+	{
+		if(parentMove == nullptr || m_ignoreParentTransform)
+		{
+			// No parent or parent not movable
+			m_wtrf = m_ltrf;
+		}
+		else if(m_ignoreLocalTransform)
+		{
+			m_wtrf = parentMove->getWorldTransform();
+		}
+		else
+		{
+			m_wtrf = parentMove->getWorldTransform().combineTransformations(m_ltrf);
+		}
+	}
 };
 /// @}
 
@@ -28,6 +28,44 @@ static Vec3 getRandom(const Vec3& min, const Vec3& max)
 	return out;
 }
 
+/// ParticleCollisionCallback that casts the rays against the static geometry of the physics world.
+static void collideWithWorld(void* userData, WeakArray<ParticleCollisionRay> rays)
+{
+	class RayCast : public PhysicsWorldRayCastCallback
+	{
+	public:
+		ParticleCollisionRay* m_ray = nullptr;
+
+		RayCast()
+			: PhysicsWorldRayCastCallback(Vec3(0.0f), Vec3(0.0f), PhysicsMaterialBit::kStaticGeometry)
+		{
+		}
+
+		void processResult([[maybe_unused]] PhysicsFilteredObject& obj, const Vec3& worldNormal,
+						   const Vec3& worldPosition) override
+		{
+			// Every result is closer than the previous one
+			m_ray->m_hit = true;
+			m_ray->m_hitNormal = worldNormal;
+			m_ray->m_hitPosition = worldPosition;
+		}
+	};
+
+	ANKI_ASSERT(rays.getSize() <= ParticleSimulation::kCollisionBatchSize);
+	Array<RayCast, ParticleSimulation::kCollisionBatchSize> rayCasts;
+	Array<PhysicsWorldRayCastCallback*, ParticleSimulation::kCollisionBatchSize> rayCastPtrs;
+	for(U32 i = 0; i < rays.getSize(); ++i)
+	{
+		rayCasts[i].m_from = rays[i].m_from;
+		rayCasts[i].m_to = rays[i].m_to;
+		rayCasts[i].m_ray = &rays[i];
+		rayCastPtrs[i] = &rayCasts[i];
+	}
+
+	static_cast<const PhysicsWorld*>(userData)->rayCast(
+		WeakArray<PhysicsWorldRayCastCallback*>(&rayCastPtrs[0], rays.getSize()));
+}
+
 /// Particle base
 class ParticleEmitterComponent::ParticleBase
 {
@@ -85,45 +123,6 @@ public:
 	}
 };
 
-/// Simple particle for simple simulation
-class ParticleEmitterComponent::SimpleParticle : public ParticleEmitterComponent::ParticleBase
-{
-public:
-	Vec3 m_velocity = Vec3(0.0f);
-	Vec3 m_acceleration = Vec3(0.0f);
-
-	void kill()
-	{
-		killCommon();
-	}
-
-	void revive(const ParticleEmitterProperties& props, const Transform& trf, Second crntTime)
-	{
-		reviveCommon(props, crntTime);
-		m_velocity = Vec3(0.0f);
-
-		m_acceleration = getRandom(props.m_particle.m_minGravity, props.m_particle.m_maxGravity);
-
-		// Set the initial position
-		m_crntPosition = getRandom(props.m_particle.m_minStartingPosition, props.m_particle.m_maxStartingPosition);
-		m_crntPosition += trf.getOrigin().xyz();
-	}
-
-	void simulate(Second prevUpdateTime, Second crntTime)
-	{
-		simulateCommon(crntTime);
-
-		const F32 dt = F32(crntTime - prevUpdateTime);
-
-		const Vec3 xp = m_crntPosition;
-		const Vec3 xc = m_acceleration * (dt * dt) + m_velocity * dt + xp;
-
-		m_crntPosition = xc;
-
-		m_velocity += m_acceleration * dt;
-	}
-};
-
 /// Particle for bullet simulations
 class ParticleEmitterComponent::PhysicsParticle : public ParticleEmitterComponent::ParticleBase
 {
@@ -203,7 +202,6 @@ ParticleEmitterComponent::ParticleEmitterComponent(SceneNode* node)
 
 ParticleEmitterComponent::~ParticleEmitterComponent()
 {
-	m_simpleParticles.destroy(m_node->getMemoryPool());
 	m_physicsParticles.destroy(m_node->getMemoryPool());
 }
 
@@ -221,7 +219,7 @@ Error ParticleEmitterComponent::loadParticleEmitterResource(CString filename)
 	m_props = m_particleEmitterResource->getProperties();
 
 	// Cleanup
-	m_simpleParticles.destroy(m_node->getMemoryPool());
+	m_simpleSimulation.destroy();
 	m_physicsParticles.destroy(m_node->getMemoryPool());
 
 	// Init particles
@@ -243,7 +241,9 @@ Error ParticleEmitterComponent::loadParticleEmitterResource(CString filename)
 	}
 	else
 	{
-		m_simpleParticles.create(m_node->getMemoryPool(), m_props.m_maxNumOfParticles);
+		m_simpleSimulation.init(&m_node->getMemoryPool(), m_props.m_maxNumOfParticles, getRandom());
+		m_simpleSimulation.setCollisionCallback((m_props.m_worldCollisions) ? collideWithWorld : nullptr,
+												&m_node->getSceneGraph().getPhysicsWorld(), m_props.m_bounciness);
 	}
 
 	m_vertBuffSize = m_props.m_maxNumOfParticles * kVertexSize;
@@ -263,19 +263,18 @@ Error ParticleEmitterComponent::update(SceneComponentUpdateInfo& info, Bool& upd
 
 	if(m_simulationType == SimulationType::kSimple)
 	{
-		simulate(info.m_previousTime, info.m_currentTime, WeakArray<SimpleParticle>(m_simpleParticles));
+		simulateSimple(info.m_previousTime, info.m_currentTime);
 	}
 	else
 	{
 		ANKI_ASSERT(m_simulationType == SimulationType::kPhysicsEngine);
-		simulate(info.m_previousTime, info.m_currentTime, WeakArray<PhysicsParticle>(m_physicsParticles));
+		simulatePhysics(info.m_previousTime, info.m_currentTime);
 	}
 
 	return Error::kNone;
 }
 
-template<typename TParticle>
-void ParticleEmitterComponent::simulate(Second prevUpdateTime, Second crntTime, WeakArray<TParticle> particles)
+void ParticleEmitterComponent::simulatePhysics(Second prevUpdateTime, Second crntTime)
 {
 	// - Deactivate the dead particles
 	// - Calc the AABB
@@ -290,7 +289,7 @@ void ParticleEmitterComponent::simulate(Second prevUpdateTime, Second crntTime,
 
 	F32 maxParticleSize = -1.0f;
 
-	for(TParticle& particle : particles)
+	for(PhysicsParticle& particle : m_physicsParticles)
 	{
 		if(particle.isDead())
 		{
@@ -352,7 +351,7 @@ void ParticleEmitterComponent::simulate(Second prevUpdateTime, Second crntTime,
 	if(m_timeLeftForNextEmission <= 0.0)
 	{
 		U particleCount = 0; // How many particles I am allowed to emmit
-		for(TParticle& particle : particles)
+		for(PhysicsParticle& particle : m_physicsParticles)
 		{
 			if(!particle.isDead())
 			{
@@ -378,6 +377,39 @@ void ParticleEmitterComponent::simulate(Second prevUpdateTime, Second crntTime,
 	}
 }
 
+void ParticleEmitterComponent::simulateSimple(Second prevUpdateTime, Second crntTime)
+{
+	const F32 dt = F32(crntTime - prevUpdateTime);
+
+	F32* verts = static_cast<F32*>(m_node->getFrameMemoryPool().allocate(m_vertBuffSize, alignof(F32)));
+
+	Vec3 aabbMin, aabbMax;
+	F32 maxParticleSize;
+	m_aliveParticleCount = m_simpleSimulation.simulate(dt, verts, aabbMin, aabbMax, maxParticleSize);
+
+	if(m_aliveParticleCount != 0)
+	{
+		m_worldBoundingVolume = Aabb(aabbMin - maxParticleSize, aabbMax + maxParticleSize);
+		m_verts = verts;
+	}
+	else
+	{
+		m_worldBoundingVolume = Aabb(Vec3(0.0f), Vec3(0.001f));
+		m_verts = nullptr;
+	}
+
+	// Emit new particles. They are appended after the alive ones
+	if(m_timeLeftForNextEmission <= 0.0)
+	{
+		m_simpleSimulation.emit(m_props, m_transform.getOrigin().xyz(), m_props.m_particlesPerEmission);
+		m_timeLeftForNextEmission = m_props.m_emissionPeriod;
+	}
+	else
+	{
+		m_timeLeftForNextEmission -= dt;
+	}
+}
+
 void ParticleEmitterComponent::draw(RenderQueueDrawContext& ctx) const
 {
 	// Early exit
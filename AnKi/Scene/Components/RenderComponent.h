@@ -101,6 +101,48 @@ public:
 		return m_rtCallback != nullptr;
 	}
 
+	/// Set the info that the screen-space error LOD selection needs.
+	/// @param lodErrors The geometric error of every LOD relative to the radius of the bounding sphere.
+	/// @param triangleCounts The triangle count of every LOD.
+	void setLodInfo(ConstWeakArray<F32> lodErrors, ConstWeakArray<U32> triangleCounts)
+	{
+		ANKI_ASSERT(lodErrors.getSize() == triangleCounts.getSize() && lodErrors.getSize() <= kMaxLodCount);
+		m_lodCount = U8(lodErrors.getSize());
+		for(U32 l = 0; l < m_lodCount; ++l)
+		{
+			m_lodErrors[l] = lodErrors[l];
+			m_triangleCounts[l] = triangleCounts[l];
+		}
+	}
+
+	/// The LOD errors or an empty array if setLodInfo() wasn't called.
+	ConstWeakArray<F32> getLodErrors() const
+	{
+		return ConstWeakArray<F32>(&m_lodErrors[0], m_lodCount);
+	}
+
+	U32 getTriangleCount(U32 lod) const
+	{
+		return (lod < m_lodCount) ? m_triangleCounts[lod] : 0;
+	}
+
+	/// Get the LOD the primary frustum selected in the previous frame or kMaxU8 if there was none.
+	/// @note It's thread-safe against setCurrentLod().
+	U8 getPreviousLod(Timestamp crntTimestamp, Timestamp prevTimestamp) const
+	{
+		// The previous frame is in the other slot only if the timestamps are consecutive
+		const LodHistory& history = m_lodHistory[prevTimestamp & 1];
+		return (prevTimestamp + 1 == crntTimestamp && history.m_timestamp == prevTimestamp) ? history.m_lod : kMaxU8;
+	}
+
+	/// Remember the LOD the primary frustum selected in this frame.
+	void setCurrentLod(U8 lod, Timestamp crntTimestamp) const
+	{
+		LodHistory& history = m_lodHistory[crntTimestamp & 1];
+		history.m_timestamp = crntTimestamp;
+		history.m_lod = lod;
+	}
+
 	/// Helper function.
 	static void allocateAndSetupUniforms(const MaterialResourcePtr& mtl, const RenderQueueDrawContext& ctx,
 										 ConstWeakArray<Mat3x4> transforms, ConstWeakArray<Mat3x4> prevTransforms,
@@ -108,12 +150,24 @@ public:
 										 const Vec4& positionScaleAndTranslation = Vec4(1.0f, 0.0f, 0.0f, 0.0f));
 
 private:
+	/// The LOD of a frame. Used for the hysteresis of the LOD selection.
+	class LodHistory
+	{
+	public:
+		Timestamp m_timestamp = 0;
+		U8 m_lod = 0;
+	};
+
 	RenderQueueDrawCallback m_callback = nullptr;
 	const void* m_userData = nullptr;
 	U64 m_mergeKey = kMaxU64;
 	FillRayTracingInstanceQueueElementCallback m_rtCallback = nullptr;
 	const void* m_rtCallbackUserData = nullptr;
 	RenderComponentFlag m_flags = RenderComponentFlag::kNone;
+	U8 m_lodCount = 0;
+	Array<F32, kMaxLodCount> m_lodErrors = {};
+	Array<U32, kMaxLodCount> m_triangleCounts = {};
+	mutable Array<LodHistory, 2> m_lodHistory;
 };
 /// @}
 
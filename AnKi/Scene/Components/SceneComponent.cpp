@@ -7,7 +7,6 @@
 
 namespace anki {
 
-constexpr U32 kMaxSceneComponentClasses = 64;
 static_assert(kMaxSceneComponentClasses < 128, "It can oly be 7 bits because of SceneComponent::m_classId");
 static SceneComponentRtti* g_rttis[kMaxSceneComponentClasses] = {};
 static U32 g_rttiCount = 0;
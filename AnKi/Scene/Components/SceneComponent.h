@@ -14,6 +14,9 @@ namespace anki {
 /// @addtogroup scene
 /// @{
 
+/// The max number of component classes. SceneNode keeps a bit mask of its component types so it can't exceed 64.
+constexpr U32 kMaxSceneComponentClasses = 64;
+
 /// Scene component class info.
 class SceneComponentRtti
 {
@@ -59,6 +62,7 @@ public:
 	const Second m_previousTime;
 	const Second m_currentTime;
 	const Second m_dt;
+	U32 m_threadId = 0; ///< The ThreadHive thread that does the update.
 
 	SceneComponentUpdateInfo(Second prevTime, Second crntTime)
 		: m_previousTime(prevTime)
@@ -71,6 +75,8 @@ public:
 /// Scene node component
 class SceneComponent
 {
+	friend class SceneComponentStorage;
+
 public:
 	/// Construct the scene component.
 	SceneComponent(SceneNode* node, U8 classId, Bool isFeedbackComponent = false);
@@ -94,6 +100,13 @@ public:
 		return m_feedbackComponent;
 	}
 
+	/// Components that are not created by SceneNode::newComponent (eg temporary ones) are not registered to the
+	/// SceneComponentStorage.
+	Bool isRegistered() const
+	{
+		return m_storageIndex != kMaxU32;
+	}
+
 	/// Do some updating
 	/// @param[in,out] info Update info.
 	/// @param[out] updated true if an update happened.
@@ -117,6 +130,7 @@ public:
 
 private:
 	Timestamp m_timestamp = 1; ///< Indicates when an update happened
+	U32 m_storageIndex = kMaxU32; ///< The index in the dense array of SceneComponentStorage.
 	U8 m_classId : 7; ///< Cache the type ID.
 	U8 m_feedbackComponent : 1;
 };
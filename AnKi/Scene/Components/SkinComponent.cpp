@@ -19,6 +19,8 @@ SkinComponent::SkinComponent(SceneNode* node)
 	: SceneComponent(node, getStaticClassId())
 	, m_node(node)
 {
+	m_boneTrfsToken.markUnused();
+	m_prevBoneTrfsToken.markUnused();
 }
 
 SkinComponent::~SkinComponent()
@@ -26,6 +28,11 @@ SkinComponent::~SkinComponent()
 	m_boneTrfs[0].destroy(m_node->getMemoryPool());
 	m_boneTrfs[1].destroy(m_node->getMemoryPool());
 	m_animationTrfs.destroy(m_node->getMemoryPool());
+
+	for(Track& track : m_tracks)
+	{
+		track.m_cursors.destroy(m_node->getMemoryPool());
+	}
 }
 
 Error SkinComponent::loadSkeletonResource(CString fname)
@@ -36,10 +43,21 @@ Error SkinComponent::loadSkeletonResource(CString fname)
 	m_boneTrfs[1].destroy(m_node->getMemoryPool());
 	m_animationTrfs.destroy(m_node->getMemoryPool());
 
-	m_boneTrfs[0].create(m_node->getMemoryPool(), m_skeleton->getBones().getSize(), Mat4::getIdentity());
-	m_boneTrfs[1].create(m_node->getMemoryPool(), m_skeleton->getBones().getSize(), Mat4::getIdentity());
+	m_boneTrfs[0].create(m_node->getMemoryPool(), m_skeleton->getBones().getSize(), Mat3x4::getIdentity());
+	m_boneTrfs[1].create(m_node->getMemoryPool(), m_skeleton->getBones().getSize(), Mat3x4::getIdentity());
 	m_animationTrfs.create(m_node->getMemoryPool(), m_skeleton->getBones().getSize(),
 						   {Vec3(0.0f), Quat::getIdentity(), 1.0f});
+	m_bonesUpdated = false;
+
+	// The palettes of this frame have the size of the old skeleton
+	m_boneTrfsToken.markUnused();
+	m_prevBoneTrfsToken.markUnused();
+
+	// The bindings belong to the old skeleton
+	for(Track& track : m_tracks)
+	{
+		track.m_binding = (track.m_anim.isCreated()) ? &m_skeleton->getAnimationBinding(*track.m_anim) : nullptr;
+	}
 
 	return Error::kNone;
 }
@@ -49,6 +67,13 @@ void SkinComponent::playAnimation(U32 track, AnimationResourcePtr anim, const An
 	const Second animDuration = anim->getDuration();
 
 	m_tracks[track].m_anim = anim;
+	m_tracks[track].m_binding = (m_skeleton.isCreated()) ? &m_skeleton->getAnimationBinding(*anim) : nullptr;
+	m_tracks[track].m_cursors.resize(m_node->getMemoryPool(), anim->getChannels().getSize());
+	for(AnimationChannelCursor& cursor : m_tracks[track].m_cursors)
+	{
+		cursor = AnimationChannelCursor();
+	}
+
 	m_tracks[track].m_absoluteStartTime = m_absoluteTime + info.m_startTime;
 	m_tracks[track].m_relativeTimePassed = 0.0;
 	if(info.m_repeatTimes > 0.0)
@@ -64,17 +89,30 @@ void SkinComponent::playAnimation(U32 track, AnimationResourcePtr anim, const An
 	m_tracks[track].m_repeatTimes = info.m_repeatTimes;
 }
 
-Error SkinComponent::update(SceneComponentUpdateInfo& info, Bool& updated)
+Error SkinComponent::update([[maybe_unused]] SceneComponentUpdateInfo& info, Bool& updated)
 {
 	ANKI_ASSERT(info.m_node == m_node);
 
-	updated = false;
-	if(!m_skeleton.isCreated())
+	// The work was done by the AnimationSystem
+	updated = m_skeleton.isCreated() && m_bonesUpdated;
+	return Error::kNone;
+}
+
+U32 SkinComponent::getMaxChannelCount() const
+{
+	U32 count = 0;
+	for(const Track& track : m_tracks)
 	{
-		return Error::kNone;
+		count = (track.m_anim.isCreated()) ? max(count, track.m_anim->getChannels().getSize()) : count;
 	}
 
-	const Second dt = info.m_dt;
+	return count;
+}
+
+void SkinComponent::animate(Second dt, WeakArray<AnimationChannelTransform> poseScratch)
+{
+	ANKI_ASSERT(m_skeleton.isCreated());
+	Bool updated = false;
 
 	Vec4 minExtend(kMaxF32, kMaxF32, kMaxF32, 0.0f);
 	Vec4 maxExtend(kMinF32, kMinF32, kMinF32, 0.0f);
@@ -108,23 +146,38 @@ Error SkinComponent::update(SceneComponentUpdateInfo& info, Bool& updated)
 		const Second animTime = track.m_relativeTimePassed;
 		track.m_relativeTimePassed += dt;
 
+		// Compressed animations decode the whole pose at once
+		const Bool compressed = track.m_anim->isCompressed();
+		if(compressed)
+		{
+			track.m_anim->samplePose(animTime, poseScratch);
+		}
+
 		// Iterate the animation channels and interpolate
-		for(U32 i = 0; i < track.m_anim->getChannels().getSize(); ++i)
+		ANKI_ASSERT(track.m_binding);
+		const ConstWeakArray<U32> channelBoneIndices = track.m_binding->getChannelBoneIndices();
+		for(U32 i = 0; i < channelBoneIndices.getSize(); ++i)
 		{
-			const AnimationChannel& channel = track.m_anim->getChannels()[i];
-			const Bone* bone = m_skeleton->tryFindBone(channel.m_name.toCString());
-			if(!bone)
+			const U32 boneIdx = channelBoneIndices[i];
+			if(boneIdx == kMaxU32)
 			{
-				ANKI_SCENE_LOGW("Animation is referencing unknown bone \"%s\"", &channel.m_name[0]);
 				continue;
 			}
-			const U32 boneIdx = bone->getIndex();
 
 			// Interpolate
 			Vec3 position;
 			Quat rotation;
 			F32 scale;
-			track.m_anim->interpolate(i, animTime, position, rotation, scale);
+			if(compressed)
+			{
+				position = poseScratch[i].m_position;
+				rotation = poseScratch[i].m_rotation;
+				scale = poseScratch[i].m_scale;
+			}
+			else
+			{
+				track.m_anim->interpolate(i, animTime, track.m_cursors[i], position, rotation, scale);
+			}
 
 			// Blend with previous track
 			if(bonesAnimated.get(boneIdx) && (track.m_blendInTime > 0.0 || track.m_blendOutTime > 0.0))
@@ -176,7 +229,7 @@ Error SkinComponent::update(SceneComponentUpdateInfo& info, Bool& updated)
 		m_crntBoneTrfs = m_crntBoneTrfs ^ 1;
 
 		// Walk the bone hierarchy to add additional transforms
-		visitBones(m_skeleton->getRootBone(), Mat4::getIdentity(), bonesAnimated, minExtend, maxExtend);
+		updateBoneTransforms(bonesAnimated, minExtend, maxExtend);
 
 		const Vec4 e(kEpsilonf, kEpsilonf, kEpsilonf, 0.0f);
 		m_boneBoundingVolume.setMin(minExtend - e);
@@ -188,35 +241,41 @@ Error SkinComponent::update(SceneComponentUpdateInfo& info, Bool& updated)
 	}
 
 	m_absoluteTime += dt;
-
-	return Error::kNone;
+	m_bonesUpdated = updated;
 }
 
-void SkinComponent::visitBones(const Bone& bone, const Mat4& parentTrf, const BitSet<128>& bonesAnimated,
-							   Vec4& minExtend, Vec4& maxExtend)
+void SkinComponent::updateBoneTransforms(const BitSet<128>& bonesAnimated, Vec4& minExtend, Vec4& maxExtend)
 {
-	Mat4 outMat;
-
-	if(bonesAnimated.get(bone.getIndex()))
+	const ConstWeakArray<U32> parents = m_skeleton->getBoneParentIndices();
+	const DynamicArray<Bone>& bones = m_skeleton->getBones();
+	DynamicArray<Mat3x4>& outTrfs = m_boneTrfs[m_crntBoneTrfs];
+
+	// The parents come first so their transforms are always ready
+	Array<Mat3x4, 128> modelSpaceTrfs;
+	ANKI_ASSERT(bones.getSize() <= modelSpaceTrfs.getSize());
+	for(U32 boneIdx : m_skeleton->getBonesInHierarchyOrder())
 	{
-		const Trf& t = m_animationTrfs[bone.getIndex()];
-		outMat = parentTrf * Mat4(t.m_translation.xyz1(), Mat3(t.m_rotation), t.m_scale);
-	}
-	else
-	{
-		outMat = parentTrf * bone.getTransform();
-	}
-
-	m_boneTrfs[m_crntBoneTrfs][bone.getIndex()] = outMat * bone.getVertexTransform();
+		Mat3x4 localTrf;
+		if(bonesAnimated.get(boneIdx))
+		{
+			const Trf& t = m_animationTrfs[boneIdx];
+			localTrf = Mat3x4(t.m_translation, t.m_rotation, t.m_scale);
+		}
+		else
+		{
+			localTrf = bones[boneIdx].getTransform();
+		}
 
-	// Update volume
-	const Vec4 bonePos = outMat * Vec4(0.0f, 0.0f, 0.0f, 1.0f);
-	minExtend = minExtend.min(bonePos.xyz0());
-	maxExtend = maxExtend.max(bonePos.xyz0());
+		const U32 parentIdx = parents[boneIdx];
+		const Mat3x4 trf =
+			(parentIdx != kMaxU32) ? modelSpaceTrfs[parentIdx].combineTransformations(localTrf) : localTrf;
+		modelSpaceTrfs[boneIdx] = trf;
+		outTrfs[boneIdx] = trf.combineTransformations(bones[boneIdx].getVertexTransform());
 
-	for(const Bone* child : bone.getChildren())
-	{
-		visitBones(*child, outMat, bonesAnimated, minExtend, maxExtend);
+		// Update volume
+		const Vec4 bonePos = trf.getTranslationPart().xyz0();
+		minExtend = minExtend.min(bonePos);
+		maxExtend = maxExtend.max(bonePos);
 	}
 }
 
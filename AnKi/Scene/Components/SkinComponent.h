@@ -7,6 +7,7 @@
 
 #include <AnKi/Scene/Components/SceneComponent.h>
 #include <AnKi/Resource/Forward.h>
+#include <AnKi/Core/GpuMemoryPools.h>
 #include <AnKi/Collision/Aabb.h>
 #include <AnKi/Util/Forward.h>
 #include <AnKi/Util/WeakArray.h>
@@ -14,6 +15,11 @@
 
 namespace anki {
 
+// Forward
+class AnimationBinding;
+class AnimationChannelCursor;
+class AnimationChannelTransform;
+
 /// @addtogroup scene
 /// @{
 
@@ -34,10 +40,12 @@ public:
 	Second m_blendOutTime = 0.0f;
 };
 
-/// Skin component.
+/// Skin component. The animations are sampled and the bone transforms are computed by the AnimationSystem before the
+/// scene nodes get updated.
 class SkinComponent : public SceneComponent
 {
 	ANKI_SCENE_COMPONENT(SkinComponent)
+	friend class AnimationSystem;
 
 public:
 	static constexpr U32 kMaxAnimationTracks = 4;
@@ -53,16 +61,28 @@ public:
 
 	void playAnimation(U32 track, AnimationResourcePtr anim, const AnimationPlayInfo& info);
 
-	ConstWeakArray<Mat4> getBoneTransforms() const
+	ConstWeakArray<Mat3x4> getBoneTransforms() const
 	{
 		return m_boneTrfs[m_crntBoneTrfs];
 	}
 
-	ConstWeakArray<Mat4> getPreviousFrameBoneTransforms() const
+	ConstWeakArray<Mat3x4> getPreviousFrameBoneTransforms() const
 	{
 		return m_boneTrfs[m_prevBoneTrfs];
 	}
 
+	/// The bone transforms of this frame in staging GPU memory. It's unused if the AnimationSystem didn't upload them.
+	const StagingGpuMemoryToken& getBoneTransformsToken() const
+	{
+		return m_boneTrfsToken;
+	}
+
+	/// @copydoc getBoneTransformsToken
+	const StagingGpuMemoryToken& getPreviousFrameBoneTransformsToken() const
+	{
+		return m_prevBoneTrfsToken;
+	}
+
 	const SkeletonResourcePtr& getSkeleronResource() const
 	{
 		return m_skeleton;
@@ -83,6 +103,8 @@ private:
 	{
 	public:
 		AnimationResourcePtr m_anim;
+		const AnimationBinding* m_binding = nullptr;
+		DynamicArray<AnimationChannelCursor> m_cursors; ///< One per channel.
 		Second m_absoluteStartTime = 0.0;
 		Second m_relativeTimePassed = 0.0;
 		Second m_blendInTime = 0.0;
@@ -100,16 +122,27 @@ private:
 
 	SceneNode* m_node;
 	SkeletonResourcePtr m_skeleton;
-	Array<DynamicArray<Mat4>, 2> m_boneTrfs;
+	Array<DynamicArray<Mat3x4>, 2> m_boneTrfs;
 	DynamicArray<Trf> m_animationTrfs;
 	Aabb m_boneBoundingVolume = Aabb(Vec3(-1.0f), Vec3(1.0f));
 	Array<Track, kMaxAnimationTracks> m_tracks;
+	StagingGpuMemoryToken m_boneTrfsToken;
+	StagingGpuMemoryToken m_prevBoneTrfsToken;
 	Second m_absoluteTime = 0.0;
 	U8 m_crntBoneTrfs = 0;
 	U8 m_prevBoneTrfs = 1;
+	Bool m_bonesUpdated = false; ///< If animate() changed the bone transforms this frame.
+
+	/// Sample the animations and compute the bone transforms.
+	/// @param dt The time since the last frame.
+	/// @param poseScratch Temporary memory for getMaxChannelCount() channels.
+	void animate(Second dt, WeakArray<AnimationChannelTransform> poseScratch);
+
+	/// Walk the bones parent first and compute their final transforms.
+	void updateBoneTransforms(const BitSet<128, U8>& bonesAnimated, Vec4& minExtend, Vec4& maxExtend);
 
-	void visitBones(const Bone& bone, const Mat4& parentTrf, const BitSet<128, U8>& bonesAnimated, Vec4& minExtend,
-					Vec4& maxExtend);
+	/// The max number of channels of the animations that are playing.
+	U32 getMaxChannelCount() const;
 };
 /// @}
 
@@ -31,6 +31,8 @@ SpatialComponent::~SpatialComponent()
 		m_node->getSceneGraph().getOctree().remove(m_octreeInfo);
 	}
 
+	m_node->getSceneGraph().increaseSpatialRemovalCount();
+
 	m_convexHullPoints.destroy(m_node->getMemoryPool());
 }
 
@@ -83,15 +85,33 @@ Error SpatialComponent::update([[maybe_unused]] SceneComponentUpdateInfo& info,
 				ANKI_ASSERT(0);
 			}
 
-			m_node->getSceneGraph().getOctree().place(m_derivedAabb, &m_octreeInfo, m_updateOctreeBounds);
+			Octree& octree = m_node->getSceneGraph().getOctree();
+			if(octree.getDeferredPlacementEnabled())
+			{
+				octree.placeDeferred(m_derivedAabb, &m_octreeInfo, m_updateOctreeBounds, info.m_threadId);
+			}
+			else
+			{
+				octree.place(m_derivedAabb, &m_octreeInfo, m_updateOctreeBounds);
+			}
 		}
 		else
 		{
-			m_node->getSceneGraph().getOctree().placeAlwaysVisible(&m_octreeInfo);
+			Octree& octree = m_node->getSceneGraph().getOctree();
+			if(octree.getDeferredPlacementEnabled())
+			{
+				octree.placeAlwaysVisibleDeferred(&m_octreeInfo, info.m_threadId);
+			}
+			else
+			{
+				octree.placeAlwaysVisible(&m_octreeInfo);
+			}
 		}
 
 		m_markedForUpdate = false;
 		m_placed = true;
+
+		m_node->getSceneGraph().addUpdatedSpatial(this, info.m_threadId);
 	}
 
 	m_octreeInfo.reset();
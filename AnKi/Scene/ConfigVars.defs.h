@@ -7,6 +7,13 @@ ANKI_CONFIG_VAR_GROUP(SCENE)
 
 ANKI_CONFIG_VAR_F32(Lod0MaxDistance, 20.0f, 1.0f, kMaxF32, "Distance that will be used to calculate the LOD 0")
 ANKI_CONFIG_VAR_F32(Lod1MaxDistance, 40.0f, 2.0f, kMaxF32, "Distance that will be used to calculate the LOD 1")
+ANKI_CONFIG_VAR_BOOL(SceneScreenSpaceErrorLod, false,
+					 "Select the LODs of the models using their projected error instead of the Lod*MaxDistance")
+ANKI_CONFIG_VAR_F32(SceneLodMaxScreenSpaceError, 4.0f, 0.1f, 1024.0f, "The max projected LOD error in pixels")
+ANKI_CONFIG_VAR_F32(SceneLodHysteresis, 0.2f, 0.0f, 0.9f,
+					"The band around the max LOD error that doesn't change LODs. Fraction of the max error")
+ANKI_CONFIG_VAR_U32(SceneLodTriangleBudget, 0, 0, kMaxU32,
+					"Coarser LODs will be used if the camera renders more triangles than that. Zero to disable")
 
 ANKI_CONFIG_VAR_U8(SceneShadowCascadeCount, (ANKI_PLATFORM_MOBILE) ? 2 : kMaxShadowCascades, 1, kMaxShadowCascades,
 				   "Max number of shadow cascades for directional lights")
@@ -15,7 +22,16 @@ ANKI_CONFIG_VAR_F32(SceneShadowCascade1Distance, 40.0, 1.0, kMaxF32, "The distan
 ANKI_CONFIG_VAR_F32(SceneShadowCascade2Distance, 80.0, 1.0, kMaxF32, "The distance of the 3rd cascade")
 ANKI_CONFIG_VAR_F32(SceneShadowCascade3Distance, 200.0, 1.0, kMaxF32, "The distance of the 4th cascade")
 
+ANKI_CONFIG_VAR_BOOL(SceneDenseComponentStorage, false,
+					 "Allocate the components of the same type in dense and cache aligned chunks")
+
 ANKI_CONFIG_VAR_U32(SceneOctreeMaxDepth, 5, 2, 10, "The max depth of the octree")
+ANKI_CONFIG_VAR_BOOL(SceneOctreeDeferredPlacement, false,
+					 "Queue the octree placements during the scene update and apply them in parallel afterwards")
+ANKI_CONFIG_VAR_BOOL(SceneLooseOctree, false,
+					 "Use a loose octree. Every object is placed in a single node that has 2x bigger bounds")
+ANKI_CONFIG_VAR_BOOL(SceneIncrementalVisibility, false,
+					 "Re-use the visible objects of the previous frame for frustums and objects that didn't move")
 ANKI_CONFIG_VAR_F32(SceneEarlyZDistance, (ANKI_PLATFORM_MOBILE) ? 0.0f : 10.0f, 0.0f, kMaxF32,
 					"Objects with distance lower than that will be used in early Z")
 
@@ -41,6 +41,12 @@ void Event::setMarkedForDeletion()
 	m_manager->markEventForDeletion(this);
 }
 
+void Event::addAssociatedSceneNode(SceneNode* node)
+{
+	ANKI_ASSERT(node);
+	m_manager->addAssociatedSceneNode(this, node);
+}
+
 Second Event::getDelta(Second crntTime) const
 {
 	Second d = crntTime - m_startTime; // delta
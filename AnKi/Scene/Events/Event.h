@@ -81,11 +81,8 @@ public:
 				   : WeakArray<SceneNode*>(&m_associatedNodes[0], m_associatedNodes.getSize());
 	}
 
-	void addAssociatedSceneNode(SceneNode* node)
-	{
-		ANKI_ASSERT(node);
-		m_associatedNodes.emplaceBack(getMemoryPool(), node);
-	}
+	/// @note It's thread-safe.
+	void addAssociatedSceneNode(SceneNode* node);
 
 	/// This method should be implemented by the derived classes
 	/// @param prevUpdateTime The time of the previous update (sec)
@@ -118,6 +115,9 @@ protected:
 	/// Return the u between current time and when the event started
 	/// @return A number [0.0, 1.0]
 	Second getDelta(Second crntTime) const;
+
+private:
+	IntrusiveList<Event>* m_container = nullptr; ///< The list of the EventManager that the event is in.
 };
 /// @}
 
@@ -15,13 +15,27 @@ EventManager::EventManager()
 
 EventManager::~EventManager()
 {
-	while(!m_events.isEmpty())
+	auto deleteAll = [this](IntrusiveList<Event>& list) {
+		while(!list.isEmpty())
+		{
+			deleteEvent(&list.getFront());
+		}
+	};
+
+	deleteAll(m_newEvents);
+	deleteAll(m_activeEvents);
+	deleteAll(m_eventsMarkedForDeletion);
+	deleteAll(m_wheelOverflow);
+	for(Array<IntrusiveList<Event>, kWheelSlotCount>& level : m_wheel)
 	{
-		Event* event = &m_events.getFront();
-		event->setMarkedForDeletion();
+		for(IntrusiveList<Event>& slot : level)
+		{
+			deleteAll(slot);
+		}
 	}
 
-	deleteEventsMarkedForDeletion(false);
+	ANKI_ASSERT(m_nodeEvents.isEmpty());
+	m_nodeEvents.destroy(getMemoryPool());
 }
 
 Error EventManager::init(SceneGraph* scene)
@@ -41,18 +55,141 @@ StackMemoryPool& EventManager::getFrameMemoryPool() const
 	return m_scene->getFrameMemoryPool();
 }
 
+void EventManager::linkEvent(Event& event, IntrusiveList<Event>& list)
+{
+	ANKI_ASSERT(event.m_container == nullptr);
+	list.pushBack(&event);
+	event.m_container = &list;
+	m_activeEventCount += (&list == &m_activeEvents);
+}
+
+void EventManager::unlinkEvent(Event& event)
+{
+	ANKI_ASSERT(event.m_container);
+
+	// Keep iterating m_activeEvents if the next event is removed
+	if(&event == m_nextEventToUpdate)
+	{
+		m_nextEventToUpdate = event.getNextListNode();
+	}
+
+	m_activeEventCount -= (event.m_container == &m_activeEvents);
+	event.m_container->erase(&event);
+	event.m_container = nullptr;
+}
+
+void EventManager::insertToWheel(Event& event)
+{
+	ANKI_ASSERT(m_wheelTick != kMaxU64);
+	const U64 tick = max(computeWheelTick(event.m_startTime), m_wheelTick);
+	const U64 delta = tick - m_wheelTick;
+
+	// Find the 1st level that covers the delta. The slot index uses the absolute tick so it stays the same as the
+	// wheel turns
+	for(U32 level = 0; level < kWheelLevelCount; ++level)
+	{
+		if(delta < (1_U64 << (kWheelSlotBits * (level + 1))))
+		{
+			const U64 slot = (tick >> (kWheelSlotBits * level)) & (kWheelSlotCount - 1);
+			linkEvent(event, m_wheel[level][slot]);
+			return;
+		}
+	}
+
+	linkEvent(event, m_wheelOverflow);
+}
+
+void EventManager::cascadeWheelSlot(IntrusiveList<Event>& slot)
+{
+	while(!slot.isEmpty())
+	{
+		Event& event = slot.getFront();
+		unlinkEvent(event);
+		insertToWheel(event);
+	}
+}
+
+void EventManager::advanceWheel(Second crntTime)
+{
+	const U64 targetTick = computeWheelTick(crntTime);
+	if(m_wheelTick == kMaxU64)
+	{
+		m_wheelTick = targetTick;
+	}
+
+	for(;;)
+	{
+		// Activate the events of the current tick that started. When the wheel is behind that's all of them
+		IntrusiveList<Event>& slot = m_wheel[0][m_wheelTick & (kWheelSlotCount - 1)];
+		Event* event = (slot.isEmpty()) ? nullptr : &slot.getFront();
+		while(event)
+		{
+			Event* next = event->getNextListNode();
+			if(event->m_startTime <= crntTime)
+			{
+				unlinkEvent(*event);
+				linkEvent(*event, m_activeEvents);
+			}
+			event = next;
+		}
+
+		if(m_wheelTick >= targetTick)
+		{
+			break;
+		}
+
+		// Next tick. When a level wraps bring down the events of the next slot of the level above
+		++m_wheelTick;
+		for(U32 level = 1; level <= kWheelLevelCount; ++level)
+		{
+			const U64 levelTick = m_wheelTick >> (kWheelSlotBits * (level - 1));
+			if((levelTick & (kWheelSlotCount - 1)) != 0)
+			{
+				break;
+			}
+
+			cascadeWheelSlot((level < kWheelLevelCount)
+								 ? m_wheel[level][(levelTick >> kWheelSlotBits) & (kWheelSlotCount - 1)]
+								 : m_wheelOverflow);
+		}
+	}
+}
+
 Error EventManager::updateAllEvents(Second prevUpdateTime, Second crntTime)
 {
 	Error err = Error::kNone;
 
-	for(Event& event : m_events)
+	advanceWheel(crntTime);
+
+	// Place the new events
+	while(!m_newEvents.isEmpty())
 	{
-		// If event or the node's event is marked for deletion then dont do anything else for that event
-		if(event.getMarkedForDeletion())
+		Event& event = m_newEvents.getFront();
+		unlinkEvent(event);
+
+		// Audjust starting time
+		if(event.m_startTime < 0.0)
 		{
-			continue;
+			event.m_startTime = crntTime;
 		}
 
+		if(event.m_startTime <= crntTime)
+		{
+			linkEvent(event, m_activeEvents);
+		}
+		else
+		{
+			insertToWheel(event);
+		}
+	}
+
+	// Update the events that started. Updates might remove events so use m_nextEventToUpdate to iterate
+	m_nextEventToUpdate = (m_activeEvents.isEmpty()) ? nullptr : &m_activeEvents.getFront();
+	while(m_nextEventToUpdate)
+	{
+		Event& event = *m_nextEventToUpdate;
+		m_nextEventToUpdate = event.getNextListNode();
+
 		// Check if the associated scene nodes are marked for deletion
 		Bool skip = false;
 		for(SceneNode* node : event.m_associatedNodes)
@@ -69,21 +206,11 @@ Error EventManager::updateAllEvents(Second prevUpdateTime, Second crntTime)
 			continue;
 		}
 
-		// Audjust starting time
-		if(event.m_startTime < 0.0)
-		{
-			event.m_startTime = crntTime;
-		}
-
 		// Check if dead
 		if(!event.isDead(crntTime))
 		{
 			// If not dead update it
-
-			if(event.getStartTime() <= crntTime)
-			{
-				err = event.update(prevUpdateTime, crntTime);
-			}
+			err = event.update(prevUpdateTime, crntTime);
 		}
 		else
 		{
@@ -118,42 +245,77 @@ void EventManager::markEventForDeletion(Event* event)
 
 	LockGuard<Mutex> lock(m_mtx);
 	event->m_markedForDeletion = true;
-	m_events.erase(event);
-	m_eventsMarkedForDeletion.pushBack(event);
+	unlinkEvent(*event);
+	linkEvent(*event, m_eventsMarkedForDeletion);
 }
 
-void EventManager::deleteEventsMarkedForDeletion(Bool fullCleanup)
+void EventManager::addAssociatedSceneNode(Event* event, SceneNode* node)
 {
-	// Mark events with to-be-deleted nodes as also to be deleted
-	if(fullCleanup)
+	ANKI_ASSERT(event && node);
+
+	LockGuard<Mutex> lock(m_mtx);
+	event->m_associatedNodes.emplaceBack(getMemoryPool(), node);
+
+	auto it = m_nodeEvents.find(node->getUuid());
+	if(it == m_nodeEvents.getEnd())
 	{
-		// Gather in an array because we can't call setMarkedForDeletion while iterating m_events
-		DynamicArrayRaii<Event*> markedForDeletion(&getFrameMemoryPool());
-		for(Event& event : m_events)
+		it = m_nodeEvents.emplace(getMemoryPool(), node->getUuid());
+	}
+
+	it->emplaceBack(getMemoryPool(), event);
+}
+
+void EventManager::deleteEvent(Event* event)
+{
+	unlinkEvent(*event);
+
+	// Remove it from the index of its nodes
+	for(SceneNode* node : event->m_associatedNodes)
+	{
+		auto it = m_nodeEvents.find(node->getUuid());
+		if(it == m_nodeEvents.getEnd())
 		{
-			for(SceneNode* node : event.m_associatedNodes)
+			// Already removed. The node appears twice
+			continue;
+		}
+
+		DynamicArray<Event*>& nodeEvents = *it;
+		for(U32 i = 0; i < nodeEvents.getSize(); ++i)
+		{
+			if(nodeEvents[i] == event)
 			{
-				if(node->getMarkedForDeletion())
-				{
-					markedForDeletion.emplaceBack(&event);
-					break;
-				}
+				nodeEvents[i] = nodeEvents.getBack();
+				nodeEvents.popBack(getMemoryPool());
+				break;
 			}
 		}
 
-		for(Event* event : markedForDeletion)
+		if(nodeEvents.getSize() == 0)
 		{
-			event->setMarkedForDeletion();
+			nodeEvents.destroy(getMemoryPool());
+			m_nodeEvents.erase(getMemoryPool(), it);
 		}
 	}
 
-	// Gather events for deletion
+	deleteInstance(getMemoryPool(), event);
+}
+
+void EventManager::deleteEventsMarkedForDeletion()
+{
 	while(!m_eventsMarkedForDeletion.isEmpty())
 	{
-		Event* event = &m_eventsMarkedForDeletion.getFront();
-		m_eventsMarkedForDeletion.popFront();
+		deleteEvent(&m_eventsMarkedForDeletion.getFront());
+	}
+}
 
-		deleteInstance(getMemoryPool(), event);
+void EventManager::deleteSceneNodeEvents(const SceneNode& node)
+{
+	auto it = m_nodeEvents.find(node.getUuid());
+	while(it != m_nodeEvents.getEnd())
+	{
+		// Deleting the event will update the index
+		deleteEvent(it->getBack());
+		it = m_nodeEvents.find(node.getUuid());
 	}
 }
 
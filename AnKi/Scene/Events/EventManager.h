@@ -7,6 +7,7 @@
 
 #include <AnKi/Scene/Common.h>
 #include <AnKi/Util/List.h>
+#include <AnKi/Util/HashMap.h>
 #include <AnKi/Math.h>
 
 namespace anki {
@@ -14,7 +15,9 @@ namespace anki {
 /// @addtogroup scene
 /// @{
 
-/// This manager creates the events ands keeps track of them
+/// This manager creates the events ands keeps track of them. Events that haven't started are kept in a hierarchical
+/// timing wheel keyed on their start time and only the running events are visited every frame. The events of every
+/// scene node are indexed so deleting a node doesn't need to scan all events.
 class EventManager
 {
 public:
@@ -50,7 +53,7 @@ public:
 		else
 		{
 			LockGuard<Mutex> lock(m_mtx);
-			m_events.pushBack(event);
+			linkEvent(*event, m_newEvents);
 		}
 		return err;
 	}
@@ -59,17 +62,66 @@ public:
 	Error updateAllEvents(Second prevUpdateTime, Second crntTime);
 
 	/// Delete events that pending deletion
-	void deleteEventsMarkedForDeletion(Bool fullCleanup);
+	void deleteEventsMarkedForDeletion();
+
+	/// Delete the events that are associated with a scene node. Called before the node gets deleted.
+	void deleteSceneNodeEvents(const SceneNode& node);
 
 	/// @note It's thread-safe against itself.
 	void markEventForDeletion(Event* event);
 
+	/// @note It's thread-safe against itself.
+	void addAssociatedSceneNode(Event* event, SceneNode* node);
+
+	/// The number of events that are running. For debugging and testing.
+	U32 getActiveEventCount() const
+	{
+		return m_activeEventCount;
+	}
+
 private:
+	static constexpr F64 kWheelTicksPerSecond = 64.0;
+	static constexpr U32 kWheelSlotBits = 6;
+	static constexpr U32 kWheelSlotCount = 1u << kWheelSlotBits;
+	static constexpr U32 kWheelLevelCount = 4;
+
 	SceneGraph* m_scene = nullptr;
 
-	IntrusiveList<Event> m_events;
+	IntrusiveList<Event> m_newEvents; ///< Events that haven't been placed anywhere yet.
+	IntrusiveList<Event> m_activeEvents; ///< Events that have started.
 	IntrusiveList<Event> m_eventsMarkedForDeletion;
+
+	/// Events that haven't started. Level L has slots of kWheelSlotCount^L ticks.
+	Array2d<IntrusiveList<Event>, kWheelLevelCount, kWheelSlotCount> m_wheel;
+	IntrusiveList<Event> m_wheelOverflow; ///< Events that start after the range of the wheel.
+	U64 m_wheelTick = kMaxU64; ///< The current tick of the wheel.
+
+	Event* m_nextEventToUpdate = nullptr; ///< Used to iterate m_activeEvents while events get removed.
+	U32 m_activeEventCount = 0;
+
+	/// The events of every scene node. The key is the UUID of the node.
+	HashMap<U64, DynamicArray<Event*>> m_nodeEvents;
+
 	Mutex m_mtx;
+
+	static U64 computeWheelTick(Second time)
+	{
+		return U64(max(time, 0.0) * kWheelTicksPerSecond);
+	}
+
+	void linkEvent(Event& event, IntrusiveList<Event>& list);
+	void unlinkEvent(Event& event);
+
+	/// Put an event that hasn't started in the wheel.
+	void insertToWheel(Event& event);
+
+	/// Move the wheel to the current time and activate the events that started.
+	void advanceWheel(Second crntTime);
+
+	/// Re-insert the events of a slot to the lower levels.
+	void cascadeWheelSlot(IntrusiveList<Event>& slot);
+
+	void deleteEvent(Event* event);
 };
 /// @}
 
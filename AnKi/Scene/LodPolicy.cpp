@@ -0,0 +1,90 @@
+// Copyright (C) 2009-2022, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <AnKi/Scene/LodPolicy.h>
+
+namespace anki {
+
+void LodPolicy::beginFrame(const Mat4& proj, const Vec3& cameraPos, U32 viewportHeight)
+{
+	ANKI_ASSERT(viewportHeight > 0);
+	m_cameraPos = cameraPos;
+	m_perspective = proj(3, 3) == 0.0f;
+
+	// Both projections map Y to [-1, 1]. The scale of Y is in proj(1, 1)
+	m_pixelsPerUnit = absolute(proj(1, 1)) * F32(viewportHeight) * 0.5f;
+}
+
+U8 LodPolicy::selectLodWithThreshold(ConstWeakArray<F32> lodErrors, F32 projectedRadius, F32 threshold)
+{
+	U32 lod = lodErrors.getSize() - 1;
+	while(lod > 0 && lodErrors[lod] * projectedRadius > threshold)
+	{
+		--lod;
+	}
+
+	return U8(lod);
+}
+
+U8 LodPolicy::selectLod(ConstWeakArray<F32> lodErrors, const Vec3& sphereCenter, F32 sphereRadius, U8 prevLod) const
+{
+	ANKI_ASSERT(lodErrors.getSize() > 0 && lodErrors.getSize() <= kMaxLodCount);
+
+	F32 projectedRadius;
+	if(m_perspective)
+	{
+		const F32 dist = (sphereCenter - m_cameraPos).getLength() - sphereRadius;
+		if(dist <= kEpsilonf)
+		{
+			// Camera inside the sphere
+			return 0;
+		}
+
+		projectedRadius = sphereRadius * m_pixelsPerUnit / dist;
+	}
+	else
+	{
+		projectedRadius = sphereRadius * m_pixelsPerUnit;
+	}
+
+	const F32 threshold = m_maxScreenSpaceError * pow(2.0f, m_bias);
+	if(prevLod >= lodErrors.getSize())
+	{
+		return selectLodWithThreshold(lodErrors, projectedRadius, threshold);
+	}
+
+	// Keep the previous LOD if it's inside the hysteresis band
+	const U8 coarsest = selectLodWithThreshold(lodErrors, projectedRadius, threshold * (1.0f + m_hysteresis));
+	const U8 finest = selectLodWithThreshold(lodErrors, projectedRadius, threshold * (1.0f - m_hysteresis));
+	return clamp(prevLod, finest, coarsest);
+}
+
+void LodPolicy::endFrame(U64 triangleCount)
+{
+	if(m_triangleBudget == 0)
+	{
+		m_bias = 0.0f;
+		return;
+	}
+
+	// Integral controller on the log of the ratio. Go up fast when over budget and come down slowly
+	constexpr F32 kOverBudgetGain = 0.5f;
+	constexpr F32 kUnderBudgetGain = 0.1f;
+	constexpr F32 kUnderBudgetMargin = 0.9f;
+
+	const F32 ratio = max(F32(triangleCount) / F32(m_triangleBudget), 1.0f / 16.0f);
+	if(ratio > 1.0f)
+	{
+		m_bias += kOverBudgetGain * log2(ratio);
+	}
+	else if(ratio < kUnderBudgetMargin)
+	{
+		m_bias += kUnderBudgetGain * log2(ratio);
+	}
+
+	m_bias = clamp(m_bias, 0.0f, kMaxBias);
+}
+
+} // end namespace anki
@@ -0,0 +1,76 @@
+// Copyright (C) 2009-2022, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#pragma once
+
+#include <AnKi/Scene/Common.h>
+#include <AnKi/Math.h>
+#include <AnKi/Util/WeakArray.h>
+#include <AnKi/Shaders/Include/Common.h>
+
+namespace anki {
+
+/// @addtogroup scene
+/// @{
+
+/// Selects LODs using the screen-space error. The geometric error of a LOD is projected using the bounding sphere of
+/// the object and the coarsest LOD with a projected error that is lower than a threshold (in pixels) is chosen. A
+/// hysteresis band around the threshold stops objects from switching LODs back and forth. The threshold is also
+/// scaled by a bias that a feedback controller adjusts every frame to keep the triangles bellow a budget.
+class LodPolicy
+{
+public:
+	/// The max value of the bias. The threshold can grow up to 2^kMaxBias times.
+	static constexpr F32 kMaxBias = 4.0f;
+
+	/// @param maxScreenSpaceError The max error in pixels.
+	/// @param hysteresis The width of the band around the threshold as a fraction of the threshold.
+	/// @param triangleBudget The triangles per frame. Zero disables the feedback controller.
+	void setParameters(F32 maxScreenSpaceError, F32 hysteresis, U64 triangleBudget)
+	{
+		ANKI_ASSERT(maxScreenSpaceError > 0.0f && hysteresis >= 0.0f && hysteresis < 1.0f);
+		m_maxScreenSpaceError = maxScreenSpaceError;
+		m_hysteresis = hysteresis;
+		m_triangleBudget = triangleBudget;
+	}
+
+	/// Set the view that the errors will be projected to. Call it before the visibility tests.
+	/// @param proj The projection matrix.
+	/// @param cameraPos The position of the camera in world space.
+	/// @param viewportHeight The height of the render target in pixels.
+	void beginFrame(const Mat4& proj, const Vec3& cameraPos, U32 viewportHeight);
+
+	/// Select a LOD.
+	/// @param lodErrors The geometric error of every LOD relative to the radius of the bounding sphere.
+	/// @param sphereCenter The bounding sphere center in world space.
+	/// @param sphereRadius The bounding sphere radius.
+	/// @param prevLod The LOD of the previous frame or kMaxU8 if there is none.
+	/// @note It's thread-safe.
+	U8 selectLod(ConstWeakArray<F32> lodErrors, const Vec3& sphereCenter, F32 sphereRadius, U8 prevLod) const;
+
+	/// Feed the triangles that the primary frustum rendered this frame. It will adjust the bias of the next frame.
+	void endFrame(U64 triangleCount);
+
+	F32 getBias() const
+	{
+		return m_bias;
+	}
+
+private:
+	F32 m_maxScreenSpaceError = 1.0f;
+	F32 m_hysteresis = 0.0f;
+	U64 m_triangleBudget = 0;
+
+	Vec3 m_cameraPos = Vec3(0.0f);
+	F32 m_pixelsPerUnit = 1.0f; ///< Pixels per world unit at distance 1 (or at any distance if it's orthographic).
+	Bool m_perspective = true;
+
+	F32 m_bias = 0.0f; ///< The log2 of the scale of the threshold.
+
+	static U8 selectLodWithThreshold(ConstWeakArray<F32> lodErrors, F32 projectedRadius, F32 threshold);
+};
+/// @}
+
+} // end namespace anki
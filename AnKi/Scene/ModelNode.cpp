@@ -46,7 +46,7 @@ public:
 
 	/// Uncompresses the mesh positions to the local view. The scale should be uniform because it will be applied to
 	/// normals and tangents and non-uniform data will cause problems.
-	Mat4 m_compressedToModelTransform = Mat4::getIdentity();
+	Mat3x4 m_compressedToModelTransform = Mat3x4::getIdentity();
 };
 
 ModelNode::ModelNode(SceneGraph* scene, CString name)
@@ -181,6 +181,16 @@ void ModelNode::initRenderComponents()
 
 		rc.setFlagsFromMaterial(modelPatch.getMaterial());
 
+		Array<F32, kMaxLodCount> lodErrors;
+		Array<U32, kMaxLodCount> triangleCounts;
+		for(U32 l = 0; l < modelPatch.getLodCount(); ++l)
+		{
+			lodErrors[l] = modelPatch.getLodError(l);
+			triangleCounts[l] = modelPatch.getTriangleCount(l);
+		}
+		rc.setLodInfo(ConstWeakArray<F32>(&lodErrors[0], modelPatch.getLodCount()),
+					  ConstWeakArray<U32>(&triangleCounts[0], modelPatch.getLodCount()));
+
 		if(!!(modelPatch.getMaterial()->getRenderingTechniques() & RenderingTechniqueBit::kAllRt))
 		{
 			rc.initRayTracing(
@@ -197,7 +207,7 @@ void ModelNode::initRenderComponents()
 		proxy.m_node = this;
 
 		const MeshResource& meshResource = *modelPatch.getMesh();
-		proxy.m_compressedToModelTransform.setTranslationPart(meshResource.getPositionsTranslation().xyz1());
+		proxy.m_compressedToModelTransform.setTranslationPart(meshResource.getPositionsTranslation().xyz());
 		proxy.m_compressedToModelTransform(0, 0) = meshResource.getPositionsScale();
 		proxy.m_compressedToModelTransform(1, 1) = meshResource.getPositionsScale();
 		proxy.m_compressedToModelTransform(2, 2) = meshResource.getPositionsScale();
@@ -227,9 +237,7 @@ void ModelNode::draw(RenderQueueDrawContext& ctx, ConstWeakArray<void*> userData
 			else
 			{
 				// Bake the decompression in the model matrix
-				const Mat4 m4 = Mat4(trf) * m_renderProxies[modelPatchIdx].m_compressedToModelTransform;
-				const Mat3x4 out(m4);
-				return out;
+				return Mat3x4(trf).combineTransformations(m_renderProxies[modelPatchIdx].m_compressedToModelTransform);
 			}
 		};
 		Array<Mat3x4, kMaxInstanceCount> trfs;
@@ -258,18 +266,23 @@ void ModelNode::draw(RenderQueueDrawContext& ctx, ConstWeakArray<void*> userData
 		ModelRenderingInfo modelInf;
 		patch.getRenderingInfo(ctx.m_key, modelInf);
 
-		// Bones storage
+		// Bones storage. The AnimationSystem uploads the palettes once per frame. If the skeleton got loaded after that
+		// upload them now
 		if(skinc.isEnabled())
 		{
-			const U32 boneCount = skinc.getBoneTransforms().getSize();
-			StagingGpuMemoryToken token, tokenPrev;
-			void* trfs = ctx.m_stagingGpuAllocator->allocateFrame(boneCount * sizeof(Mat4),
-																  StagingGpuMemoryType::kStorage, token);
-			memcpy(trfs, &skinc.getBoneTransforms()[0], boneCount * sizeof(Mat4));
-
-			trfs = ctx.m_stagingGpuAllocator->allocateFrame(boneCount * sizeof(Mat4), StagingGpuMemoryType::kStorage,
-															tokenPrev);
-			memcpy(trfs, &skinc.getPreviousFrameBoneTransforms()[0], boneCount * sizeof(Mat4));
+			StagingGpuMemoryToken token = skinc.getBoneTransformsToken();
+			StagingGpuMemoryToken tokenPrev = skinc.getPreviousFrameBoneTransformsToken();
+			if(token.isUnused())
+			{
+				const U32 boneCount = skinc.getBoneTransforms().getSize();
+				void* trfs = ctx.m_stagingGpuAllocator->allocateFrame(boneCount * sizeof(Mat3x4),
+																	  StagingGpuMemoryType::kStorage, token);
+				memcpy(trfs, &skinc.getBoneTransforms()[0], boneCount * sizeof(Mat3x4));
+
+				trfs = ctx.m_stagingGpuAllocator->allocateFrame(boneCount * sizeof(Mat3x4),
+																StagingGpuMemoryType::kStorage, tokenPrev);
+				memcpy(trfs, &skinc.getPreviousFrameBoneTransforms()[0], boneCount * sizeof(Mat3x4));
+			}
 
 			cmdb->bindStorageBuffer(kMaterialSetLocal, kMaterialBindingBoneTransforms, token.m_buffer, token.m_offset,
 									token.m_range);
@@ -375,12 +388,13 @@ void ModelNode::draw(RenderQueueDrawContext& ctx, ConstWeakArray<void*> userData
 				ANKI_ASSERT(bone.getIndex() == i);
 				const Vec4 point(0.0f, 0.0f, 0.0f, 1.0f);
 				const Bone* parent = bone.getParent();
-				Mat4 m = (parent)
-							 ? skinc.getBoneTransforms()[parent->getIndex()] * parent->getVertexTransform().getInverse()
-							 : Mat4::getIdentity();
+				const Vec4 lastRow(0.0f, 0.0f, 0.0f, 1.0f);
+				Mat4 m = (parent) ? Mat4(skinc.getBoneTransforms()[parent->getIndex()], lastRow)
+										* Mat4(parent->getVertexTransform(), lastRow).getInverse()
+								  : Mat4::getIdentity();
 				const Vec3 a = (m * point).xyz();
 
-				m = skinc.getBoneTransforms()[i] * bone.getVertexTransform().getInverse();
+				m = Mat4(skinc.getBoneTransforms()[i], lastRow) * Mat4(bone.getVertexTransform(), lastRow).getInverse();
 				const Vec3 b = (m * point).xyz();
 
 				lines.emplaceBack(a);
@@ -434,8 +448,8 @@ void ModelNode::setupRayTracingInstanceQueueElement(U32 lod, U32 modelPatchIdx,
 
 	const MoveComponent& movec = getFirstComponentOfType<MoveComponent>();
 
-	const Mat4 m4 = Mat4(movec.getWorldTransform()) * m_renderProxies[modelPatchIdx].m_compressedToModelTransform;
-	el.m_transform = Mat3x4(m4);
+	el.m_transform = Mat3x4(movec.getWorldTransform())
+						 .combineTransformations(m_renderProxies[modelPatchIdx].m_compressedToModelTransform);
 
 	el.m_shaderGroupHandleIndex = info.m_shaderGroupHandleIndex;
 }
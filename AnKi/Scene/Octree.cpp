@@ -54,14 +54,30 @@ public:
 	Leaf* m_leaf = nullptr;
 };
 
+class Octree::CommitOctantCtx
+{
+public:
+	Octree* m_octree = nullptr;
+	U8 m_octant = kRootOctant;
+	U32 m_newPlaceableCount = 0;
+	Vec3 m_actualSceneAabbMin = Vec3(kMaxF32);
+	Vec3 m_actualSceneAabbMax = Vec3(kMinF32);
+};
+
 Octree::~Octree()
 {
 	ANKI_ASSERT(m_placeableCount == 0);
 	cleanupInternal();
 	ANKI_ASSERT(m_rootLeaf == nullptr);
+
+	for(DeferredPlacementQueue& queue : m_deferredQueues)
+	{
+		ANKI_ASSERT(queue.m_count == 0 && "Forgot to commit");
+		queue.m_placements.destroy(*m_pool);
+	}
 }
 
-void Octree::init(const Vec3& sceneAabbMin, const Vec3& sceneAabbMax, U32 maxDepth)
+void Octree::init(const Vec3& sceneAabbMin, const Vec3& sceneAabbMax, U32 maxDepth, OctreeFlag flags)
 {
 	ANKI_ASSERT(sceneAabbMin < sceneAabbMax);
 	ANKI_ASSERT(maxDepth > 0);
@@ -69,6 +85,17 @@ void Octree::init(const Vec3& sceneAabbMin, const Vec3& sceneAabbMax, U32 maxDep
 	m_maxDepth = maxDepth;
 	m_sceneAabbMin = sceneAabbMin;
 	m_sceneAabbMax = sceneAabbMax;
+	m_flags = flags;
+}
+
+void Octree::createRootLeaf()
+{
+	if(!m_rootLeaf)
+	{
+		m_rootLeaf = newLeaf(kRootOctant);
+		m_rootLeaf->m_aabbMin = m_sceneAabbMin;
+		m_rootLeaf->m_aabbMax = m_sceneAabbMax;
+	}
 }
 
 void Octree::place(const Aabb& volume, OctreePlaceable* placeable, Bool updateActualSceneBounds)
@@ -78,20 +105,23 @@ void Octree::place(const Aabb& volume, OctreePlaceable* placeable, Bool updateAc
 
 	LockGuard<Mutex> lock(m_globalMtx);
 
-	// Remove the placeable from the Octree
-	removeInternal(*placeable);
-
-	// Create the root leaf
-	if(!m_rootLeaf)
+	if(isLoose())
 	{
-		m_rootLeaf = newLeaf();
-		m_rootLeaf->m_aabbMin = m_sceneAabbMin;
-		m_rootLeaf->m_aabbMax = m_sceneAabbMax;
+		createRootLeaf();
+		m_placeableCount += placeLoose(volume, placeable, m_rootLeaf, 0);
 	}
+	else
+	{
+		// Remove the placeable from the Octree
+		removeInternal(*placeable);
 
-	// And re-place it
-	placeRecursive(volume, placeable, m_rootLeaf, 0);
-	++m_placeableCount;
+		// Create the root leaf
+		createRootLeaf();
+
+		// And re-place it
+		placeRecursive(volume, placeable, m_rootLeaf, 0);
+		++m_placeableCount;
+	}
 
 	// Update the actual scene bounds
 	if(updateActualSceneBounds)
@@ -111,32 +141,263 @@ void Octree::placeAlwaysVisible(OctreePlaceable* placeable)
 	removeInternal(*placeable);
 
 	// Create the root leaf
-	if(!m_rootLeaf)
-	{
-		m_rootLeaf = newLeaf();
-		m_rootLeaf->m_aabbMin = m_sceneAabbMin;
-		m_rootLeaf->m_aabbMax = m_sceneAabbMax;
-	}
+	createRootLeaf();
 
 	// Connect placeable and leaf
 	placeable->m_leafs.pushBack(newLeafNode(m_rootLeaf));
-	m_rootLeaf->m_placeables.pushBack(newPlaceableNode(placeable));
+	m_rootLeaf->m_placeables.pushBack(newPlaceableNode(placeable, *m_rootLeaf));
 
 	++m_placeableCount;
 }
 
 void Octree::remove(OctreePlaceable& placeable)
 {
+	ANKI_ASSERT(!placeable.m_deferredPlacementPending && "Can't remove before committing");
 	LockGuard<Mutex> lock(m_globalMtx);
 	removeInternal(placeable);
 }
 
-Bool Octree::volumeTotallyInsideLeaf(const Aabb& volume, const Leaf& leaf)
+void Octree::placeDeferred(const Aabb& volume, OctreePlaceable* placeable, Bool updateActualSceneBounds, U32 threadId)
+{
+	ANKI_ASSERT(placeable);
+	ANKI_ASSERT(testCollision(volume, Aabb(m_sceneAabbMin, m_sceneAabbMax)) && "volume is outside the scene");
+	ANKI_ASSERT(!placeable->m_deferredPlacementPending && "Only one placement per commit");
+	ANKI_ASSERT(threadId < m_deferredQueues.getSize());
+
+	// Find the top level octant of the new placement
+	U8 octant = computeTopLevelOctant(volume);
+
+	// The current placement should also be in the same octant. The leafs of the placeable are not modified by anyone
+	// else at this point so it's safe to iterate them
+	if(octant != kRootOctant)
+	{
+		for(const LeafNode& leafNode : placeable->m_leafs)
+		{
+			if(leafNode.m_leaf->m_octant != octant)
+			{
+				octant = kRootOctant;
+				break;
+			}
+		}
+	}
+
+	DeferredPlacementQueue& queue = m_deferredQueues[threadId];
+	if(queue.m_count == queue.m_placements.getSize())
+	{
+		queue.m_placements.resize(*m_pool, max(queue.m_count * 2, 64u));
+	}
+
+	DeferredPlacement& placement = queue.m_placements[queue.m_count++];
+	placement.m_volumeMin = volume.getMin().xyz();
+	placement.m_volumeMax = volume.getMax().xyz();
+	placement.m_placeable = placeable;
+	placement.m_octant = octant;
+	placement.m_alwaysVisible = false;
+	placement.m_updateActualSceneBounds = updateActualSceneBounds;
+	placeable->m_deferredPlacementPending = true;
+}
+
+void Octree::placeAlwaysVisibleDeferred(OctreePlaceable* placeable, U32 threadId)
+{
+	ANKI_ASSERT(placeable);
+	ANKI_ASSERT(!placeable->m_deferredPlacementPending && "Only one placement per commit");
+	ANKI_ASSERT(threadId < m_deferredQueues.getSize());
+
+	DeferredPlacementQueue& queue = m_deferredQueues[threadId];
+	if(queue.m_count == queue.m_placements.getSize())
+	{
+		queue.m_placements.resize(*m_pool, max(queue.m_count * 2, 64u));
+	}
+
+	DeferredPlacement& placement = queue.m_placements[queue.m_count++];
+	placement.m_placeable = placeable;
+	placement.m_octant = kRootOctant;
+	placement.m_alwaysVisible = true;
+	placement.m_updateActualSceneBounds = false;
+	placeable->m_deferredPlacementPending = true;
+}
+
+Bool Octree::unlinkPlaceable(OctreePlaceable& placeable)
+{
+	const Bool isPlaced = !placeable.m_leafs.isEmpty();
+	while(!placeable.m_leafs.isEmpty())
+	{
+		// Pop a leaf node
+		LeafNode* leafNode = placeable.m_leafs.popFront();
+
+		// Iterate the placeables of the leaf
+		[[maybe_unused]] Bool found = false;
+		for(PlaceableNode& placeableNode : leafNode->m_leaf->m_placeables)
+		{
+			if(placeableNode.m_placeable == &placeable)
+			{
+				found = true;
+				leafNode->m_leaf->m_placeables.erase(&placeableNode);
+				releasePlaceableNode(&placeableNode, *leafNode->m_leaf);
+				break;
+			}
+		}
+		ANKI_ASSERT(found);
+
+		// Delete the leaf node
+		releaseLeafNode(leafNode);
+	}
+
+	return isPlaced;
+}
+
+Bool Octree::commitPlacement(const DeferredPlacement& placement, Vec3& actualSceneAabbMin, Vec3& actualSceneAabbMax)
+{
+	OctreePlaceable& placeable = *placement.m_placeable;
+	ANKI_ASSERT(placeable.m_deferredPlacementPending);
+	placeable.m_deferredPlacementPending = false;
+
+	if(placement.m_alwaysVisible)
+	{
+		const Bool wasPlaced = unlinkPlaceable(placeable);
+		placeable.m_leafs.pushBack(newLeafNode(m_rootLeaf));
+		m_rootLeaf->m_placeables.pushBack(newPlaceableNode(&placeable, *m_rootLeaf));
+		return !wasPlaced;
+	}
+
+	const Aabb volume(placement.m_volumeMin, placement.m_volumeMax);
+	if(placement.m_updateActualSceneBounds)
+	{
+		actualSceneAabbMin = actualSceneAabbMin.min(placement.m_volumeMin);
+		actualSceneAabbMax = actualSceneAabbMax.max(placement.m_volumeMax);
+	}
+
+	// Skip the root if the placement is known to be inside a single top level octant
+	Leaf* const startLeaf =
+		(placement.m_octant == kRootOctant) ? m_rootLeaf : m_rootLeaf->m_children[placement.m_octant];
+	const U32 startDepth = (placement.m_octant == kRootOctant) ? 0 : 1;
+
+	if(isLoose())
+	{
+		return placeLoose(volume, &placeable, startLeaf, startDepth);
+	}
+
+	const Bool wasPlaced = unlinkPlaceable(placeable);
+	placeRecursive(volume, &placeable, startLeaf, startDepth);
+	return !wasPlaced;
+}
+
+void Octree::commitOctantTaskCallback(void* ud, [[maybe_unused]] U32 threadId, [[maybe_unused]] ThreadHive& hive,
+									  [[maybe_unused]] ThreadHiveSemaphore* sem)
+{
+	CommitOctantCtx& ctx = *static_cast<CommitOctantCtx*>(ud);
+	Octree& self = *ctx.m_octree;
+
+	for(const DeferredPlacementQueue& queue : self.m_deferredQueues)
+	{
+		for(U32 i = 0; i < queue.m_count; ++i)
+		{
+			if(queue.m_placements[i].m_octant == ctx.m_octant)
+			{
+				ctx.m_newPlaceableCount +=
+					self.commitPlacement(queue.m_placements[i], ctx.m_actualSceneAabbMin, ctx.m_actualSceneAabbMax);
+			}
+		}
+	}
+}
+
+void Octree::commitDeferredPlacements(ThreadHive& hive)
+{
+	ANKI_TRACE_SCOPED_EVENT(SCENE_OCTREE_COMMIT);
+
+	// Count the placements of every octant
+	Array<U32, kRootOctant + 1> octantPlacementCounts = {};
+	for(const DeferredPlacementQueue& queue : m_deferredQueues)
+	{
+		for(U32 i = 0; i < queue.m_count; ++i)
+		{
+			++octantPlacementCounts[queue.m_placements[i].m_octant];
+		}
+	}
+
+	U32 placementCount = 0;
+	for(U32 count : octantPlacementCounts)
+	{
+		placementCount += count;
+	}
+
+	if(placementCount == 0)
+	{
+		return;
+	}
+
+	// Create the root and the top level octants serially since they are shared
+	createRootLeaf();
+	Array<CommitOctantCtx, kRootOctant + 1> ctxs;
+	U32 parallelOctantCount = 0;
+	for(U8 octant = 0; octant <= kRootOctant; ++octant)
+	{
+		ctxs[octant].m_octree = this;
+		ctxs[octant].m_octant = octant;
+
+		if(octant < kRootOctant && octantPlacementCounts[octant] > 0)
+		{
+			++parallelOctantCount;
+			if(m_rootLeaf->m_children[octant] == nullptr)
+			{
+				newChildLeaf(*m_rootLeaf, octant);
+			}
+		}
+	}
+
+	// First the placements that touch the root or many octants
+	if(octantPlacementCounts[kRootOctant])
+	{
+		commitOctantTaskCallback(&ctxs[kRootOctant], 0, hive, nullptr);
+	}
+
+	// Then the rest. Every octant has its own leafs and allocators so they can go in parallel
+	if(parallelOctantCount > 1 && hive.getThreadCount() > 1)
+	{
+		Array<ThreadHiveTask, kRootOctant> tasks;
+		U32 taskCount = 0;
+		for(U8 octant = 0; octant < kRootOctant; ++octant)
+		{
+			if(octantPlacementCounts[octant])
+			{
+				tasks[taskCount].m_callback = commitOctantTaskCallback;
+				tasks[taskCount].m_argument = &ctxs[octant];
+				++taskCount;
+			}
+		}
+
+		hive.submitTasks(&tasks[0], taskCount);
+		hive.waitAllTasks();
+	}
+	else
+	{
+		for(U8 octant = 0; octant < kRootOctant; ++octant)
+		{
+			if(octantPlacementCounts[octant])
+			{
+				commitOctantTaskCallback(&ctxs[octant], 0, hive, nullptr);
+			}
+		}
+	}
+
+	// Gather the results
+	for(const CommitOctantCtx& ctx : ctxs)
+	{
+		m_placeableCount += ctx.m_newPlaceableCount;
+		m_actualSceneAabbMin = m_actualSceneAabbMin.min(ctx.m_actualSceneAabbMin);
+		m_actualSceneAabbMax = m_actualSceneAabbMax.max(ctx.m_actualSceneAabbMax);
+	}
+
+	for(DeferredPlacementQueue& queue : m_deferredQueues)
+	{
+		queue.m_count = 0;
+	}
+}
+
+Bool Octree::volumeTotallyInsideBox(const Aabb& volume, const Vec3& bmin, const Vec3& bmax)
 {
 	const Vec4& amin = volume.getMin();
 	const Vec4& amax = volume.getMax();
-	const Vec3& bmin = leaf.m_aabbMin;
-	const Vec3& bmax = leaf.m_aabbMax;
 
 	Bool superset = true;
 	superset = superset && amin.x() <= bmin.x();
@@ -174,14 +435,178 @@ void Octree::placeRecursive(const Aabb& volume, OctreePlaceable* placeable, Leaf
 
 		// Connect placeable and leaf
 		placeable->m_leafs.pushBack(newLeafNode(parent));
-		parent->m_placeables.pushBack(newPlaceableNode(placeable));
+		parent->m_placeables.pushBack(newPlaceableNode(placeable, *parent));
 
 		return;
 	}
 
+	const Vec3 center = (parent->m_aabbMax + parent->m_aabbMin) / 2.0f;
+	const LeafMask maskUnion = computeChildMask(volume, center);
+	ANKI_ASSERT(!!maskUnion && "Should be inside at least one leaf");
+
+	for(U i = 0; i < 8; ++i)
+	{
+		const LeafMask crntBit = LeafMask(1u << i);
+
+		if(!!(maskUnion & crntBit))
+		{
+			// Inside the leaf, move deeper
+
+			// Create the leaf
+			if(parent->m_children[i] == nullptr)
+			{
+				newChildLeaf(*parent, U32(i));
+			}
+
+			// Move deeper
+			placeRecursive(volume, placeable, parent->m_children[i], depth + 1);
+		}
+	}
+}
+
+Octree::Leaf* Octree::newChildLeaf(Leaf& parent, U32 child)
+{
+	ANKI_ASSERT(child < 8 && parent.m_children[child] == nullptr);
+	Leaf* leaf = newLeaf((&parent == m_rootLeaf) ? U8(child) : parent.m_octant);
+
+	Vec3 parentMin, parentMax;
+	getTightAabb(parent, parentMin, parentMax);
+	computeChildAabb(LeafMask(1u << child), parentMin, parentMax, (parentMin + parentMax) / 2.0f, leaf->m_aabbMin,
+					 leaf->m_aabbMax);
+
+	if(isLoose())
+	{
+		// Extend by half the size on each side so the loose bounds are 2 times bigger
+		const Vec3 halfSize = (leaf->m_aabbMax - leaf->m_aabbMin) / 2.0f;
+		leaf->m_aabbMin -= halfSize;
+		leaf->m_aabbMax += halfSize;
+	}
+
+	parent.m_children[child] = leaf;
+	return leaf;
+}
+
+void Octree::getTightAabb(const Leaf& leaf, Vec3& aabbMin, Vec3& aabbMax) const
+{
+	if(!isLoose() || &leaf == m_rootLeaf)
+	{
+		aabbMin = leaf.m_aabbMin;
+		aabbMax = leaf.m_aabbMax;
+	}
+	else
+	{
+		const Vec3 center = (leaf.m_aabbMin + leaf.m_aabbMax) / 2.0f;
+		const Vec3 halfSize = (leaf.m_aabbMax - leaf.m_aabbMin) / 4.0f;
+		aabbMin = center - halfSize;
+		aabbMax = center + halfSize;
+	}
+}
+
+Octree::Leaf* Octree::findLooseLeaf(const Aabb& volume, Leaf* leaf, U32 depth)
+{
+	ANKI_ASSERT(isLoose() && leaf);
+
+	const Vec3 volumeCenter = ((volume.getMin() + volume.getMax()) / 2.0f).xyz();
+	const Vec3 volumeHalfSize = ((volume.getMax() - volume.getMin()) / 2.0f).xyz();
+	const F32 volumeExtend = max(volumeHalfSize.x(), max(volumeHalfSize.y(), volumeHalfSize.z()));
+
+	Vec3 tightMin, tightMax;
+	getTightAabb(*leaf, tightMin, tightMax);
+
+	// If the center is not inside the scene the volume can't be moved deeper than the root
+	if(depth == 0 && !(volumeCenter >= tightMin && volumeCenter <= tightMax))
+	{
+		return leaf;
+	}
+
+	while(depth < m_maxDepth)
+	{
+		// A volume fits in the loose bounds of a child if its center is inside the child's tight bounds and its half
+		// size is not bigger than the child's half size
+		const Vec3 childHalfSize = (tightMax - tightMin) / 4.0f;
+		if(volumeExtend > min(childHalfSize.x(), min(childHalfSize.y(), childHalfSize.z())))
+		{
+			break;
+		}
+
+		const U32 child = computeChildIndex(volumeCenter, (tightMin + tightMax) / 2.0f);
+
+		if(leaf->m_children[child] == nullptr)
+		{
+			newChildLeaf(*leaf, child);
+		}
+
+		leaf = leaf->m_children[child];
+		getTightAabb(*leaf, tightMin, tightMax);
+		++depth;
+	}
+
+	return leaf;
+}
+
+Bool Octree::placeLoose(const Aabb& volume, OctreePlaceable* placeable, Leaf* leaf, U32 depth)
+{
+	ANKI_ASSERT(placeable);
+	Leaf* target = findLooseLeaf(volume, leaf, depth);
+
+	// Fast path: It stays in the same leaf
+	if(placeable->m_leafs.getSize() == 1 && placeable->m_leafs.getFront().m_leaf == target)
+	{
+		return false;
+	}
+
+	const Bool wasPlaced = unlinkPlaceable(*placeable);
+	placeable->m_leafs.pushBack(newLeafNode(target));
+	target->m_placeables.pushBack(newPlaceableNode(placeable, *target));
+	return !wasPlaced;
+}
+
+U8 Octree::computeTopLevelOctant(const Aabb& volume) const
+{
+	U8 octant = kRootOctant;
+	const Vec3 sceneCenter = (m_sceneAabbMin + m_sceneAabbMax) / 2.0f;
+
+	if(isLoose())
+	{
+		// Same as the 1st step of findLooseLeaf
+		const Vec3 volumeCenter = ((volume.getMin() + volume.getMax()) / 2.0f).xyz();
+		const Vec3 volumeHalfSize = ((volume.getMax() - volume.getMin()) / 2.0f).xyz();
+		const F32 volumeExtend = max(volumeHalfSize.x(), max(volumeHalfSize.y(), volumeHalfSize.z()));
+		const Vec3 childHalfSize = (m_sceneAabbMax - m_sceneAabbMin) / 4.0f;
+
+		if(volumeCenter >= m_sceneAabbMin && volumeCenter <= m_sceneAabbMax
+		   && volumeExtend <= min(childHalfSize.x(), min(childHalfSize.y(), childHalfSize.z())))
+		{
+			octant = U8(computeChildIndex(volumeCenter, sceneCenter));
+		}
+	}
+	else if(!volumeTotallyInsideBox(volume, m_sceneAabbMin, m_sceneAabbMax))
+	{
+		// If it's bigger than the scene it will be binned to the root
+		const LeafMask mask = computeChildMask(volume, sceneCenter);
+		if(__builtin_popcount(U32(mask)) == 1)
+		{
+			octant = U8(__builtin_ctz(U32(mask)));
+		}
+	}
+
+	return octant;
+}
+
+U32 Octree::computeChildIndex(const Vec3& point, const Vec3& center)
+{
+	U32 child = 0;
+	child |= (point.x() >= center.x()) ? 0u : 4u; // Left
+	child |= (point.y() >= center.y()) ? 0u : 2u; // Bottom
+	child |= (point.z() >= center.z()) ? 0u : 1u; // Back
+	ANKI_ASSERT(child < 8);
+	return child;
+}
+
+Octree::LeafMask Octree::computeChildMask(const Aabb& volume, const Vec3& center)
+{
 	const Vec4& vMin = volume.getMin();
 	const Vec4& vMax = volume.getMax();
-	const Vec3 center = (parent->m_aabbMax + parent->m_aabbMin) / 2.0f;
 
 	LeafMask maskX;
 	if(vMin.x() > center.x())
@@ -231,34 +656,7 @@ void Octree::placeRecursive(const Aabb& volume, OctreePlaceable* placeable, Leaf
 		maskZ = LeafMask::kAll;
 	}
 
-	const LeafMask maskUnion = maskX & maskY & maskZ;
-	ANKI_ASSERT(!!maskUnion && "Should be inside at least one leaf");
-
-	for(U i = 0; i < 8; ++i)
-	{
-		const LeafMask crntBit = LeafMask(1u << i);
-
-		if(!!(maskUnion & crntBit))
-		{
-			// Inside the leaf, move deeper
-
-			// Create the leaf
-			if(parent->m_children[i] == nullptr)
-			{
-				Leaf* child = newLeaf();
-
-				// Compute AABB
-				Vec3 childAabbMin, childAabbMax;
-				computeChildAabb(crntBit, parent->m_aabbMin, parent->m_aabbMax, center, child->m_aabbMin,
-								 child->m_aabbMax);
-
-				parent->m_children[i] = child;
-			}
-
-			// Move deeper
-			placeRecursive(volume, placeable, parent->m_children[i], depth + 1);
-		}
-	}
+	return maskX & maskY & maskZ;
 }
 
 void Octree::computeChildAabb(LeafMask child, const Vec3& parentAabbMin, const Vec3& parentAabbMax,
@@ -312,32 +710,9 @@ void Octree::computeChildAabb(LeafMask child, const Vec3& parentAabbMin, const V
 
 void Octree::removeInternal(OctreePlaceable& placeable)
 {
-	const Bool isPlaced = !placeable.m_leafs.isEmpty();
+	const Bool isPlaced = unlinkPlaceable(placeable);
 	if(isPlaced)
 	{
-		while(!placeable.m_leafs.isEmpty())
-		{
-			// Pop a leaf node
-			LeafNode* leafNode = placeable.m_leafs.popFront();
-
-			// Iterate the placeables of the leaf
-			[[maybe_unused]] Bool found = false;
-			for(PlaceableNode& placeableNode : leafNode->m_leaf->m_placeables)
-			{
-				if(placeableNode.m_placeable == &placeable)
-				{
-					found = true;
-					leafNode->m_leaf->m_placeables.erase(&placeableNode);
-					releasePlaceableNode(&placeableNode);
-					break;
-				}
-			}
-			ANKI_ASSERT(found);
-
-			// Delete the leaf node
-			releaseLeafNode(leafNode);
-		}
-
 		// Cleanup the tree if there are no placeables
 		ANKI_ASSERT(m_placeableCount > 0);
 		--m_placeableCount;
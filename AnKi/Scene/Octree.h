@@ -12,18 +12,33 @@
 #include <AnKi/Util/Enum.h>
 #include <AnKi/Util/ObjectAllocator.h>
 #include <AnKi/Util/List.h>
+#include <AnKi/Util/HashMap.h>
 #include <AnKi/Util/Tracer.h>
+#include <AnKi/Util/ThreadHive.h>
 
 namespace anki {
 
 // Forward
 class OctreePlaceable;
-class ThreadHive;
-class ThreadHiveSemaphore;
 
 /// @addtogroup scene
 /// @{
 
+/// Octree options.
+enum class OctreeFlag : U8
+{
+	kNone = 0,
+
+	/// Hint to the users of the Octree that they should use the deferred placement methods.
+	kDeferredPlacement = 1 << 0,
+
+	/// Make it a loose octree. Every leaf's bounds are 2 times bigger than normal and every placeable lives in a single
+	/// leaf chosen by its center and size. Moving objects rarely change leafs and nothing gets stuck at the top levels
+	/// because it straddles a boundary.
+	kLoose = 1 << 1,
+};
+ANKI_ENUM_ALLOW_NUMERIC_OPERATIONS(OctreeFlag)
+
 /// Callback to determine if an octree node is visible.
 using OctreeNodeVisibilityTestCallback = Bool (*)(void* userData, const Aabb& box);
 
@@ -51,7 +66,11 @@ public:
 
 	Octree& operator=(const Octree&) = delete; // Non-copyable
 
-	void init(const Vec3& sceneAabbMin, const Vec3& sceneAabbMax, U32 maxDepth);
+	/// @param sceneAabbMin The min of the bounds of the scene.
+	/// @param sceneAabbMax The max of the bounds of the scene.
+	/// @param maxDepth The max depth of the tree.
+	/// @param flags Options.
+	void init(const Vec3& sceneAabbMin, const Vec3& sceneAabbMax, U32 maxDepth, OctreeFlag flags = OctreeFlag::kNone);
 
 	/// Place or re-place an element in the tree.
 	/// @note It's thread-safe against place and remove methods.
@@ -65,6 +84,31 @@ public:
 	/// @note It's thread-safe against place and remove methods.
 	void remove(OctreePlaceable& placeable);
 
+	Bool getDeferredPlacementEnabled() const
+	{
+		return !!(m_flags & OctreeFlag::kDeferredPlacement);
+	}
+
+	Bool isLoose() const
+	{
+		return !!(m_flags & OctreeFlag::kLoose);
+	}
+
+	/// Same as place but the placement will happen in commitDeferredPlacements. Only one placement per placeable is
+	/// allowed between commits.
+	/// @param threadId The index of the calling thread. Every thread has its own queue so there is no locking.
+	/// @note It's thread-safe if every thread uses a different threadId.
+	void placeDeferred(const Aabb& volume, OctreePlaceable* placeable, Bool updateActualSceneBounds, U32 threadId);
+
+	/// Same as placeAlwaysVisible but the placement will happen in commitDeferredPlacements.
+	/// @note It's thread-safe if every thread uses a different threadId.
+	void placeAlwaysVisibleDeferred(OctreePlaceable* placeable, U32 threadId);
+
+	/// Apply the deferred placements. The placements that stay inside a single top level octant are applied in
+	/// parallel.
+	/// @note Not thread-safe against any other method. Don't call it from a ThreadHive task.
+	void commitDeferredPlacements(ThreadHive& hive);
+
 	/// Gather visible placeables.
 	/// @param frustumPlanes The frustum planes to test against.
 	/// @param testId A unique index for this test.
@@ -98,6 +142,27 @@ public:
 		walkTreeInternal(*m_rootLeaf, testId, testFunc, newPlaceableFunc);
 	}
 
+	/// Walk the tree once for many tests. The tests that see a leaf are carried down as a bitmask so leafs and
+	/// placeables shared by many tests (eg the faces of a point light) are visited only once.
+	/// @tparam TTestAabbFunc The lambda that will test an Aabb. Signature of lambda:
+	///                       U32(*)(const Aabb& leafBox, U32 testMask). Returns the subset of testMask that passed.
+	/// @tparam TNewPlaceableFunc The lambda to do something with a visible placeable.
+	///                           Signature: void(*)(void* placeableUserData, U32 testMask). The mask holds the tests
+	///                           that see the placeable for the 1st time.
+	/// @param testId A single test index for the whole walk. The same semantics as walkTree().
+	/// @param testCount The number of tests. They are the bits of the masks.
+	/// @param testFunc See TTestAabbFunc.
+	/// @param newPlaceableFunc See TNewPlaceableFunc.
+	template<typename TTestAabbFunc, typename TNewPlaceableFunc>
+	void walkTreeMulti(U32 testId, U32 testCount, TTestAabbFunc testFunc, TNewPlaceableFunc newPlaceableFunc)
+	{
+		ANKI_ASSERT(m_rootLeaf);
+		ANKI_ASSERT(testCount > 0 && testCount <= 32);
+		const U32 testMask = (testCount == 32) ? kMaxU32 : (1u << testCount) - 1u;
+		HashMapRaii<U64, U32> sharedPlaceableMasks(m_pool);
+		walkTreeMultiInternal(*m_rootLeaf, testId, testMask, sharedPlaceableMasks, testFunc, newPlaceableFunc);
+	}
+
 	/// Debug draw.
 	void debugDraw(OctreeDebugDrawer& drawer) const
 	{
@@ -118,6 +183,10 @@ public:
 private:
 	class GatherParallelCtx;
 	class GatherParallelTaskCtx;
+	class CommitOctantCtx;
+
+	/// Used in Leaf::m_octant for the root leaf.
+	static constexpr U8 kRootOctant = 8;
 
 	/// List node.
 	class PlaceableNode : public IntrusiveListEnabled<PlaceableNode>
@@ -139,9 +208,10 @@ private:
 	{
 	public:
 		IntrusiveList<PlaceableNode> m_placeables;
-		Vec3 m_aabbMin;
-		Vec3 m_aabbMax;
+		Vec3 m_aabbMin; ///< In loose octrees it's the loose bounds. Those are used in the visibility tests.
+		Vec3 m_aabbMax; ///< In loose octrees it's the loose bounds. Those are used in the visibility tests.
 		Array<Leaf*, 8> m_children = {};
+		U8 m_octant = kRootOctant; ///< The top level octant this leaf belongs to.
 
 #if ANKI_ENABLE_ASSERTIONS
 		~Leaf()
@@ -198,15 +268,42 @@ private:
 	};
 	ANKI_ENUM_ALLOW_NUMERIC_OPERATIONS_FRIEND(LeafMask)
 
+	/// The objects of every top level octant come from different allocators so the octants can be modified in
+	/// parallel.
+	class OctantAllocators
+	{
+	public:
+		ObjectAllocatorSameType<Leaf, 256> m_leafAlloc;
+		ObjectAllocatorSameType<LeafNode, 128> m_leafNodeAlloc;
+		ObjectAllocatorSameType<PlaceableNode, 256> m_placeableNodeAlloc;
+	};
+
+	class DeferredPlacement
+	{
+	public:
+		Vec3 m_volumeMin; ///< Not an Aabb because the unused elements of the queue are not valid Aabbs.
+		Vec3 m_volumeMax;
+		OctreePlaceable* m_placeable;
+		U8 m_octant; ///< The only top level octant it touches or kRootOctant.
+		Bool m_alwaysVisible;
+		Bool m_updateActualSceneBounds;
+	};
+
+	/// Per thread queue of deferred placements. Aligned to avoid false sharing.
+	class alignas(ANKI_CACHE_LINE_SIZE) DeferredPlacementQueue
+	{
+	public:
+		DynamicArray<DeferredPlacement> m_placements; ///< Never shrinks.
+		U32 m_count = 0;
+	};
+
 	HeapMemoryPool* m_pool;
 	U32 m_maxDepth = 0;
 	Vec3 m_sceneAabbMin = Vec3(0.0f);
 	Vec3 m_sceneAabbMax = Vec3(0.0f);
 	mutable Mutex m_globalMtx;
 
-	ObjectAllocatorSameType<Leaf, 256> m_leafAlloc;
-	ObjectAllocatorSameType<LeafNode, 128> m_leafNodeAlloc;
-	ObjectAllocatorSameType<PlaceableNode, 256> m_placeableNodeAlloc;
+	Array<OctantAllocators, kRootOctant + 1> m_allocators;
 
 	Leaf* m_rootLeaf = nullptr;
 	U32 m_placeableCount = 0;
@@ -215,45 +312,89 @@ private:
 	Vec3 m_actualSceneAabbMin = Vec3(kMaxF32);
 	Vec3 m_actualSceneAabbMax = Vec3(kMinF32);
 
-	Leaf* newLeaf()
+	Array<DeferredPlacementQueue, ThreadHive::kMaxThreads> m_deferredQueues;
+	OctreeFlag m_flags = OctreeFlag::kNone;
+
+	Leaf* newLeaf(U8 octant)
 	{
-		return m_leafAlloc.newInstance(*m_pool);
+		Leaf* out = m_allocators[octant].m_leafAlloc.newInstance(*m_pool);
+		out->m_octant = octant;
+		return out;
 	}
 
 	void releaseLeaf(Leaf* leaf)
 	{
-		m_leafAlloc.deleteInstance(*m_pool, leaf);
+		m_allocators[leaf->m_octant].m_leafAlloc.deleteInstance(*m_pool, leaf);
 	}
 
-	PlaceableNode* newPlaceableNode(OctreePlaceable* placeable)
+	PlaceableNode* newPlaceableNode(OctreePlaceable* placeable, const Leaf& leaf)
 	{
 		ANKI_ASSERT(placeable);
-		PlaceableNode* out = m_placeableNodeAlloc.newInstance(*m_pool);
+		PlaceableNode* out = m_allocators[leaf.m_octant].m_placeableNodeAlloc.newInstance(*m_pool);
 		out->m_placeable = placeable;
 		return out;
 	}
 
-	void releasePlaceableNode(PlaceableNode* placeable)
+	void releasePlaceableNode(PlaceableNode* placeable, const Leaf& leaf)
 	{
-		m_placeableNodeAlloc.deleteInstance(*m_pool, placeable);
+		m_allocators[leaf.m_octant].m_placeableNodeAlloc.deleteInstance(*m_pool, placeable);
 	}
 
 	LeafNode* newLeafNode(Leaf* leaf)
 	{
 		ANKI_ASSERT(leaf);
-		LeafNode* out = m_leafNodeAlloc.newInstance(*m_pool);
+		LeafNode* out = m_allocators[leaf->m_octant].m_leafNodeAlloc.newInstance(*m_pool);
 		out->m_leaf = leaf;
 		return out;
 	}
 
 	void releaseLeafNode(LeafNode* node)
 	{
-		m_leafNodeAlloc.deleteInstance(*m_pool, node);
+		m_allocators[node->m_leaf->m_octant].m_leafNodeAlloc.deleteInstance(*m_pool, node);
 	}
 
+	void createRootLeaf();
+
+	/// Create a child leaf and compute its bounds.
+	Leaf* newChildLeaf(Leaf& parent, U32 child);
+
+	/// Get the bounds of the leaf without the looseness.
+	void getTightAabb(const Leaf& leaf, Vec3& aabbMin, Vec3& aabbMax) const;
+
 	void placeRecursive(const Aabb& volume, OctreePlaceable* placeable, Leaf* parent, U32 depth);
 
-	static Bool volumeTotallyInsideLeaf(const Aabb& volume, const Leaf& leaf);
+	/// Find the leaf of a loose octree that the volume belongs to. Create leafs if needed.
+	Leaf* findLooseLeaf(const Aabb& volume, Leaf* leaf, U32 depth);
+
+	/// Place in a loose octree. If the placeable is already in the right leaf nothing happens.
+	/// @return True if the placeable wasn't placed before.
+	Bool placeLoose(const Aabb& volume, OctreePlaceable* placeable, Leaf* leaf, U32 depth);
+
+	/// Get the index of the child that contains the point.
+	static U32 computeChildIndex(const Vec3& point, const Vec3& center);
+
+	/// Find the top level octant of a volume or kRootOctant if it touches the root or many octants.
+	U8 computeTopLevelOctant(const Aabb& volume) const;
+
+	/// Compute the children of a leaf that a volume overlaps.
+	static LeafMask computeChildMask(const Aabb& volume, const Vec3& leafCenter);
+
+	/// Remove a placeable from all the leafs. It doesn't touch m_placeableCount.
+	/// @return True if it was placed.
+	Bool unlinkPlaceable(OctreePlaceable& placeable);
+
+	/// Apply a deferred placement.
+	/// @return True if the placeable wasn't placed before.
+	Bool commitPlacement(const DeferredPlacement& placement, Vec3& actualSceneAabbMin, Vec3& actualSceneAabbMax);
+
+	static void commitOctantTaskCallback(void* ud, U32 threadId, ThreadHive& hive, ThreadHiveSemaphore* sem);
+
+	static Bool volumeTotallyInsideBox(const Aabb& volume, const Vec3& boxMin, const Vec3& boxMax);
+
+	static Bool volumeTotallyInsideLeaf(const Aabb& volume, const Leaf& leaf)
+	{
+		return volumeTotallyInsideBox(volume, leaf.m_aabbMin, leaf.m_aabbMax);
+	}
 
 	static void computeChildAabb(LeafMask child, const Vec3& parentAabbMin, const Vec3& parentAabbMax,
 								 const Vec3& parentAabbCenter, Vec3& childAabbMin, Vec3& childAabbMax);
@@ -282,6 +423,11 @@ private:
 
 	template<typename TTestAabbFunc, typename TNewPlaceableFunc>
 	void walkTreeInternal(Leaf& leaf, U32 testId, TTestAabbFunc testFunc, TNewPlaceableFunc newPlaceableFunc);
+
+	/// @param sharedPlaceableMasks The tests that saw the placeables that are in many leafs. Keyed by the placeable.
+	template<typename TTestAabbFunc, typename TNewPlaceableFunc>
+	void walkTreeMultiInternal(Leaf& leaf, U32 testId, U32 testMask, HashMapRaii<U64, U32>& sharedPlaceableMasks,
+							   TTestAabbFunc testFunc, TNewPlaceableFunc newPlaceableFunc);
 };
 
 /// An entity that can be placed in octrees.
@@ -306,10 +452,13 @@ public:
 		}
 	}
 
-private:
+	/// The max number of tests in a frame. See Octree::walkTree() and the rest.
 	static constexpr U32 kMaxTests = 128;
+
+private:
 	Array<Atomic<U64>, kMaxTests / 64> m_visitedMasks = {0u, 0u};
 	IntrusiveList<Octree::LeafNode> m_leafs; ///< A list of leafs this placeable belongs.
+	Bool m_deferredPlacementPending = false;
 
 	/// Check if already visited.
 	/// @note It's thread-safe.
@@ -354,6 +503,65 @@ inline void Octree::walkTreeInternal(Leaf& leaf, U32 testId, TTestAabbFunc testF
 
 	ANKI_TRACE_INC_COUNTER(OCTREE_VISIBLE_LEAFS, visibleLeafs);
 }
+
+template<typename TTestAabbFunc, typename TNewPlaceableFunc>
+inline void Octree::walkTreeMultiInternal(Leaf& leaf, U32 testId, U32 testMask,
+										  HashMapRaii<U64, U32>& sharedPlaceableMasks, TTestAabbFunc testFunc,
+										  TNewPlaceableFunc newPlaceableFunc)
+{
+	ANKI_ASSERT(testMask);
+
+	// Visit the placeables that belong to that leaf
+	for(PlaceableNode& placeableNode : leaf.m_placeables)
+	{
+		OctreePlaceable& placeable = *placeableNode.m_placeable;
+		const Bool inManyLeafs = &placeable.m_leafs.getFront() != &placeable.m_leafs.getBack();
+
+		U32 newMask = 0;
+		if(!placeable.alreadyVisited(testId))
+		{
+			newMask = testMask;
+
+			// Only the placeables in many leafs can be met again. Remember the tests that saw them
+			if(inManyLeafs)
+			{
+				sharedPlaceableMasks.emplace(ptrToNumber(&placeable), testMask);
+			}
+		}
+		else if(inManyLeafs)
+		{
+			auto it = sharedPlaceableMasks.find(ptrToNumber(&placeable));
+			ANKI_ASSERT(it != sharedPlaceableMasks.getEnd());
+			newMask = testMask & ~(*it);
+			*it |= testMask;
+		}
+
+		if(newMask)
+		{
+			ANKI_ASSERT(placeable.m_userData);
+			newPlaceableFunc(placeable.m_userData, newMask);
+		}
+	}
+
+	Aabb aabb;
+	[[maybe_unused]] U visibleLeafs = 0;
+	for(Leaf* child : leaf.m_children)
+	{
+		if(child)
+		{
+			aabb.setMin(child->m_aabbMin);
+			aabb.setMax(child->m_aabbMax);
+			const U32 childMask = testFunc(aabb, testMask) & testMask;
+			if(childMask)
+			{
+				++visibleLeafs;
+				walkTreeMultiInternal(*child, testId, childMask, sharedPlaceableMasks, testFunc, newPlaceableFunc);
+			}
+		}
+	}
+
+	ANKI_TRACE_INC_COUNTER(OCTREE_VISIBLE_LEAFS, visibleLeafs);
+}
 /// @}
 
 } // end namespace anki
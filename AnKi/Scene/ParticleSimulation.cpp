@@ -0,0 +1,311 @@
+// Copyright (C) 2009-2022, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <AnKi/Scene/ParticleSimulation.h>
+#include <AnKi/Resource/ParticleEmitterResource.h>
+
+namespace anki {
+
+static_assert(sizeof(Vec4) == 4 * sizeof(F32), "The streams are also accessed as arrays of floats");
+
+static F32 horizontalMin(const Vec4& v)
+{
+	return min(min(v.x(), v.y()), min(v.z(), v.w()));
+}
+
+static F32 horizontalMax(const Vec4& v)
+{
+	return max(max(v.x(), v.y()), max(v.z(), v.w()));
+}
+
+void SimdRandom::seed(U64 seed)
+{
+	// Use splitmix64 to spread the seed to the lanes. xorshift can't have zero state
+	for(U32 i = 0; i < 4; ++i)
+	{
+		seed += 0x9E3779B97F4A7C15ull;
+		U64 z = seed;
+		z = (z ^ (z >> 30u)) * 0xBF58476D1CE4E5B9ull;
+		z = (z ^ (z >> 27u)) * 0x94D049BB133111EBull;
+		z ^= z >> 31u;
+		m_state[i] = max(U32(z), 1u);
+	}
+}
+
+ParticleSimulation::~ParticleSimulation()
+{
+	destroy();
+}
+
+void ParticleSimulation::init(HeapMemoryPool* pool, U32 maxParticleCount, U64 seed)
+{
+	ANKI_ASSERT(pool && maxParticleCount > 0);
+	destroy();
+
+	m_pool = pool;
+	m_maxCount = maxParticleCount;
+	m_packetCount = (maxParticleCount + 3) / 4;
+	m_streams.create(*m_pool, m_packetCount * U32(Stream::kCount), Vec4(0.0f));
+	m_aliveCount = 0;
+	m_random.seed(seed);
+
+	// The lanes after the alive particles are simulated as well. Give them a lifetime to avoid dividing by zero
+	Vec4* lifetimes = getStream(Stream::kLifetime);
+	for(U32 i = 0; i < m_packetCount; ++i)
+	{
+		lifetimes[i] = Vec4(1.0f);
+	}
+}
+
+void ParticleSimulation::destroy()
+{
+	if(m_pool)
+	{
+		m_streams.destroy(*m_pool);
+		m_pool = nullptr;
+	}
+
+	m_packetCount = 0;
+	m_maxCount = 0;
+	m_aliveCount = 0;
+}
+
+void ParticleSimulation::emit(const ParticleEmitterProperties& props, const Vec3& emitterPosition, U32 count)
+{
+	count = min(count, m_maxCount - m_aliveCount);
+
+	const auto& p = props.m_particle;
+	const Vec4 minLifeSizeAlpha(F32(p.m_minLife), p.m_minInitialSize, p.m_minFinalSize, p.m_minInitialAlpha);
+	const Vec4 maxLifeSizeAlpha(F32(p.m_maxLife), p.m_maxInitialSize, p.m_maxFinalSize, p.m_maxInitialAlpha);
+	const Vec4 minGravityAlpha(p.m_minGravity, p.m_minFinalAlpha);
+	const Vec4 maxGravityAlpha(p.m_maxGravity, p.m_maxFinalAlpha);
+	const Vec4 minPosition(p.m_minStartingPosition + emitterPosition, 0.0f);
+	const Vec4 maxPosition(p.m_maxStartingPosition + emitterPosition, 0.0f);
+
+	Array<F32*, U32(Stream::kCount)> streams;
+	for(Stream s : EnumIterable<Stream>())
+	{
+		streams[s] = getScalarStream(s);
+	}
+
+	for(U32 i = m_aliveCount; i < m_aliveCount + count; ++i)
+	{
+		const Vec4 lifeSizeAlpha = m_random.getRandomRange(minLifeSizeAlpha, maxLifeSizeAlpha);
+		const Vec4 gravityAlpha = m_random.getRandomRange(minGravityAlpha, maxGravityAlpha);
+		const Vec4 position = m_random.getRandomRange(minPosition, maxPosition);
+
+		streams[Stream::kPositionX][i] = position.x();
+		streams[Stream::kPositionY][i] = position.y();
+		streams[Stream::kPositionZ][i] = position.z();
+		streams[Stream::kVelocityX][i] = 0.0f;
+		streams[Stream::kVelocityY][i] = 0.0f;
+		streams[Stream::kVelocityZ][i] = 0.0f;
+		streams[Stream::kAccelerationX][i] = gravityAlpha.x();
+		streams[Stream::kAccelerationY][i] = gravityAlpha.y();
+		streams[Stream::kAccelerationZ][i] = gravityAlpha.z();
+		streams[Stream::kAge][i] = 0.0f;
+		streams[Stream::kLifetime][i] = lifeSizeAlpha.x();
+		streams[Stream::kInitialSize][i] = lifeSizeAlpha.y();
+		streams[Stream::kFinalSize][i] = lifeSizeAlpha.z();
+		streams[Stream::kSize][i] = lifeSizeAlpha.y();
+		streams[Stream::kInitialAlpha][i] = lifeSizeAlpha.w();
+		streams[Stream::kFinalAlpha][i] = gravityAlpha.w();
+		streams[Stream::kAlpha][i] = clamp(lifeSizeAlpha.w(), 0.0f, 1.0f);
+	}
+
+	m_aliveCount += count;
+}
+
+U32 ParticleSimulation::simulate(F32 dt, F32* verts, Vec3& aabbMin, Vec3& aabbMax, F32& maxSize)
+{
+	ANKI_ASSERT(verts);
+
+	// Integrate 4 particles at a time
+	{
+		Vec4* posX = getStream(Stream::kPositionX);
+		Vec4* posY = getStream(Stream::kPositionY);
+		Vec4* posZ = getStream(Stream::kPositionZ);
+		Vec4* velX = getStream(Stream::kVelocityX);
+		Vec4* velY = getStream(Stream::kVelocityY);
+		Vec4* velZ = getStream(Stream::kVelocityZ);
+		const Vec4* accX = getStream(Stream::kAccelerationX);
+		const Vec4* accY = getStream(Stream::kAccelerationY);
+		const Vec4* accZ = getStream(Stream::kAccelerationZ);
+		Vec4* age = getStream(Stream::kAge);
+		const Vec4* lifetime = getStream(Stream::kLifetime);
+		const Vec4* initialSize = getStream(Stream::kInitialSize);
+		const Vec4* finalSize = getStream(Stream::kFinalSize);
+		Vec4* size = getStream(Stream::kSize);
+		const Vec4* initialAlpha = getStream(Stream::kInitialAlpha);
+		const Vec4* finalAlpha = getStream(Stream::kFinalAlpha);
+		Vec4* alpha = getStream(Stream::kAlpha);
+
+		const Vec4 dtv(dt);
+		const Vec4 dt2(dt * dt);
+		const U32 packetCount = (m_aliveCount + 3) / 4;
+		for(U32 i = 0; i < packetCount; ++i)
+		{
+			posX[i] += accX[i] * dt2 + velX[i] * dtv;
+			posY[i] += accY[i] * dt2 + velY[i] * dtv;
+			posZ[i] += accZ[i] * dt2 + velZ[i] * dtv;
+
+			velX[i] += accX[i] * dtv;
+			velY[i] += accY[i] * dtv;
+			velZ[i] += accZ[i] * dtv;
+
+			age[i] += dtv;
+			const Vec4 lifeFactor = age[i] / lifetime[i];
+			size[i] = initialSize[i] + (finalSize[i] - initialSize[i]) * lifeFactor;
+			alpha[i] = (initialAlpha[i] + (finalAlpha[i] - initialAlpha[i]) * lifeFactor).clamp(0.0f, 1.0f);
+		}
+	}
+
+	if(m_collisionCallback)
+	{
+		collide(dt);
+	}
+
+	Array<F32*, U32(Stream::kCount)> streams;
+	for(Stream s : EnumIterable<Stream>())
+	{
+		streams[s] = getScalarStream(s);
+	}
+
+	// Move the alive particles over the dead ones and write the vertices. Every particle is copied and the write
+	// position advances only if it's alive so there are no branches
+	U32 aliveCount = 0;
+	for(U32 i = 0; i < m_aliveCount; ++i)
+	{
+		for(F32* stream : streams)
+		{
+			stream[aliveCount] = stream[i];
+		}
+
+		F32* vert = verts + aliveCount * (kVertexSize / sizeof(F32));
+		vert[0] = streams[Stream::kPositionX][i];
+		vert[1] = streams[Stream::kPositionY][i];
+		vert[2] = streams[Stream::kPositionZ][i];
+		vert[3] = streams[Stream::kSize][i];
+		vert[4] = streams[Stream::kAlpha][i];
+
+		aliveCount += streams[Stream::kAge][i] <= streams[Stream::kLifetime][i];
+	}
+
+	m_aliveCount = aliveCount;
+	if(aliveCount == 0)
+	{
+		return 0;
+	}
+
+	// Fill the rest of the last packet with the 1st particle so it doesn't affect the bounds
+	for(U32 i = aliveCount; i < getAlignedRoundUp(4, aliveCount); ++i)
+	{
+		streams[Stream::kPositionX][i] = streams[Stream::kPositionX][0];
+		streams[Stream::kPositionY][i] = streams[Stream::kPositionY][0];
+		streams[Stream::kPositionZ][i] = streams[Stream::kPositionZ][0];
+		streams[Stream::kSize][i] = streams[Stream::kSize][0];
+	}
+
+	// Compute the bounds 4 particles at a time
+	const Vec4* posX = getStream(Stream::kPositionX);
+	const Vec4* posY = getStream(Stream::kPositionY);
+	const Vec4* posZ = getStream(Stream::kPositionZ);
+	const Vec4* size = getStream(Stream::kSize);
+	Vec4 minX(kMaxF32), minY(kMaxF32), minZ(kMaxF32);
+	Vec4 maxX(kMinF32), maxY(kMinF32), maxZ(kMinF32);
+	Vec4 maxSizes(kMinF32);
+	const U32 packetCount = (aliveCount + 3) / 4;
+	for(U32 i = 0; i < packetCount; ++i)
+	{
+		minX = minX.min(posX[i]);
+		minY = minY.min(posY[i]);
+		minZ = minZ.min(posZ[i]);
+		maxX = maxX.max(posX[i]);
+		maxY = maxY.max(posY[i]);
+		maxZ = maxZ.max(posZ[i]);
+		maxSizes = maxSizes.max(size[i]);
+	}
+
+	aabbMin = Vec3(horizontalMin(minX), horizontalMin(minY), horizontalMin(minZ));
+	aabbMax = Vec3(horizontalMax(maxX), horizontalMax(maxY), horizontalMax(maxZ));
+	maxSize = horizontalMax(maxSizes);
+
+	return aliveCount;
+}
+
+void ParticleSimulation::collide(F32 dt)
+{
+	F32* posX = getScalarStream(Stream::kPositionX);
+	F32* posY = getScalarStream(Stream::kPositionY);
+	F32* posZ = getScalarStream(Stream::kPositionZ);
+	F32* velX = getScalarStream(Stream::kVelocityX);
+	F32* velY = getScalarStream(Stream::kVelocityY);
+	F32* velZ = getScalarStream(Stream::kVelocityZ);
+	const F32* age = getScalarStream(Stream::kAge);
+	const F32* lifetime = getScalarStream(Stream::kLifetime);
+
+	Array<ParticleCollisionRay, kCollisionBatchSize> rays;
+	Array<U32, kCollisionBatchSize> particleIndices;
+	U32 rayCount = 0;
+
+	auto flush = [&]() {
+		m_collisionCallback(m_collisionUserData, WeakArray<ParticleCollisionRay>(&rays[0], rayCount));
+
+		for(U32 r = 0; r < rayCount; ++r)
+		{
+			const ParticleCollisionRay& ray = rays[r];
+			if(!ray.m_hit)
+			{
+				continue;
+			}
+
+			const U32 i = particleIndices[r];
+			Vec3 velocity(velX[i], velY[i], velZ[i]);
+			const F32 normalSpeed = velocity.dot(ray.m_hitNormal);
+			if(normalSpeed < 0.0f)
+			{
+				velocity -= ray.m_hitNormal * ((1.0f + m_bounciness) * normalSpeed);
+			}
+
+			const Vec3 position = ray.m_hitPosition + ray.m_hitNormal * kCollisionOffset;
+			posX[i] = position.x();
+			posY[i] = position.y();
+			posZ[i] = position.z();
+			velX[i] = velocity.x();
+			velY[i] = velocity.y();
+			velZ[i] = velocity.z();
+		}
+
+		rayCount = 0;
+	};
+
+	for(U32 i = 0; i < m_aliveCount; ++i)
+	{
+		// Don't bother with the ones that will die
+		if(age[i] > lifetime[i])
+		{
+			continue;
+		}
+
+		// The integrator gives x1 = x0 + v0 * dt + a * dt^2 and v1 = v0 + a * dt so x0 = x1 - v1 * dt
+		ParticleCollisionRay& ray = rays[rayCount];
+		ray.m_to = Vec3(posX[i], posY[i], posZ[i]);
+		ray.m_from = ray.m_to - Vec3(velX[i], velY[i], velZ[i]) * dt;
+		ray.m_hit = false;
+		particleIndices[rayCount] = i;
+
+		if(++rayCount == kCollisionBatchSize)
+		{
+			flush();
+		}
+	}
+
+	if(rayCount)
+	{
+		flush();
+	}
+}
+
+} // end namespace anki
@@ -0,0 +1,191 @@
+// Copyright (C) 2009-2022, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#pragma once
+
+#include <AnKi/Scene/Common.h>
+#include <AnKi/Math.h>
+#include <AnKi/Util/DynamicArray.h>
+#include <AnKi/Util/Enum.h>
+#include <AnKi/Util/WeakArray.h>
+
+namespace anki {
+
+// Forward
+class ParticleEmitterProperties;
+
+/// @addtogroup scene
+/// @{
+
+/// A random number generator with 4 independent xorshift lanes. It's not thread-safe but it's cheap enough to have one
+/// per user.
+class SimdRandom
+{
+public:
+	SimdRandom()
+	{
+		seed(1);
+	}
+
+	void seed(U64 seed);
+
+	/// Get 4 random numbers in the [0, 1) range.
+	Vec4 getRandom()
+	{
+		m_state ^= m_state << 13u;
+		m_state ^= m_state >> 17u;
+		m_state ^= m_state << 5u;
+
+		// Keep the top 24 bits that fit in the mantissa
+		return Vec4(m_state >> 8u) * (1.0f / F32(1u << 24u));
+	}
+
+	/// Get 4 random numbers in the [min, max) range.
+	Vec4 getRandomRange(const Vec4& min, const Vec4& max)
+	{
+		return min + (max - min) * getRandom();
+	}
+
+private:
+	UVec4 m_state;
+};
+
+/// The move of a particle in the last step that ParticleSimulation wants to test against the world.
+class ParticleCollisionRay
+{
+public:
+	Vec3 m_from;
+	Vec3 m_to;
+	Vec3 m_hitPosition; ///< Valid if m_hit is true.
+	Vec3 m_hitNormal; ///< Valid if m_hit is true.
+	Bool m_hit;
+};
+
+/// Tests a batch of particle moves against the world. It should set the hit info of all rays.
+using ParticleCollisionCallback = void (*)(void* userData, WeakArray<ParticleCollisionRay> rays);
+
+/// The simulation of particles that don't interact with the physics world. The particles are stored as a structure of
+/// arrays where every Vec4 holds the same property of 4 consecutive particles so the integration runs on 4 particles at
+/// a time. The alive particles are always packed at the beginning of the arrays. The dead ones are compacted away after
+/// every step and the new ones are appended at the end. The particles can optionally bounce off the world.
+class ParticleSimulation
+{
+public:
+	/// The size of a vertex that simulate() writes. The position, the size and the alpha.
+	static constexpr U32 kVertexSize = 5 * sizeof(F32);
+
+	/// The max number of rays that are passed to the ParticleCollisionCallback at a time.
+	static constexpr U32 kCollisionBatchSize = 64;
+
+	/// How far from the surface a particle is placed after a bounce.
+	static constexpr F32 kCollisionOffset = 0.01f;
+
+	ParticleSimulation() = default;
+
+	ParticleSimulation(const ParticleSimulation&) = delete; // Non-copyable
+
+	~ParticleSimulation();
+
+	ParticleSimulation& operator=(const ParticleSimulation&) = delete; // Non-copyable
+
+	/// Allocate the particles. All of them are dead.
+	void init(HeapMemoryPool* pool, U32 maxParticleCount, U64 seed);
+
+	void destroy();
+
+	/// Revive particles.
+	/// @param props The properties of the particles.
+	/// @param emitterPosition The new particles are relative to that.
+	/// @param count How many to emit. It will emit less if there are not enough dead particles.
+	void emit(const ParticleEmitterProperties& props, const Vec3& emitterPosition, U32 count);
+
+	/// Enable collisions.
+	/// @param callback The callback. If it's nullptr the collisions are disabled.
+	/// @param userData Passed to the callback.
+	/// @param bounciness The part of the velocity along the normal that is kept after a bounce.
+	void setCollisionCallback(ParticleCollisionCallback callback, void* userData, F32 bounciness)
+	{
+		ANKI_ASSERT(bounciness >= 0.0f);
+		m_collisionCallback = callback;
+		m_collisionUserData = userData;
+		m_bounciness = bounciness;
+	}
+
+	/// Kill the particles that reached the end of their life and move the rest forward.
+	/// @param dt The time since the last step.
+	/// @param[out] verts The vertices of the alive particles. Must have space for kVertexSize * getMaxParticleCount().
+	/// @param[out] aabbMin The min of the positions of the alive particles. Undefined if there are none.
+	/// @param[out] aabbMax The max of the positions of the alive particles. Undefined if there are none.
+	/// @param[out] maxSize The max size of the alive particles. Undefined if there are none.
+	/// @return The number of alive particles.
+	U32 simulate(F32 dt, F32* verts, Vec3& aabbMin, Vec3& aabbMax, F32& maxSize);
+
+	U32 getAliveParticleCount() const
+	{
+		return m_aliveCount;
+	}
+
+	U32 getMaxParticleCount() const
+	{
+		return m_maxCount;
+	}
+
+private:
+	enum class Stream : U8
+	{
+		kPositionX,
+		kPositionY,
+		kPositionZ,
+		kVelocityX,
+		kVelocityY,
+		kVelocityZ,
+		kAccelerationX,
+		kAccelerationY,
+		kAccelerationZ,
+		kAge,
+		kLifetime,
+		kInitialSize,
+		kFinalSize,
+		kSize,
+		kInitialAlpha,
+		kFinalAlpha,
+		kAlpha,
+
+		kCount,
+		kFirst = 0
+	};
+	ANKI_ENUM_ALLOW_NUMERIC_OPERATIONS_FRIEND(Stream)
+
+	HeapMemoryPool* m_pool = nullptr;
+
+	/// All the streams one after the other. Every stream has m_packetCount elements.
+	DynamicArray<Vec4> m_streams;
+	U32 m_packetCount = 0;
+	U32 m_maxCount = 0;
+	U32 m_aliveCount = 0;
+
+	SimdRandom m_random;
+
+	ParticleCollisionCallback m_collisionCallback = nullptr;
+	void* m_collisionUserData = nullptr;
+	F32 m_bounciness = 0.0f;
+
+	Vec4* getStream(Stream stream)
+	{
+		return &m_streams[U32(stream) * m_packetCount];
+	}
+
+	/// Bounce the particles that hit something in the last step.
+	void collide(F32 dt);
+
+	/// Access a stream one particle at a time.
+	F32* getScalarStream(Stream stream)
+	{
+		return reinterpret_cast<F32*>(getStream(stream));
+	}
+};
+/// @}
+
+} // end namespace anki
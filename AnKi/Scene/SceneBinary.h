@@ -0,0 +1,238 @@
+// Copyright (C) 2009-2022, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+// WARNING: This file is auto generated.
+
+#pragma once
+
+#include <AnKi/Scene/Common.h>
+#include <AnKi/Util/WeakArray.h>
+#include <AnKi/Util/Enum.h>
+
+namespace anki {
+
+/// @addtogroup scene
+/// @{
+
+inline constexpr const Char* kSceneBinaryMagic = "ANKISCN1";
+
+/// @memberof SceneBinaryNode
+enum class SceneBinaryNodeType : U32
+{
+	kModel,
+	kStaticCollision,
+	kPointLight,
+	kSpotLight,
+	kDirectionalLight,
+	kReflectionProbe,
+	kGlobalIlluminationProbe,
+	kSkybox,
+	kDecal,
+	kParticleEmitter,
+	kGpuParticleEmitter,
+	kPerspectiveCamera,
+
+	kCount,
+	kFirst = 0
+};
+ANKI_ENUM_ALLOW_NUMERIC_OPERATIONS(SceneBinaryNodeType)
+
+/// The properties mirror the setters of the components that the level scripts call. The comments show what the
+/// SceneBinaryProperty holds.
+/// @memberof SceneBinaryProperty
+enum class SceneBinaryPropertyType : U32
+{
+	kModelResource, ///< m_strings[0]
+	kSkeletonResource, ///< m_strings[0]
+	kBodyMeshResource, ///< m_strings[0]
+	kBodyWorldTransform, ///< m_transform
+	kParticleEmitterResource, ///< m_strings[0]. For both kinds of particle emitters.
+	kLightDiffuseColor, ///< m_values[0-3]
+	kLightRadius, ///< m_values[0]
+	kLightDistance, ///< m_values[0]
+	kLightInnerAngle, ///< m_values[0]
+	kLightOuterAngle, ///< m_values[0]
+	kLightShadowEnabled, ///< m_values[0] is 0 or 1
+	kLightEvent, ///< Create a LightEvent. m_values[0-1] are the start time and the duration.
+	kLightEventFrequency, ///< The last kLightEvent. m_values[0-1] are the frequency and the deviation.
+	kLightEventIntensityMultiplier, ///< The last kLightEvent. m_values[0-3]
+	kReflectionProbeBoxVolumeSize, ///< m_values[0-2]
+	kGlobalIlluminationProbeBoxVolumeSize, ///< m_values[0-2]
+	kGlobalIlluminationProbeCellSize, ///< m_values[0]
+	kGlobalIlluminationProbeFadeDistance, ///< m_values[0]
+	kSkyboxImage, ///< m_strings[0]
+	kSkyboxSolidColor, ///< m_values[0-2]
+	kSkyboxMinFogDensity, ///< m_values[0]
+	kSkyboxMaxFogDensity, ///< m_values[0]
+	kSkyboxHeightOfMinFogDensity, ///< m_values[0]
+	kSkyboxHeightOfMaxFogDensity, ///< m_values[0]
+	kDecalDiffuse, ///< m_strings[0] is the atlas, m_strings[1] the sub-texture and m_values[0] the blend factor.
+	kDecalSpecularRoughness, ///< Same as kDecalDiffuse.
+	kDecalBoxVolumeSize, ///< m_values[0-2]
+	kLensFlareImage, ///< m_strings[0]
+	kLensFlareFirstFlareSize, ///< m_values[0-1]
+	kLensFlareColorMultiplier, ///< m_values[0-3]
+	kPerspective, ///< m_values[0-3] are near, far, fovX and fovY. The fovX is multiplied by the aspect ratio.
+
+	kCount,
+	kFirst = 0
+};
+ANKI_ENUM_ALLOW_NUMERIC_OPERATIONS(SceneBinaryPropertyType)
+
+/// A Transform.
+class SceneBinaryTransform
+{
+public:
+	Array<F32, 3> m_origin;
+
+	/// A Mat3x4 in row major order.
+	Array<F32, 12> m_rotation;
+
+	F32 m_scale;
+
+	template<typename TSerializer, typename TClass>
+	static void serializeCommon(TSerializer& s, TClass self)
+	{
+		s.doArray("m_origin", offsetof(SceneBinaryTransform, m_origin), &self.m_origin[0], self.m_origin.getSize());
+		s.doArray("m_rotation", offsetof(SceneBinaryTransform, m_rotation), &self.m_rotation[0],
+				  self.m_rotation.getSize());
+		s.doValue("m_scale", offsetof(SceneBinaryTransform, m_scale), self.m_scale);
+	}
+
+	template<typename TDeserializer>
+	void deserialize(TDeserializer& deserializer)
+	{
+		serializeCommon<TDeserializer, SceneBinaryTransform&>(deserializer, *this);
+	}
+
+	template<typename TSerializer>
+	void serialize(TSerializer& serializer) const
+	{
+		serializeCommon<TSerializer, const SceneBinaryTransform&>(serializer, *this);
+	}
+};
+
+/// A value of a component of a node.
+class SceneBinaryProperty
+{
+public:
+	SceneBinaryPropertyType m_type;
+
+	/// Offsets in SceneBinary::m_strings or kMaxU32.
+	Array<U32, 2> m_strings;
+
+	/// Index in SceneBinary::m_transforms or kMaxU32.
+	U32 m_transform;
+
+	Array<F32, 4> m_values;
+
+	template<typename TSerializer, typename TClass>
+	static void serializeCommon(TSerializer& s, TClass self)
+	{
+		s.doValue("m_type", offsetof(SceneBinaryProperty, m_type), self.m_type);
+		s.doArray("m_strings", offsetof(SceneBinaryProperty, m_strings), &self.m_strings[0], self.m_strings.getSize());
+		s.doValue("m_transform", offsetof(SceneBinaryProperty, m_transform), self.m_transform);
+		s.doArray("m_values", offsetof(SceneBinaryProperty, m_values), &self.m_values[0], self.m_values.getSize());
+	}
+
+	template<typename TDeserializer>
+	void deserialize(TDeserializer& deserializer)
+	{
+		serializeCommon<TDeserializer, SceneBinaryProperty&>(deserializer, *this);
+	}
+
+	template<typename TSerializer>
+	void serialize(TSerializer& serializer) const
+	{
+		serializeCommon<TSerializer, const SceneBinaryProperty&>(serializer, *this);
+	}
+};
+
+/// A scene node.
+class SceneBinaryNode
+{
+public:
+	SceneBinaryNodeType m_type;
+
+	/// Offset in SceneBinary::m_strings or kMaxU32 if it doesn't have a name.
+	U32 m_name;
+
+	/// Index in SceneBinary::m_nodes or kMaxU32 if it's a root.
+	U32 m_parent;
+
+	/// Index in SceneBinary::m_transforms or kMaxU32.
+	U32 m_localTransform;
+
+	/// Index in SceneBinary::m_properties.
+	U32 m_firstProperty;
+
+	U32 m_propertyCount;
+
+	template<typename TSerializer, typename TClass>
+	static void serializeCommon(TSerializer& s, TClass self)
+	{
+		s.doValue("m_type", offsetof(SceneBinaryNode, m_type), self.m_type);
+		s.doValue("m_name", offsetof(SceneBinaryNode, m_name), self.m_name);
+		s.doValue("m_parent", offsetof(SceneBinaryNode, m_parent), self.m_parent);
+		s.doValue("m_localTransform", offsetof(SceneBinaryNode, m_localTransform), self.m_localTransform);
+		s.doValue("m_firstProperty", offsetof(SceneBinaryNode, m_firstProperty), self.m_firstProperty);
+		s.doValue("m_propertyCount", offsetof(SceneBinaryNode, m_propertyCount), self.m_propertyCount);
+	}
+
+	template<typename TDeserializer>
+	void deserialize(TDeserializer& deserializer)
+	{
+		serializeCommon<TDeserializer, SceneBinaryNode&>(deserializer, *this);
+	}
+
+	template<typename TSerializer>
+	void serialize(TSerializer& serializer) const
+	{
+		serializeCommon<TSerializer, const SceneBinaryNode&>(serializer, *this);
+	}
+};
+
+/// A snapshot of the nodes that a level script creates. The nodes of the same type are next to each other.
+class SceneBinary
+{
+public:
+	Array<U8, 8> m_magic;
+	WeakArray<SceneBinaryNode> m_nodes;
+	WeakArray<SceneBinaryProperty> m_properties;
+	WeakArray<SceneBinaryTransform> m_transforms;
+
+	/// Null terminated strings one after the other. The names of the nodes and the resources.
+	WeakArray<Char> m_strings;
+
+	/// Index in m_nodes or kMaxU32.
+	U32 m_activeCameraNode;
+
+	template<typename TSerializer, typename TClass>
+	static void serializeCommon(TSerializer& s, TClass self)
+	{
+		s.doArray("m_magic", offsetof(SceneBinary, m_magic), &self.m_magic[0], self.m_magic.getSize());
+		s.doValue("m_nodes", offsetof(SceneBinary, m_nodes), self.m_nodes);
+		s.doValue("m_properties", offsetof(SceneBinary, m_properties), self.m_properties);
+		s.doValue("m_transforms", offsetof(SceneBinary, m_transforms), self.m_transforms);
+		s.doValue("m_strings", offsetof(SceneBinary, m_strings), self.m_strings);
+		s.doValue("m_activeCameraNode", offsetof(SceneBinary, m_activeCameraNode), self.m_activeCameraNode);
+	}
+
+	template<typename TDeserializer>
+	void deserialize(TDeserializer& deserializer)
+	{
+		serializeCommon<TDeserializer, SceneBinary&>(deserializer, *this);
+	}
+
+	template<typename TSerializer>
+	void serialize(TSerializer& serializer) const
+	{
+		serializeCommon<TSerializer, const SceneBinary&>(serializer, *this);
+	}
+};
+
+/// @}
+
+} // end namespace anki
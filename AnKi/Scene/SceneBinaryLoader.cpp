@@ -0,0 +1,551 @@
+// Copyright (C) 2009-2022, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <AnKi/Scene/SceneBinaryLoader.h>
+#include <AnKi/Scene/SceneGraph.h>
+#include <AnKi/Scene/ModelNode.h>
+#include <AnKi/Scene/StaticCollisionNode.h>
+#include <AnKi/Scene/LightNode.h>
+#include <AnKi/Scene/ReflectionProbeNode.h>
+#include <AnKi/Scene/GlobalIlluminationProbeNode.h>
+#include <AnKi/Scene/SkyboxNode.h>
+#include <AnKi/Scene/DecalNode.h>
+#include <AnKi/Scene/ParticleEmitterNode.h>
+#include <AnKi/Scene/GpuParticleEmitterNode.h>
+#include <AnKi/Scene/CameraNode.h>
+#include <AnKi/Scene/Components/MoveComponent.h>
+#include <AnKi/Scene/Components/ModelComponent.h>
+#include <AnKi/Scene/Components/SkinComponent.h>
+#include <AnKi/Scene/Components/BodyComponent.h>
+#include <AnKi/Scene/Components/LightComponent.h>
+#include <AnKi/Scene/Components/LensFlareComponent.h>
+#include <AnKi/Scene/Components/ReflectionProbeComponent.h>
+#include <AnKi/Scene/Components/GlobalIlluminationProbeComponent.h>
+#include <AnKi/Scene/Components/SkyboxComponent.h>
+#include <AnKi/Scene/Components/DecalComponent.h>
+#include <AnKi/Scene/Components/ParticleEmitterComponent.h>
+#include <AnKi/Scene/Components/GpuParticleEmitterComponent.h>
+#include <AnKi/Scene/Components/FrustumComponent.h>
+#include <AnKi/Scene/Events/LightEvent.h>
+#include <AnKi/Resource/ResourceManager.h>
+#include <AnKi/Resource/ResourceFilesystem.h>
+#include <AnKi/Core/ConfigSet.h>
+#include <AnKi/Util/Serializer.h>
+#include <AnKi/Util/Tracer.h>
+
+namespace anki {
+
+/// Get a component of a node and fail if it's not there.
+template<typename TComponent>
+static Error getComponent(SceneNode& node, SceneBinaryPropertyType propType, TComponent*& comp)
+{
+	comp = node.tryGetFirstComponentOfType<TComponent>();
+	if(!comp)
+	{
+		ANKI_SCENE_LOGE("Node %s doesn't have the component of property %u", node.getName().cstr(), U32(propType));
+		return Error::kUserData;
+	}
+
+	return Error::kNone;
+}
+
+SceneBinaryLoader::~SceneBinaryLoader()
+{
+	HeapMemoryPool& pool = m_scene->getMemoryPool();
+	m_nodes.destroy(pool);
+
+	if(m_binary)
+	{
+		pool.free(m_binary);
+		m_binary = nullptr;
+	}
+}
+
+Error SceneBinaryLoader::validate() const
+{
+	if(memcmp(&m_binary->m_magic[0], kSceneBinaryMagic, sizeof(m_binary->m_magic)) != 0)
+	{
+		ANKI_SCENE_LOGE("Wrong magic");
+		return Error::kUserData;
+	}
+
+	if(m_binary->m_strings.getSize() > 0 && m_binary->m_strings.getBack() != '\0')
+	{
+		ANKI_SCENE_LOGE("The strings are not null terminated");
+		return Error::kUserData;
+	}
+
+	auto checkString = [&](U32 offset) {
+		return offset == kMaxU32 || offset < m_binary->m_strings.getSize();
+	};
+
+	auto checkTransform = [&](U32 idx) {
+		return idx == kMaxU32 || idx < m_binary->m_transforms.getSize();
+	};
+
+	for(const SceneBinaryProperty& prop : m_binary->m_properties)
+	{
+		if(prop.m_type >= SceneBinaryPropertyType::kCount || !checkString(prop.m_strings[0])
+		   || !checkString(prop.m_strings[1]) || !checkTransform(prop.m_transform))
+		{
+			ANKI_SCENE_LOGE("Incorrect property");
+			return Error::kUserData;
+		}
+	}
+
+	for(U32 i = 0; i < m_binary->m_nodes.getSize(); ++i)
+	{
+		const SceneBinaryNode& node = m_binary->m_nodes[i];
+		if(node.m_type >= SceneBinaryNodeType::kCount || !checkString(node.m_name)
+		   || !checkTransform(node.m_localTransform)
+		   || (node.m_parent != kMaxU32 && node.m_parent >= m_binary->m_nodes.getSize()) || node.m_parent == i
+		   || node.m_firstProperty > m_binary->m_properties.getSize()
+		   || node.m_propertyCount > m_binary->m_properties.getSize() - node.m_firstProperty)
+		{
+			ANKI_SCENE_LOGE("Incorrect node %u", i);
+			return Error::kUserData;
+		}
+	}
+
+	// The parents can't form a cycle. Walk up from every node until a root or a node that is known to lead to one
+	enum class ChainState : U8
+	{
+		kUnknown,
+		kWalking,
+		kRooted
+	};
+
+	const U32 nodeCount = m_binary->m_nodes.getSize();
+	DynamicArrayRaii<ChainState> states(&m_scene->getMemoryPool(), nodeCount, ChainState::kUnknown);
+	for(U32 i = 0; i < nodeCount; ++i)
+	{
+		U32 idx = i;
+		while(idx != kMaxU32 && states[idx] == ChainState::kUnknown)
+		{
+			states[idx] = ChainState::kWalking;
+			idx = m_binary->m_nodes[idx].m_parent;
+		}
+
+		if(idx != kMaxU32 && states[idx] == ChainState::kWalking)
+		{
+			ANKI_SCENE_LOGE("Node %u is in a cycle of parents", idx);
+			return Error::kUserData;
+		}
+
+		for(idx = i; idx != kMaxU32 && states[idx] == ChainState::kWalking; idx = m_binary->m_nodes[idx].m_parent)
+		{
+			states[idx] = ChainState::kRooted;
+		}
+	}
+
+	if(m_binary->m_activeCameraNode != kMaxU32
+	   && (m_binary->m_activeCameraNode >= m_binary->m_nodes.getSize()
+		   || m_binary->m_nodes[m_binary->m_activeCameraNode].m_type != SceneBinaryNodeType::kPerspectiveCamera))
+	{
+		ANKI_SCENE_LOGE("Incorrect active camera");
+		return Error::kUserData;
+	}
+
+	return Error::kNone;
+}
+
+CString SceneBinaryLoader::getString(U32 offset) const
+{
+	return (offset == kMaxU32) ? CString() : CString(&m_binary->m_strings[offset]);
+}
+
+Transform SceneBinaryLoader::getTransform(U32 idx) const
+{
+	const SceneBinaryTransform& trf = m_binary->m_transforms[idx];
+	return Transform(Vec4(trf.m_origin[0], trf.m_origin[1], trf.m_origin[2], 0.0f), Mat3x4(&trf.m_rotation[0]),
+					 trf.m_scale);
+}
+
+Error SceneBinaryLoader::newNode(const SceneBinaryNode& binNode, SceneNode*& node)
+{
+	const CString name = getString(binNode.m_name);
+
+#define ANKI_NEW_NODE(type, Node) \
+	case SceneBinaryNodeType::type: \
+	{ \
+		Node* n; \
+		ANKI_CHECK(m_scene->newSceneNode(name, n)); \
+		node = n; \
+		break; \
+	}
+
+	switch(binNode.m_type)
+	{
+		ANKI_NEW_NODE(kModel, ModelNode)
+		ANKI_NEW_NODE(kStaticCollision, StaticCollisionNode)
+		ANKI_NEW_NODE(kPointLight, PointLightNode)
+		ANKI_NEW_NODE(kSpotLight, SpotLightNode)
+		ANKI_NEW_NODE(kDirectionalLight, DirectionalLightNode)
+		ANKI_NEW_NODE(kReflectionProbe, ReflectionProbeNode)
+		ANKI_NEW_NODE(kGlobalIlluminationProbe, GlobalIlluminationProbeNode)
+		ANKI_NEW_NODE(kSkybox, SkyboxNode)
+		ANKI_NEW_NODE(kDecal, DecalNode)
+		ANKI_NEW_NODE(kParticleEmitter, ParticleEmitterNode)
+		ANKI_NEW_NODE(kGpuParticleEmitter, GpuParticleEmitterNode)
+		ANKI_NEW_NODE(kPerspectiveCamera, PerspectiveCameraNode)
+	default:
+		ANKI_ASSERT(0);
+	}
+
+#undef ANKI_NEW_NODE
+
+	return Error::kNone;
+}
+
+Error SceneBinaryLoader::applyProperty(const SceneBinaryProperty& prop, SceneNode& node)
+{
+	const F32* v = &prop.m_values[0];
+	const CString str0 = getString(prop.m_strings[0]);
+	const CString str1 = getString(prop.m_strings[1]);
+
+	switch(prop.m_type)
+	{
+	case SceneBinaryPropertyType::kModelResource:
+	{
+		ModelComponent* comp;
+		ANKI_CHECK(getComponent(node, prop.m_type, comp));
+		ANKI_CHECK(comp->loadModelResource(str0));
+		break;
+	}
+	case SceneBinaryPropertyType::kSkeletonResource:
+	{
+		SkinComponent* comp;
+		ANKI_CHECK(getComponent(node, prop.m_type, comp));
+		ANKI_CHECK(comp->loadSkeletonResource(str0));
+		break;
+	}
+	case SceneBinaryPropertyType::kBodyMeshResource:
+	{
+		BodyComponent* comp;
+		ANKI_CHECK(getComponent(node, prop.m_type, comp));
+		ANKI_CHECK(comp->loadMeshResource(str0));
+		break;
+	}
+	case SceneBinaryPropertyType::kBodyWorldTransform:
+	{
+		BodyComponent* comp;
+		ANKI_CHECK(getComponent(node, prop.m_type, comp));
+		if(prop.m_transform == kMaxU32)
+		{
+			ANKI_SCENE_LOGE("Missing transform");
+			return Error::kUserData;
+		}
+		comp->setWorldTransform(getTransform(prop.m_transform));
+		break;
+	}
+	case SceneBinaryPropertyType::kParticleEmitterResource:
+	{
+		if(node.tryGetFirstComponentOfType<GpuParticleEmitterComponent>())
+		{
+			ANKI_CHECK(node.getFirstComponentOfType<GpuParticleEmitterComponent>().loadParticleEmitterResource(str0));
+		}
+		else
+		{
+			ParticleEmitterComponent* comp;
+			ANKI_CHECK(getComponent(node, prop.m_type, comp));
+			ANKI_CHECK(comp->loadParticleEmitterResource(str0));
+		}
+		break;
+	}
+	case SceneBinaryPropertyType::kLightDiffuseColor:
+	{
+		LightComponent* comp;
+		ANKI_CHECK(getComponent(node, prop.m_type, comp));
+		comp->setDiffuseColor(Vec4(v[0], v[1], v[2], v[3]));
+		break;
+	}
+	case SceneBinaryPropertyType::kLightRadius:
+	{
+		LightComponent* comp;
+		ANKI_CHECK(getComponent(node, prop.m_type, comp));
+		comp->setRadius(v[0]);
+		break;
+	}
+	case SceneBinaryPropertyType::kLightDistance:
+	{
+		LightComponent* comp;
+		ANKI_CHECK(getComponent(node, prop.m_type, comp));
+		comp->setDistance(v[0]);
+		break;
+	}
+	case SceneBinaryPropertyType::kLightInnerAngle:
+	{
+		LightComponent* comp;
+		ANKI_CHECK(getComponent(node, prop.m_type, comp));
+		comp->setInnerAngle(v[0]);
+		break;
+	}
+	case SceneBinaryPropertyType::kLightOuterAngle:
+	{
+		LightComponent* comp;
+		ANKI_CHECK(getComponent(node, prop.m_type, comp));
+		comp->setOuterAngle(v[0]);
+		break;
+	}
+	case SceneBinaryPropertyType::kLightShadowEnabled:
+	{
+		LightComponent* comp;
+		ANKI_CHECK(getComponent(node, prop.m_type, comp));
+		comp->setShadowEnabled(v[0] != 0.0f);
+		break;
+	}
+	case SceneBinaryPropertyType::kLightEvent:
+	{
+		ANKI_CHECK(m_scene->getEventManager().newEvent(m_lightEvent, v[0], v[1], &node));
+		break;
+	}
+	case SceneBinaryPropertyType::kLightEventFrequency:
+	case SceneBinaryPropertyType::kLightEventIntensityMultiplier:
+	{
+		if(!m_lightEvent)
+		{
+			ANKI_SCENE_LOGE("There is no light event to set");
+			return Error::kUserData;
+		}
+
+		if(prop.m_type == SceneBinaryPropertyType::kLightEventFrequency)
+		{
+			m_lightEvent->setFrequency(v[0], v[1]);
+		}
+		else
+		{
+			m_lightEvent->setIntensityMultiplier(Vec4(v[0], v[1], v[2], v[3]));
+		}
+		break;
+	}
+	case SceneBinaryPropertyType::kReflectionProbeBoxVolumeSize:
+	{
+		ReflectionProbeComponent* comp;
+		ANKI_CHECK(getComponent(node, prop.m_type, comp));
+		comp->setBoxVolumeSize(Vec3(v[0], v[1], v[2]));
+		break;
+	}
+	case SceneBinaryPropertyType::kGlobalIlluminationProbeBoxVolumeSize:
+	{
+		GlobalIlluminationProbeComponent* comp;
+		ANKI_CHECK(getComponent(node, prop.m_type, comp));
+		comp->setBoxVolumeSize(Vec3(v[0], v[1], v[2]));
+		break;
+	}
+	case SceneBinaryPropertyType::kGlobalIlluminationProbeCellSize:
+	{
+		GlobalIlluminationProbeComponent* comp;
+		ANKI_CHECK(getComponent(node, prop.m_type, comp));
+		comp->setCellSize(v[0]);
+		break;
+	}
+	case SceneBinaryPropertyType::kGlobalIlluminationProbeFadeDistance:
+	{
+		GlobalIlluminationProbeComponent* comp;
+		ANKI_CHECK(getComponent(node, prop.m_type, comp));
+		comp->setFadeDistance(v[0]);
+		break;
+	}
+	case SceneBinaryPropertyType::kSkyboxImage:
+	{
+		SkyboxComponent* comp;
+		ANKI_CHECK(getComponent(node, prop.m_type, comp));
+		comp->setImage(str0);
+		break;
+	}
+	case SceneBinaryPropertyType::kSkyboxSolidColor:
+	{
+		SkyboxComponent* comp;
+		ANKI_CHECK(getComponent(node, prop.m_type, comp));
+		comp->setSolidColor(Vec3(v[0], v[1], v[2]));
+		break;
+	}
+	case SceneBinaryPropertyType::kSkyboxMinFogDensity:
+	{
+		SkyboxComponent* comp;
+		ANKI_CHECK(getComponent(node, prop.m_type, comp));
+		comp->setMinFogDensity(v[0]);
+		break;
+	}
+	case SceneBinaryPropertyType::kSkyboxMaxFogDensity:
+	{
+		SkyboxComponent* comp;
+		ANKI_CHECK(getComponent(node, prop.m_type, comp));
+		comp->setMaxFogDensity(v[0]);
+		break;
+	}
+	case SceneBinaryPropertyType::kSkyboxHeightOfMinFogDensity:
+	{
+		SkyboxComponent* comp;
+		ANKI_CHECK(getComponent(node, prop.m_type, comp));
+		comp->setHeightOfMinFogDensity(v[0]);
+		break;
+	}
+	case SceneBinaryPropertyType::kSkyboxHeightOfMaxFogDensity:
+	{
+		SkyboxComponent* comp;
+		ANKI_CHECK(getComponent(node, prop.m_type, comp));
+		comp->setHeightOfMaxFogDensity(v[0]);
+		break;
+	}
+	case SceneBinaryPropertyType::kDecalDiffuse:
+	{
+		DecalComponent* comp;
+		ANKI_CHECK(getComponent(node, prop.m_type, comp));
+		ANKI_CHECK(comp->setDiffuseDecal(str0, str1, v[0]));
+		break;
+	}
+	case SceneBinaryPropertyType::kDecalSpecularRoughness:
+	{
+		DecalComponent* comp;
+		ANKI_CHECK(getComponent(node, prop.m_type, comp));
+		ANKI_CHECK(comp->setSpecularRoughnessDecal(str0, str1, v[0]));
+		break;
+	}
+	case SceneBinaryPropertyType::kDecalBoxVolumeSize:
+	{
+		DecalComponent* comp;
+		ANKI_CHECK(getComponent(node, prop.m_type, comp));
+		comp->setBoxVolumeSize(Vec3(v[0], v[1], v[2]));
+		break;
+	}
+	case SceneBinaryPropertyType::kLensFlareImage:
+	{
+		LensFlareComponent* comp;
+		ANKI_CHECK(getComponent(node, prop.m_type, comp));
+		ANKI_CHECK(comp->loadImageResource(str0));
+		break;
+	}
+	case SceneBinaryPropertyType::kLensFlareFirstFlareSize:
+	{
+		LensFlareComponent* comp;
+		ANKI_CHECK(getComponent(node, prop.m_type, comp));
+		comp->setFirstFlareSize(Vec2(v[0], v[1]));
+		break;
+	}
+	case SceneBinaryPropertyType::kLensFlareColorMultiplier:
+	{
+		LensFlareComponent* comp;
+		ANKI_CHECK(getComponent(node, prop.m_type, comp));
+		comp->setColorMultiplier(Vec4(v[0], v[1], v[2], v[3]));
+		break;
+	}
+	case SceneBinaryPropertyType::kPerspective:
+	{
+		FrustumComponent* comp;
+		ANKI_CHECK(getComponent(node, prop.m_type, comp));
+		const ConfigSet& config = m_scene->getConfig();
+		const F32 aspectRatio = F32(config.getWidth()) / F32(config.getHeight());
+		comp->setPerspective(v[0], v[1], v[2] * aspectRatio, v[3]);
+		break;
+	}
+	default:
+		ANKI_ASSERT(0);
+	}
+
+	return Error::kNone;
+}
+
+Error SceneBinaryLoader::load(CString filename)
+{
+	ResourceFilePtr file;
+	ANKI_CHECK(m_scene->getResourceManager().getFilesystem().openFile(filename, file));
+	if(load(*file))
+	{
+		ANKI_SCENE_LOGE("Failed to load scene binary: %s", filename.cstr());
+		return Error::kUserData;
+	}
+
+	return Error::kNone;
+}
+
+Error SceneBinaryLoader::load(ResourceFile& file)
+{
+	ANKI_TRACE_SCOPED_EVENT(SCENE_BINARY_LOAD);
+	ANKI_ASSERT(m_binary == nullptr && "Can't load twice");
+	HeapMemoryPool& pool = m_scene->getMemoryPool();
+
+	// Read the whole file
+	ANKI_CHECK(BinaryDeserializer::deserialize(m_binary, pool, file));
+	ANKI_CHECK(validate());
+
+	const U32 nodeCount = m_binary->m_nodes.getSize();
+	m_nodes.create(pool, nodeCount, nullptr);
+
+	// Create the nodes. Those of the same type are next to each other so reserve the components of the whole run after
+	// its first node shows how many of them a node of that type has
+	U32 runBegin = 0;
+	while(runBegin < nodeCount)
+	{
+		const SceneBinaryNodeType type = m_binary->m_nodes[runBegin].m_type;
+		U32 runEnd = runBegin + 1;
+		while(runEnd < nodeCount && m_binary->m_nodes[runEnd].m_type == type)
+		{
+			++runEnd;
+		}
+
+		ANKI_CHECK(newNode(m_binary->m_nodes[runBegin], m_nodes[runBegin]));
+
+		if(runEnd - runBegin > 1)
+		{
+			Array<U32, kMaxSceneComponentClasses> countPerClass = {};
+			m_nodes[runBegin]->iterateComponents([&](const SceneComponent& comp, [[maybe_unused]] Bool feedback) {
+				++countPerClass[comp.getClassId()];
+			});
+
+			for(U8 classId = 0; classId < countPerClass.getSize(); ++classId)
+			{
+				if(countPerClass[classId])
+				{
+					m_scene->reserveComponents(classId, countPerClass[classId] * (runEnd - runBegin - 1));
+				}
+			}
+		}
+
+		for(U32 i = runBegin + 1; i < runEnd; ++i)
+		{
+			ANKI_CHECK(newNode(m_binary->m_nodes[i], m_nodes[i]));
+		}
+
+		runBegin = runEnd;
+	}
+
+	// Set the values
+	for(U32 i = 0; i < nodeCount; ++i)
+	{
+		const SceneBinaryNode& binNode = m_binary->m_nodes[i];
+		SceneNode& node = *m_nodes[i];
+
+		for(U32 p = binNode.m_firstProperty; p < binNode.m_firstProperty + binNode.m_propertyCount; ++p)
+		{
+			ANKI_CHECK(applyProperty(m_binary->m_properties[p], node));
+		}
+
+		if(binNode.m_localTransform != kMaxU32)
+		{
+			MoveComponent* move = node.tryGetFirstComponentOfType<MoveComponent>();
+			if(!move)
+			{
+				ANKI_SCENE_LOGE("Node %s can't have a transform", node.getName().cstr());
+				return Error::kUserData;
+			}
+			move->setLocalTransform(getTransform(binNode.m_localTransform));
+		}
+
+		if(binNode.m_parent != kMaxU32)
+		{
+			m_nodes[binNode.m_parent]->addChild(&node);
+		}
+	}
+
+	if(m_binary->m_activeCameraNode != kMaxU32)
+	{
+		m_scene->setActiveCameraNode(m_nodes[m_binary->m_activeCameraNode]);
+	}
+
+	return Error::kNone;
+}
+
+} // end namespace anki
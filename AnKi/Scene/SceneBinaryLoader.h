@@ -0,0 +1,70 @@
+// Copyright (C) 2009-2022, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#pragma once
+
+#include <AnKi/Scene/SceneBinary.h>
+#include <AnKi/Math.h>
+#include <AnKi/Util/DynamicArray.h>
+
+namespace anki {
+
+// Forward
+class LightEvent;
+class ResourceFile;
+
+/// @addtogroup scene
+/// @{
+
+/// Creates the nodes of a SceneBinary. It's the fast alternative of evaluating a level script. The SceneConverter tool
+/// creates the binaries out of the scripts. The whole file is read with a single allocation. The nodes of the same type
+/// are created together after their components are reserved in the SceneComponentStorage.
+class SceneBinaryLoader
+{
+public:
+	SceneBinaryLoader(SceneGraph* scene)
+		: m_scene(scene)
+	{
+		ANKI_ASSERT(scene);
+	}
+
+	SceneBinaryLoader(const SceneBinaryLoader&) = delete; // Non-copyable
+
+	~SceneBinaryLoader();
+
+	SceneBinaryLoader& operator=(const SceneBinaryLoader&) = delete; // Non-copyable
+
+	/// Read a binary and create its nodes.
+	/// @param filename The binary. It's opened through the ResourceFilesystem.
+	Error load(CString filename);
+
+	/// Read a binary that is already open and create its nodes.
+	Error load(ResourceFile& file);
+
+	/// Get the nodes that load() created. They are in the order of SceneBinary::m_nodes.
+	ConstWeakArray<SceneNode*> getNodes() const
+	{
+		return ConstWeakArray<SceneNode*>(m_nodes);
+	}
+
+private:
+	SceneGraph* m_scene = nullptr;
+	SceneBinary* m_binary = nullptr;
+	DynamicArray<SceneNode*> m_nodes;
+	LightEvent* m_lightEvent = nullptr; ///< The last LightEvent that was created.
+
+	Error validate() const;
+
+	CString getString(U32 offset) const;
+
+	Transform getTransform(U32 idx) const;
+
+	Error newNode(const SceneBinaryNode& binNode, SceneNode*& node);
+
+	Error applyProperty(const SceneBinaryProperty& prop, SceneNode& node);
+};
+/// @}
+
+} // end namespace anki
@@ -0,0 +1,148 @@
+// Copyright (C) 2009-2022, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <AnKi/Scene/SceneComponentStorage.h>
+
+namespace anki {
+
+static PtrSize getComponentStride(const SceneComponentRtti& rtti)
+{
+	return getAlignedRoundUp(rtti.m_classAlignment, max<PtrSize>(rtti.m_classSize, sizeof(void*)));
+}
+
+SceneComponentStorage::~SceneComponentStorage()
+{
+	if(m_pool == nullptr)
+	{
+		return;
+	}
+
+	for(PerClass& cls : m_classes)
+	{
+		ANKI_ASSERT(cls.m_components.getSize() == 0 && "Components should have been deleted");
+
+		for(void* chunk : cls.m_chunks)
+		{
+			m_pool->free(chunk);
+		}
+
+		cls.m_components.destroy(*m_pool);
+		cls.m_nodes.destroy(*m_pool);
+		cls.m_chunks.destroy(*m_pool);
+	}
+}
+
+void SceneComponentStorage::init(HeapMemoryPool* pool, Bool chunkAllocation)
+{
+	ANKI_ASSERT(pool);
+	m_pool = pool;
+	m_chunkAllocation = chunkAllocation;
+}
+
+void SceneComponentStorage::allocateChunk(U8 classId)
+{
+	// Allocate a new chunk and put all of its slots to the free list
+	const SceneComponentRtti& rtti = SceneComponent::findClassRtti(classId);
+	PerClass& cls = m_classes[classId];
+	const PtrSize stride = getComponentStride(rtti);
+	const PtrSize alignment = max<PtrSize>(ANKI_CACHE_LINE_SIZE, rtti.m_classAlignment);
+	U8* chunk = static_cast<U8*>(m_pool->allocate(stride * kComponentsPerChunk, alignment));
+	cls.m_chunks.emplaceBack(*m_pool, chunk);
+
+	for(U32 i = kComponentsPerChunk; i > 0; --i)
+	{
+		FreeSlot* slot = reinterpret_cast<FreeSlot*>(chunk + stride * (i - 1));
+		slot->m_next = cls.m_freeSlots;
+		cls.m_freeSlots = slot;
+	}
+}
+
+void SceneComponentStorage::reserve(U8 classId, U32 count)
+{
+	ANKI_ASSERT(m_pool);
+	PerClass& cls = m_classes[classId];
+	const U32 newSize = cls.m_components.getSize() + count;
+	cls.m_components.resizeStorage(*m_pool, newSize);
+	cls.m_nodes.resizeStorage(*m_pool, newSize);
+
+	if(m_chunkAllocation)
+	{
+		U32 freeSlotCount = 0;
+		for(const FreeSlot* slot = cls.m_freeSlots; slot && freeSlotCount < count; slot = slot->m_next)
+		{
+			++freeSlotCount;
+		}
+
+		for(U32 i = freeSlotCount; i < count; i += kComponentsPerChunk)
+		{
+			allocateChunk(classId);
+		}
+	}
+}
+
+void* SceneComponentStorage::allocateComponent(U8 classId)
+{
+	ANKI_ASSERT(m_pool);
+	const SceneComponentRtti& rtti = SceneComponent::findClassRtti(classId);
+
+	if(!m_chunkAllocation)
+	{
+		return m_pool->allocate(rtti.m_classSize, rtti.m_classAlignment);
+	}
+
+	PerClass& cls = m_classes[classId];
+	if(cls.m_freeSlots == nullptr)
+	{
+		allocateChunk(classId);
+	}
+
+	FreeSlot* slot = cls.m_freeSlots;
+	cls.m_freeSlots = slot->m_next;
+	return slot;
+}
+
+void SceneComponentStorage::registerComponent(SceneComponent* comp, SceneNode* node)
+{
+	PerClass& cls = m_classes[comp->getClassId()];
+	ANKI_ASSERT(comp->m_storageIndex == kMaxU32);
+	comp->m_storageIndex = cls.m_components.getSize();
+	cls.m_components.emplaceBack(*m_pool, comp);
+	cls.m_nodes.emplaceBack(*m_pool, node);
+}
+
+void SceneComponentStorage::deleteComponent(SceneComponent* comp)
+{
+	ANKI_ASSERT(comp);
+	const U8 classId = comp->getClassId();
+	PerClass& cls = m_classes[classId];
+
+	// Remove it from the dense arrays by moving the last component in its place
+	const U32 idx = comp->m_storageIndex;
+	ANKI_ASSERT(idx < cls.m_components.getSize() && cls.m_components[idx] == comp);
+	const U32 lastIdx = cls.m_components.getSize() - 1;
+	if(idx != lastIdx)
+	{
+		cls.m_components[idx] = cls.m_components[lastIdx];
+		cls.m_nodes[idx] = cls.m_nodes[lastIdx];
+		cls.m_components[idx]->m_storageIndex = idx;
+	}
+	cls.m_components.popBack(*m_pool);
+	cls.m_nodes.popBack(*m_pool);
+
+	comp->~SceneComponent();
+
+	if(!m_chunkAllocation)
+	{
+		m_pool->free(comp);
+	}
+	else
+	{
+		FreeSlot* slot = reinterpret_cast<FreeSlot*>(comp);
+		slot->m_next = cls.m_freeSlots;
+		cls.m_freeSlots = slot;
+	}
+}
+
+} // end namespace anki
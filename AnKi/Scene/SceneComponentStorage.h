@@ -0,0 +1,121 @@
+// Copyright (C) 2009-2022, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#pragma once
+
+#include <AnKi/Scene/Components/SceneComponent.h>
+#include <AnKi/Util/DynamicArray.h>
+#include <AnKi/Util/WeakArray.h>
+
+namespace anki {
+
+/// @addtogroup scene
+/// @{
+
+/// Keeps the components of the scene segregated by type. Every type has a dense array of components and a parallel
+/// array with their owning nodes so systems can iterate all components of a type without touching the nodes. If chunk
+/// allocation is enabled the components of the same type are also placed in cache aligned chunks of memory.
+/// @note It's not thread-safe.
+class SceneComponentStorage
+{
+public:
+	/// Components per memory chunk when chunk allocation is enabled.
+	static constexpr U32 kComponentsPerChunk = 64;
+
+	SceneComponentStorage() = default;
+
+	SceneComponentStorage(const SceneComponentStorage&) = delete; // Non-copyable
+
+	~SceneComponentStorage();
+
+	SceneComponentStorage& operator=(const SceneComponentStorage&) = delete; // Non-copyable
+
+	/// @param pool The memory pool.
+	/// @param chunkAllocation If true the components of the same type will be allocated in dense chunks.
+	void init(HeapMemoryPool* pool, Bool chunkAllocation);
+
+	/// Create a new component.
+	template<typename TComponent>
+	TComponent* newComponent(SceneNode* node)
+	{
+		void* mem = allocateComponent(TComponent::getStaticClassId());
+		TComponent* comp = ::new(mem) TComponent(node);
+		ANKI_ASSERT(comp->getClassId() == TComponent::getStaticClassId());
+		registerComponent(comp, node);
+		return comp;
+	}
+
+	/// Make room for components of a type that are about to be created in bulk. It avoids growing the arrays and
+	/// allocating chunks one at a time.
+	/// @param classId The type of the components.
+	/// @param count How many will be created.
+	void reserve(U8 classId, U32 count);
+
+	/// Destroy a component that was created by newComponent.
+	void deleteComponent(SceneComponent* comp);
+
+	/// Iterate all the components of a type.
+	/// @param func A functor with signature void(TComponent&, SceneNode&).
+	template<typename TComponent, typename TFunc>
+	void forEachComponent(TFunc func)
+	{
+		const PerClass& cls = m_classes[TComponent::getStaticClassId()];
+		for(U32 i = 0; i < cls.m_components.getSize(); ++i)
+		{
+			func(static_cast<TComponent&>(*cls.m_components[i]), *cls.m_nodes[i]);
+		}
+	}
+
+	U32 getComponentCount(U8 classId) const
+	{
+		return m_classes[classId].m_components.getSize();
+	}
+
+	/// Get the dense array of all components of a type.
+	ConstWeakArray<SceneComponent*> getComponents(U8 classId) const
+	{
+		return ConstWeakArray<SceneComponent*>(m_classes[classId].m_components);
+	}
+
+	/// Get the owning nodes of the components returned by getComponents.
+	ConstWeakArray<SceneNode*> getComponentNodes(U8 classId) const
+	{
+		return ConstWeakArray<SceneNode*>(m_classes[classId].m_nodes);
+	}
+
+	Bool getChunkAllocationEnabled() const
+	{
+		return m_chunkAllocation;
+	}
+
+private:
+	/// A free slot in a chunk. It's stored in the memory of the slot.
+	class FreeSlot
+	{
+	public:
+		FreeSlot* m_next;
+	};
+
+	class PerClass
+	{
+	public:
+		DynamicArray<SceneComponent*> m_components;
+		DynamicArray<SceneNode*> m_nodes; ///< Same size as m_components.
+		DynamicArray<void*> m_chunks;
+		FreeSlot* m_freeSlots = nullptr;
+	};
+
+	HeapMemoryPool* m_pool = nullptr;
+	Array<PerClass, kMaxSceneComponentClasses> m_classes;
+	Bool m_chunkAllocation = false;
+
+	void* allocateComponent(U8 classId);
+
+	void allocateChunk(U8 classId);
+	void registerComponent(SceneComponent* comp, SceneNode* node);
+};
+/// @}
+
+} // end namespace anki
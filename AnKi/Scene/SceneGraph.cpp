@@ -9,6 +9,7 @@
 #include <AnKi/Scene/ModelNode.h>
 #include <AnKi/Scene/Octree.h>
 #include <AnKi/Scene/Components/FrustumComponent.h>
+#include <AnKi/Scene/Components/MoveComponent.h>
 #include <AnKi/Physics/PhysicsWorld.h>
 #include <AnKi/Resource/ResourceManager.h>
 #include <AnKi/Renderer/MainRenderer.h>
@@ -50,18 +51,24 @@ SceneGraph::~SceneGraph()
 	{
 		deleteInstance(m_pool, m_octree);
 	}
+
+	for(UpdatedSpatials& updated : m_updatedSpatials)
+	{
+		updated.m_spatials.destroy(m_pool);
+	}
 }
 
 Error SceneGraph::init(AllocAlignedCallback allocCb, void* allocCbData, ThreadHive* threadHive,
-					   ResourceManager* resources, Input* input, ScriptManager* scriptManager, UiManager* uiManager,
-					   ConfigSet* config, const Timestamp* globalTimestamp,
-					   UnifiedGeometryMemoryPool* unifiedGeometryMemPool)
+					   ResourceManager* resources, PhysicsWorld* physics, Input* input, ScriptManager* scriptManager,
+					   UiManager* uiManager, ConfigSet* config, const Timestamp* globalTimestamp,
+					   UnifiedGeometryMemoryPool* unifiedGeometryMemPool, StagingGpuMemoryPool* stagingGpuMemPool)
 {
+	ANKI_ASSERT(threadHive && physics && config && globalTimestamp);
 	m_globalTimestamp = globalTimestamp;
 	m_threadHive = threadHive;
 	m_resources = resources;
-	m_gr = &m_resources->getGrManager();
-	m_physics = &m_resources->getPhysicsWorld();
+	m_gr = (resources) ? &resources->getGrManager() : nullptr;
+	m_physics = physics;
 	m_input = input;
 	m_scriptManager = scriptManager;
 	m_uiManager = uiManager;
@@ -71,10 +78,24 @@ Error SceneGraph::init(AllocAlignedCallback allocCb, void* allocCbData, ThreadHi
 	m_pool.init(allocCb, allocCbData);
 	m_framePool.init(allocCb, allocCbData, 1 * 1024 * 1024);
 
+	m_componentStorage.init(&m_pool, m_config->getSceneDenseComponentStorage());
+	m_transformHierarchy.init(&m_pool);
+	m_animationSystem.init(&m_pool, stagingGpuMemPool,
+						   (m_gr) ? m_gr->getDeviceCapabilities().m_storageBufferBindOffsetAlignment : 16);
+	if(m_resources)
+	{
+		m_sectorStreamer.init(this, &m_resources->getAsyncLoader(), &m_resources->getFilesystem());
+	}
+
 	ANKI_CHECK(m_events.init(this));
 
 	m_octree = newInstance<Octree>(m_pool, &m_pool);
-	m_octree->init(m_sceneMin, m_sceneMax, m_config->getSceneOctreeMaxDepth());
+	OctreeFlag octreeFlags = OctreeFlag::kNone;
+	octreeFlags |= (m_config->getSceneOctreeDeferredPlacement()) ? OctreeFlag::kDeferredPlacement : OctreeFlag::kNone;
+	octreeFlags |= (m_config->getSceneLooseOctree()) ? OctreeFlag::kLoose : OctreeFlag::kNone;
+	m_octree->init(m_sceneMin, m_sceneMax, m_config->getSceneOctreeMaxDepth(), octreeFlags);
+
+	m_incrementalVisibility = m_config->getSceneIncrementalVisibility();
 
 	// Init the default main camera
 	ANKI_CHECK(newSceneNode<PerspectiveCameraNode>("mainCamera", m_defaultMainCam));
@@ -82,12 +103,15 @@ Error SceneGraph::init(AllocAlignedCallback allocCb, void* allocCbData, ThreadHi
 																				 (1080.0f / 1920.0f) * toRad(60.0f));
 	m_mainCam = m_defaultMainCam;
 
-	// Create a special node for debugging the physics world
-	PhysicsDebugNode* pnode;
-	ANKI_CHECK(newSceneNode<PhysicsDebugNode>("_physicsDebugNode", pnode));
+	// The debug drawing needs resources
+	if(m_resources)
+	{
+		// Create a special node for debugging the physics world
+		PhysicsDebugNode* pnode;
+		ANKI_CHECK(newSceneNode<PhysicsDebugNode>("_physicsDebugNode", pnode));
 
-	// Other
-	ANKI_CHECK(m_debugDrawer.init(&getResourceManager()));
+		ANKI_CHECK(m_debugDrawer.init(m_resources));
+	}
 
 	return Error::kNone;
 }
@@ -112,6 +136,9 @@ Error SceneGraph::registerNode(SceneNode* node)
 	m_nodes.pushBack(node);
 	++m_nodesCount;
 
+	m_transformHierarchy.invalidate();
+	m_sectorStreamer.registerNode(*node);
+
 	return Error::kNone;
 }
 
@@ -121,6 +148,9 @@ void SceneGraph::unregisterNode(SceneNode* node)
 	m_nodes.erase(node);
 	--m_nodesCount;
 
+	m_transformHierarchy.invalidate();
+	m_sectorStreamer.unregisterNode(*node);
+
 	if(m_mainCam != m_defaultMainCam && m_mainCam == node)
 	{
 		m_mainCam = m_defaultMainCam;
@@ -164,6 +194,7 @@ void SceneGraph::deleteNodesMarkedForDeletion()
 			if(node.getMarkedForDeletion())
 			{
 				// Delete node
+				m_events.deleteSceneNodeEvents(node);
 				unregisterNode(&node);
 				deleteInstance(m_pool, &node);
 				m_objectsMarkedForDeletionCount.fetchSub(1);
@@ -183,17 +214,27 @@ Error SceneGraph::update(Second prevUpdateTime, Second crntTime)
 
 	m_stats.m_updateTime = HighRezTimer::getCurrentTime();
 
+	m_prevTimestamp = m_timestamp;
 	m_timestamp = *m_globalTimestamp;
 	ANKI_ASSERT(m_timestamp > 0);
 
 	// Reset the framepool
 	m_framePool.reset();
 
+	// Forget the spatials that moved in the previous frame
+	for(UpdatedSpatials& updated : m_updatedSpatials)
+	{
+		updated.m_count = 0;
+	}
+
+	// Stream the world. The unloaded sectors get deleted right after and the new ones get updated in this frame
+	m_sectorStreamer.update(
+		m_mainCam->getFirstComponentOfType<MoveComponent>().getWorldTransform().getOrigin().xyz());
+
 	// Delete stuff
 	{
 		ANKI_TRACE_SCOPED_EVENT(SCENE_MARKED_FOR_DELETION);
-		const Bool fullCleanup = m_objectsMarkedForDeletionCount.load() != 0;
-		m_events.deleteEventsMarkedForDeletion(fullCleanup);
+		m_events.deleteEventsMarkedForDeletion();
 		deleteNodesMarkedForDeletion();
 	}
 
@@ -209,6 +250,13 @@ Error SceneGraph::update(Second prevUpdateTime, Second crntTime)
 		ANKI_TRACE_SCOPED_EVENT(SCENE_NODES_UPDATE);
 		ANKI_CHECK(m_events.updateAllEvents(prevUpdateTime, crntTime));
 
+		// Update the world transforms of all hierarchies in parallel. The MoveComponents will only handle whatever
+		// moves during the node updates
+		m_transformHierarchy.update(m_componentStorage, m_timestamp, *m_threadHive);
+
+		// Animate the skins of all nodes in parallel. The SkinComponents will only report what changed
+		m_animationSystem.update(m_componentStorage, crntTime - prevUpdateTime, *m_threadHive);
+
 		// Then the rest
 		Array<ThreadHiveTask, ThreadHive::kMaxThreads> tasks;
 		UpdateSceneNodesCtx updateCtx;
@@ -221,7 +269,7 @@ Error SceneGraph::update(Second prevUpdateTime, Second crntTime)
 		{
 			tasks[i] = ANKI_THREAD_HIVE_TASK(
 				{
-					if(self->m_scene->updateNodes(*self))
+					if(self->m_scene->updateNodes(*self, threadId))
 					{
 						ANKI_SCENE_LOGF("Will not recover");
 					}
@@ -231,6 +279,11 @@ Error SceneGraph::update(Second prevUpdateTime, Second crntTime)
 
 		m_threadHive->submitTasks(&tasks[0], m_threadHive->getThreadCount());
 		m_threadHive->waitAllTasks();
+
+		if(m_octree->getDeferredPlacementEnabled())
+		{
+			m_octree->commitDeferredPlacements(*m_threadHive);
+		}
 	}
 
 	m_stats.m_updateTime = HighRezTimer::getCurrentTime() - m_stats.m_updateTime;
@@ -244,7 +297,7 @@ void SceneGraph::doVisibilityTests(RenderQueue& rqueue)
 	m_stats.m_visibilityTestsTime = HighRezTimer::getCurrentTime() - m_stats.m_visibilityTestsTime;
 }
 
-Error SceneGraph::updateNode(Second prevTime, Second crntTime, SceneNode& node)
+Error SceneGraph::updateNode(Second prevTime, Second crntTime, U32 threadId, SceneNode& node)
 {
 	ANKI_TRACE_INC_COUNTER(SCENE_NODES_UPDATED, 1);
 
@@ -252,6 +305,7 @@ Error SceneGraph::updateNode(Second prevTime, Second crntTime, SceneNode& node)
 
 	// Components update
 	SceneComponentUpdateInfo componentUpdateInfo(prevTime, crntTime);
+	componentUpdateInfo.m_threadId = threadId;
 
 	Timestamp componentTimestamp = 0;
 	Bool atLeastOneComponentUpdated = false;
@@ -286,7 +340,7 @@ Error SceneGraph::updateNode(Second prevTime, Second crntTime, SceneNode& node)
 	if(!err)
 	{
 		err = node.visitChildrenMaxDepth(0, [&](SceneNode& child) -> Error {
-			return updateNode(prevTime, crntTime, child);
+			return updateNode(prevTime, crntTime, threadId, child);
 		});
 	}
 
@@ -308,7 +362,7 @@ Error SceneGraph::updateNode(Second prevTime, Second crntTime, SceneNode& node)
 	return err;
 }
 
-Error SceneGraph::updateNodes(UpdateSceneNodesCtx& ctx) const
+Error SceneGraph::updateNodes(UpdateSceneNodesCtx& ctx, U32 threadId) const
 {
 	ANKI_TRACE_SCOPED_EVENT(SCENE_NODES_UPDATE);
 
@@ -351,7 +405,7 @@ Error SceneGraph::updateNodes(UpdateSceneNodesCtx& ctx) const
 		// Process nodes
 		for(U i = 0; i < batchSize && !err; ++i)
 		{
-			err = updateNode(ctx.m_prevUpdateTime, ctx.m_crntTime, *batch[i]);
+			err = updateNode(ctx.m_prevUpdateTime, ctx.m_crntTime, threadId, *batch[i]);
 		}
 	}
 
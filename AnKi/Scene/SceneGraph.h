@@ -7,9 +7,15 @@
 
 #include <AnKi/Scene/Common.h>
 #include <AnKi/Scene/SceneNode.h>
+#include <AnKi/Scene/SceneComponentStorage.h>
+#include <AnKi/Scene/TransformHierarchy.h>
+#include <AnKi/Scene/AnimationSystem.h>
+#include <AnKi/Scene/SectorStreamer.h>
+#include <AnKi/Scene/LodPolicy.h>
 #include <AnKi/Scene/DebugDrawer.h>
 #include <AnKi/Math.h>
 #include <AnKi/Util/HashMap.h>
+#include <AnKi/Util/ThreadHive.h>
 #include <AnKi/Core/App.h>
 #include <AnKi/Scene/Events/EventManager.h>
 #include <AnKi/Resource/Common.h>
@@ -25,6 +31,7 @@ class PerspectiveCameraNode;
 class Octree;
 class UiManager;
 class UnifiedGeometryMemoryPool;
+class StagingGpuMemoryPool;
 
 /// @addtogroup scene
 /// @{
@@ -49,9 +56,12 @@ public:
 
 	~SceneGraph();
 
+	/// @param resources It can be nullptr. Then the graph has no GrManager either and it can only have the nodes that
+	///                  don't load resources. The SectorStreamer needs to be initialized by the caller.
 	Error init(AllocAlignedCallback allocCb, void* allocCbData, ThreadHive* threadHive, ResourceManager* resources,
-			   Input* input, ScriptManager* scriptManager, UiManager* uiManager, ConfigSet* config,
-			   const Timestamp* globalTimestamp, UnifiedGeometryMemoryPool* unifiedGeometryMemPool);
+			   PhysicsWorld* physics, Input* input, ScriptManager* scriptManager, UiManager* uiManager,
+			   ConfigSet* config, const Timestamp* globalTimestamp, UnifiedGeometryMemoryPool* unifiedGeometryMemPool,
+			   StagingGpuMemoryPool* stagingGpuMemPool);
 
 	Timestamp getGlobalTimestamp() const
 	{
@@ -133,6 +143,31 @@ public:
 	template<typename Func>
 	Error iterateSceneNodes(PtrSize begin, PtrSize end, Func func);
 
+	/// Iterate all the components of a specific type in the order they are stored.
+	/// @param func A functor with signature void(TComponent&, SceneNode&).
+	template<typename TComponent, typename TFunc>
+	void forEachComponent(TFunc func)
+	{
+		m_componentStorage.forEachComponent<TComponent>(func);
+	}
+
+	/// Same as forEachComponent but split the components in batches and process them in the ThreadHive. Don't call it
+	/// from a ThreadHive task since it waits for all tasks.
+	/// @param func A thread-safe functor with signature void(TComponent&, SceneNode&).
+	template<typename TComponent, typename TFunc>
+	void forEachComponentParallel(TFunc func);
+
+	const SceneComponentStorage& getComponentStorage() const
+	{
+		return m_componentStorage;
+	}
+
+	/// Make space for a number of components of a type before creating many nodes at once.
+	ANKI_INTERNAL void reserveComponents(U8 classId, U32 count)
+	{
+		m_componentStorage.reserve(classId, count);
+	}
+
 	/// Create a new SceneNode
 	template<typename Node, typename... Args>
 	Error newSceneNode(const CString& name, Node*& node, Args&&... args);
@@ -143,6 +178,67 @@ public:
 		node->setMarkedForDeletion();
 	}
 
+	/// The node hierarchy changed.
+	void invalidateTransformHierarchy()
+	{
+		m_transformHierarchy.invalidate();
+	}
+
+	/// If true the visibility tests of frustums that didn't move re-use the visible objects of the previous frame and
+	/// only test the objects that moved.
+	Bool getIncrementalVisibilityEnabled() const
+	{
+		return m_incrementalVisibility;
+	}
+
+	/// The LOD selection that is used if SceneScreenSpaceErrorLod is enabled.
+	const LodPolicy& getLodPolicy() const
+	{
+		return m_lodPolicy;
+	}
+
+	/// The timestamp of the previous update.
+	Timestamp getPreviousGlobalTimestamp() const
+	{
+		return m_prevTimestamp;
+	}
+
+	/// Remember a SpatialComponent that was updated in this frame. Used by the incremental visibility.
+	/// @note It's thread-safe against calls with different threadId.
+	ANKI_INTERNAL void addUpdatedSpatial(SpatialComponent* spatial, U32 threadId)
+	{
+		ANKI_ASSERT(spatial && threadId < m_updatedSpatials.getSize());
+		if(m_incrementalVisibility)
+		{
+			UpdatedSpatials& updated = m_updatedSpatials[threadId];
+			if(updated.m_count == updated.m_spatials.getSize())
+			{
+				updated.m_spatials.resize(m_pool, max(64u, updated.m_count * 2));
+			}
+
+			updated.m_spatials[updated.m_count++] = spatial;
+		}
+	}
+
+	/// Get the SpatialComponents that a thread updated in this frame.
+	ANKI_INTERNAL ConstWeakArray<SpatialComponent*> getUpdatedSpatials(U32 threadId) const
+	{
+		const UpdatedSpatials& updated = m_updatedSpatials[threadId];
+		return ConstWeakArray<SpatialComponent*>((updated.m_count) ? &updated.m_spatials[0] : nullptr,
+												 updated.m_count);
+	}
+
+	/// A SpatialComponent got deleted. It invalidates the visible objects that the incremental visibility keeps.
+	ANKI_INTERNAL void increaseSpatialRemovalCount()
+	{
+		m_spatialRemovalCount.fetchAdd(1);
+	}
+
+	ANKI_INTERNAL U32 getSpatialRemovalCount() const
+	{
+		return m_spatialRemovalCount.load();
+	}
+
 	void increaseObjectsMarkedForDeletion()
 	{
 		m_objectsMarkedForDeletionCount.fetchAdd(1);
@@ -165,11 +261,19 @@ public:
 
 	ResourceManager& getResourceManager()
 	{
+		ANKI_ASSERT(m_resources);
 		return *m_resources;
 	}
 
+	/// The graph has no ResourceManager when it's used without a GPU, like in tests and benchmarks.
+	Bool hasResourceManager() const
+	{
+		return m_resources != nullptr;
+	}
+
 	GrManager& getGrManager()
 	{
+		ANKI_ASSERT(m_gr);
 		return *m_gr;
 	}
 
@@ -211,6 +315,12 @@ public:
 		return *m_octree;
 	}
 
+	/// Streams the sectors of the world around the active camera.
+	SectorStreamer& getSectorStreamer()
+	{
+		return m_sectorStreamer;
+	}
+
 	const DebugDrawer2& getDebugDrawer() const
 	{
 		return m_debugDrawer;
@@ -222,11 +332,22 @@ public:
 		return *m_config;
 	}
 
+#if !ANKI_TESTS
 private:
+#endif
 	class UpdateSceneNodesCtx;
 
+	/// The SpatialComponents that a thread updated in this frame.
+	class alignas(ANKI_CACHE_LINE_SIZE) UpdatedSpatials
+	{
+	public:
+		DynamicArray<SpatialComponent*> m_spatials; ///< It never shrinks. Only the first m_count are valid.
+		U32 m_count = 0;
+	};
+
 	const Timestamp* m_globalTimestamp = nullptr;
 	Timestamp m_timestamp = 0; ///< Cached timestamp
+	Timestamp m_prevTimestamp = 0; ///< The timestamp of the previous update.
 
 	// Sub-systems
 	ThreadHive* m_threadHive = nullptr;
@@ -242,6 +363,12 @@ private:
 	mutable HeapMemoryPool m_pool;
 	mutable StackMemoryPool m_framePool;
 
+	SceneComponentStorage m_componentStorage;
+	TransformHierarchy m_transformHierarchy;
+	AnimationSystem m_animationSystem;
+	SectorStreamer m_sectorStreamer;
+	LodPolicy m_lodPolicy;
+
 	IntrusiveList<SceneNode> m_nodes;
 	U32 m_nodesCount = 0;
 	HashMap<CString, SceneNode*> m_nodesDict;
@@ -259,6 +386,10 @@ private:
 
 	Atomic<U32> m_objectsMarkedForDeletionCount = {0};
 
+	Bool m_incrementalVisibility = false;
+	Array<UpdatedSpatials, ThreadHive::kMaxThreads> m_updatedSpatials;
+	Atomic<U32> m_spatialRemovalCount = {0};
+
 	Atomic<U64> m_nodesUuid = {1};
 
 	SceneGraphStats m_stats;
@@ -272,8 +403,8 @@ private:
 	/// Delete the nodes that are marked for deletion
 	void deleteNodesMarkedForDeletion();
 
-	Error updateNodes(UpdateSceneNodesCtx& ctx) const;
-	[[nodiscard]] static Error updateNode(Second prevTime, Second crntTime, SceneNode& node);
+	Error updateNodes(UpdateSceneNodesCtx& ctx, U32 threadId) const;
+	[[nodiscard]] static Error updateNode(Second prevTime, Second crntTime, U32 threadId, SceneNode& node);
 
 	/// Do visibility tests.
 	static void doVisibilityTests(SceneNode& frustumable, SceneGraph& scene, RenderQueue& rqueue);
@@ -313,6 +444,57 @@ inline Error SceneGraph::newSceneNode(const CString& name, Node*& node, Args&&..
 	return err;
 }
 
+template<typename TComponent, typename TFunc>
+void SceneGraph::forEachComponentParallel(TFunc func)
+{
+	constexpr U32 kBatchSize = 64;
+
+	class Ctx
+	{
+	public:
+		ConstWeakArray<SceneComponent*> m_components;
+		ConstWeakArray<SceneNode*> m_nodes;
+		TFunc* m_func;
+		Atomic<U32> m_nextBatch = {0};
+	};
+
+	Ctx ctx;
+	ctx.m_components = m_componentStorage.getComponents(TComponent::getStaticClassId());
+	ctx.m_nodes = m_componentStorage.getComponentNodes(TComponent::getStaticClassId());
+	ctx.m_func = &func;
+
+	const U32 batchCount = (ctx.m_components.getSize() + kBatchSize - 1) / kBatchSize;
+	const U32 taskCount = min(batchCount, m_threadHive->getThreadCount());
+	if(taskCount <= 1)
+	{
+		m_componentStorage.forEachComponent<TComponent>(func);
+		return;
+	}
+
+	Array<ThreadHiveTask, ThreadHive::kMaxThreads> tasks;
+	for(U32 i = 0; i < taskCount; ++i)
+	{
+		tasks[i].m_argument = &ctx;
+		tasks[i].m_callback = [](void* ud, [[maybe_unused]] U32 threadId, [[maybe_unused]] ThreadHive& hive,
+								 [[maybe_unused]] ThreadHiveSemaphore* sem) {
+			Ctx& self = *static_cast<Ctx*>(ud);
+			const U32 count = self.m_components.getSize();
+			U32 begin;
+			while((begin = self.m_nextBatch.fetchAdd(1) * kBatchSize) < count)
+			{
+				const U32 end = min(begin + kBatchSize, count);
+				for(U32 idx = begin; idx < end; ++idx)
+				{
+					(*self.m_func)(static_cast<TComponent&>(*self.m_components[idx]), *self.m_nodes[idx]);
+				}
+			}
+		};
+	}
+
+	m_threadHive->submitTasks(&tasks[0], taskCount);
+	m_threadHive->waitAllTasks();
+}
+
 template<typename Func>
 Error SceneGraph::iterateSceneNodes(PtrSize begin, PtrSize end, Func func)
 {
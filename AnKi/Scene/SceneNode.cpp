@@ -21,18 +21,44 @@ SceneNode::SceneNode(SceneGraph* scene, CString name)
 SceneNode::~SceneNode()
 {
 	HeapMemoryPool& pool = getMemoryPool();
+	SceneComponentStorage& storage = getComponentStorage();
 
 	auto it = m_components.getBegin();
 	auto end = m_components.getEnd();
 	for(; it != end; ++it)
 	{
-		deleteInstance(pool, *it);
+		storage.deleteComponent(*it);
 	}
 
 	Base::destroy(pool);
 	m_name.destroy(pool);
 	m_components.destroy(pool);
 	m_componentInfos.destroy(pool);
+	m_firstComponentOfType.destroy(pool);
+}
+
+void SceneNode::appendComponent(SceneComponent* comp)
+{
+	HeapMemoryPool& pool = getMemoryPool();
+	ANKI_ASSERT(m_components.getSize() < kMaxU8 && "The first component indices are U8");
+
+	const U64 bit = U64(1) << U64(comp->getClassId());
+	if(!(m_componentClassMask & bit))
+	{
+		// First component of that class, insert its index in the right place
+		const U32 slot = __builtin_popcountll(m_componentClassMask & (bit - 1));
+		m_firstComponentOfType.emplaceBack(pool, U8(0));
+		for(U32 i = m_firstComponentOfType.getSize() - 1; i > slot; --i)
+		{
+			m_firstComponentOfType[i] = m_firstComponentOfType[i - 1];
+		}
+
+		m_firstComponentOfType[slot] = U8(m_components.getSize());
+		m_componentClassMask |= bit;
+	}
+
+	m_components.emplaceBack(pool, comp);
+	m_componentInfos.emplaceBack(pool, *comp);
 }
 
 void SceneNode::setMarkedForDeletion()
@@ -55,6 +81,23 @@ Timestamp SceneNode::getGlobalTimestamp() const
 	return m_scene->getGlobalTimestamp();
 }
 
+void SceneNode::addChild(SceneNode* obj)
+{
+	Base::addChild(getMemoryPool(), obj);
+	m_scene->invalidateTransformHierarchy();
+}
+
+void SceneNode::removeChild(SceneNode* obj)
+{
+	Base::removeChild(getMemoryPool(), obj);
+	m_scene->invalidateTransformHierarchy();
+}
+
+SceneComponentStorage& SceneNode::getComponentStorage()
+{
+	return m_scene->m_componentStorage;
+}
+
 HeapMemoryPool& SceneNode::getMemoryPool() const
 {
 	ANKI_ASSERT(m_scene);
@@ -6,6 +6,7 @@
 #pragma once
 
 #include <AnKi/Scene/Components/SceneComponent.h>
+#include <AnKi/Scene/SceneComponentStorage.h>
 #include <AnKi/Util/Hierarchy.h>
 #include <AnKi/Util/BitMask.h>
 #include <AnKi/Util/BitSet.h>
@@ -91,10 +92,11 @@ public:
 
 	StackMemoryPool& getFrameMemoryPool() const;
 
-	void addChild(SceneNode* obj)
-	{
-		Base::addChild(getMemoryPool(), obj);
-	}
+	void addChild(SceneNode* obj);
+
+	void removeChild(SceneNode* obj);
+
+	using Base::removeChild; // The Hierarchy needs the other overload when the node is destroyed
 
 	/// This is called by the scenegraph every frame after all component updates. By default it does nothing.
 	/// @param prevUpdateTime Timestamp of the previous update
@@ -130,9 +132,10 @@ public:
 	template<typename TComponent, typename TFunct>
 	void iterateComponentsOfType(TFunct func) const
 	{
-		for(U32 i = 0; i < m_componentInfos.getSize(); ++i)
+		const U8 classId = TComponent::getStaticClassId();
+		for(U32 i = getFirstComponentIndexOfType(classId); i < m_componentInfos.getSize(); ++i)
 		{
-			if(m_componentInfos[i].getComponentClassId() == TComponent::getStaticClassId())
+			if(m_componentInfos[i].getComponentClassId() == classId)
 			{
 				func(static_cast<const TComponent&>(*m_components[i]));
 			}
@@ -143,27 +146,29 @@ public:
 	template<typename TComponent, typename TFunct>
 	void iterateComponentsOfType(TFunct func)
 	{
-		for(U32 i = 0; i < m_componentInfos.getSize(); ++i)
+		const U8 classId = TComponent::getStaticClassId();
+		for(U32 i = getFirstComponentIndexOfType(classId); i < m_componentInfos.getSize(); ++i)
 		{
-			if(m_componentInfos[i].getComponentClassId() == TComponent::getStaticClassId())
+			if(m_componentInfos[i].getComponentClassId() == classId)
 			{
 				func(static_cast<TComponent&>(*m_components[i]));
 			}
 		}
 	}
 
-	/// Try geting a pointer to the first component of the requested type
+	/// Check if the node has at least one component of a specific type.
+	template<typename TComponent>
+	Bool hasComponentOfType() const
+	{
+		return (m_componentClassMask & (U64(1) << U64(TComponent::getStaticClassId()))) != 0;
+	}
+
+	/// Try geting a pointer to the first component of the requested type. It's O(1).
 	template<typename TComponent>
 	const TComponent* tryGetFirstComponentOfType() const
 	{
-		for(U32 i = 0; i < m_componentInfos.getSize(); ++i)
-		{
-			if(m_componentInfos[i].getComponentClassId() == TComponent::getStaticClassId())
-			{
-				return static_cast<const TComponent*>(m_components[i]);
-			}
-		}
-		return nullptr;
+		const U32 idx = getFirstComponentIndexOfType(TComponent::getStaticClassId());
+		return (idx < m_components.getSize()) ? static_cast<const TComponent*>(m_components[idx]) : nullptr;
 	}
 
 	/// Try geting a pointer to the first component of the requested type
@@ -195,10 +200,11 @@ public:
 	template<typename TComponent>
 	const TComponent* tryGetNthComponentOfType(U32 nth) const
 	{
+		const U8 classId = TComponent::getStaticClassId();
 		I32 inth = I32(nth);
-		for(U32 i = 0; i < m_componentInfos.getSize(); ++i)
+		for(U32 i = getFirstComponentIndexOfType(classId); i < m_componentInfos.getSize(); ++i)
 		{
-			if(m_componentInfos[i].getComponentClassId() == TComponent::getStaticClassId() && inth-- == 0)
+			if(m_componentInfos[i].getComponentClassId() == classId && inth-- == 0)
 			{
 				return static_cast<const TComponent*>(m_components[i]);
 			}
@@ -268,9 +274,8 @@ protected:
 	template<typename TComponent>
 	TComponent* newComponent()
 	{
-		TComponent* comp = newInstance<TComponent>(getMemoryPool(), this);
-		m_components.emplaceBack(getMemoryPool(), comp);
-		m_componentInfos.emplaceBack(getMemoryPool(), *comp);
+		TComponent* comp = getComponentStorage().newComponent<TComponent>(this);
+		appendComponent(comp);
 		return comp;
 	}
 
@@ -317,6 +322,7 @@ private:
 	};
 
 	static_assert(sizeof(ComponentsArrayElement) == sizeof(U8), "Wrong size");
+	static_assert(kMaxSceneComponentClasses <= 64, "Component classes should fit in m_componentClassMask");
 
 	SceneGraph* m_scene = nullptr;
 	U64 m_uuid;
@@ -325,9 +331,32 @@ private:
 	DynamicArray<SceneComponent*> m_components;
 	DynamicArray<ComponentsArrayElement> m_componentInfos; ///< Same size as m_components. Used to iterate fast.
 
+	/// A bit for every component class this node has.
+	U64 m_componentClassMask = 0;
+	/// The index in m_components of the first component of each class in m_componentClassMask. It's indexed by the
+	/// number of bits in m_componentClassMask that are lower than the class ID.
+	DynamicArray<U8> m_firstComponentOfType;
+
 	Timestamp m_maxComponentTimestamp = 0;
 
 	Bool m_markedForDeletion = false;
+
+	SceneComponentStorage& getComponentStorage();
+
+	void appendComponent(SceneComponent* comp);
+
+	/// Return the index of the first component of a class or the component count if there is none.
+	U32 getFirstComponentIndexOfType(U8 classId) const
+	{
+		const U64 bit = U64(1) << U64(classId);
+		if(!(m_componentClassMask & bit))
+		{
+			return m_components.getSize();
+		}
+
+		const U32 slot = __builtin_popcountll(m_componentClassMask & (bit - 1));
+		return m_firstComponentOfType[slot];
+	}
 };
 /// @}
 
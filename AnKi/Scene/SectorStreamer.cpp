@@ -0,0 +1,525 @@
+// Copyright (C) 2009-2022, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <AnKi/Scene/SectorStreamer.h>
+#include <AnKi/Scene/SceneGraph.h>
+#include <AnKi/Script/ScriptManager.h>
+#include <AnKi/Resource/ResourceManager.h>
+#include <AnKi/Resource/ResourceFilesystem.h>
+#include <AnKi/Resource/AsyncLoader.h>
+#include <AnKi/Resource/ModelResource.h>
+#include <AnKi/Resource/ParticleEmitterResource.h>
+#include <AnKi/Resource/ImageResource.h>
+#include <AnKi/Resource/SkeletonResource.h>
+#include <AnKi/Resource/AnimationResource.h>
+#include <AnKi/Util/Tracer.h>
+#include <AnKi/Util/HighRezTimer.h>
+#include <algorithm>
+
+namespace anki {
+
+/// Holds a reference to a resource that a sector will need.
+class StagedResource
+{
+public:
+	virtual ~StagedResource() = default;
+};
+
+template<typename T>
+class TypedStagedResource : public StagedResource
+{
+public:
+	ResourcePtr<T> m_resource;
+};
+
+template<typename T>
+static Error stageResource(ResourceManager& resources, CString filename, HeapMemoryPool& pool, StagedResource*& out)
+{
+	TypedStagedResource<T>* staged = newInstance<TypedStagedResource<T>>(pool);
+	const Error err = resources.loadResource(filename, staged->m_resource);
+	if(err)
+	{
+		deleteInstance(pool, staged);
+		return err;
+	}
+
+	out = staged;
+	return Error::kNone;
+}
+
+using StageResourceCallback = Error (*)(ResourceManager& resources, CString filename, HeapMemoryPool& pool,
+										StagedResource*& out);
+
+class StagedResourceType
+{
+public:
+	CString m_extension;
+	StageResourceCallback m_callback;
+};
+
+static const Array<StagedResourceType, 5> kStagedResourceTypes = {
+	{{".ankimdl", stageResource<ModelResource>},
+	 {".ankipart", stageResource<ParticleEmitterResource>},
+	 {".ankitex", stageResource<ImageResource>},
+	 {".ankiskel", stageResource<SkeletonResource>},
+	 {".ankianim", stageResource<AnimationResource>}}};
+
+static const StagedResourceType* findStagedResourceType(CString filename)
+{
+	for(const StagedResourceType& type : kStagedResourceTypes)
+	{
+		const U32 len = filename.getLength();
+		const U32 extLen = type.m_extension.getLength();
+		if(len > extLen && filename.find(type.m_extension, len - extLen) == len - extLen)
+		{
+			return &type;
+		}
+	}
+
+	return nullptr;
+}
+
+static constexpr PtrSize kMaxResourceFilenameLength = 1024;
+
+/// Find the resources that a script references. They are the string literals with a known extension.
+static void gatherResourceFilenames(CString script, HeapMemoryPool& pool, DynamicArray<String>& filenames)
+{
+	const Char* it = script.getBegin();
+	const Char* end = script.getEnd();
+	while(it != end)
+	{
+		const Char quote = *it++;
+		if(quote != '"' && quote != '\'')
+		{
+			continue;
+		}
+
+		const Char* literalBegin = it;
+		while(it != end && *it != quote && *it != '\n')
+		{
+			it += (*it == '\\' && it + 1 != end) ? 2 : 1;
+		}
+
+		if(it == end || *it != quote)
+		{
+			continue;
+		}
+
+		const PtrSize length = PtrSize(it - literalBegin);
+		++it;
+
+		// The long literals can't be filenames
+		if(length == 0 || length > kMaxResourceFilenameLength)
+		{
+			continue;
+		}
+
+		StringRaii literal(&pool);
+		literal.create(literalBegin, literalBegin + length);
+
+		if(findStagedResourceType(literal) == nullptr)
+		{
+			continue;
+		}
+
+		const Bool alreadyFound = std::find_if(filenames.getBegin(), filenames.getEnd(), [&](const String& other) {
+									  return other == literal;
+								  }) != filenames.getEnd();
+		if(!alreadyFound)
+		{
+			filenames.emplaceBack(pool, std::move(literal));
+		}
+	}
+}
+
+class SectorStreamer::Sector
+{
+public:
+	String m_scriptFilename;
+	Aabb m_bounds;
+	PtrSize m_memorySize = 0;
+	F32 m_distance = 0.0f;
+
+	Atomic<U32> m_state = {U32(SectorState::kUnloaded)};
+	Atomic<U32> m_cancelLoading = {0};
+
+	/// @name The staged data. The LoadSectorTask owns it while loading and the main thread after that.
+	/// @{
+	String m_script;
+	DynamicArray<StagedResource*> m_stagedResources;
+	/// @}
+
+	DynamicArray<SceneNode*> m_nodes; ///< The nodes that the script created.
+
+	SectorState getState() const
+	{
+		return SectorState(m_state.load());
+	}
+
+	void releaseStagedData(HeapMemoryPool& pool)
+	{
+		m_script.destroy(pool);
+
+		for(StagedResource* rsrc : m_stagedResources)
+		{
+			deleteInstance(pool, rsrc);
+		}
+		m_stagedResources.destroy(pool);
+	}
+};
+
+/// Loads a sector in small steps so the AsyncLoader can pause between them.
+class SectorStreamer::LoadSectorTask : public AsyncLoaderTask
+{
+public:
+	SectorStreamer* m_streamer;
+	Sector* m_sector;
+	DynamicArray<String> m_filenames;
+	U32 m_nextFilename = 0;
+	Bool m_scriptRead = false;
+	Bool m_staged = false;
+
+	LoadSectorTask(SectorStreamer* streamer, Sector* sector)
+		: m_streamer(streamer)
+		, m_sector(sector)
+	{
+	}
+
+	~LoadSectorTask()
+	{
+		HeapMemoryPool& pool = m_streamer->getMemoryPool();
+
+		for(String& filename : m_filenames)
+		{
+			filename.destroy(pool);
+		}
+		m_filenames.destroy(pool);
+
+		// The task is deleted without staging the sector if it's cancelled or removed from the AsyncLoader. Only the
+		// task moves the sector out of kLoading so the main thread can't start a new load before the sector is let go.
+		// That's the last thing the task does with the sector
+		if(!m_staged)
+		{
+			m_sector->releaseStagedData(pool);
+			m_sector->m_state.store(U32(SectorState::kUnloaded));
+		}
+	}
+
+	Error operator()(AsyncLoaderTaskContext& ctx) final
+	{
+		HeapMemoryPool& pool = m_streamer->getMemoryPool();
+
+		// Failures are only logged because an error would stop the AsyncLoader for good
+		if(m_sector->m_cancelLoading.load())
+		{
+			// The destructor lets go of the sector
+		}
+		else if(!m_scriptRead)
+		{
+			m_scriptRead = true;
+
+			ResourceFilePtr file;
+			StringRaii script(&pool);
+			if(m_streamer->m_fs->openFile(m_sector->m_scriptFilename, file) || file->readAllText(script))
+			{
+				ANKI_SCENE_LOGE("Failed to read the script of sector: %s", m_sector->m_scriptFilename.cstr());
+			}
+			else
+			{
+				gatherResourceFilenames(script, pool, m_filenames);
+				m_sector->m_script = std::move(script);
+			}
+
+			ctx.m_resubmitTask = true;
+		}
+		else if(m_nextFilename < m_filenames.getSize())
+		{
+			const CString filename = m_filenames[m_nextFilename++];
+			ResourceManager& resources = m_streamer->m_scene->getResourceManager();
+			StagedResource* staged;
+			if(findStagedResourceType(filename)->m_callback(resources, filename, pool, staged))
+			{
+				ANKI_SCENE_LOGW("Sector %s failed to load a resource: %s", m_sector->m_scriptFilename.cstr(),
+								filename.cstr());
+			}
+			else
+			{
+				m_sector->m_stagedResources.emplaceBack(pool, staged);
+			}
+
+			ctx.m_resubmitTask = true;
+		}
+		else
+		{
+			// The main thread owns the sector after that
+			m_staged = true;
+			m_sector->m_state.store(U32(SectorState::kStaged));
+		}
+
+		return Error::kNone;
+	}
+};
+
+SectorStreamer::~SectorStreamer()
+{
+	if(!m_scene)
+	{
+		return;
+	}
+
+	// Wait for the AsyncLoader to let go of the sectors. Don't count on it running the queued tasks because it might be
+	// paused or stopped. Drop them instead. The task that is running lets go when it returns
+	for(Sector* sector : m_sectors)
+	{
+		sector->m_cancelLoading.store(1);
+	}
+
+	auto anySectorLoading = [this]() {
+		return std::find_if(m_sectors.getBegin(), m_sectors.getEnd(), [](const Sector* sector) {
+				   return sector->getState() == SectorState::kLoading;
+			   })
+			   != m_sectors.getEnd();
+	};
+
+	while(anySectorLoading())
+	{
+		m_loader->removeTasks([this](AsyncLoaderTask& task) {
+			const LoadSectorTask* sectorTask = dynamic_cast<const LoadSectorTask*>(&task);
+			return sectorTask && sectorTask->m_streamer == this;
+		});
+
+		if(anySectorLoading())
+		{
+			HighRezTimer::sleep(1.0_ms);
+		}
+	}
+
+	// The graph deletes the nodes itself
+	HeapMemoryPool& pool = getMemoryPool();
+	for(Sector* sector : m_sectors)
+	{
+		sector->releaseStagedData(pool);
+		sector->m_scriptFilename.destroy(pool);
+		sector->m_nodes.destroy(pool);
+		deleteInstance(pool, sector);
+	}
+
+	m_sectors.destroy(pool);
+	m_sortedSectors.destroy(pool);
+	m_nodeSectors.destroy(pool);
+}
+
+SectorState SectorStreamer::getSectorState(U32 sector) const
+{
+	return m_sectors[sector]->getState();
+}
+
+HeapMemoryPool& SectorStreamer::getMemoryPool() const
+{
+	ANKI_ASSERT(m_scene);
+	return m_scene->getMemoryPool();
+}
+
+void SectorStreamer::addSector(CString scriptFilename, const Aabb& bounds, PtrSize memorySize)
+{
+	ANKI_ASSERT(scriptFilename);
+	HeapMemoryPool& pool = getMemoryPool();
+
+	Sector* sector = newInstance<Sector>(pool);
+	sector->m_scriptFilename.create(pool, scriptFilename);
+	sector->m_bounds = bounds;
+	sector->m_memorySize = memorySize;
+
+	m_sectors.emplaceBack(pool, sector);
+	m_sortedSectors.emplaceBack(pool, 0);
+}
+
+void SectorStreamer::update(const Vec3& cameraPosition)
+{
+	ANKI_ASSERT(m_scene);
+	if(m_sectors.getSize() == 0)
+	{
+		return;
+	}
+
+	ANKI_TRACE_SCOPED_EVENT(SCENE_SECTOR_STREAMING);
+
+	// Sort the sectors from near to far
+	for(U32 i = 0; i < m_sectors.getSize(); ++i)
+	{
+		Sector& sector = *m_sectors[i];
+		const Vec3 closest = cameraPosition.max(sector.m_bounds.getMin().xyz()).min(sector.m_bounds.getMax().xyz());
+		sector.m_distance = (closest - cameraPosition).getLength();
+		m_sortedSectors[i] = i;
+	}
+
+	std::sort(m_sortedSectors.getBegin(), m_sortedSectors.getEnd(), [this](U32 a, U32 b) {
+		return m_sectors[a]->m_distance < m_sectors[b]->m_distance;
+	});
+
+	// Walk from near to far and keep the sectors that are in range as long as they fit in the budget
+	PtrSize wantedMemory = 0;
+	Bool nothingWanted = true;
+	for(U32 idx : m_sortedSectors)
+	{
+		Sector& sector = *m_sectors[idx];
+		const SectorState state = sector.getState();
+		const Bool loaded = state != SectorState::kUnloaded;
+		const F32 maxDistance = (loaded) ? m_unloadDistance : m_loadDistance;
+
+		const Bool wanted = sector.m_distance <= maxDistance
+							&& (nothingWanted || wantedMemory + sector.m_memorySize <= m_memoryBudget);
+		if(wanted)
+		{
+			wantedMemory += sector.m_memorySize;
+			nothingWanted = false;
+
+			if(!loaded)
+			{
+				startLoading(sector);
+			}
+			else if(state == SectorState::kLoading)
+			{
+				// It might have been cancelled in a previous update. Undo that if the task didn't see it yet
+				sector.m_cancelLoading.store(0);
+			}
+		}
+		else if(loaded)
+		{
+			unload(sector);
+		}
+	}
+
+	// Create the nodes of the nearest staged sectors
+	U32 commitCount = 0;
+	for(U32 idx : m_sortedSectors)
+	{
+		if(commitCount == m_maxCommitsPerUpdate)
+		{
+			break;
+		}
+
+		Sector& sector = *m_sectors[idx];
+		if(sector.getState() == SectorState::kStaged)
+		{
+			commit(sector);
+			++commitCount;
+		}
+	}
+
+	// The sectors that are still loading count until the AsyncLoader lets them go
+	m_residentMemory = 0;
+	for(const Sector* sector : m_sectors)
+	{
+		if(sector->getState() != SectorState::kUnloaded)
+		{
+			m_residentMemory += sector->m_memorySize;
+		}
+	}
+}
+
+void SectorStreamer::startLoading(Sector& sector)
+{
+	ANKI_ASSERT(sector.getState() == SectorState::kUnloaded);
+
+	sector.m_cancelLoading.store(0);
+	sector.m_state.store(U32(SectorState::kLoading));
+
+	m_loader->submitTask(m_loader->newTask<LoadSectorTask>(this, &sector));
+}
+
+void SectorStreamer::commit(Sector& sector)
+{
+	ANKI_ASSERT(sector.getState() == SectorState::kStaged);
+	ANKI_TRACE_SCOPED_EVENT(SCENE_SECTOR_COMMIT);
+
+	// The graph gives the new nodes to registerNode()
+	ANKI_ASSERT(m_committingSector == nullptr);
+	m_committingSector = &sector;
+
+	if(!sector.m_script.isEmpty() && m_scene->getScriptManager().evalString(sector.m_script))
+	{
+		ANKI_SCENE_LOGE("Failed to create the nodes of sector: %s", sector.m_scriptFilename.cstr());
+	}
+
+	m_committingSector = nullptr;
+
+	// The nodes hold their own references now
+	sector.releaseStagedData(getMemoryPool());
+
+	sector.m_state.store(U32(SectorState::kCommitted));
+	++m_committedSectorCount;
+}
+
+void SectorStreamer::registerNode(SceneNode& node)
+{
+	if(m_committingSector)
+	{
+		HeapMemoryPool& pool = getMemoryPool();
+		m_committingSector->m_nodes.emplaceBack(pool, &node);
+		m_nodeSectors.emplace(pool, node.getUuid(), m_committingSector);
+	}
+}
+
+void SectorStreamer::unregisterNode(const SceneNode& node)
+{
+	if(m_nodeSectors.isEmpty())
+	{
+		return;
+	}
+
+	// Someone else deleted a node of a sector
+	auto it = m_nodeSectors.find(node.getUuid());
+	if(it != m_nodeSectors.getEnd())
+	{
+		HeapMemoryPool& pool = getMemoryPool();
+		DynamicArray<SceneNode*>& nodes = (*it)->m_nodes;
+		for(U32 i = 0; i < nodes.getSize(); ++i)
+		{
+			if(nodes[i] == &node)
+			{
+				nodes[i] = nodes.getBack();
+				nodes.popBack(pool);
+				break;
+			}
+		}
+
+		m_nodeSectors.erase(pool, it);
+	}
+}
+
+void SectorStreamer::unload(Sector& sector)
+{
+	switch(sector.getState())
+	{
+	case SectorState::kLoading:
+		// The task will clean up
+		sector.m_cancelLoading.store(1);
+		break;
+	case SectorState::kStaged:
+		sector.releaseStagedData(getMemoryPool());
+		sector.m_state.store(U32(SectorState::kUnloaded));
+		break;
+	case SectorState::kCommitted:
+	{
+		HeapMemoryPool& pool = getMemoryPool();
+		for(SceneNode* node : sector.m_nodes)
+		{
+			m_nodeSectors.erase(pool, m_nodeSectors.find(node->getUuid()));
+			m_scene->deleteSceneNode(node);
+		}
+		sector.m_nodes.destroy(pool);
+
+		sector.m_state.store(U32(SectorState::kUnloaded));
+		ANKI_ASSERT(m_committedSectorCount > 0);
+		--m_committedSectorCount;
+		break;
+	}
+	default:
+		ANKI_ASSERT(0);
+	}
+}
+
+} // end namespace anki
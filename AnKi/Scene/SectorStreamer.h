@@ -0,0 +1,156 @@
+// Copyright (C) 2009-2022, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#pragma once
+
+#include <AnKi/Scene/Common.h>
+#include <AnKi/Collision/Aabb.h>
+#include <AnKi/Util/DynamicArray.h>
+#include <AnKi/Util/HashMap.h>
+
+namespace anki {
+
+// Forward
+class AsyncLoader;
+class ResourceFilesystem;
+
+/// @addtogroup scene
+/// @{
+
+/// The state of a sector of the SectorStreamer.
+enum class SectorState : U32
+{
+	kUnloaded,
+	kLoading, ///< The AsyncLoader is working on it.
+	kStaged, ///< The resources are loaded and the nodes are waiting to be created.
+	kCommitted ///< The nodes are in the graph.
+};
+
+/// Streams parts of the world in and out of the SceneGraph. The world is split in sectors. Every sector has bounds and
+/// a script that creates its nodes. The sectors near the camera are loaded and the far ones are unloaded while the
+/// memory of the loaded sectors stays inside a budget.
+///
+/// A sector is loaded in 2 stages. First the AsyncLoader reads the script and loads the resources it references. Then
+/// update() evaluates the script at the start of a frame. The nodes find their resources in the cache so that is cheap.
+/// The graph and the component storage are not thread-safe so the nodes themselves can't be created in the background.
+class SectorStreamer
+{
+public:
+	SectorStreamer() = default;
+
+	SectorStreamer(const SectorStreamer&) = delete; // Non-copyable
+
+	~SectorStreamer();
+
+	SectorStreamer& operator=(const SectorStreamer&) = delete; // Non-copyable
+
+	/// @param scene The graph that the nodes of the sectors go to.
+	/// @param loader The loader that reads the sectors in the background.
+	/// @param fs Where the scripts of the sectors are read from.
+	void init(SceneGraph* scene, AsyncLoader* loader, ResourceFilesystem* fs)
+	{
+		ANKI_ASSERT(scene && loader && fs);
+		m_scene = scene;
+		m_loader = loader;
+		m_fs = fs;
+	}
+
+	/// Add a sector to the world. It will be loaded when update() decides so.
+	/// @param scriptFilename A script that creates the nodes of the sector.
+	/// @param bounds The bounds of the sector.
+	/// @param memorySize The approximate memory the sector needs when it's loaded.
+	void addSector(CString scriptFilename, const Aabb& bounds, PtrSize memorySize);
+
+	/// The sectors that are closer than that to the camera will be loaded.
+	void setLoadDistance(F32 dist)
+	{
+		ANKI_ASSERT(dist >= 0.0f);
+		m_loadDistance = dist;
+	}
+
+	/// The loaded sectors that are farther than that from the camera will be unloaded. It should be greater than the
+	/// load distance so the sectors on the edge don't get loaded and unloaded all the time.
+	void setUnloadDistance(F32 dist)
+	{
+		ANKI_ASSERT(dist >= 0.0f);
+		m_unloadDistance = dist;
+	}
+
+	/// The max memory of all the loaded sectors. The farthest sectors are dropped first if they don't fit. The nearest
+	/// sector is always loaded.
+	void setMemoryBudget(PtrSize budget)
+	{
+		m_memoryBudget = budget;
+	}
+
+	/// How many sectors will be added to the graph in a single update. It spreads the cost of big areas across frames.
+	void setMaxCommitsPerUpdate(U32 count)
+	{
+		ANKI_ASSERT(count > 0);
+		m_maxCommitsPerUpdate = count;
+	}
+
+	U32 getSectorCount() const
+	{
+		return m_sectors.getSize();
+	}
+
+	/// @param sector The index of the sector in the order addSector() was called.
+	SectorState getSectorState(U32 sector) const;
+
+	/// Get the number of the sectors whose nodes are in the graph.
+	U32 getCommittedSectorCount() const
+	{
+		return m_committedSectorCount;
+	}
+
+	/// Get the memory of the sectors that are loaded or being loaded.
+	PtrSize getResidentMemory() const
+	{
+		return m_residentMemory;
+	}
+
+	/// Load and unload sectors. Call it at the start of the frame before the nodes get updated.
+	void update(const Vec3& cameraPosition);
+
+	/// The graph calls it for every new node. The nodes that a sector creates are deleted when it's unloaded.
+	ANKI_INTERNAL void registerNode(SceneNode& node);
+
+	/// The graph calls it for every node it deletes.
+	ANKI_INTERNAL void unregisterNode(const SceneNode& node);
+
+private:
+	class Sector;
+	class LoadSectorTask;
+
+	SceneGraph* m_scene = nullptr;
+	AsyncLoader* m_loader = nullptr;
+	ResourceFilesystem* m_fs = nullptr;
+
+	DynamicArray<Sector*> m_sectors;
+	DynamicArray<U32> m_sortedSectors; ///< Scratch. The sectors from the nearest to the farthest.
+	HashMap<U64, Sector*> m_nodeSectors; ///< The sector of every node that a sector created. The key is the UUID.
+	Sector* m_committingSector = nullptr; ///< The sector whose script runs.
+
+	F32 m_loadDistance = 100.0f;
+	F32 m_unloadDistance = 150.0f;
+	PtrSize m_memoryBudget = kMaxPtrSize;
+	U32 m_maxCommitsPerUpdate = 1;
+
+	PtrSize m_residentMemory = 0;
+	U32 m_committedSectorCount = 0;
+
+	HeapMemoryPool& getMemoryPool() const;
+
+	void startLoading(Sector& sector);
+
+	/// Create the nodes of a staged sector.
+	void commit(Sector& sector);
+
+	void unload(Sector& sector);
+};
+/// @}
+
+} // end namespace anki
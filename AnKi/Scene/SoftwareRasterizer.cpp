@@ -7,29 +7,78 @@
 #include <AnKi/Collision/Aabb.h>
 #include <AnKi/Collision/Functions.h>
 #include <AnKi/Util/Tracer.h>
+#include <algorithm>
 
 namespace anki {
 
+static_assert(SoftwareRasterizer::kTileSize * SoftwareRasterizer::kTileSize == 64, "The tile mask is a U64");
+
+class SoftwareRasterizer::RasterizeCtx
+{
+public:
+	SoftwareRasterizer* m_rasterizer = nullptr;
+	Atomic<U32> m_nextBin = {0};
+};
+
+SoftwareRasterizer::~SoftwareRasterizer()
+{
+	if(m_pool)
+	{
+		m_tiles.destroy(*m_pool);
+		destroyBins();
+	}
+}
+
+void SoftwareRasterizer::destroyBins()
+{
+	for(ThreadBins& bins : m_threadBins)
+	{
+		for(DynamicArray<U32>& binTriangles : bins.m_binTriangles)
+		{
+			binTriangles.destroy(*m_pool);
+		}
+
+		bins.m_binTriangles.destroy(*m_pool);
+		bins.m_triangles.destroy(*m_pool);
+	}
+}
+
 void SoftwareRasterizer::prepare(const Mat4& mv, const Mat4& p, U32 width, U32 height)
 {
 	m_mv = mv;
 	m_p = p;
 	m_mvp = p * mv;
+	for(U32 i = 0; i < 4; ++i)
+	{
+		m_mvpColumns[i] = m_mvp.getColumn(i);
+	}
 
 	extractClipPlanes(p, m_planesL);
 	extractClipPlanes(m_mvp, m_planesW);
 
-	// Reset z buffer
+	// Reset the tiles
 	ANKI_ASSERT(width > 0 && height > 0);
 	m_width = width;
 	m_height = height;
-	U32 size = width * height;
-	if(m_zbuffer.getSize() < size)
+	m_tileCounts = UVec2((width + kTileSize - 1) / kTileSize, (height + kTileSize - 1) / kTileSize);
+	m_binCounts = UVec2((m_tileCounts.x() + kBinSize - 1) / kBinSize, (m_tileCounts.y() + kBinSize - 1) / kBinSize);
+
+	const U32 tileCount = m_tileCounts.x() * m_tileCounts.y();
+	if(m_tiles.getSize() < tileCount)
+	{
+		m_tiles.destroy(*m_pool);
+		m_tiles.create(*m_pool, tileCount);
+	}
+
+	for(U32 i = 0; i < tileCount; ++i)
 	{
-		m_zbuffer.destroy(*m_pool);
-		m_zbuffer.create(*m_pool, size);
+		m_tiles[i].m_mask = 0;
+		m_tiles[i].m_zMax0 = 1.0f;
+		m_tiles[i].m_zMax1 = 0.0f;
 	}
-	memset(&m_zbuffer[0], 0xFF, sizeof(m_zbuffer[0]) * size);
+
+	// Forget the triangles of the previous draws
+	destroyBins();
 }
 
 void SoftwareRasterizer::clipTriangle(const Vec4* inVerts, Vec4* outVerts, U& outVertCount) const
@@ -159,10 +208,11 @@ void SoftwareRasterizer::clipTriangle(const Vec4* inVerts, Vec4* outVerts, U& ou
 	}
 }
 
-void SoftwareRasterizer::draw(const F32* verts, U vertCount, U stride, Bool backfaceCulling)
+void SoftwareRasterizer::draw(const F32* verts, U vertCount, U stride, Bool backfaceCulling, U32 threadId)
 {
 	ANKI_ASSERT(verts && vertCount > 0 && (vertCount % 3) == 0);
 	ANKI_ASSERT(stride >= sizeof(F32) * 3 && (stride % sizeof(F32)) == 0);
+	ANKI_ASSERT(threadId < m_threadBins.getSize());
 
 	U floatStride = stride / sizeof(F32);
 	const F32* vertsEnd = verts + vertCount * floatStride;
@@ -199,7 +249,7 @@ void SoftwareRasterizer::draw(const F32* verts, U vertCount, U stride, Bool back
 			continue;
 		}
 
-		// Rasterize
+		// Bin
 		Array<Vec4, 3> clip;
 		for(U j = 0; j < clippedCount; j += 3)
 		{
@@ -209,89 +259,293 @@ void SoftwareRasterizer::draw(const F32* verts, U vertCount, U stride, Bool back
 				ANKI_ASSERT(clip[k].w() > 0.0f);
 			}
 
-			rasterizeTriangle(&clip[0]);
+			binTriangle(&clip[0], threadId);
 		}
 	}
 }
 
-Bool SoftwareRasterizer::computeBarycetrinc(const Vec2& a, const Vec2& b, const Vec2& c, const Vec2& p, Vec3& uvw) const
+void SoftwareRasterizer::binTriangle(const Vec4* tri, U32 threadId)
 {
-	Vec2 dca = c - a;
-	Vec2 dba = b - a;
-	Vec2 dap = a - p;
+	ANKI_ASSERT(tri);
 
-	Vec3 n(dca.x(), dba.x(), dap.x());
-	Vec3 m(dca.y(), dba.y(), dap.y());
+	const Vec2 windowSize{F32(m_width), F32(m_height)};
+	Array<Vec2, 3> window;
+	Array<F32, 3> z;
+	Vec2 bboxMin(kMaxF32), bboxMax(kMinF32);
+	F32 zMax = 0.0f;
+	for(U32 i = 0; i < 3; i++)
+	{
+		const Vec3 ndc = tri[i].xyz() / tri[i].w();
+		window[i] = (ndc.xy() / 2.0f + 0.5f) * windowSize;
+		z[i] = clamp(ndc.z(), 0.0f, 1.0f);
 
-	Vec3 k = n.cross(m);
+		bboxMin = bboxMin.min(window[i]);
+		bboxMax = bboxMax.max(window[i]);
+		zMax = max(zMax, z[i]);
+	}
 
-	Bool skip = false;
-	if(!isZero(k.z()))
+	// Cull if it's outside the screen or if it's too far to occlude anything
+	if(bboxMax.x() < 0.0f || bboxMax.y() < 0.0f || bboxMin.x() >= windowSize.x() || bboxMin.y() >= windowSize.y()
+	   || zMax >= 1.0f)
 	{
-		uvw = Vec3(1.0f - (k.x() + k.y()) / k.z(), k.y() / k.z(), k.x() / k.z());
+		return;
+	}
 
-		if(uvw.x() < 0.0f || uvw.y() < 0.0f || uvw.z() < 0.0f)
-		{
-			skip = true;
-		}
+	// Make it counter-clockwise
+	F32 area = (window[1].x() - window[0].x()) * (window[2].y() - window[0].y())
+			   - (window[2].x() - window[0].x()) * (window[1].y() - window[0].y());
+	if(absolute(area) < kEpsilonf)
+	{
+		return;
 	}
-	else
+
+	if(area < 0.0f)
+	{
+		std::swap(window[1], window[2]);
+		std::swap(z[1], z[2]);
+		area = -area;
+	}
+
+	BinnedTriangle out;
+
+	// The edge function of the edge from a to b is (b - a) x (p - a)
+	for(U32 i = 0; i < 3; ++i)
+	{
+		const Vec2& a = window[i];
+		const Vec2& b = window[(i + 1) % 3];
+		out.m_edgeA[i] = a.y() - b.y();
+		out.m_edgeB[i] = b.x() - a.x();
+		out.m_edgeC[i] = -(out.m_edgeA[i] * a.x() + out.m_edgeB[i] * a.y());
+	}
+
+	// NDC depth is linear in window space
+	const Vec2 d1 = window[1] - window[0];
+	const Vec2 d2 = window[2] - window[0];
+	const F32 dz1 = z[1] - z[0];
+	const F32 dz2 = z[2] - z[0];
+	out.m_dzdx = (dz1 * d2.y() - dz2 * d1.y()) / area;
+	out.m_dzdy = (dz2 * d1.x() - dz1 * d2.x()) / area;
+	out.m_z0 = z[0] - out.m_dzdx * window[0].x() - out.m_dzdy * window[0].y();
+	out.m_zMax = zMax;
+
+	for(U32 i = 0; i < 2; ++i)
 	{
-		skip = true;
+		const I32 lastTile = I32(m_tileCounts[i]) - 1;
+		out.m_tileMin[i] = U16(clamp(I32(bboxMin[i]) / I32(kTileSize), 0, lastTile));
+		out.m_tileMax[i] = U16(clamp(I32(bboxMax[i]) / I32(kTileSize), 0, lastTile));
 	}
 
-	return skip;
+	// Store it and add it to the bins it touches
+	ThreadBins& bins = m_threadBins[threadId];
+	if(bins.m_binTriangles.getSize() == 0)
+	{
+		bins.m_binTriangles.create(*m_pool, getBinCount());
+	}
+
+	const U32 triIdx = bins.m_triangles.getSize();
+	bins.m_triangles.emplaceBack(*m_pool, out);
+
+	for(U32 binY = out.m_tileMin[1] / kBinSize; binY <= out.m_tileMax[1] / kBinSize; ++binY)
+	{
+		for(U32 binX = out.m_tileMin[0] / kBinSize; binX <= out.m_tileMax[0] / kBinSize; ++binX)
+		{
+			bins.m_binTriangles[binY * m_binCounts.x() + binX].emplaceBack(*m_pool, triIdx);
+		}
+	}
 }
 
-void SoftwareRasterizer::rasterizeTriangle(const Vec4* tri)
+U64 SoftwareRasterizer::computeTileCoverage(const BinnedTriangle& tri, U32 tileX, U32 tileY)
 {
-	ANKI_ASSERT(tri);
+	// The center of the 1st pixel of the tile
+	const F32 x0 = F32(tileX * kTileSize) + 0.5f;
+	const F32 y0 = F32(tileY * kTileSize) + 0.5f;
+	constexpr F32 kSpan = F32(kTileSize - 1);
+
+	// Trivially reject or accept using the pixels at the corners of the tile. The edge functions are linear
+	Array<F32, 3> rowStarts;
+	Bool allInside = true;
+	for(U32 e = 0; e < 3; ++e)
+	{
+		const F32 a = tri.m_edgeA[e];
+		const F32 b = tri.m_edgeB[e];
+		rowStarts[e] = a * x0 + b * y0 + tri.m_edgeC[e];
 
-	const Vec2 windowSize{F32(m_width), F32(m_height)};
-	Array<Vec3, 3> ndc;
-	Array<Vec2, 3> window;
-	Vec2 bboxMin(kMaxF32), bboxMax(kMinF32);
-	for(U i = 0; i < 3; i++)
+		const F32 eMax = rowStarts[e] + (max(a, 0.0f) + max(b, 0.0f)) * kSpan;
+		if(eMax < 0.0f)
+		{
+			return 0;
+		}
+
+		const F32 eMin = rowStarts[e] + (min(a, 0.0f) + min(b, 0.0f)) * kSpan;
+		allInside = allInside && eMin >= 0.0f;
+	}
+
+	if(allInside)
+	{
+		return kMaxU64;
+	}
+
+	// Evaluate the edge functions at every pixel of the tile, one row at a time
+	U64 coverage = 0;
+#if ANKI_SIMD_SSE
+	const __m128 zero = _mm_setzero_ps();
+	Array<__m128, 3> lanes0;
+	Array<__m128, 3> lanes1;
+	for(U32 e = 0; e < 3; ++e)
+	{
+		const __m128 a = _mm_set1_ps(tri.m_edgeA[e]);
+		const __m128 start = _mm_set1_ps(rowStarts[e]);
+		lanes0[e] = _mm_add_ps(start, _mm_mul_ps(a, _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f)));
+		lanes1[e] = _mm_add_ps(start, _mm_mul_ps(a, _mm_setr_ps(4.0f, 5.0f, 6.0f, 7.0f)));
+	}
+
+	for(U32 y = 0; y < kTileSize; ++y)
 	{
-		ndc[i] = tri[i].xyz() / tri[i].w();
-		window[i] = (ndc[i].xy() / 2.0f + 0.5f) * windowSize;
+		U32 rowMask = 0xFF;
+		for(U32 e = 0; e < 3; ++e)
+		{
+			const __m128 rowOffset = _mm_set1_ps(tri.m_edgeB[e] * F32(y));
+			const U32 mask0 = U32(_mm_movemask_ps(_mm_cmpge_ps(_mm_add_ps(lanes0[e], rowOffset), zero)));
+			const U32 mask1 = U32(_mm_movemask_ps(_mm_cmpge_ps(_mm_add_ps(lanes1[e], rowOffset), zero)));
+			rowMask &= mask0 | (mask1 << 4u);
+		}
 
-		for(U j = 0; j < 2; j++)
+		coverage |= U64(rowMask) << U64(y * kTileSize);
+	}
+#else
+	for(U32 y = 0; y < kTileSize; ++y)
+	{
+		for(U32 x = 0; x < kTileSize; ++x)
 		{
-			bboxMin[j] = std::floor(min(bboxMin[j], window[i][j]));
-			bboxMin[j] = clamp(bboxMin[j], 0.0f, windowSize[j]);
+			Bool inside = true;
+			for(U32 e = 0; e < 3; ++e)
+			{
+				inside = inside && rowStarts[e] + tri.m_edgeA[e] * F32(x) + tri.m_edgeB[e] * F32(y) >= 0.0f;
+			}
 
-			bboxMax[j] = std::ceil(max(bboxMax[j], window[i][j]));
-			bboxMax[j] = clamp(bboxMax[j], 0.0f, windowSize[j]);
+			coverage |= U64(inside) << U64(y * kTileSize + x);
 		}
 	}
+#endif
+
+	return coverage;
+}
 
-	for(F32 y = bboxMin.y() + 0.5f; y < bboxMax.y() + 0.5f; y += 1.0f)
+void SoftwareRasterizer::updateTile(Tile& tile, U64 coverage, F32 zMax)
+{
+	if(coverage == 0 || zMax >= tile.m_zMax0)
 	{
-		for(F32 x = bboxMin.x() + 0.5f; x < bboxMax.x() + 0.5f; x += 1.0f)
+		return;
+	}
+
+	// If the new triangle is much closer than the working layer it's better to start a new working layer
+	if(tile.m_mask != 0 && tile.m_zMax1 - zMax > tile.m_zMax0 - tile.m_zMax1)
+	{
+		tile.m_mask = 0;
+		tile.m_zMax1 = 0.0f;
+	}
+
+	tile.m_zMax1 = max(tile.m_zMax1, zMax);
+	tile.m_mask |= coverage;
+
+	// If the working layer covers the whole tile it becomes the reference layer
+	if(tile.m_mask == kMaxU64)
+	{
+		ANKI_ASSERT(tile.m_zMax1 <= tile.m_zMax0);
+		tile.m_zMax0 = tile.m_zMax1;
+		tile.m_zMax1 = 0.0f;
+		tile.m_mask = 0;
+	}
+}
+
+void SoftwareRasterizer::rasterizeBin(U32 bin)
+{
+	ANKI_ASSERT(bin < getBinCount());
+
+	const U32 binX = bin % m_binCounts.x();
+	const U32 binY = bin / m_binCounts.x();
+	const U32 binTileMinX = binX * kBinSize;
+	const U32 binTileMinY = binY * kBinSize;
+	const U32 binTileMaxX = min((binX + 1) * kBinSize, m_tileCounts.x()) - 1;
+	const U32 binTileMaxY = min((binY + 1) * kBinSize, m_tileCounts.y()) - 1;
+
+	for(const ThreadBins& bins : m_threadBins)
+	{
+		if(bins.m_binTriangles.getSize() == 0)
 		{
-			Vec2 p(x, y);
-			Vec3 bc;
-			if(!computeBarycetrinc(window[0], window[1], window[2], p, bc))
-			{
-				const F32 z0 = ndc[0].z();
-				const F32 z1 = ndc[1].z();
-				const F32 z2 = ndc[2].z();
+			continue;
+		}
 
-				F32 depth = z0 * bc[0] + z1 * bc[1] + z2 * bc[2];
-				ANKI_ASSERT(depth >= 0.0 && depth <= 1.0);
+		for(U32 triIdx : bins.m_binTriangles[bin])
+		{
+			const BinnedTriangle& tri = bins.m_triangles[triIdx];
 
-				// Clamp it to a bit less that 1.0f because 1.0f will produce a 0 depthi
-				depth = min(depth, 1.0f - kEpsilonf);
+			const U32 tileMinX = max<U32>(tri.m_tileMin[0], binTileMinX);
+			const U32 tileMinY = max<U32>(tri.m_tileMin[1], binTileMinY);
+			const U32 tileMaxX = min<U32>(tri.m_tileMax[0], binTileMaxX);
+			const U32 tileMaxY = min<U32>(tri.m_tileMax[1], binTileMaxY);
 
-				// Store the min of the current value and new one
-				const U32 depthi = U32(depth * F32(kMaxU32));
-				m_zbuffer[U32(y) * m_width + U32(x)].min(depthi);
+			for(U32 tileY = tileMinY; tileY <= tileMaxY; ++tileY)
+			{
+				for(U32 tileX = tileMinX; tileX <= tileMaxX; ++tileX)
+				{
+					Tile& tile = m_tiles[tileY * m_tileCounts.x() + tileX];
+
+					// The depth plane is linear so its max inside the tile is at one of the corners
+					const F32 x0 = F32(tileX * kTileSize);
+					const F32 y0 = F32(tileY * kTileSize);
+					const F32 x1 = x0 + F32(kTileSize);
+					const F32 y1 = y0 + F32(kTileSize);
+					const F32 planeMax =
+						tri.m_z0 + max(tri.m_dzdx * x0, tri.m_dzdx * x1) + max(tri.m_dzdy * y0, tri.m_dzdy * y1);
+					const F32 zMax = min(planeMax, tri.m_zMax);
+
+					// Skip the coverage computation if it's behind anyway
+					if(zMax >= tile.m_zMax0)
+					{
+						continue;
+					}
+
+					updateTile(tile, computeTileCoverage(tri, tileX, tileY), zMax);
+				}
 			}
 		}
 	}
 }
 
+void SoftwareRasterizer::rasterizeBinsTaskCallback(void* ud, [[maybe_unused]] U32 threadId,
+												   [[maybe_unused]] ThreadHive& hive,
+												   [[maybe_unused]] ThreadHiveSemaphore* sem)
+{
+	RasterizeCtx& ctx = *static_cast<RasterizeCtx*>(ud);
+	const U32 binCount = ctx.m_rasterizer->getBinCount();
+
+	U32 bin;
+	while((bin = ctx.m_nextBin.fetchAdd(1)) < binCount)
+	{
+		ctx.m_rasterizer->rasterizeBin(bin);
+	}
+}
+
+void SoftwareRasterizer::rasterizeBins(ThreadHive& hive)
+{
+	ANKI_TRACE_SCOPED_EVENT(SCENE_RASTERIZER_BINS);
+
+	RasterizeCtx ctx;
+	ctx.m_rasterizer = this;
+
+	const U32 taskCount = min(hive.getThreadCount(), getBinCount());
+	Array<ThreadHiveTask, ThreadHive::kMaxThreads> tasks;
+	for(U32 i = 0; i < taskCount; ++i)
+	{
+		tasks[i].m_argument = &ctx;
+		tasks[i].m_callback = rasterizeBinsTaskCallback;
+	}
+
+	hive.submitTasks(&tasks[0], taskCount);
+	hive.waitAllTasks();
+}
+
 Bool SoftwareRasterizer::visibilityTest(const Aabb& aabb) const
 {
 	ANKI_TRACE_SCOPED_EVENT(SCENE_RASTERIZER_TEST);
@@ -302,23 +556,18 @@ Bool SoftwareRasterizer::visibilityTest(const Aabb& aabb) const
 
 Bool SoftwareRasterizer::visibilityTestInternal(const Aabb& aabb) const
 {
-	// Set the AABB points
+	// Transform the AABB points. The transform is linear so compute the contribution of every axis only once
 	const Vec4& minv = aabb.getMin();
 	const Vec4& maxv = aabb.getMax();
+	const Array<Vec4, 2> xs = {m_mvpColumns[0] * minv.x(), m_mvpColumns[0] * maxv.x()};
+	const Array<Vec4, 2> ys = {m_mvpColumns[1] * minv.y(), m_mvpColumns[1] * maxv.y()};
+	const Array<Vec4, 2> zs = {m_mvpColumns[2] * minv.z() + m_mvpColumns[3],
+							   m_mvpColumns[2] * maxv.z() + m_mvpColumns[3]};
+
 	Array<Vec4, 8> boxPoints;
-	boxPoints[0] = minv.xyz1();
-	boxPoints[1] = Vec4(minv.x(), maxv.y(), minv.z(), 1.0f);
-	boxPoints[2] = Vec4(minv.x(), maxv.y(), maxv.z(), 1.0f);
-	boxPoints[3] = Vec4(minv.x(), minv.y(), maxv.z(), 1.0f);
-	boxPoints[4] = maxv.xyz1();
-	boxPoints[5] = Vec4(maxv.x(), minv.y(), maxv.z(), 1.0f);
-	boxPoints[6] = Vec4(maxv.x(), minv.y(), minv.z(), 1.0f);
-	boxPoints[7] = Vec4(maxv.x(), maxv.y(), minv.z(), 1.0f);
-
-	// Transform points
-	for(Vec4& p : boxPoints)
+	for(U32 i = 0; i < 8; ++i)
 	{
-		p = m_mvp * p;
+		boxPoints[i] = xs[i & 1] + ys[(i >> 1) & 1] + zs[(i >> 2) & 1];
 	}
 
 	// Check of a point touches the near plane
@@ -334,17 +583,13 @@ Bool SoftwareRasterizer::visibilityTestInternal(const Aabb& aabb) const
 	// Compute the min and max bounds
 	Vec4 bboxMin(kMaxF32);
 	Vec4 bboxMax(kMinF32);
+	const F32 halfWidth = F32(m_width) * 0.5f;
+	const F32 halfHeight = F32(m_height) * 0.5f;
 	for(Vec4& p : boxPoints)
 	{
-		// Perspecrive divide
-		p /= p.w();
-
-		// To [0, 1]
-		p *= Vec4(0.5f, 0.5f, 1.0f, 1.0f);
-		p += Vec4(0.5f, 0.5f, 0.0f, 0.0f);
-
-		// To [0, m_width|m_height]
-		p *= Vec4(F32(m_width), F32(m_height), 1.0f, 1.0f);
+		// Perspecrive divide and to [0, m_width|m_height] in one go
+		const F32 invW = 1.0f / p.w();
+		p = p * Vec4(halfWidth * invW, halfHeight * invW, invW, 0.0f) + Vec4(halfWidth, halfHeight, 0.0f, 0.0f);
 
 		// Min
 		bboxMin = bboxMin.min(p);
@@ -354,28 +599,42 @@ Bool SoftwareRasterizer::visibilityTestInternal(const Aabb& aabb) const
 	}
 
 	// Fix the bounds
-	bboxMin.x() = floorf(bboxMin.x());
-	bboxMin.x() = clamp(bboxMin.x(), 0.0f, F32(m_width));
-
-	bboxMax.x() = ceilf(bboxMax.x());
-	bboxMax.x() = clamp(bboxMax.x(), 0.0f, F32(m_width));
-
-	bboxMin.y() = floorf(bboxMin.y());
-	bboxMin.y() = clamp(bboxMin.y(), 0.0f, F32(m_height));
-
-	bboxMax.y() = ceilf(bboxMax.y());
-	bboxMax.y() = clamp(bboxMax.y(), 0.0f, F32(m_height));
+	const U32 minX = U32(clamp(floorf(bboxMin.x()), 0.0f, F32(m_width)));
+	const U32 maxX = U32(clamp(ceilf(bboxMax.x()), 0.0f, F32(m_width)));
+	const U32 minY = U32(clamp(floorf(bboxMin.y()), 0.0f, F32(m_height)));
+	const U32 maxY = U32(clamp(ceilf(bboxMax.y()), 0.0f, F32(m_height)));
+	if(minX >= maxX || minY >= maxY)
+	{
+		return false;
+	}
 
 	// Loop the tiles
-	F32 minZ = bboxMin.z();
-	for(F32 y = bboxMin.y(); y < bboxMax.y(); y += 1.0f)
+	const F32 minZ = bboxMin.z();
+	for(U32 tileY = minY / kTileSize; tileY <= (maxY - 1) / kTileSize; ++tileY)
 	{
-		for(F32 x = bboxMin.x(); x < bboxMax.x(); x += 1.0f)
+		// The rows of the tile that are inside the bounds
+		const U32 rowBegin = (minY > tileY * kTileSize) ? minY - tileY * kTileSize : 0;
+		const U32 rowEnd = min(maxY - tileY * kTileSize, kTileSize);
+		const U32 rowCount = rowEnd - rowBegin;
+		const U64 rowsMask = ((rowCount == kTileSize) ? kMaxU64 : ((U64(1) << U64(rowCount * kTileSize)) - 1))
+							 << U64(rowBegin * kTileSize);
+
+		for(U32 tileX = minX / kTileSize; tileX <= (maxX - 1) / kTileSize; ++tileX)
 		{
-			const U32 idx = U32(y) * m_width + U32(x);
-			const U32 depthi = m_zbuffer[idx].getNonAtomically();
-			const F32 depthf = F32(depthi) / F32(kMaxU32);
-			if(minZ < depthf)
+			// The columns of the tile that are inside the bounds
+			const U32 colBegin = (minX > tileX * kTileSize) ? minX - tileX * kTileSize : 0;
+			const U32 colEnd = min(maxX - tileX * kTileSize, kTileSize);
+			const U64 colsMask = U64(((1u << (colEnd - colBegin)) - 1u) << colBegin) * 0x0101010101010101ull;
+			const U64 boundsMask = rowsMask & colsMask;
+
+			// Test against the layers of the tile the bounds overlap
+			const Tile& tile = m_tiles[tileY * m_tileCounts.x() + tileX];
+			if((boundsMask & ~tile.m_mask) && minZ < tile.m_zMax0)
+			{
+				return true;
+			}
+
+			if((boundsMask & tile.m_mask) && minZ < tile.m_zMax1)
 			{
 				return true;
 			}
@@ -387,18 +646,69 @@ Bool SoftwareRasterizer::visibilityTestInternal(const Aabb& aabb) const
 
 void SoftwareRasterizer::fillDepthBuffer(ConstWeakArray<F32> depthValues)
 {
-	ANKI_ASSERT(m_zbuffer.getSize() == depthValues.getSize());
+	ANKI_ASSERT(m_width * m_height == depthValues.getSize());
 
-	U32 count = depthValues.getSize();
-	while(count--)
+	// Split the pixels of every tile in the 2 layers. The near pixels go to the working layer and the rest to the
+	// reference layer. Pick the split that loses the least depth compared to the per-pixel values
+	for(U32 tileY = 0; tileY < m_tileCounts.y(); ++tileY)
 	{
-		F32 depth = depthValues[count];
-		ANKI_ASSERT(depth >= 0.0f && depth <= 1.0f);
+		for(U32 tileX = 0; tileX < m_tileCounts.x(); ++tileX)
+		{
+			const U32 xBegin = tileX * kTileSize;
+			const U32 yBegin = tileY * kTileSize;
+			const U32 xEnd = min(xBegin + kTileSize, m_width);
+			const U32 yEnd = min(yBegin + kTileSize, m_height);
+
+			Array<F32, kTileSize * kTileSize> sortedDepths;
+			U32 count = 0;
+			for(U32 y = yBegin; y < yEnd; ++y)
+			{
+				for(U32 x = xBegin; x < xEnd; ++x)
+				{
+					const F32 depth = depthValues[y * m_width + x];
+					ANKI_ASSERT(depth >= 0.0f && depth <= 1.0f);
+					sortedDepths[count++] = depth;
+				}
+			}
+
+			std::sort(sortedDepths.getBegin(), sortedDepths.getBegin() + count);
+			const F32 zMax = sortedDepths[count - 1];
+
+			// The nearest nearCount pixels get the depth of the last of them and the rest get zMax
+			U32 bestNearCount = 0;
+			F32 bestCost = F32(count) * zMax;
+			for(U32 nearCount = 1; nearCount < count; ++nearCount)
+			{
+				const F32 cost = F32(nearCount) * sortedDepths[nearCount - 1] + F32(count - nearCount) * zMax;
+				if(cost < bestCost)
+				{
+					bestCost = cost;
+					bestNearCount = nearCount;
+				}
+			}
 
-		depth = min(depth, 1.0f - kEpsilonf); // See a few lines above why is that
+			Tile& tile = m_tiles[tileY * m_tileCounts.x() + tileX];
+			tile.m_mask = 0;
+			tile.m_zMax0 = zMax;
+			tile.m_zMax1 = 0.0f;
 
-		const U32 depthi = U32(depth * F32(kMaxU32));
-		m_zbuffer[count].setNonAtomically(depthi);
+			if(bestNearCount > 0)
+			{
+				const F32 split = sortedDepths[bestNearCount - 1];
+				for(U32 y = yBegin; y < yEnd; ++y)
+				{
+					for(U32 x = xBegin; x < xEnd; ++x)
+					{
+						if(depthValues[y * m_width + x] <= split)
+						{
+							tile.m_mask |= U64(1) << U64((y - yBegin) * kTileSize + (x - xBegin));
+						}
+					}
+				}
+
+				tile.m_zMax1 = split;
+			}
+		}
 	}
 }
 
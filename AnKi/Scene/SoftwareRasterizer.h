@@ -9,24 +9,28 @@
 #include <AnKi/Math.h>
 #include <AnKi/Collision/Plane.h>
 #include <AnKi/Util/WeakArray.h>
+#include <AnKi/Util/ThreadHive.h>
 
 namespace anki {
 
 /// @addtogroup scene
 /// @{
 
-/// Software rasterizer for visibility tests.
+/// Software rasterizer for visibility tests. It's modeled after masked occlusion culling. The screen is split in tiles
+/// of 8x8 pixels. Every tile holds a coverage mask (one bit per pixel) and 2 conservative depth values instead of a
+/// full depth buffer. Triangles are first binned to groups of tiles and then every bin is rasterized by a single
+/// thread so no atomics are needed.
 class SoftwareRasterizer
 {
 public:
+	static constexpr U32 kTileSize = 8; ///< In pixels.
+	static constexpr U32 kBinSize = 4; ///< In tiles.
+
 	SoftwareRasterizer()
 	{
 	}
 
-	~SoftwareRasterizer()
-	{
-		m_zbuffer.destroy(*m_pool);
-	}
+	~SoftwareRasterizer();
 
 	/// Initialize.
 	void init(BaseMemoryPool* pool)
@@ -38,43 +42,103 @@ public:
 	/// Prepare for rendering. Call it before every draw.
 	void prepare(const Mat4& mv, const Mat4& p, U32 width, U32 height);
 
-	/// Render some verts.
+	/// Bin some verts. They will be rasterized by rasterizeBin() or rasterizeBins().
 	/// @param[in] verts Pointer to the first vertex to draw.
 	/// @param vertCount The number of verts to draw.
 	/// @param stride The stride (in bytes) of the next vertex.
 	/// @param backfaceCulling If true it will do backface culling.
-	/// @note It's thread-safe against other draw() invocations only.
-	void draw(const F32* verts, U vertCount, U stride, Bool backfaceCulling);
+	/// @param threadId The ID of the calling thread.
+	/// @note It's thread-safe against other draw() invocations with different threadId.
+	void draw(const F32* verts, U vertCount, U stride, Bool backfaceCulling, U32 threadId = 0);
+
+	U32 getBinCount() const
+	{
+		return m_binCounts.x() * m_binCounts.y();
+	}
+
+	/// Rasterize the triangles of a single bin.
+	/// @note It's thread-safe against other rasterizeBin() invocations with different bin.
+	void rasterizeBin(U32 bin);
+
+	/// Rasterize all bins using the ThreadHive. Don't call it from a ThreadHive task.
+	void rasterizeBins(ThreadHive& hive);
 
 	/// Fill the depth buffer with some values.
 	void fillDepthBuffer(ConstWeakArray<F32> depthValues);
 
-	/// Perform visibility tests.
+	/// Perform visibility tests. Call it after the bins are rasterized.
 	/// @param aabb The Aabb in of the cs in world space.
 	/// @return Return true if it's visible and false otherwise.
 	Bool visibilityTest(const Aabb& aabb) const;
 
 private:
+	/// The depth of a tile is represented by 2 layers. The reference layer covers all the pixels of the tile. The
+	/// working layer covers the pixels in the mask. Depth values are conservative, the actual depth is equal or closer.
+	class Tile
+	{
+	public:
+		U64 m_mask; ///< The pixels covered by the working layer. Bit (y * kTileSize + x).
+		F32 m_zMax0; ///< The depth of the reference layer.
+		F32 m_zMax1; ///< The depth of the working layer.
+	};
+
+	/// A triangle in window space ready to be rasterized.
+	class BinnedTriangle
+	{
+	public:
+		Array<F32, 3> m_edgeA; ///< Edge functions: a * x + b * y + c >= 0 if inside.
+		Array<F32, 3> m_edgeB;
+		Array<F32, 3> m_edgeC;
+		F32 m_z0; ///< The depth plane: m_z0 + m_dzdx * x + m_dzdy * y.
+		F32 m_dzdx;
+		F32 m_dzdy;
+		F32 m_zMax; ///< The max depth of the vertices.
+		Array<U16, 2> m_tileMin; ///< Inclusive.
+		Array<U16, 2> m_tileMax; ///< Inclusive.
+	};
+
+	/// The binned triangles of a single thread. Aligned to avoid false sharing.
+	class alignas(ANKI_CACHE_LINE_SIZE) ThreadBins
+	{
+	public:
+		DynamicArray<BinnedTriangle> m_triangles;
+		DynamicArray<DynamicArray<U32>> m_binTriangles; ///< Indices to m_triangles per bin.
+	};
+
+	class RasterizeCtx;
+
 	BaseMemoryPool* m_pool = nullptr;
 	Mat4 m_mv; ///< ModelView.
 	Mat4 m_p; ///< Projection.
 	Mat4 m_mvp;
+	Array<Vec4, 4> m_mvpColumns; ///< The columns of m_mvp to transform the AABBs faster.
 	Array<Plane, 6> m_planesL; ///< In view space.
 	Array<Plane, 6> m_planesW; ///< In world space.
 	U32 m_width;
 	U32 m_height;
-	DynamicArray<Atomic<U32>> m_zbuffer;
+	UVec2 m_tileCounts = UVec2(0u);
+	UVec2 m_binCounts = UVec2(0u);
+	DynamicArray<Tile> m_tiles;
+	Array<ThreadBins, ThreadHive::kMaxThreads> m_threadBins;
 
 	/// @param tri In clip space.
-	void rasterizeTriangle(const Vec4* tri);
+	void binTriangle(const Vec4* tri, U32 threadId);
+
+	/// Compute the pixels of a tile that are inside the triangle.
+	static U64 computeTileCoverage(const BinnedTriangle& tri, U32 tileX, U32 tileY);
 
-	Bool computeBarycetrinc(const Vec2& a, const Vec2& b, const Vec2& c, const Vec2& p, Vec3& uvw) const;
+	/// Merge the coverage of a triangle to a tile.
+	static void updateTile(Tile& tile, U64 coverage, F32 zMax);
 
 	/// Clip triangle in the near plane.
 	/// @note Triangles in view space.
 	void clipTriangle(const Vec4* inTriangle, Vec4* outTriangles, U& outTriangleCount) const;
 
+	void destroyBins();
+
 	Bool visibilityTestInternal(const Aabb& aabb) const;
+
+	static void rasterizeBinsTaskCallback(void* ud, U32 threadId, ThreadHive& hive, ThreadHiveSemaphore* sem);
 };
 /// @}
 
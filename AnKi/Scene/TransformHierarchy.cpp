@@ -0,0 +1,228 @@
+// Copyright (C) 2009-2022, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <AnKi/Scene/TransformHierarchy.h>
+#include <AnKi/Scene/SceneComponentStorage.h>
+#include <AnKi/Scene/SceneNode.h>
+#include <AnKi/Scene/Components/MoveComponent.h>
+#include <AnKi/Util/ThreadHive.h>
+#include <AnKi/Util/Tracer.h>
+
+namespace anki {
+
+class TransformHierarchy::UpdateCtx
+{
+public:
+	TransformHierarchy* m_hierarchy = nullptr;
+	Timestamp m_timestamp = 0;
+	U32 m_begin = 0;
+	U32 m_end = 0;
+	Atomic<U32> m_nextBatch = {0};
+};
+
+TransformHierarchy::~TransformHierarchy()
+{
+	if(m_pool)
+	{
+		m_components.destroy(*m_pool);
+		m_parents.destroy(*m_pool);
+		m_dirty.destroy(*m_pool);
+		m_levelOffsets.destroy(*m_pool);
+	}
+}
+
+void TransformHierarchy::rebuild(const SceneComponentStorage& storage)
+{
+	ANKI_TRACE_SCOPED_EVENT(SCENE_TRANSFORM_HIERARCHY_REBUILD);
+
+	const ConstWeakArray<SceneComponent*> comps = storage.getComponents(MoveComponent::getStaticClassId());
+	const ConstWeakArray<SceneNode*> nodes = storage.getComponentNodes(MoveComponent::getStaticClassId());
+	const U32 count = comps.getSize();
+
+	// Remember the old parents. The components that got a new parent need a new world transform
+	DynamicArrayRaii<const MoveComponent*> oldParents(m_pool, count);
+	for(U32 i = 0; i < count; ++i)
+	{
+		const MoveComponent* comp = static_cast<const MoveComponent*>(comps[i]);
+		const U32 idx = comp->m_hierarchyIndex;
+		const Bool known = idx < m_components.getSize() && m_components[idx] == comp;
+		oldParents[i] = (known && m_parents[idx] != kMaxU32) ? m_components[m_parents[idx]] : nullptr;
+	}
+
+	// Temporarily store the storage index in the components to find the parents fast
+	for(U32 i = 0; i < count; ++i)
+	{
+		static_cast<MoveComponent*>(comps[i])->m_hierarchyIndex = i;
+	}
+
+	// The parent of a MoveComponent is the 1st MoveComponent of the parent node
+	DynamicArrayRaii<U32> parents(m_pool, count);
+	for(U32 i = 0; i < count; ++i)
+	{
+		const SceneNode* parentNode = nodes[i]->getParent();
+		const MoveComponent* parentMove =
+			(parentNode) ? parentNode->tryGetFirstComponentOfType<MoveComponent>() : nullptr;
+		parents[i] = (parentMove) ? parentMove->m_hierarchyIndex : kMaxU32;
+
+		if(parentMove != oldParents[i])
+		{
+			static_cast<MoveComponent*>(comps[i])->m_markedForUpdate = true;
+		}
+	}
+
+	// Compute the depths. Walk up until a component with a known depth is found
+	DynamicArrayRaii<U32> depths(m_pool, count, kMaxU32);
+	U32 maxDepth = 0;
+	for(U32 i = 0; i < count; ++i)
+	{
+		U32 depth = 0;
+		U32 idx = i;
+		while(depths[idx] == kMaxU32 && parents[idx] != kMaxU32)
+		{
+			idx = parents[idx];
+			++depth;
+		}
+		depth += (depths[idx] == kMaxU32) ? 0 : depths[idx];
+
+		// Walk again and write the depths of the chain
+		idx = i;
+		while(depths[idx] == kMaxU32)
+		{
+			depths[idx] = depth;
+			maxDepth = max(maxDepth, depth);
+			if(depth == 0)
+			{
+				break;
+			}
+			idx = parents[idx];
+			--depth;
+		}
+	}
+
+	// Counting sort by depth
+	const U32 levelCount = (count) ? maxDepth + 1 : 0;
+	m_levelOffsets.resize(*m_pool, levelCount + 1, 0);
+	memset(m_levelOffsets.getBegin(), 0, m_levelOffsets.getSizeInBytes());
+	for(U32 i = 0; i < count; ++i)
+	{
+		++m_levelOffsets[depths[i] + 1];
+	}
+
+	for(U32 level = 1; level <= levelCount; ++level)
+	{
+		m_levelOffsets[level] += m_levelOffsets[level - 1];
+	}
+
+	DynamicArrayRaii<U32> remap(m_pool, count);
+	{
+		DynamicArrayRaii<U32> levelCursors(m_pool, levelCount);
+		for(U32 level = 0; level < levelCount; ++level)
+		{
+			levelCursors[level] = m_levelOffsets[level];
+		}
+
+		for(U32 i = 0; i < count; ++i)
+		{
+			remap[i] = levelCursors[depths[i]]++;
+		}
+	}
+
+	m_components.resize(*m_pool, count);
+	m_parents.resize(*m_pool, count);
+	m_dirty.resize(*m_pool, count);
+	for(U32 i = 0; i < count; ++i)
+	{
+		MoveComponent* comp = static_cast<MoveComponent*>(comps[i]);
+		comp->m_hierarchyIndex = remap[i];
+		m_components[remap[i]] = comp;
+		m_parents[remap[i]] = (parents[i] != kMaxU32) ? remap[parents[i]] : kMaxU32;
+		ANKI_ASSERT(m_parents[remap[i]] == kMaxU32 || m_parents[remap[i]] < m_levelOffsets[depths[i]]);
+	}
+
+	m_rebuild = false;
+}
+
+void TransformHierarchy::updateRange(U32 begin, U32 end, Timestamp timestamp)
+{
+	for(U32 i = begin; i < end; ++i)
+	{
+		MoveComponent& comp = *m_components[i];
+		const U32 parentIdx = m_parents[i];
+
+		// Parents are in previous levels so their dirty bits are final
+		const Bool parentDirty = parentIdx != kMaxU32 && m_dirty[parentIdx];
+		const Bool dirty = comp.m_markedForUpdate || parentDirty;
+		m_dirty[i] = dirty;
+
+		comp.m_prevWTrf = comp.m_wtrf;
+		comp.m_hierarchyUpdateTimestamp = timestamp;
+		comp.m_worldTransformUpdated = dirty;
+
+		if(dirty)
+		{
+			comp.computeWorldTransform((parentIdx != kMaxU32) ? m_components[parentIdx] : nullptr);
+			comp.m_markedForUpdate = false;
+		}
+	}
+}
+
+void TransformHierarchy::updateLevelTaskCallback(void* ud, [[maybe_unused]] U32 threadId,
+												 [[maybe_unused]] ThreadHive& hive,
+												 [[maybe_unused]] ThreadHiveSemaphore* sem)
+{
+	constexpr U32 kBatchSize = kParallelThreshold / 4;
+	UpdateCtx& ctx = *static_cast<UpdateCtx*>(ud);
+
+	U32 begin;
+	while((begin = ctx.m_begin + ctx.m_nextBatch.fetchAdd(1) * kBatchSize) < ctx.m_end)
+	{
+		ctx.m_hierarchy->updateRange(begin, min(begin + kBatchSize, ctx.m_end), ctx.m_timestamp);
+	}
+}
+
+void TransformHierarchy::update(const SceneComponentStorage& storage, Timestamp timestamp, ThreadHive& hive)
+{
+	ANKI_ASSERT(m_pool);
+	ANKI_TRACE_SCOPED_EVENT(SCENE_TRANSFORM_HIERARCHY_UPDATE);
+
+	if(m_rebuild)
+	{
+		rebuild(storage);
+	}
+
+	ANKI_ASSERT(m_components.getSize() == storage.getComponentCount(MoveComponent::getStaticClassId()));
+
+	// Process one level at a time. The next level needs the world transforms of this one
+	for(U32 level = 0; level < getLevelCount(); ++level)
+	{
+		const U32 begin = m_levelOffsets[level];
+		const U32 end = m_levelOffsets[level + 1];
+		const U32 taskCount = min(hive.getThreadCount(), (end - begin) / (kParallelThreshold / 4));
+
+		if(end - begin < kParallelThreshold || taskCount <= 1)
+		{
+			updateRange(begin, end, timestamp);
+			continue;
+		}
+
+		UpdateCtx ctx;
+		ctx.m_hierarchy = this;
+		ctx.m_timestamp = timestamp;
+		ctx.m_begin = begin;
+		ctx.m_end = end;
+
+		Array<ThreadHiveTask, ThreadHive::kMaxThreads> tasks;
+		for(U32 i = 0; i < taskCount; ++i)
+		{
+			tasks[i].m_argument = &ctx;
+			tasks[i].m_callback = updateLevelTaskCallback;
+		}
+
+		hive.submitTasks(&tasks[0], taskCount);
+		hive.waitAllTasks();
+	}
+}
+
+} // end namespace anki
@@ -0,0 +1,80 @@
+// Copyright (C) 2009-2022, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#pragma once
+
+#include <AnKi/Scene/Common.h>
+#include <AnKi/Util/DynamicArray.h>
+
+namespace anki {
+
+// Forward
+class MoveComponent;
+class SceneComponentStorage;
+class ThreadHive;
+class ThreadHiveSemaphore;
+
+/// @addtogroup scene
+/// @{
+
+/// Updates the world transforms of all MoveComponents before the scene nodes get updated. It flattens the node
+/// hierarchies into arrays of MoveComponents sorted by depth so every depth level can be processed in parallel no
+/// matter how big a single hierarchy is. Dirtiness is propagated with one bit per component so clean components are
+/// cheap to skip.
+class TransformHierarchy
+{
+public:
+	/// Levels with less components than that will be updated serially.
+	static constexpr U32 kParallelThreshold = 256;
+
+	TransformHierarchy() = default;
+
+	TransformHierarchy(const TransformHierarchy&) = delete; // Non-copyable
+
+	~TransformHierarchy();
+
+	TransformHierarchy& operator=(const TransformHierarchy&) = delete; // Non-copyable
+
+	void init(HeapMemoryPool* pool)
+	{
+		ANKI_ASSERT(pool);
+		m_pool = pool;
+	}
+
+	/// The node hierarchy or the MoveComponents changed. The depth-sorted arrays will be rebuilt on the next update.
+	void invalidate()
+	{
+		m_rebuild = true;
+	}
+
+	/// Update the world transforms of all dirty MoveComponents. Don't call it from a ThreadHive task.
+	void update(const SceneComponentStorage& storage, Timestamp timestamp, ThreadHive& hive);
+
+	U32 getLevelCount() const
+	{
+		return (m_levelOffsets.getSize()) ? m_levelOffsets.getSize() - 1 : 0;
+	}
+
+private:
+	class UpdateCtx;
+
+	HeapMemoryPool* m_pool = nullptr;
+
+	DynamicArray<MoveComponent*> m_components; ///< Sorted by depth.
+	DynamicArray<U32> m_parents; ///< The index of the parent MoveComponent in m_components or kMaxU32.
+	DynamicArray<U8> m_dirty; ///< If the component or one of its ancestors moved this frame.
+	DynamicArray<U32> m_levelOffsets; ///< Where every depth level starts in m_components. Has an extra last element.
+
+	Bool m_rebuild = true;
+
+	void rebuild(const SceneComponentStorage& storage);
+
+	void updateRange(U32 begin, U32 end, Timestamp timestamp);
+
+	static void updateLevelTaskCallback(void* ud, U32 threadId, ThreadHive& hive, ThreadHiveSemaphore* sem);
+};
+/// @}
+
+} // end namespace anki
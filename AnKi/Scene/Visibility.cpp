@@ -21,6 +21,7 @@
 #include <AnKi/Renderer/MainRenderer.h>
 #include <AnKi/Util/Logger.h>
 #include <AnKi/Util/ThreadHive.h>
+#include <AnKi/Util/RadixSort.h>
 #include <AnKi/Core/ConfigSet.h>
 
 namespace anki {
@@ -72,6 +73,15 @@ static Bool spatialInsideFrustum(const FrustumComponent& frc, const SpatialCompo
 	}
 }
 
+/// Check if the visible spatials of the previous frame can be re-used.
+static Bool visibleSpatialsCacheValid(const FrustumComponent& frc, const SceneGraph& scene)
+{
+	const FrustumComponent::VisibleSpatialsCache& cache = frc.getVisibleSpatialsCache();
+	return cache.m_timestamp != 0 && cache.m_timestamp == scene.getPreviousGlobalTimestamp()
+		   && frc.getTimestamp() <= cache.m_timestamp && cache.m_flags == frc.getEnabledVisibilityTests()
+		   && cache.m_spatialRemovalCount == scene.getSpatialRemovalCount();
+}
+
 /// Used to silent warnings
 template<typename TComponent>
 Bool getComponent(SceneNode& node, TComponent*& comp)
@@ -80,96 +90,154 @@ Bool getComponent(SceneNode& node, TComponent*& comp)
 	return comp != nullptr;
 }
 
-void VisibilityContext::submitNewWork(const FrustumComponent& frc, const FrustumComponent& primaryFrustum,
-									  RenderQueue& rqueue, ThreadHive& hive)
+void VisibilityContext::submitNewWork(ConstWeakArray<const FrustumComponent*> frcs,
+									  const FrustumComponent& primaryFrustum, ConstWeakArray<RenderQueue*> rqueues,
+									  ThreadHive& hive)
 {
 	ANKI_TRACE_SCOPED_EVENT(SCENE_VIS_SUBMIT_WORK);
+	ANKI_ASSERT(frcs.getSize() == rqueues.getSize());
 
-	// Check enabled and make sure that the results are null (this can happen on multiple on circular viewing)
-	if(ANKI_UNLIKELY(frc.getEnabledVisibilityTests() == FrustumComponentVisibilityTestFlag::kNone))
-	{
-		return;
-	}
+	StackMemoryPool& pool = m_scene->getFrameMemoryPool();
 
-	rqueue.m_cameraTransform = Mat3x4(frc.getWorldTransform());
-	rqueue.m_viewMatrix = frc.getViewMatrix();
-	rqueue.m_projectionMatrix = frc.getProjectionMatrix();
-	rqueue.m_viewProjectionMatrix = frc.getViewProjectionMatrix();
-	rqueue.m_previousViewProjectionMatrix = frc.getPreviousViewProjectionMatrix();
-	rqueue.m_cameraNear = frc.getNear();
-	rqueue.m_cameraFar = frc.getFar();
-	if(frc.getFrustumType() == FrustumType::kPerspective)
-	{
-		rqueue.m_cameraFovX = frc.getFovX();
-		rqueue.m_cameraFovY = frc.getFovY();
-	}
-	else
+	// Frustums without a S/W rasterizer are batched to share the octree walk
+	GatherVisiblesFromOctreeTask* batchGatherTask = nullptr;
+	auto submitBatch = [&]() {
+		if(batchGatherTask)
+		{
+			ThreadHiveTask gatherTask =
+				ANKI_THREAD_HIVE_TASK({ self->gather(hive); }, batchGatherTask, nullptr, nullptr);
+			hive.submitTasks(&gatherTask, 1);
+			batchGatherTask = nullptr;
+		}
+	};
+
+	for(U32 i = 0; i < frcs.getSize(); ++i)
 	{
-		rqueue.m_cameraFovX = rqueue.m_cameraFovY = 0.0f;
-	}
+		const FrustumComponent& frc = *frcs[i];
+		RenderQueue& rqueue = *rqueues[i];
 
-	StackMemoryPool& pool = m_scene->getFrameMemoryPool();
+		// Check enabled and make sure that the results are null (this can happen on multiple on circular viewing)
+		if(ANKI_UNLIKELY(frc.getEnabledVisibilityTests() == FrustumComponentVisibilityTestFlag::kNone))
+		{
+			continue;
+		}
 
-	// Check if this frc was tested before
-	{
-		LockGuard<Mutex> l(m_mtx);
+		rqueue.m_cameraTransform = Mat3x4(frc.getWorldTransform());
+		rqueue.m_viewMatrix = frc.getViewMatrix();
+		rqueue.m_projectionMatrix = frc.getProjectionMatrix();
+		rqueue.m_viewProjectionMatrix = frc.getViewProjectionMatrix();
+		rqueue.m_previousViewProjectionMatrix = frc.getPreviousViewProjectionMatrix();
+		rqueue.m_cameraNear = frc.getNear();
+		rqueue.m_cameraFar = frc.getFar();
+		if(frc.getFrustumType() == FrustumType::kPerspective)
+		{
+			rqueue.m_cameraFovX = frc.getFovX();
+			rqueue.m_cameraFovY = frc.getFovY();
+		}
+		else
+		{
+			rqueue.m_cameraFovX = rqueue.m_cameraFovY = 0.0f;
+		}
 
-		// Check if already in the list
-		for(const FrustumComponent* x : m_testedFrcs)
+		// Check if this frc was tested before
 		{
-			if(x == &frc)
+			LockGuard<Mutex> l(m_mtx);
+
+			// Check if already in the list
+			Bool tested = false;
+			for(const FrustumComponent* x : m_testedFrcs)
 			{
-				return;
+				if(x == &frc)
+				{
+					tested = true;
+					break;
+				}
+			}
+
+			if(tested)
+			{
+				continue;
 			}
+
+			// Not there, push it
+			m_testedFrcs.pushBack(pool, &frc);
 		}
 
-		// Not there, push it
-		m_testedFrcs.pushBack(pool, &frc);
-	}
+		// Prepare the ctx
+		FrustumVisibilityContext* frcCtx = newInstance<FrustumVisibilityContext>(pool);
+		frcCtx->m_visCtx = this;
+		frcCtx->m_frc = &frc;
+		frcCtx->m_primaryFrustum = &primaryFrustum;
+		frcCtx->m_queueViews.create(pool, hive.getThreadCount());
+		frcCtx->m_visTestsSignalSem = hive.newSemaphore(1);
+		frcCtx->m_renderQueue = &rqueue;
 
-	// Prepare the ctx
-	FrustumVisibilityContext* frcCtx = newInstance<FrustumVisibilityContext>(pool);
-	frcCtx->m_visCtx = this;
-	frcCtx->m_frc = &frc;
-	frcCtx->m_primaryFrustum = &primaryFrustum;
-	frcCtx->m_queueViews.create(pool, hive.getThreadCount());
-	frcCtx->m_visTestsSignalSem = hive.newSemaphore(1);
-	frcCtx->m_renderQueue = &rqueue;
+		// Submit new work
+		//
 
-	// Submit new work
-	//
+		if(!!(frc.getEnabledVisibilityTests() & FrustumComponentVisibilityTestFlag::kOccluders))
+		{
+			rqueue.m_fillCoverageBufferCallback = FrustumComponent::fillCoverageBufferCallback;
+			rqueue.m_fillCoverageBufferCallbackUserData = static_cast<void*>(const_cast<FrustumComponent*>(&frc));
+		}
 
-	// Software rasterizer task
-	ThreadHiveSemaphore* prepareRasterizerSem = nullptr;
-	if(!!(frc.getEnabledVisibilityTests() & FrustumComponentVisibilityTestFlag::kOccluders) && frc.hasCoverageBuffer())
-	{
-		// Gather triangles task
-		ThreadHiveTask fillDepthTask =
-			ANKI_THREAD_HIVE_TASK({ self->fill(); }, newInstance<FillRasterizerWithCoverageTask>(pool, frcCtx), nullptr,
-								  hive.newSemaphore(1));
+		const Bool useRasterizer =
+			!!(frc.getEnabledVisibilityTests() & FrustumComponentVisibilityTestFlag::kOccluders)
+			&& frc.hasCoverageBuffer();
 
-		hive.submitTasks(&fillDepthTask, 1);
+		// The coverage buffer changes every frame so the frustums that use it can't re-use the previous results
+		frcCtx->m_updateVisibleSpatialsCache =
+			m_scene->getIncrementalVisibilityEnabled() && !useRasterizer && frc.isRegistered();
 
-		prepareRasterizerSem = fillDepthTask.m_signalSemaphore;
-	}
+		if(useRasterizer)
+		{
+			// Software rasterizer task
+			ThreadHiveTask fillDepthTask =
+				ANKI_THREAD_HIVE_TASK({ self->fill(); }, newInstance<FillRasterizerWithCoverageTask>(pool, frcCtx),
+									  nullptr, hive.newSemaphore(1));
+
+			hive.submitTasks(&fillDepthTask, 1);
+
+			// Gather visibles from the octree after the rasterizer is ready. No need to signal anything because it will
+			// spawn new tasks
+			ThreadHiveTask gatherTask =
+				ANKI_THREAD_HIVE_TASK({ self->gather(hive); }, newInstance<GatherVisiblesFromOctreeTask>(pool, frcCtx),
+									  fillDepthTask.m_signalSemaphore, nullptr);
+			hive.submitTasks(&gatherTask, 1);
+		}
+		else if(frcCtx->m_updateVisibleSpatialsCache && visibleSpatialsCacheValid(frc, *m_scene))
+		{
+			// Nothing changed for the frustum, start from the results of the previous frame
+			ThreadHiveTask gatherTask =
+				ANKI_THREAD_HIVE_TASK({ self->gather(hive); }, newInstance<GatherVisiblesFromCacheTask>(pool, frcCtx),
+									  nullptr, nullptr);
+			hive.submitTasks(&gatherTask, 1);
+		}
+		else
+		{
+			// Gather visibles from the octree along with other frustums
+			if(batchGatherTask == nullptr)
+			{
+				batchGatherTask = newInstance<GatherVisiblesFromOctreeTask>(pool);
+			}
 
-	if(!!(frc.getEnabledVisibilityTests() & FrustumComponentVisibilityTestFlag::kOccluders))
-	{
-		rqueue.m_fillCoverageBufferCallback = FrustumComponent::fillCoverageBufferCallback;
-		rqueue.m_fillCoverageBufferCallbackUserData = static_cast<void*>(const_cast<FrustumComponent*>(&frc));
-	}
+			batchGatherTask->addFrustum(frcCtx);
+
+			if(batchGatherTask->m_frcCtxCount == kMaxFrustumsPerOctreeWalk)
+			{
+				submitBatch();
+			}
+		}
 
-	// Gather visibles from the octree. No need to signal anything because it will spawn new tasks
-	ThreadHiveTask gatherTask =
-		ANKI_THREAD_HIVE_TASK({ self->gather(hive); }, newInstance<GatherVisiblesFromOctreeTask>(pool, frcCtx),
-							  prepareRasterizerSem, nullptr);
-	hive.submitTasks(&gatherTask, 1);
+		// Combind results task
+		ANKI_ASSERT(frcCtx->m_visTestsSignalSem);
+		ThreadHiveTask combineTask =
+			ANKI_THREAD_HIVE_TASK({ self->combine(hive); }, newInstance<CombineResultsTask>(pool, frcCtx),
+								  frcCtx->m_visTestsSignalSem, nullptr);
+		hive.submitTasks(&combineTask, 1);
+	}
 
-	// Combind results task
-	ANKI_ASSERT(frcCtx->m_visTestsSignalSem);
-	ThreadHiveTask combineTask = ANKI_THREAD_HIVE_TASK(
-		{ self->combine(); }, newInstance<CombineResultsTask>(pool, frcCtx), frcCtx->m_visTestsSignalSem, nullptr);
-	hive.submitTasks(&combineTask, 1);
+	submitBatch();
 }
 
 void FillRasterizerWithCoverageTask::fill()
@@ -201,45 +269,154 @@ void FillRasterizerWithCoverageTask::fill()
 void GatherVisiblesFromOctreeTask::gather(ThreadHive& hive)
 {
 	ANKI_TRACE_SCOPED_EVENT(SCENE_VIS_OCTREE);
+	ANKI_ASSERT(m_frcCtxCount > 0);
 
-	U32 testIdx = m_frcCtx->m_visCtx->m_testsCount.fetchAdd(1);
+	VisibilityContext& visCtx = *m_frcCtxs[0]->m_visCtx;
 
-	// Walk the tree
-	m_frcCtx->m_visCtx->m_scene->getOctree().walkTree(
-		testIdx,
-		[&](const Aabb& box) {
-			Bool visible = m_frcCtx->m_frc->insideFrustum(box);
-			if(visible && m_frcCtx->m_r)
+	// Walk the tree once for all frustums. The whole walk is a single test of the octree so a frame can have
+	// OctreePlaceable::kMaxTests walks of kMaxFrustumsPerOctreeWalk frustums each
+	const U32 testId = visCtx.m_testsCount.fetchAdd(1);
+	if(testId >= OctreePlaceable::kMaxTests)
+	{
+		ANKI_SCENE_LOGE("Too many octree walks in a single frame. Some frustums will see nothing");
+	}
+	else
+	{
+		walkOctree(testId, hive);
+	}
+
+	for(U32 i = 0; i < m_frcCtxCount; ++i)
+	{
+		// Flush the remaining
+		flush(i, hive);
+
+		// Fire an additional dummy task to decrease the semaphore to zero
+		GatherVisiblesFromOctreeTask* pself = this; // MSVC workaround
+		ThreadHiveTask task = ANKI_THREAD_HIVE_TASK({}, pself, nullptr, m_frcCtxs[i]->m_visTestsSignalSem);
+		hive.submitTasks(&task, 1);
+	}
+}
+
+void GatherVisiblesFromOctreeTask::walkOctree(U32 testId, ThreadHive& hive)
+{
+	m_frcCtxs[0]->m_visCtx->m_scene->getOctree().walkTreeMulti(
+		testId, m_frcCtxCount,
+		[&](const Aabb& box, U32 testMask) {
+			U32 visibleMask = 0;
+			while(testMask)
 			{
-				visible = m_frcCtx->m_r->visibilityTest(box);
+				const U32 i = U32(__builtin_ctz(testMask));
+				testMask &= testMask - 1u;
+
+				const FrustumVisibilityContext& frcCtx = *m_frcCtxs[i];
+				Bool visible = frcCtx.m_frc->insideFrustum(box);
+				if(visible && frcCtx.m_r)
+				{
+					visible = frcCtx.m_r->visibilityTest(box);
+				}
+
+				visibleMask |= U32(visible) << i;
 			}
 
-			return visible;
+			return visibleMask;
 		},
-		[&](void* placeableUserData) {
+		[&](void* placeableUserData, U32 testMask) {
 			ANKI_ASSERT(placeableUserData);
 			SpatialComponent* scomp = static_cast<SpatialComponent*>(placeableUserData);
 
-			ANKI_ASSERT(m_spatialCount < m_spatials.getSize());
+			while(testMask)
+			{
+				const U32 i = U32(__builtin_ctz(testMask));
+				testMask &= testMask - 1u;
+
+				Spatials& spatials = m_spatials[i];
+				ANKI_ASSERT(spatials.m_spatialCount < spatials.m_spatials.getSize());
 
-			m_spatials[m_spatialCount++] = scomp;
+				spatials.m_spatials[spatials.m_spatialCount++] = scomp;
 
-			if(m_spatialCount == m_spatials.getSize())
-			{
-				flush(hive);
+				if(spatials.m_spatialCount == spatials.m_spatials.getSize())
+				{
+					flush(i, hive);
+				}
 			}
 		});
+}
+
+void GatherVisiblesFromOctreeTask::flush(U32 frustumIdx, ThreadHive& hive)
+{
+	Spatials& spatials = m_spatials[frustumIdx];
+	if(spatials.m_spatialCount)
+	{
+		FrustumVisibilityContext* frcCtx = m_frcCtxs[frustumIdx];
+
+		// Create the task
+		VisibilityTestTask* vis =
+			newInstance<VisibilityTestTask>(frcCtx->m_visCtx->m_scene->getFrameMemoryPool(), frcCtx);
+		memcpy(&vis->m_spatialsToTest[0], &spatials.m_spatials[0],
+			   sizeof(spatials.m_spatials[0]) * spatials.m_spatialCount);
+		vis->m_spatialToTestCount = spatials.m_spatialCount;
+
+		// Increase the semaphore to block the CombineResultsTask
+		frcCtx->m_visTestsSignalSem->increaseSemaphore(1);
+
+		// Submit task
+		ThreadHiveTask task =
+			ANKI_THREAD_HIVE_TASK({ self->test(threadId); }, vis, nullptr, frcCtx->m_visTestsSignalSem);
+		hive.submitTasks(&task, 1);
+
+		// Clear count
+		spatials.m_spatialCount = 0;
+	}
+}
+
+void GatherVisiblesFromCacheTask::gather(ThreadHive& hive)
+{
+	ANKI_TRACE_SCOPED_EVENT(SCENE_VIS_CACHE);
+
+	const SceneGraph& scene = *m_frcCtx->m_visCtx->m_scene;
+	const Timestamp crntTimestamp = scene.getGlobalTimestamp();
+
+	// The spatials that were visible and didn't move are still visible. The rest will be visited bellow
+	for(SpatialComponent* spatial : m_frcCtx->m_frc->getVisibleSpatialsCache().m_spatials)
+	{
+		if(spatial->getTimestamp() != crntTimestamp)
+		{
+			addSpatial(spatial, true, hive);
+			++m_frcCtx->m_reusedSpatialCount;
+		}
+	}
+
+	// The spatials that moved need to be tested
+	for(U32 threadId = 0; threadId < hive.getThreadCount(); ++threadId)
+	{
+		for(SpatialComponent* spatial : scene.getUpdatedSpatials(threadId))
+		{
+			addSpatial(spatial, false, hive);
+		}
+	}
 
 	// Flush the remaining
 	flush(hive);
 
 	// Fire an additional dummy task to decrease the semaphore to zero
-	GatherVisiblesFromOctreeTask* pself = this; // MSVC workaround
+	GatherVisiblesFromCacheTask* pself = this; // MSVC workaround
 	ThreadHiveTask task = ANKI_THREAD_HIVE_TASK({}, pself, nullptr, m_frcCtx->m_visTestsSignalSem);
 	hive.submitTasks(&task, 1);
 }
 
-void GatherVisiblesFromOctreeTask::flush(ThreadHive& hive)
+void GatherVisiblesFromCacheTask::addSpatial(SpatialComponent* spatial, Bool knownVisible, ThreadHive& hive)
+{
+	ANKI_ASSERT(m_spatialCount < m_spatials.getSize());
+	m_knownVisibleMask |= U64(knownVisible) << U64(m_spatialCount);
+	m_spatials[m_spatialCount++] = spatial;
+
+	if(m_spatialCount == m_spatials.getSize())
+	{
+		flush(hive);
+	}
+}
+
+void GatherVisiblesFromCacheTask::flush(ThreadHive& hive)
 {
 	if(m_spatialCount)
 	{
@@ -248,21 +425,23 @@ void GatherVisiblesFromOctreeTask::flush(ThreadHive& hive)
 			newInstance<VisibilityTestTask>(m_frcCtx->m_visCtx->m_scene->getFrameMemoryPool(), m_frcCtx);
 		memcpy(&vis->m_spatialsToTest[0], &m_spatials[0], sizeof(m_spatials[0]) * m_spatialCount);
 		vis->m_spatialToTestCount = m_spatialCount;
+		vis->m_knownVisibleMask = m_knownVisibleMask;
 
 		// Increase the semaphore to block the CombineResultsTask
 		m_frcCtx->m_visTestsSignalSem->increaseSemaphore(1);
 
 		// Submit task
 		ThreadHiveTask task =
-			ANKI_THREAD_HIVE_TASK({ self->test(hive, threadId); }, vis, nullptr, m_frcCtx->m_visTestsSignalSem);
+			ANKI_THREAD_HIVE_TASK({ self->test(threadId); }, vis, nullptr, m_frcCtx->m_visTestsSignalSem);
 		hive.submitTasks(&task, 1);
 
-		// Clear count
+		// Clear
 		m_spatialCount = 0;
+		m_knownVisibleMask = 0;
 	}
 }
 
-void VisibilityTestTask::test(ThreadHive& hive, U32 taskId)
+void VisibilityTestTask::test(U32 taskId)
 {
 	ANKI_TRACE_SCOPED_EVENT(SCENE_VIS_TEST);
 
@@ -281,6 +460,12 @@ void VisibilityTestTask::test(ThreadHive& hive, U32 taskId)
 	const Bool wantsEarlyZ =
 		!!(frustumFlags & FrustumComponentVisibilityTestFlag::kEarlyZ) && m_frcCtx->m_visCtx->m_earlyZDist > 0.0f;
 
+	// The primary frustum owns the LOD hysteresis and counts the triangles for the LOD budget
+	const SceneGraph& scene = *m_frcCtx->m_visCtx->m_scene;
+	const Bool isPrimaryFrustum = &testedFrc == &primaryFrc;
+	const Bool screenSpaceErrorLod = m_frcCtx->m_visCtx->m_screenSpaceErrorLod;
+	U64 primaryTriangleCount = 0;
+
 	// Iterate
 	RenderQueueView& result = m_frcCtx->m_queueViews[taskId];
 	for(U i = 0; i < m_spatialToTestCount; ++i)
@@ -289,6 +474,12 @@ void VisibilityTestTask::test(ThreadHive& hive, U32 taskId)
 		ANKI_ASSERT(spatialC);
 		SceneNode& node = spatialC->getSceneNode();
 
+		// Remember everything that is not rejected by the frustum tests bellow. It will be re-used next frame
+		if(m_frcCtx->m_updateVisibleSpatialsCache)
+		{
+			*result.m_visibleSpatials.newElement(pool) = spatialC;
+		}
+
 		// Skip if it is the same
 		if(ANKI_UNLIKELY(&testedNode == &node))
 		{
@@ -351,9 +542,16 @@ void VisibilityTestTask::test(ThreadHive& hive, U32 taskId)
 			continue;
 		}
 
-		if(!spatialc->getAlwaysVisible()
+		const Bool knownVisible = !!(m_knownVisibleMask & (U64(1) << U64(i)));
+		if(!spatialc->getAlwaysVisible() && !knownVisible
 		   && (!spatialInsideFrustum(testedFrc, *spatialc) || !testAgainstRasterizer(spatialc->getAabbWorldSpace())))
 		{
+			if(m_frcCtx->m_updateVisibleSpatialsCache)
+			{
+				// Rejected, forget it
+				--result.m_visibleSpatials.m_elementCount;
+			}
+
 			continue;
 		}
 
@@ -379,7 +577,29 @@ void VisibilityTestTask::test(ThreadHive& hive, U32 taskId)
 										   ? primaryFrc.getFar()
 										   : max(0.0f, testPlane(nearPlane, spatialc->getAabbWorldSpace()));
 
-			el->m_lod = computeLod(primaryFrc, el->m_distanceFromCamera);
+			if(screenSpaceErrorLod && rc.getLodErrors().getSize())
+			{
+				const Aabb& aabb = spatialc->getAabbWorldSpace();
+				const Vec3 sphereCenter = ((aabb.getMin() + aabb.getMax()) * 0.5f).xyz();
+				const F32 sphereRadius = ((aabb.getMax() - aabb.getMin()) * 0.5f).getLength();
+				const U8 prevLod = rc.getPreviousLod(scene.getGlobalTimestamp(), scene.getPreviousGlobalTimestamp());
+
+				el->m_lod = scene.getLodPolicy().selectLod(rc.getLodErrors(), sphereCenter, sphereRadius, prevLod);
+
+				if(isPrimaryFrustum)
+				{
+					rc.setCurrentLod(el->m_lod, scene.getGlobalTimestamp());
+				}
+			}
+			else
+			{
+				el->m_lod = computeLod(primaryFrc, el->m_distanceFromCamera);
+			}
+
+			if(isPrimaryFrustum)
+			{
+				primaryTriangleCount += rc.getTriangleCount(el->m_lod);
+			}
 
 			// Add to early Z
 			if(wantsEarlyZ && el->m_distanceFromCamera < m_frcCtx->m_visCtx->m_earlyZDist
@@ -608,7 +828,7 @@ void VisibilityTestTask::test(ThreadHive& hive, U32 taskId)
 			result.m_skyboxSet = true;
 		}
 
-		// Add more frustums to the list
+		// Add more frustums to the list. They will be submitted all together when the results get combined
 		if(nextQueues.getSize() > 0)
 		{
 			U32 count = 0;
@@ -616,14 +836,18 @@ void VisibilityTestTask::test(ThreadHive& hive, U32 taskId)
 			if(ANKI_LIKELY(nextQueueFrustumComponents.getSize() == 0))
 			{
 				node.iterateComponentsOfType<FrustumComponent>([&](FrustumComponent& frc) {
-					m_frcCtx->m_visCtx->submitNewWork(frc, primaryFrc, nextQueues[count++], hive);
+					NextFrustum* el = result.m_nextFrustums.newElement(pool);
+					el->m_frc = &frc;
+					el->m_renderQueue = &nextQueues[count++];
 				});
 			}
 			else
 			{
 				for(FrustumComponent& frc : nextQueueFrustumComponents)
 				{
-					m_frcCtx->m_visCtx->submitNewWork(frc, primaryFrc, nextQueues[count++], hive);
+					NextFrustum* el = result.m_nextFrustums.newElement(pool);
+					el->m_frc = &frc;
+					el->m_renderQueue = &nextQueues[count++];
 				}
 			}
 		}
@@ -631,17 +855,83 @@ void VisibilityTestTask::test(ThreadHive& hive, U32 taskId)
 		// Update timestamp
 		timestamp = max(timestamp, node.getComponentMaxTimestamp());
 	} // end for
+
+	if(primaryTriangleCount)
+	{
+		m_frcCtx->m_visCtx->m_primaryTriangleCount.fetchAdd(primaryTriangleCount);
+	}
 }
 
-void CombineResultsTask::combine()
+void CombineResultsTask::combine(ThreadHive& hive)
 {
 	ANKI_TRACE_SCOPED_EVENT(SCENE_VIS_COMBINE_RESULTS);
 
 	StackMemoryPool& pool = m_frcCtx->m_visCtx->m_scene->getFrameMemoryPool();
 	RenderQueue& results = *m_frcCtx->m_renderQueue;
+	const U32 threadCount = m_frcCtx->m_queueViews.getSize();
+
+	// Submit the frustums found by the tests first so they can start early. Submitting them all together allows
+	// frustums of different lights to share octree walks
+	U32 nextFrustumCount = 0;
+	for(U32 i = 0; i < threadCount; ++i)
+	{
+		nextFrustumCount += m_frcCtx->m_queueViews[i].m_nextFrustums.m_elementCount;
+	}
+
+	if(nextFrustumCount)
+	{
+		const FrustumComponent** nextFrcs = newArray<const FrustumComponent*>(pool, nextFrustumCount);
+		RenderQueue** nextQueues = newArray<RenderQueue*>(pool, nextFrustumCount);
+		U32 count = 0;
+		for(U32 i = 0; i < threadCount; ++i)
+		{
+			const TRenderQueueElementStorage<NextFrustum>& storage = m_frcCtx->m_queueViews[i].m_nextFrustums;
+			for(U32 j = 0; j < storage.m_elementCount; ++j)
+			{
+				nextFrcs[count] = storage.m_elements[j].m_frc;
+				nextQueues[count] = storage.m_elements[j].m_renderQueue;
+				++count;
+			}
+		}
+
+		m_frcCtx->m_visCtx->submitNewWork(ConstWeakArray<const FrustumComponent*>(nextFrcs, nextFrustumCount),
+										  *m_frcCtx->m_primaryFrustum,
+										  ConstWeakArray<RenderQueue*>(nextQueues, nextFrustumCount), hive);
+	}
+
+	// Keep the visible spatials for the next frame
+	if(m_frcCtx->m_updateVisibleSpatialsCache)
+	{
+		const FrustumComponent& frc = *m_frcCtx->m_frc;
+		const SceneGraph& scene = *m_frcCtx->m_visCtx->m_scene;
+		FrustumComponent::VisibleSpatialsCache& cache = frc.getVisibleSpatialsCache();
+
+		U32 visibleCount = 0;
+		for(U32 i = 0; i < threadCount; ++i)
+		{
+			visibleCount += m_frcCtx->m_queueViews[i].m_visibleSpatials.m_elementCount;
+		}
+
+		cache.m_spatials.resize(frc.getSceneNode().getMemoryPool(), visibleCount);
+		U32 count = 0;
+		for(U32 i = 0; i < threadCount; ++i)
+		{
+			const TRenderQueueElementStorage<SpatialComponent*>& storage = m_frcCtx->m_queueViews[i].m_visibleSpatials;
+			if(storage.m_elementCount)
+			{
+				memcpy(&cache.m_spatials[count], storage.m_elements,
+					   sizeof(SpatialComponent*) * storage.m_elementCount);
+				count += storage.m_elementCount;
+			}
+		}
+
+		cache.m_timestamp = scene.getGlobalTimestamp();
+		cache.m_spatialRemovalCount = scene.getSpatialRemovalCount();
+		cache.m_flags = frc.getEnabledVisibilityTests();
+		cache.m_reusedSpatialCount = m_frcCtx->m_reusedSpatialCount;
+	}
 
 	// Compute the timestamp
-	const U32 threadCount = m_frcCtx->m_queueViews.getSize();
 	results.m_shadowRenderablesLastUpdateTimestamp = 0;
 	for(U32 i = 0; i < threadCount; ++i)
 	{
@@ -693,16 +983,39 @@ void CombineResultsTask::combine()
 	const Bool isShadowFrustum = !!(m_frcCtx->m_frc->getEnabledVisibilityTests()
 									& FrustumComponentVisibilityTestFlag::kShadowCasterRenderComponents);
 
-	// Sort some of the arrays
+	// Sort some of the arrays. The big ones will be sorted by other tasks while the rest of the frustums are tested
 	if(!isShadowFrustum)
 	{
-		std::sort(results.m_renderables.getBegin(), results.m_renderables.getEnd(), MaterialDistanceSortFunctor());
-
-		std::sort(results.m_earlyZRenderables.getBegin(), results.m_earlyZRenderables.getEnd(),
-				  DistanceSortFunctor<RenderableQueueElement>());
-
-		std::sort(results.m_forwardShadingRenderables.getBegin(), results.m_forwardShadingRenderables.getEnd(),
-				  RevDistanceSortFunctor<RenderableQueueElement>());
+		sortRenderables<U64>(
+			pool, results.m_renderables,
+			[](const RenderableQueueElement& el) {
+				return el.computeMaterialSortKey();
+			},
+			hive);
+
+		sortRenderables<U32>(
+			pool, results.m_earlyZRenderables,
+			[](const RenderableQueueElement& el) {
+				return el.computeDistanceSortKey();
+			},
+			hive);
+
+		sortRenderables<U32>(
+			pool, results.m_forwardShadingRenderables,
+			[](const RenderableQueueElement& el) {
+				return ~el.computeDistanceSortKey();
+			},
+			hive);
+	}
+	else
+	{
+		// Sort by material as well to help merging
+		sortRenderables<U64>(
+			pool, results.m_renderables,
+			[](const RenderableQueueElement& el) {
+				return el.computeMaterialSortKey();
+			},
+			hive);
 	}
 
 	std::sort(results.m_giProbes.getBegin(), results.m_giProbes.getEnd());
@@ -739,6 +1052,71 @@ void CombineResultsTask::combine()
 	}
 }
 
+template<typename TKey>
+class CombineResultsTask::SortRenderablesCtx
+{
+public:
+	StackMemoryPool* m_pool;
+	WeakArray<RenderableQueueElement>* m_renderables;
+	WeakArray<TKey> m_keys;
+	WeakArray<U32> m_indices;
+
+	/// Reorder the renderables using the sorted indices.
+	void permute()
+	{
+		const U32 count = m_renderables->getSize();
+		RenderableQueueElement* sorted = newArray<RenderableQueueElement>(*m_pool, count);
+		for(U32 i = 0; i < count; ++i)
+		{
+			sorted[i] = (*m_renderables)[m_indices[i]];
+		}
+
+		*m_renderables = WeakArray<RenderableQueueElement>(sorted, count);
+	}
+};
+
+template<typename TKey, typename TComputeKeyFunc>
+void CombineResultsTask::sortRenderables(StackMemoryPool& pool, WeakArray<RenderableQueueElement>& renderables,
+										 TComputeKeyFunc computeKey, ThreadHive& hive)
+{
+	const U32 count = renderables.getSize();
+	if(count <= 1)
+	{
+		return;
+	}
+
+	// Sort the keys along with the indices of the renderables. The 2nd half of the arrays is scratch memory
+	SortRenderablesCtx<TKey>* ctx = newInstance<SortRenderablesCtx<TKey>>(pool);
+	ctx->m_pool = &pool;
+	ctx->m_renderables = &renderables;
+	ctx->m_keys = WeakArray<TKey>(newArray<TKey>(pool, count * 2), count * 2);
+	ctx->m_indices = WeakArray<U32>(newArray<U32>(pool, count * 2), count * 2);
+	for(U32 i = 0; i < count; ++i)
+	{
+		ctx->m_keys[i] = computeKey(renderables[i]);
+		ctx->m_indices[i] = i;
+	}
+
+	const WeakArray<TKey> keys(&ctx->m_keys[0], count);
+	const WeakArray<TKey> tmpKeys(&ctx->m_keys[count], count);
+	const WeakArray<U32> indices(&ctx->m_indices[0], count);
+	const WeakArray<U32> tmpIndices(&ctx->m_indices[count], count);
+
+	if(count < kAsyncSortThreshold)
+	{
+		radixSort(keys, indices, tmpKeys, tmpIndices);
+		ctx->permute();
+	}
+	else
+	{
+		ThreadHiveSemaphore* sem = hive.newSemaphore(1);
+		radixSortAsync(keys, indices, tmpKeys, tmpIndices, hive, sem);
+
+		ThreadHiveTask task = ANKI_THREAD_HIVE_TASK({ self->permute(); }, ctx, sem, nullptr);
+		hive.submitTasks(&task, 1);
+	}
+}
+
 template<typename T>
 void CombineResultsTask::combineQueueElements(StackMemoryPool& pool,
 											  WeakArray<TRenderQueueElementStorage<T>> subStorages,
@@ -844,6 +1222,17 @@ void SceneGraph::doVisibilityTests(SceneNode& fsn, SceneGraph& scene, RenderQueu
 	ctx.m_scene = &scene;
 	ctx.m_earlyZDist = scene.getConfig().getSceneEarlyZDistance();
 	const FrustumComponent& mainFrustum = fsn.getFirstComponentOfType<FrustumComponent>();
+
+	ctx.m_screenSpaceErrorLod = scene.getConfig().getSceneScreenSpaceErrorLod();
+	if(ctx.m_screenSpaceErrorLod)
+	{
+		scene.m_lodPolicy.setParameters(scene.getConfig().getSceneLodMaxScreenSpaceError(),
+										scene.getConfig().getSceneLodHysteresis(),
+										scene.getConfig().getSceneLodTriangleBudget());
+		scene.m_lodPolicy.beginFrame(mainFrustum.getProjectionMatrix(),
+									 mainFrustum.getWorldTransform().getOrigin().xyz(), scene.getConfig().getHeight());
+	}
+
 	ctx.submitNewWork(mainFrustum, mainFrustum, rqueue, hive);
 
 	const FrustumComponent* extendedFrustum = fsn.tryGetNthComponentOfType<FrustumComponent>(1);
@@ -859,6 +1248,11 @@ void SceneGraph::doVisibilityTests(SceneNode& fsn, SceneGraph& scene, RenderQueu
 
 	hive.waitAllTasks();
 	ctx.m_testedFrcs.destroy(scene.getFrameMemoryPool());
+
+	if(ctx.m_screenSpaceErrorLod)
+	{
+		scene.m_lodPolicy.endFrame(ctx.m_primaryTriangleCount.load());
+	}
 }
 
 } // end namespace anki
@@ -19,44 +19,8 @@ namespace anki {
 /// @{
 
 constexpr U32 kMaxSpatialsPerVisTest = 48; ///< Num of spatials to test in a single ThreadHive task.
-
-/// Sort objects on distance
-template<typename T>
-class DistanceSortFunctor
-{
-public:
-	Bool operator()(const T& a, const T& b)
-	{
-		return a.m_distanceFromCamera < b.m_distanceFromCamera;
-	}
-};
-
-template<typename T>
-class RevDistanceSortFunctor
-{
-public:
-	Bool operator()(const T& a, const T& b)
-	{
-		return a.m_distanceFromCamera > b.m_distanceFromCamera;
-	}
-};
-
-/// Sorts first by LOD and then by material (merge key).
-class MaterialDistanceSortFunctor
-{
-public:
-	Bool operator()(const RenderableQueueElement& a, const RenderableQueueElement& b)
-	{
-		if(a.m_lod == b.m_lod)
-		{
-			return a.m_mergeKey < b.m_mergeKey;
-		}
-		else
-		{
-			return a.m_lod < b.m_lod;
-		}
-	}
-};
+constexpr U32 kMaxFrustumsPerOctreeWalk = 32; ///< Num of frustums tested in a single walk of the octree.
+static_assert(kMaxSpatialsPerVisTest <= 64, "Some masks assume that");
 
 /// Storage for a single element type.
 template<typename T, U32 kInitialStorage = 32, U32 kStorageGrowRate = 4>
@@ -86,6 +50,15 @@ public:
 	}
 };
 
+/// A frustum found by the visibility tests (eg a shadow casting light) that will be tested after the results of the
+/// parent frustum are combined.
+class NextFrustum
+{
+public:
+	const FrustumComponent* m_frc;
+	RenderQueue* m_renderQueue;
+};
+
 class RenderQueueView
 {
 public:
@@ -106,6 +79,9 @@ public:
 	SkyboxQueueElement m_skybox;
 	Bool m_skyboxSet = false;
 
+	TRenderQueueElementStorage<NextFrustum> m_nextFrustums;
+	TRenderQueueElementStorage<SpatialComponent*> m_visibleSpatials; ///< For the incremental visibility.
+
 	Timestamp m_timestamp = 0;
 
 	RenderQueueView()
@@ -125,12 +101,25 @@ public:
 	Atomic<U32> m_testsCount = {0};
 
 	F32 m_earlyZDist = -1.0f; ///< Cache this.
+	Bool m_screenSpaceErrorLod = false; ///< Cache this.
+
+	Atomic<U64> m_primaryTriangleCount = {0}; ///< The triangles of the renderables of the primary frustum.
 
 	List<const FrustumComponent*> m_testedFrcs;
 	Mutex m_mtx;
 
+	/// Submit the tasks that test some frustums. Frustums that don't use the S/W rasterizer will share octree walks.
+	void submitNewWork(ConstWeakArray<const FrustumComponent*> frcs, const FrustumComponent& primaryFrustum,
+					   ConstWeakArray<RenderQueue*> results, ThreadHive& hive);
+
 	void submitNewWork(const FrustumComponent& frc, const FrustumComponent& primaryFrustum, RenderQueue& result,
-					   ThreadHive& hive);
+					   ThreadHive& hive)
+	{
+		const FrustumComponent* pfrc = &frc;
+		RenderQueue* presult = &result;
+		submitNewWork(ConstWeakArray<const FrustumComponent*>(&pfrc, 1), primaryFrustum,
+					  ConstWeakArray<RenderQueue*>(&presult, 1), hive);
+	}
 };
 
 /// A context for a specific test of a frustum component.
@@ -151,6 +140,8 @@ public:
 	// Visibility test members
 	DynamicArray<RenderQueueView> m_queueViews; ///< Sub result. Will be combined later.
 	ThreadHiveSemaphore* m_visTestsSignalSem = nullptr;
+	Bool m_updateVisibleSpatialsCache = false; ///< Store the visible spatials to the FrustumComponent.
+	U32 m_reusedSpatialCount = 0; ///< The spatials of the previous frame that were not tested again.
 
 	// Gather results members
 	RenderQueue* m_renderQueue = nullptr;
@@ -173,13 +164,55 @@ public:
 static_assert(std::is_trivially_destructible<FillRasterizerWithCoverageTask>::value == true,
 			  "Should be trivially destructible");
 
-/// ThreadHive task to get visible nodes from the octree.
+/// ThreadHive task to get visible nodes from the octree. It gathers for many frustums in a single walk.
 class GatherVisiblesFromOctreeTask
 {
 public:
-	FrustumVisibilityContext* m_frcCtx = nullptr;
+	Array<FrustumVisibilityContext*, kMaxFrustumsPerOctreeWalk> m_frcCtxs;
+	U32 m_frcCtxCount = 0;
+
+	GatherVisiblesFromOctreeTask() = default;
 
 	GatherVisiblesFromOctreeTask(FrustumVisibilityContext* frcCtx)
+	{
+		addFrustum(frcCtx);
+	}
+
+	void addFrustum(FrustumVisibilityContext* frcCtx)
+	{
+		ANKI_ASSERT(frcCtx && m_frcCtxCount < m_frcCtxs.getSize());
+		m_frcCtxs[m_frcCtxCount++] = frcCtx;
+	}
+
+	void gather(ThreadHive& hive);
+
+private:
+	/// The spatials of a frustum that wait to be tested.
+	class Spatials
+	{
+	public:
+		Array<SpatialComponent*, kMaxSpatialsPerVisTest> m_spatials;
+		U32 m_spatialCount = 0;
+	};
+
+	Array<Spatials, kMaxFrustumsPerOctreeWalk> m_spatials;
+
+	void walkOctree(U32 testId, ThreadHive& hive);
+
+	/// Submit tasks to test the spatials of a frustum.
+	void flush(U32 frustumIdx, ThreadHive& hive);
+};
+static_assert(std::is_trivially_destructible<GatherVisiblesFromOctreeTask>::value == true,
+			  "Should be trivially destructible");
+
+/// ThreadHive task that gets the visible nodes from the visible spatials of the previous frame and the spatials that
+/// moved in this frame. Used by the incremental visibility.
+class GatherVisiblesFromCacheTask
+{
+public:
+	FrustumVisibilityContext* m_frcCtx = nullptr;
+
+	GatherVisiblesFromCacheTask(FrustumVisibilityContext* frcCtx)
 		: m_frcCtx(frcCtx)
 	{
 		ANKI_ASSERT(m_frcCtx);
@@ -190,11 +223,14 @@ public:
 private:
 	Array<SpatialComponent*, kMaxSpatialsPerVisTest> m_spatials;
 	U32 m_spatialCount = 0;
+	U64 m_knownVisibleMask = 0;
+
+	void addSpatial(SpatialComponent* spatial, Bool knownVisible, ThreadHive& hive);
 
 	/// Submit tasks to test the m_spatials.
 	void flush(ThreadHive& hive);
 };
-static_assert(std::is_trivially_destructible<GatherVisiblesFromOctreeTask>::value == true,
+static_assert(std::is_trivially_destructible<GatherVisiblesFromCacheTask>::value == true,
 			  "Should be trivially destructible");
 
 /// ThreadHive task that does the actual visibility tests.
@@ -205,6 +241,7 @@ public:
 
 	Array<SpatialComponent*, kMaxSpatialsPerVisTest> m_spatialsToTest;
 	U32 m_spatialToTestCount = 0;
+	U64 m_knownVisibleMask = 0; ///< The spatials that are known to be inside the frustum. No need to test them.
 
 	VisibilityTestTask(FrustumVisibilityContext* frcCtx)
 		: m_frcCtx(frcCtx)
@@ -212,7 +249,7 @@ public:
 		ANKI_ASSERT(m_frcCtx);
 	}
 
-	void test(ThreadHive& hive, U32 taskId);
+	void test(U32 taskId);
 
 private:
 	[[nodiscard]] Bool testAgainstRasterizer(const Aabb& aabb) const
@@ -234,13 +271,24 @@ public:
 		ANKI_ASSERT(m_frcCtx);
 	}
 
-	void combine();
+	void combine(ThreadHive& hive);
 
 private:
+	/// Renderable arrays bigger than that will be sorted by other tasks.
+	static constexpr U32 kAsyncSortThreshold = 2 * 1024;
+
+	template<typename TKey>
+	class SortRenderablesCtx;
+
 	template<typename T>
 	static void combineQueueElements(StackMemoryPool& pool, WeakArray<TRenderQueueElementStorage<T>> subStorages,
 									 WeakArray<TRenderQueueElementStorage<U32>>* ptrSubStorage, WeakArray<T>& combined,
 									 WeakArray<T*>* ptrCombined);
+
+	/// Sort renderables with radix sort using the key computed by computeKey. Big arrays are sorted asynchronously.
+	template<typename TKey, typename TComputeKeyFunc>
+	static void sortRenderables(StackMemoryPool& pool, WeakArray<RenderableQueueElement>& renderables,
+								TComputeKeyFunc computeKey, ThreadHive& hive);
 };
 static_assert(std::is_trivially_destructible<CombineResultsTask>::value == true, "Should be trivially destructible");
 /// @}
@@ -0,0 +1,403 @@
+// Copyright (C) 2009-2022, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#pragma once
+
+#include <AnKi/Util/ThreadHive.h>
+#include <AnKi/Util/WeakArray.h>
+#include <AnKi/Util/Functions.h>
+
+namespace anki {
+
+/// @addtogroup util_other
+/// @{
+
+/// @memberof radixSort
+template<typename TKey, typename TValue>
+class RadixSortContext
+{
+public:
+	static constexpr U32 kDigitBits = 8;
+	static constexpr U32 kBucketCount = 1u << kDigitBits;
+
+	/// Key-value pairs smaller than that will be sorted serially.
+	static constexpr U32 kParallelThreshold = 16 * 1024;
+
+	ConstWeakArray<TKey> m_srcKeys;
+	ConstWeakArray<TValue> m_srcValues;
+	WeakArray<TKey> m_dstKeys;
+	WeakArray<TValue> m_dstValues;
+
+	U32 m_shift = 0;
+	U32 m_chunkCount = 0;
+	U32 m_chunkSize = 0;
+
+	/// Histogram of every chunk. Becomes the scatter offsets of every chunk.
+	Array2d<U32, ThreadHive::kMaxThreads, kBucketCount> m_offsets;
+
+	static U32 getDigit(TKey key, U32 shift)
+	{
+		return U32((key >> shift) & TKey(kBucketCount - 1));
+	}
+
+	void computeHistogram(U32 chunk)
+	{
+		computeHistogram(m_srcKeys, chunk, m_shift);
+	}
+
+	void computeHistogram(ConstWeakArray<TKey> srcKeys, U32 chunk, U32 shift)
+	{
+		const U32 begin = chunk * m_chunkSize;
+		const U32 end = min(begin + m_chunkSize, srcKeys.getSize());
+
+		zeroMemory(m_offsets[chunk]);
+		for(U32 i = begin; i < end; ++i)
+		{
+			++m_offsets[chunk][getDigit(srcKeys[i], shift)];
+		}
+	}
+
+	void scatter(U32 chunk)
+	{
+		scatter(m_srcKeys, m_srcValues, m_dstKeys, m_dstValues, chunk, m_shift);
+	}
+
+	void scatter(ConstWeakArray<TKey> srcKeys, ConstWeakArray<TValue> srcValues, WeakArray<TKey> dstKeys,
+				 WeakArray<TValue> dstValues, U32 chunk, U32 shift)
+	{
+		const U32 begin = chunk * m_chunkSize;
+		const U32 end = min(begin + m_chunkSize, srcKeys.getSize());
+		const Bool hasValues = srcValues.getSize() > 0;
+
+		Array<U32, kBucketCount>& offsets = m_offsets[chunk];
+		for(U32 i = begin; i < end; ++i)
+		{
+			const U32 out = offsets[getDigit(srcKeys[i], shift)]++;
+			dstKeys[out] = srcKeys[i];
+			if(hasValues)
+			{
+				dstValues[out] = srcValues[i];
+			}
+		}
+	}
+
+	/// Convert the histograms to offsets. Returns false if all keys fall into the same bucket and the pass can be
+	/// skipped.
+	Bool computeOffsets(U32 keyCount)
+	{
+		U32 offset = 0;
+		for(U32 bucket = 0; bucket < kBucketCount; ++bucket)
+		{
+			U32 bucketTotal = 0;
+			for(U32 chunk = 0; chunk < m_chunkCount; ++chunk)
+			{
+				const U32 count = m_offsets[chunk][bucket];
+				m_offsets[chunk][bucket] = offset + bucketTotal;
+				bucketTotal += count;
+			}
+
+			if(bucketTotal == keyCount)
+			{
+				return false;
+			}
+
+			offset += bucketTotal;
+		}
+
+		return true;
+	}
+
+	Bool computeOffsets()
+	{
+		return computeOffsets(m_srcKeys.getSize());
+	}
+
+	void runChunks(ThreadHive* hive, Bool histogram)
+	{
+		if(m_chunkCount == 1)
+		{
+			if(histogram)
+			{
+				computeHistogram(0);
+			}
+			else
+			{
+				scatter(0);
+			}
+			return;
+		}
+
+		Array<TaskArg, ThreadHive::kMaxThreads> args;
+		Array<ThreadHiveTask, ThreadHive::kMaxThreads> tasks;
+		for(U32 chunk = 0; chunk < m_chunkCount; ++chunk)
+		{
+			args[chunk].m_ctx = this;
+			args[chunk].m_chunk = chunk;
+			tasks[chunk].m_argument = &args[chunk];
+			tasks[chunk].m_callback = (histogram) ? histogramTaskCallback : scatterTaskCallback;
+		}
+
+		hive->submitTasks(&tasks[0], m_chunkCount);
+		hive->waitAllTasks();
+	}
+
+private:
+	class TaskArg
+	{
+	public:
+		RadixSortContext* m_ctx;
+		U32 m_chunk;
+	};
+
+	static void histogramTaskCallback(void* ud, [[maybe_unused]] U32 threadId, [[maybe_unused]] ThreadHive& hive,
+									  [[maybe_unused]] ThreadHiveSemaphore* sem)
+	{
+		TaskArg& arg = *static_cast<TaskArg*>(ud);
+		arg.m_ctx->computeHistogram(arg.m_chunk);
+	}
+
+	static void scatterTaskCallback(void* ud, [[maybe_unused]] U32 threadId, [[maybe_unused]] ThreadHive& hive,
+									[[maybe_unused]] ThreadHiveSemaphore* sem)
+	{
+		TaskArg& arg = *static_cast<TaskArg*>(ud);
+		arg.m_ctx->scatter(arg.m_chunk);
+	}
+};
+
+/// @memberof radixSortAsync
+template<typename TKey, typename TValue>
+class RadixSortAsyncContext : public RadixSortContext<TKey, TValue>
+{
+public:
+	using Base = RadixSortContext<TKey, TValue>;
+
+	/// The user arrays and the scratch arrays. Every pass reads from one and writes to the other.
+	Array<WeakArray<TKey>, 2> m_keyBuffers;
+	Array<WeakArray<TValue>, 2> m_valueBuffers;
+	U32 m_crntBuffer = 0; ///< The buffer that holds the keys sorted by all the passes so far.
+
+	/// Submit the tasks of all passes. Every pass is a chain of histogram tasks, a single offsets task and scatter
+	/// tasks. The offsets task decides if the pass will be skipped and which buffer the scatter reads from.
+	void submit(ThreadHive& hive, U32 keyBits, ThreadHiveSemaphore* signalSemaphore)
+	{
+		const U32 passCount = (keyBits + Base::kDigitBits - 1) / Base::kDigitBits;
+		Pass* passes = static_cast<Pass*>(hive.allocateScratchMemory(sizeof(Pass) * passCount, alignof(Pass)));
+		ChunkArg* chunkArgs = static_cast<ChunkArg*>(
+			hive.allocateScratchMemory(sizeof(ChunkArg) * passCount * this->m_chunkCount, alignof(ChunkArg)));
+
+		ThreadHiveSemaphore* prevPassSem = nullptr;
+		Array<ThreadHiveTask, ThreadHive::kMaxThreads> tasks;
+		for(U32 p = 0; p < passCount; ++p)
+		{
+			Pass& pass = passes[p];
+			pass.m_ctx = this;
+			pass.m_shift = p * Base::kDigitBits;
+			pass.m_srcBuffer = kMaxU32;
+
+			// Histograms
+			ThreadHiveSemaphore* histogramSem = hive.newSemaphore(this->m_chunkCount);
+			for(U32 chunk = 0; chunk < this->m_chunkCount; ++chunk)
+			{
+				ChunkArg& arg = chunkArgs[p * this->m_chunkCount + chunk];
+				arg.m_pass = &pass;
+				arg.m_chunk = chunk;
+
+				tasks[chunk] = ANKI_THREAD_HIVE_TASK(
+					{
+						RadixSortAsyncContext& ctx = *self->m_pass->m_ctx;
+						ctx.computeHistogram(ctx.m_keyBuffers[ctx.m_crntBuffer], self->m_chunk, self->m_pass->m_shift);
+					},
+					&arg, prevPassSem, histogramSem);
+			}
+			hive.submitTasks(&tasks[0], this->m_chunkCount);
+
+			// Offsets
+			ThreadHiveSemaphore* offsetsSem = hive.newSemaphore(1);
+			ThreadHiveTask offsetsTask = ANKI_THREAD_HIVE_TASK(
+				{
+					RadixSortAsyncContext& ctx = *self->m_ctx;
+					if(ctx.computeOffsets(ctx.m_keyBuffers[0].getSize()))
+					{
+						self->m_srcBuffer = ctx.m_crntBuffer;
+						ctx.m_crntBuffer ^= 1u;
+					}
+				},
+				&pass, histogramSem, offsetsSem);
+			hive.submitTasks(&offsetsTask, 1);
+
+			// Scatter
+			ThreadHiveSemaphore* scatterSem = hive.newSemaphore(this->m_chunkCount);
+			for(U32 chunk = 0; chunk < this->m_chunkCount; ++chunk)
+			{
+				tasks[chunk] = ANKI_THREAD_HIVE_TASK(
+					{
+						const Pass& pass = *self->m_pass;
+						RadixSortAsyncContext& ctx = *pass.m_ctx;
+						if(pass.m_srcBuffer != kMaxU32)
+						{
+							const U32 src = pass.m_srcBuffer;
+							ctx.scatter(ctx.m_keyBuffers[src], ctx.m_valueBuffers[src], ctx.m_keyBuffers[src ^ 1u],
+										ctx.m_valueBuffers[src ^ 1u], self->m_chunk, pass.m_shift);
+						}
+					},
+					&chunkArgs[p * this->m_chunkCount + chunk], offsetsSem, scatterSem);
+			}
+			hive.submitTasks(&tasks[0], this->m_chunkCount);
+
+			prevPassSem = scatterSem;
+		}
+
+		// If the last pass ended in the scratch memory copy back
+		ThreadHiveTask finalTask = ANKI_THREAD_HIVE_TASK(
+			{
+				if(self->m_crntBuffer != 0)
+				{
+					memcpy(self->m_keyBuffers[0].getBegin(), self->m_keyBuffers[1].getBegin(),
+						   self->m_keyBuffers[0].getSizeInBytes());
+					if(self->m_valueBuffers[0].getSize())
+					{
+						memcpy(self->m_valueBuffers[0].getBegin(), self->m_valueBuffers[1].getBegin(),
+							   self->m_valueBuffers[0].getSizeInBytes());
+					}
+				}
+			},
+			this, prevPassSem, signalSemaphore);
+		hive.submitTasks(&finalTask, 1);
+	}
+
+private:
+	class Pass
+	{
+	public:
+		RadixSortAsyncContext* m_ctx;
+		U32 m_shift;
+		U32 m_srcBuffer; ///< The buffer the scatter reads from or kMaxU32 if the pass is skipped.
+	};
+
+	class ChunkArg
+	{
+	public:
+		Pass* m_pass;
+		U32 m_chunk;
+	};
+};
+
+/// LSD radix sort of key-value pairs. It sorts 8 bits at a time and it skips the passes where all the keys share the
+/// same digit. The sort is stable.
+/// @param[in,out] keys The keys to sort.
+/// @param[in,out] values The values that will be moved along with the keys. Can be empty.
+/// @param tmpKeys Scratch memory with the same size as keys.
+/// @param tmpValues Scratch memory with the same size as values.
+/// @param hive If not nullptr big arrays will be sorted in parallel. Don't call it from a task of the same hive since
+///             it waits for all tasks.
+/// @param keyBits The number of lower bits of the keys that are significant.
+template<typename TKey, typename TValue>
+void radixSort(WeakArray<TKey> keys, WeakArray<TValue> values, WeakArray<TKey> tmpKeys, WeakArray<TValue> tmpValues,
+			   ThreadHive* hive = nullptr, U32 keyBits = sizeof(TKey) * 8)
+{
+	static_assert(std::is_unsigned<TKey>::value, "Only unsigned integer keys are supported");
+	static_assert(std::is_trivially_copyable<TValue>::value, "Values are moved with memcpy");
+	using Ctx = RadixSortContext<TKey, TValue>;
+
+	const U32 count = keys.getSize();
+	ANKI_ASSERT(tmpKeys.getSize() >= count);
+	ANKI_ASSERT(values.getSize() == 0 || values.getSize() == count);
+	ANKI_ASSERT(tmpValues.getSize() >= values.getSize());
+	ANKI_ASSERT(keyBits > 0 && keyBits <= sizeof(TKey) * 8);
+
+	if(count <= 1)
+	{
+		return;
+	}
+
+	Ctx ctx;
+	ctx.m_chunkCount = (hive && count >= Ctx::kParallelThreshold) ? min(hive->getThreadCount(), ThreadHive::kMaxThreads)
+																   : 1;
+	ctx.m_chunkSize = (count + ctx.m_chunkCount - 1) / ctx.m_chunkCount;
+
+	WeakArray<TKey> srcKeys = keys;
+	WeakArray<TValue> srcValues = values;
+	WeakArray<TKey> dstKeys(tmpKeys.getBegin(), count);
+	WeakArray<TValue> dstValues(tmpValues.getBegin(), values.getSize());
+
+	for(U32 shift = 0; shift < keyBits; shift += Ctx::kDigitBits)
+	{
+		ctx.m_srcKeys = srcKeys;
+		ctx.m_srcValues = srcValues;
+		ctx.m_dstKeys = dstKeys;
+		ctx.m_dstValues = dstValues;
+		ctx.m_shift = shift;
+
+		ctx.runChunks(hive, true);
+		if(!ctx.computeOffsets())
+		{
+			continue;
+		}
+
+		ctx.runChunks(hive, false);
+
+		std::swap(srcKeys, dstKeys);
+		std::swap(srcValues, dstValues);
+	}
+
+	// If the last pass ended in the scratch memory copy back
+	if(srcKeys.getBegin() != keys.getBegin())
+	{
+		memcpy(keys.getBegin(), srcKeys.getBegin(), srcKeys.getSizeInBytes());
+		if(values.getSize())
+		{
+			memcpy(values.getBegin(), srcValues.getBegin(), srcValues.getSizeInBytes());
+		}
+	}
+}
+
+/// Same as radixSort but instead of waiting it submits a graph of ThreadHive tasks so it can be called from a task of
+/// the same hive. The passes can't be known in advance so it's a bit slower than radixSort for small arrays.
+/// @param[in,out] keys See radixSort. It should stay alive until the sort is done.
+/// @param[in,out] values See radixSort. It should stay alive until the sort is done.
+/// @param tmpKeys See radixSort. It should stay alive until the sort is done.
+/// @param tmpValues See radixSort. It should stay alive until the sort is done.
+/// @param hive The hive.
+/// @param signalSemaphore It will be decreased by one when the sort is done. Can be nullptr.
+/// @param keyBits See radixSort.
+template<typename TKey, typename TValue>
+void radixSortAsync(WeakArray<TKey> keys, WeakArray<TValue> values, WeakArray<TKey> tmpKeys,
+					WeakArray<TValue> tmpValues, ThreadHive& hive, ThreadHiveSemaphore* signalSemaphore,
+					U32 keyBits = sizeof(TKey) * 8)
+{
+	static_assert(std::is_unsigned<TKey>::value, "Only unsigned integer keys are supported");
+	static_assert(std::is_trivially_copyable<TValue>::value, "Values are moved with memcpy");
+	using Ctx = RadixSortAsyncContext<TKey, TValue>;
+
+	const U32 count = keys.getSize();
+	ANKI_ASSERT(tmpKeys.getSize() >= count);
+	ANKI_ASSERT(values.getSize() == 0 || values.getSize() == count);
+	ANKI_ASSERT(tmpValues.getSize() >= values.getSize());
+	ANKI_ASSERT(keyBits > 0 && keyBits <= sizeof(TKey) * 8);
+
+	if(count <= 1)
+	{
+		if(signalSemaphore)
+		{
+			// Still need to signal
+			ThreadHiveTask task = ANKI_THREAD_HIVE_TASK({}, signalSemaphore, nullptr, signalSemaphore);
+			hive.submitTasks(&task, 1);
+		}
+		return;
+	}
+
+	Ctx* ctx = static_cast<Ctx*>(hive.allocateScratchMemory(sizeof(Ctx), alignof(Ctx)));
+	::new(ctx) Ctx();
+	ctx->m_chunkCount = (count >= Ctx::kParallelThreshold) ? min(hive.getThreadCount(), ThreadHive::kMaxThreads) : 1;
+	ctx->m_chunkSize = (count + ctx->m_chunkCount - 1) / ctx->m_chunkCount;
+	ctx->m_keyBuffers = {keys, WeakArray<TKey>(tmpKeys.getBegin(), count)};
+	ctx->m_valueBuffers = {values, WeakArray<TValue>(tmpValues.getBegin(), values.getSize())};
+	ctx->m_crntBuffer = 0;
+
+	ctx->submit(hive, keyBits, signalSemaphore);
+}
+/// @}
+
+} // end namespace anki
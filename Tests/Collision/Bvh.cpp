@@ -0,0 +1,243 @@
+// Copyright (C) 2009-2022, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <Tests/Framework/Framework.h>
+#include <AnKi/Collision/Bvh.h>
+#include <AnKi/Collision/MortonCode.h>
+#include <AnKi/Util/ThreadHive.h>
+#include <AnKi/Util/System.h>
+
+using namespace anki;
+
+static void generateBoxes(U32 count, F32 worldSize, DynamicArrayRaii<BvhPrimitive>& boxes)
+{
+	boxes.resize(count);
+	for(BvhPrimitive& box : boxes)
+	{
+		const Vec3 center(getRandomRange(-worldSize, worldSize), getRandomRange(-worldSize, worldSize),
+						  getRandomRange(-worldSize, worldSize));
+		const Vec3 extend(getRandomRange(0.1f, 2.0f), getRandomRange(0.1f, 2.0f), getRandomRange(0.1f, 2.0f));
+		box.m_aabbMin = center - extend;
+		box.m_aabbMax = center + extend;
+	}
+}
+
+static Bool overlaps(const BvhPrimitive& a, const Aabb& b)
+{
+	return testCollision(Aabb(a.m_aabbMin, a.m_aabbMax), b);
+}
+
+ANKI_TEST(Collision, BvhAabbQuery)
+{
+	HeapMemoryPool pool(allocAligned, nullptr);
+	ThreadHive hive(getCpuCoresCount(), &pool);
+
+	for(U32 parallel = 0; parallel < 2; ++parallel)
+	{
+		DynamicArrayRaii<BvhPrimitive> boxes(&pool);
+		generateBoxes(10000, 100.0f, boxes);
+
+		Bvh bvh(&pool);
+		bvh.build(boxes, (parallel) ? &hive : nullptr);
+		ANKI_TEST_EXPECT_EQ(bvh.getPrimitiveCount(), boxes.getSize());
+
+		DynamicArrayRaii<U8> found(&pool);
+		for(U32 q = 0; q < 50; ++q)
+		{
+			const Vec3 center(getRandomRange(-100.0f, 100.0f), getRandomRange(-100.0f, 100.0f),
+							  getRandomRange(-100.0f, 100.0f));
+			const Aabb query(center - 10.0f, center + 10.0f);
+
+			found.resize(boxes.getSize(), 0);
+			memset(&found[0], 0, found.getSizeInBytes());
+			bvh.aabbQuery(query, [&](U32 idx) {
+				++found[idx];
+			});
+
+			// The query is conservative so it can return more but it can't miss any
+			for(U32 i = 0; i < boxes.getSize(); ++i)
+			{
+				ANKI_TEST_EXPECT_LEQ(found[i], 1);
+				if(overlaps(boxes[i], query))
+				{
+					ANKI_TEST_EXPECT_EQ(found[i], 1);
+				}
+			}
+		}
+
+		// Move everything, refit and query again
+		for(BvhPrimitive& box : boxes)
+		{
+			box.m_aabbMin += Vec3(5.0f, 0.0f, -3.0f);
+			box.m_aabbMax += Vec3(5.0f, 0.0f, -3.0f);
+		}
+		bvh.refit(boxes);
+
+		const Aabb query(Vec3(-20.0f), Vec3(20.0f));
+		found.resize(boxes.getSize(), 0);
+		memset(&found[0], 0, found.getSizeInBytes());
+		bvh.aabbQuery(query, [&](U32 idx) {
+			++found[idx];
+		});
+
+		for(U32 i = 0; i < boxes.getSize(); ++i)
+		{
+			if(overlaps(boxes[i], query))
+			{
+				ANKI_TEST_EXPECT_EQ(found[i], 1);
+			}
+		}
+	}
+}
+
+ANKI_TEST(Collision, BvhFrustumQuery)
+{
+	HeapMemoryPool pool(allocAligned, nullptr);
+
+	DynamicArrayRaii<BvhPrimitive> boxes(&pool);
+	generateBoxes(5000, 100.0f, boxes);
+
+	Bvh bvh(&pool);
+	bvh.build(boxes);
+
+	const Mat4 proj = Mat4::calculatePerspectiveProjectionMatrix(toRad(60.0f), toRad(60.0f), 0.1f, 80.0f);
+	Array<Plane, 6> planes;
+	extractClipPlanes(proj, planes);
+
+	DynamicArrayRaii<U8> found(&pool);
+	found.resize(boxes.getSize(), 0);
+	bvh.frustumQuery(ConstWeakArray<Plane>(planes), [&](U32 idx) {
+		++found[idx];
+	});
+
+	for(U32 i = 0; i < boxes.getSize(); ++i)
+	{
+		Bool inside = true;
+		for(const Plane& plane : planes)
+		{
+			inside = inside && testPlane(plane, Aabb(boxes[i].m_aabbMin, boxes[i].m_aabbMax)) >= 0.0f;
+		}
+
+		ANKI_TEST_EXPECT_LEQ(found[i], 1);
+		if(inside)
+		{
+			ANKI_TEST_EXPECT_EQ(found[i], 1);
+		}
+	}
+}
+
+ANKI_TEST(Collision, BvhRayTriangles)
+{
+	HeapMemoryPool pool(allocAligned, nullptr);
+	ThreadHive hive(getCpuCoresCount(), &pool);
+
+	// Random triangle soup
+	constexpr U32 kTriangleCount = 20000;
+	DynamicArrayRaii<Vec3> positions(&pool);
+	DynamicArrayRaii<U32> indices(&pool);
+	positions.resize(kTriangleCount * 3);
+	indices.resize(kTriangleCount * 3);
+	for(U32 t = 0; t < kTriangleCount; ++t)
+	{
+		const Vec3 center(getRandomRange(-50.0f, 50.0f), getRandomRange(-50.0f, 50.0f),
+						  getRandomRange(-50.0f, 50.0f));
+		for(U32 v = 0; v < 3; ++v)
+		{
+			positions[t * 3 + v] =
+				center + Vec3(getRandomRange(-1.0f, 1.0f), getRandomRange(-1.0f, 1.0f), getRandomRange(-1.0f, 1.0f));
+			indices[t * 3 + v] = t * 3 + v;
+		}
+	}
+
+	Bvh bvh(&pool);
+	bvh.buildFromTriangles(positions, indices, &hive);
+
+	U32 hitCount = 0;
+	for(U32 r = 0; r < 200; ++r)
+	{
+		const Vec3 origin(getRandomRange(-60.0f, 60.0f), getRandomRange(-60.0f, 60.0f), getRandomRange(-60.0f, 60.0f));
+		const Vec3 dir =
+			Vec3(getRandomRange(-1.0f, 1.0f), getRandomRange(-1.0f, 1.0f), getRandomRange(-1.0f, 1.0f)).getNormalized();
+		const Ray ray(origin, dir);
+
+		// Brute force
+		F32 bruteDistance = kMaxF32;
+		for(U32 t = 0; t < kTriangleCount; ++t)
+		{
+			F32 dist;
+			if(testCollision(ray, positions[t * 3], positions[t * 3 + 1], positions[t * 3 + 2], dist)
+			   && dist < bruteDistance)
+			{
+				bruteDistance = dist;
+			}
+		}
+
+		F32 distance;
+		U32 triangleIdx;
+		const Bool hit = bvh.castRayTriangles(positions, indices, ray, kMaxF32, distance, triangleIdx);
+		ANKI_TEST_EXPECT_EQ(hit, bruteDistance < kMaxF32);
+		if(hit)
+		{
+			ANKI_TEST_EXPECT_NEAR(distance, bruteDistance, kEpsilonf * 100.0f);
+			++hitCount;
+		}
+	}
+
+	ANKI_TEST_LOGI("%u rays hit", hitCount);
+}
+
+ANKI_TEST(Collision, BvhLinear)
+{
+	HeapMemoryPool pool(allocAligned, nullptr);
+	ThreadHive hive(getCpuCoresCount(), &pool);
+
+	// Check the SIMD Morton codes against the scalar version
+	{
+		DynamicArrayRaii<Vec3> positions(&pool);
+		positions.resize(103);
+		for(Vec3& pos : positions)
+		{
+			pos = Vec3(getRandomRange(-5.0f, 5.0f), getRandomRange(-5.0f, 5.0f), getRandomRange(-5.0f, 5.0f));
+		}
+
+		DynamicArrayRaii<U32> codes(&pool);
+		codes.resize(positions.getSize());
+		computeMortonCodes30(positions, Vec3(-5.0f), Vec3(5.0f), WeakArray<U32>(codes));
+		for(U32 i = 0; i < positions.getSize(); ++i)
+		{
+			ANKI_TEST_EXPECT_EQ(codes[i], computeMortonCode30(positions[i], Vec3(-5.0f), Vec3(0.1f)));
+		}
+	}
+
+	DynamicArrayRaii<BvhPrimitive> boxes(&pool);
+	generateBoxes(20000, 100.0f, boxes);
+
+	Bvh bvh(&pool);
+	bvh.buildLinear(boxes, &hive);
+	ANKI_TEST_EXPECT_EQ(bvh.getPrimitiveCount(), boxes.getSize());
+
+	DynamicArrayRaii<U8> found(&pool);
+	found.resize(boxes.getSize(), 0);
+	for(U32 q = 0; q < 50; ++q)
+	{
+		const Vec3 center(getRandomRange(-100.0f, 100.0f), getRandomRange(-100.0f, 100.0f),
+						  getRandomRange(-100.0f, 100.0f));
+		const Aabb query(center - 10.0f, center + 10.0f);
+
+		memset(&found[0], 0, found.getSizeInBytes());
+		bvh.aabbQuery(query, [&](U32 idx) {
+			++found[idx];
+		});
+
+		for(U32 i = 0; i < boxes.getSize(); ++i)
+		{
+			ANKI_TEST_EXPECT_LEQ(found[i], 1);
+			if(overlaps(boxes[i], query))
+			{
+				ANKI_TEST_EXPECT_EQ(found[i], 1);
+			}
+		}
+	}
+}
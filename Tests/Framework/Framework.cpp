@@ -58,7 +58,7 @@ void Test::run()
 #endif
 }
 
-void Tester::addTest(const char* name, const char* suiteName, TestCallback callback)
+void Tester::addTest(const char* name, const char* suiteName, TestCallback callback, bool optIn)
 {
 	std::vector<TestSuite*>::iterator it;
 	for(it = suites.begin(); it != suites.end(); it++)
@@ -99,6 +99,7 @@ void Tester::addTest(const char* name, const char* suiteName, TestCallback callb
 	test->name = name;
 	test->suite = suite;
 	test->callback = callback;
+	test->optIn = optIn;
 }
 
 int Tester::run(int argc, char** argv)
@@ -112,7 +113,8 @@ Options:
   --help         Print this message
   --list-tests   List all the tests
   --suite <name> Run tests only from this suite
-  --test <name>  Run this test. --suite needs to be specified)";
+  --test <name>  Run this test. --suite needs to be specified. The tests added with
+                 ANKI_TEST_OPT_IN only run this way)";
 
 	std::string suiteName;
 	std::string testName;
@@ -170,6 +172,11 @@ Options:
 		{
 			for(Test* test : suite->tests)
 			{
+				if(test->optIn)
+				{
+					continue;
+				}
+
 				++run;
 				test->run();
 				++passed;
@@ -184,7 +191,7 @@ Options:
 			{
 				for(Test* test : suite->tests)
 				{
-					if(test->name == testName || testName.length() == 0)
+					if(test->name == testName || (testName.length() == 0 && !test->optIn))
 					{
 						++run;
 						test->run();
@@ -49,6 +49,7 @@ public:
 	std::string name;
 	TestSuite* suite = nullptr;
 	TestCallback callback = nullptr;
+	bool optIn = false; ///< Run it only when --test names it.
 
 	void run();
 };
@@ -60,7 +61,7 @@ public:
 	std::vector<TestSuite*> suites;
 	std::string programName;
 
-	void addTest(const char* name, const char* suite, TestCallback callback);
+	void addTest(const char* name, const char* suite, TestCallback callback, bool optIn = false);
 
 	int run(int argc, char** argv);
 
@@ -83,20 +84,26 @@ extern void deleteTesterSingleton();
 
 // Macros
 
-/// Create a new test and add it. It does a trick to add the test by using a static function
-#define ANKI_TEST(suiteName_, name_) \
+/// Intermediate macro
+#define ANKI_TEST_IMPL(suiteName_, name_, optIn_) \
 	using namespace anki; \
 	void test_##suiteName_##name_(Test&); \
 	struct Foo##suiteName_##name_ \
 	{ \
 		Foo##suiteName_##name_() \
 		{ \
-			getTesterSingleton().addTest(#name_, #suiteName_, test_##suiteName_##name_); \
+			getTesterSingleton().addTest(#name_, #suiteName_, test_##suiteName_##name_, optIn_); \
 		} \
 	}; \
 	static Foo##suiteName_##name_ yada##suiteName_##name_; \
 	void test_##suiteName_##name_(Test&)
 
+/// Create a new test and add it. It does a trick to add the test by using a static function
+#define ANKI_TEST(suiteName_, name_) ANKI_TEST_IMPL(suiteName_, name_, false)
+
+/// Same as ANKI_TEST but the test runs only when --test names it. Use it for the slow ones like benchmarks
+#define ANKI_TEST_OPT_IN(suiteName_, name_) ANKI_TEST_IMPL(suiteName_, name_, true)
+
 /// Intermediate macro
 #define ANKI_TEST_EXPECT_EQ_IMPL(file_, line_, func_, x, y) \
 	do \
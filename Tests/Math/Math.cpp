@@ -376,3 +376,57 @@ ANKI_TEST(Math, Mat3x4)
 		ANKI_TEST_EXPECT_EQ(m * v, Vec3(20, 44, 68));
 	}
 }
+
+ANKI_TEST(Math, AffineTransformations)
+{
+	const Transform a(Vec4(1.0f, -2.0f, 3.0f, 0.0f), Mat3x4(Vec3(0.0f), Euler(0.3f, -1.1f, 0.7f)), 2.5f);
+	const Transform b(Vec4(-4.0f, 0.5f, 2.0f, 0.0f), Mat3x4(Vec3(0.0f), Euler(-0.2f, 0.4f, 1.9f)), 0.5f);
+	const Vec3 point(0.3f, -7.0f, 11.0f);
+
+	// Compose
+	{
+		const Mat3x4 c = Mat3x4(a).combineTransformations(Mat3x4(b));
+		const Mat4 d = Mat4(a) * Mat4(b);
+		const Mat3x4 e(a.combineTransformations(b));
+		for(U32 j = 0; j < 3; ++j)
+		{
+			for(U32 i = 0; i < 4; ++i)
+			{
+				ANKI_TEST_EXPECT_NEAR(c(j, i), d(j, i), 0.0001f);
+				ANKI_TEST_EXPECT_NEAR(e(j, i), d(j, i), 0.0001f);
+			}
+		}
+	}
+
+	// Inverse
+	{
+		const Mat3x4 inv = Mat3x4(a).getInverseTransformation();
+		const Mat4 inv4 = Mat4(a).getInverse();
+		const Mat3x4 inv2(a.getInverse());
+		for(U32 j = 0; j < 3; ++j)
+		{
+			for(U32 i = 0; i < 4; ++i)
+			{
+				ANKI_TEST_EXPECT_NEAR(inv(j, i), inv4(j, i), 0.0001f);
+				ANKI_TEST_EXPECT_NEAR(inv2(j, i), inv4(j, i), 0.0001f);
+			}
+		}
+	}
+
+	// Point and vector transform
+	{
+		const Vec3 p0 = Mat3x4(a).transform(point);
+		const Vec3 p1 = a.transform(point);
+		const Vec3 p2 = (Mat4(a) * Vec4(point, 1.0f)).xyz();
+		const Vec3 v0 = Mat3x4(a).transformVector(point);
+		const Vec3 v1 = a.transformVector(point);
+		const Vec3 v2 = (Mat4(a) * Vec4(point, 0.0f)).xyz();
+		for(U32 i = 0; i < 3; ++i)
+		{
+			ANKI_TEST_EXPECT_NEAR(p0[i], p2[i], 0.0001f);
+			ANKI_TEST_EXPECT_NEAR(p1[i], p2[i], 0.0001f);
+			ANKI_TEST_EXPECT_NEAR(v0[i], v2[i], 0.0001f);
+			ANKI_TEST_EXPECT_NEAR(v1[i], v2[i], 0.0001f);
+		}
+	}
+}
@@ -0,0 +1,79 @@
+// Copyright (C) 2009-2022, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <Tests/Framework/Framework.h>
+#include <AnKi/Physics/PhysicsWorld.h>
+#include <AnKi/Physics/PhysicsBody.h>
+#include <AnKi/Physics/PhysicsCollisionShape.h>
+
+using namespace anki;
+
+namespace {
+
+class RayCastResult : public PhysicsWorldRayCastCallback
+{
+public:
+	Bool m_hit = false;
+	Vec3 m_position = Vec3(0.0f);
+
+	RayCastResult(const Vec3& from, const Vec3& to)
+		: PhysicsWorldRayCastCallback(from, to, PhysicsMaterialBit::kAll)
+	{
+	}
+
+	void processResult([[maybe_unused]] PhysicsFilteredObject& obj, [[maybe_unused]] const Vec3& worldNormal,
+					   const Vec3& worldPosition) override
+	{
+		m_hit = true;
+		m_position = worldPosition;
+	}
+};
+
+} // end namespace
+
+ANKI_TEST(Physics, RayCastBatch)
+{
+	PhysicsWorld* world = new PhysicsWorld();
+	ANKI_TEST_EXPECT_NO_ERR(world->init(allocAligned, nullptr));
+
+	{
+		// A static box with its +Z face at z=1
+		PhysicsCollisionShapePtr shape = world->newInstance<PhysicsBox>(Vec3(1.0f));
+		PhysicsBodyInitInfo init;
+		init.m_shape = shape;
+		PhysicsBodyPtr body = world->newInstance<PhysicsBody>(init);
+		world->update(1.0 / 60.0);
+
+		// Every ray hits the box further along the ray than the previous one. If the rays shared the closest hit
+		// fraction the later ones would be clipped before they reach the box
+		Array<RayCastResult, 4> results = {RayCastResult(Vec3(0.0f, 0.0f, 3.0f), Vec3(0.0f, 0.0f, -3.0f)),
+										   RayCastResult(Vec3(0.0f, 0.0f, 5.0f), Vec3(0.0f, 0.0f, -5.0f)),
+										   RayCastResult(Vec3(0.5f, 0.0f, 20.0f), Vec3(0.5f, 0.0f, -20.0f)),
+										   RayCastResult(Vec3(0.0f, 0.5f, 100.0f), Vec3(0.0f, 0.5f, -100.0f))};
+
+		Array<PhysicsWorldRayCastCallback*, 4> rays;
+		for(U32 i = 0; i < results.getSize(); ++i)
+		{
+			rays[i] = &results[i];
+		}
+
+		world->rayCast(WeakArray<PhysicsWorldRayCastCallback*>(rays));
+
+		for(const RayCastResult& result : results)
+		{
+			ANKI_TEST_EXPECT_EQ(result.m_hit, true);
+			ANKI_TEST_EXPECT_NEAR(result.m_position.z(), 1.0f, 0.001f);
+			ANKI_TEST_EXPECT_NEAR(result.m_position.x(), result.m_from.x(), 0.001f);
+			ANKI_TEST_EXPECT_NEAR(result.m_position.y(), result.m_from.y(), 0.001f);
+		}
+
+		// A ray that misses after the hits
+		RayCastResult miss(Vec3(5.0f, 0.0f, 5.0f), Vec3(5.0f, 0.0f, -5.0f));
+		world->rayCast(miss);
+		ANKI_TEST_EXPECT_EQ(miss.m_hit, false);
+	}
+
+	delete world;
+}
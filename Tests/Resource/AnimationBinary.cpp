@@ -0,0 +1,44 @@
+// Copyright (C) 2009-2022, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <Tests/Framework/Framework.h>
+#include <AnKi/Resource/AnimationBinary.h>
+
+using namespace anki;
+
+ANKI_TEST(Resource, AnimationBinaryRotationPacking)
+{
+	constexpr F32 kEpsilon = 1.0e-4f;
+
+	for(U32 i = 0; i < 10000; ++i)
+	{
+		Quat q(getRandomRange(-1.0f, 1.0f), getRandomRange(-1.0f, 1.0f), getRandomRange(-1.0f, 1.0f),
+			   getRandomRange(-1.0f, 1.0f));
+		if(q.getLengthSquared() < kEpsilon)
+		{
+			continue;
+		}
+		q /= sqrt(q.getLengthSquared());
+
+		const Array<U16, 3> packed = packAnimationRotation(q);
+		const Quat unpacked = unpackAnimationRotation(&packed[0]);
+
+		// q and -q are the same rotation
+		ANKI_TEST_EXPECT_GEQ(absolute(q.dot(unpacked)), 1.0f - kEpsilon);
+		ANKI_TEST_EXPECT_NEAR(unpacked.getLengthSquared(), 1.0f, kEpsilon);
+	}
+
+	// The largest component can be in any place
+	for(U32 largest = 0; largest < 4; ++largest)
+	{
+		Quat q(0.1f);
+		q[largest] = -1.0f;
+		q /= sqrt(q.getLengthSquared());
+
+		const Array<U16, 3> packed = packAnimationRotation(q);
+		const Quat unpacked = unpackAnimationRotation(&packed[0]);
+		ANKI_TEST_EXPECT_GEQ(absolute(q.dot(unpacked)), 1.0f - kEpsilon);
+	}
+}
@@ -249,6 +249,30 @@ ANKI_TEST(Resource, AsyncLoader)
 		ANKI_TEST_EXPECT_EQ(counter.load(), 4);
 	}
 
+	// Remove tasks from a paused loader
+	{
+		AsyncLoader a;
+		a.init(&pool);
+		Atomic<U32> keptCounter = {0};
+		Atomic<U32> removedCounter = {0};
+
+		a.pause();
+		for(U32 i = 0; i < 10; i++)
+		{
+			a.submitNewTask<Task>(0.0f, nullptr, (i % 2) ? &removedCounter : &keptCounter);
+		}
+
+		const U32 removedCount = a.removeTasks([&](AsyncLoaderTask& task) {
+			return static_cast<Task&>(task).m_count == &removedCounter;
+		});
+		ANKI_TEST_EXPECT_EQ(removedCount, 5);
+
+		a.resume();
+		HighRezTimer::sleep(1.0);
+		ANKI_TEST_EXPECT_EQ(keptCounter.load(), 5);
+		ANKI_TEST_EXPECT_EQ(removedCounter.load(), 0);
+	}
+
 	// Fuzzy test
 	{
 		AsyncLoader a;
@@ -79,6 +79,57 @@ ANKI_TEST(Resource, ResourceManager)
 		}
 	}
 
+	// Load from many threads
+	{
+		class ThreadCtx
+		{
+		public:
+			ResourceManager* m_resources = nullptr;
+			U32 m_threadIdx = 0;
+			DummyResourcePtr m_shared;
+			U32 m_errorCount = 0;
+		};
+
+		Array<ThreadCtx, 4> ctxs;
+		Array<Thread*, 4> threads;
+		for(U32 i = 0; i < threads.getSize(); ++i)
+		{
+			ctxs[i].m_resources = resources;
+			ctxs[i].m_threadIdx = i;
+			threads[i] = alloc.newInstance<Thread>("Load");
+			threads[i]->start(&ctxs[i], [](ThreadCallbackInfo& info) -> Error {
+				ThreadCtx& ctx = *static_cast<ThreadCtx*>(info.m_userData);
+				HeapMemoryPool& pool = ctx.m_resources->getMemoryPool();
+				StringRaii ownName(&pool);
+				ownName.sprintf("thread%u", ctx.m_threadIdx);
+
+				for(U32 i = 0; i < 100; ++i)
+				{
+					// Resources that all threads load and one that only this thread loads
+					DummyResourcePtr shared, common, own;
+					ctx.m_errorCount += (ctx.m_resources->loadResource("shared", shared)) ? 1 : 0;
+					ctx.m_errorCount += (ctx.m_resources->loadResource((i & 1) ? "blah" : "blih", common)) ? 1 : 0;
+					ctx.m_errorCount += (ctx.m_resources->loadResource(ownName, own)) ? 1 : 0;
+					ctx.m_shared = shared;
+				}
+
+				return Error::kNone;
+			});
+		}
+
+		for(Thread* thread : threads)
+		{
+			ANKI_TEST_EXPECT_NO_ERR(thread->join());
+			alloc.deleteInstance(thread);
+		}
+
+		for(const ThreadCtx& ctx : ctxs)
+		{
+			ANKI_TEST_EXPECT_EQ(ctx.m_errorCount, 0);
+			ANKI_TEST_EXPECT_EQ(ctx.m_shared.get(), ctxs[0].m_shared.get());
+		}
+	}
+
 	// Delete
 	alloc.deleteInstance(resources);
 }
@@ -0,0 +1,162 @@
+// Copyright (C) 2009-2022, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <Tests/Scene/HeadlessSceneGraph.h>
+
+using namespace anki;
+
+namespace {
+
+class TestEvent : public Event
+{
+public:
+	Second m_activationTime = -1.0; ///< The time of the 1st update.
+	U32* m_deletedCount = nullptr;
+
+	TestEvent(EventManager* manager)
+		: Event(manager)
+	{
+	}
+
+	~TestEvent()
+	{
+		++(*m_deletedCount);
+	}
+
+	Error init(Second startTime, U32* deletedCount)
+	{
+		Event::init(startTime, 1000000.0);
+		m_deletedCount = deletedCount;
+		return Error::kNone;
+	}
+
+	Error update([[maybe_unused]] Second prevUpdateTime, Second crntTime) override
+	{
+		if(m_activationTime < 0.0)
+		{
+			m_activationTime = crntTime;
+		}
+
+		return Error::kNone;
+	}
+};
+
+class EmptyNode : public SceneNode
+{
+public:
+	EmptyNode(SceneGraph* scene, CString name)
+		: SceneNode(scene, name)
+	{
+	}
+};
+
+} // end anonymous namespace
+
+ANKI_TEST(Scene, EventManager)
+{
+	U32 deletedCount = 0;
+	HeadlessSceneGraph headless;
+	ANKI_TEST_EXPECT_NO_ERR(headless.init());
+	SceneGraph& scene = headless.m_scene;
+	EventManager& events = scene.getEventManager();
+
+	// Events that land in every level of the wheel and in the overflow list. The wheel has 64 ticks per second
+	constexpr U32 kEventCount = 6;
+	const Array<Second, kEventCount> startTimes = {0.5, 10.0, 10.0, 1000.0, 100000.0, 300000.0};
+	Array<TestEvent*, kEventCount> testEvents;
+	for(U32 i = 0; i < kEventCount; ++i)
+	{
+		ANKI_TEST_EXPECT_NO_ERR(events.newEvent(testEvents[i], startTimes[i], &deletedCount));
+	}
+
+	EmptyNode* nodeA;
+	ANKI_TEST_EXPECT_NO_ERR(scene.newSceneNode("A", nodeA));
+	EmptyNode* nodeB;
+	ANKI_TEST_EXPECT_NO_ERR(scene.newSceneNode("B", nodeB));
+	events.addAssociatedSceneNode(testEvents[2], nodeA);
+	events.addAssociatedSceneNode(testEvents[2], nodeB);
+	events.addAssociatedSceneNode(testEvents[3], nodeB);
+
+	Second prevTime = 0.0;
+	auto advance = [&](Second crntTime) {
+		ANKI_TEST_EXPECT_NO_ERR(events.updateAllEvents(prevTime, crntTime));
+		prevTime = crntTime;
+	};
+
+	auto expectActivated = [&](U32 activatedCount, Second activationTime) {
+		ANKI_TEST_EXPECT_EQ(events.getActiveEventCount(), activatedCount);
+		ANKI_TEST_EXPECT_EQ(testEvents[activatedCount - 1]->m_activationTime, activationTime);
+		if(activatedCount < kEventCount)
+		{
+			ANKI_TEST_EXPECT_EQ(testEvents[activatedCount]->m_activationTime, -1.0);
+		}
+	};
+
+	advance(0.0);
+	ANKI_TEST_EXPECT_EQ(events.getActiveEventCount(), 0);
+	advance(0.4);
+	ANKI_TEST_EXPECT_EQ(events.getActiveEventCount(), 0);
+
+	// Level 0
+	advance(0.6);
+	expectActivated(1, 0.6);
+
+	// Level 1
+	advance(9.9);
+	expectActivated(1, 0.6);
+	advance(10.1);
+	expectActivated(3, 10.1);
+	ANKI_TEST_EXPECT_EQ(testEvents[1]->m_activationTime, 10.1);
+
+	// Level 2. Jump over many slots at once
+	advance(999.0);
+	expectActivated(3, 10.1);
+	advance(1000.0);
+	expectActivated(4, 1000.0);
+
+	// Level 3
+	advance(99999.0);
+	expectActivated(4, 1000.0);
+	advance(100000.5);
+	expectActivated(5, 100000.5);
+
+	// Overflow
+	advance(299999.0);
+	expectActivated(5, 100000.5);
+	advance(300001.0);
+	expectActivated(6, 300001.0);
+
+	// An event that is added after the wheel moved
+	TestEvent* lateEvent;
+	ANKI_TEST_EXPECT_NO_ERR(events.newEvent(lateEvent, 300100.0, &deletedCount));
+	events.addAssociatedSceneNode(lateEvent, nodeA);
+	advance(300099.0);
+	ANKI_TEST_EXPECT_EQ(lateEvent->m_activationTime, -1.0);
+	advance(300100.0);
+	ANKI_TEST_EXPECT_EQ(lateEvent->m_activationTime, 300100.0);
+	ANKI_TEST_EXPECT_EQ(events.getActiveEventCount(), kEventCount + 1);
+
+	// Delete the events of a node. The events of the node that are shared with another node go as well
+	events.deleteSceneNodeEvents(*nodeA);
+	ANKI_TEST_EXPECT_EQ(deletedCount, 2);
+	ANKI_TEST_EXPECT_EQ(events.getActiveEventCount(), kEventCount - 1);
+
+	// Delete the other node through the scene
+	nodeB->setMarkedForDeletion();
+	scene.deleteNodesMarkedForDeletion();
+	ANKI_TEST_EXPECT_EQ(deletedCount, 3);
+	ANKI_TEST_EXPECT_EQ(events.getActiveEventCount(), kEventCount - 2);
+
+	// The rest are still updated
+	for(U32 i : {0u, 1u, 4u, 5u})
+	{
+		testEvents[i]->m_activationTime = -1.0;
+	}
+	advance(300200.0);
+	for(U32 i : {0u, 1u, 4u, 5u})
+	{
+		ANKI_TEST_EXPECT_EQ(testEvents[i]->m_activationTime, 300200.0);
+	}
+}
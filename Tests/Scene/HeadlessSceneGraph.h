@@ -0,0 +1,66 @@
+// Copyright (C) 2009-2022, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#pragma once
+
+#include <Tests/Framework/Framework.h>
+#include <AnKi/Scene.h>
+#include <AnKi/Physics/PhysicsWorld.h>
+#include <AnKi/Resource/AsyncLoader.h>
+#include <AnKi/Resource/ResourceFilesystem.h>
+#include <AnKi/Script/ScriptManager.h>
+#include <AnKi/Core/ConfigSet.h>
+#include <AnKi/Util/System.h>
+
+namespace anki {
+
+/// A SceneGraph that doesn't need a GPU. It's initialized without a ResourceManager so the tests can create the nodes
+/// that don't load resources, update the scene and do visibility tests. The filesystem starts without paths. The tests
+/// that read files add their own with addNewPath().
+class HeadlessSceneGraph
+{
+public:
+	HeapMemoryPool m_pool{allocAligned, nullptr};
+	ConfigSet m_config;
+	PhysicsWorld m_physics;
+	ThreadHive m_hive{getCpuCoresCount(), &m_pool, false};
+	AsyncLoader m_loader;
+	ResourceFilesystem m_fs;
+	ScriptManager m_script;
+	Timestamp m_globalTimestamp = 1;
+	Second m_time = 0.0;
+	SceneGraph m_scene;
+
+	Error init()
+	{
+		ANKI_CHECK(m_physics.init(allocAligned, nullptr));
+		m_loader.init(&m_pool);
+		m_fs.m_pool.init(allocAligned, nullptr);
+		ANKI_CHECK(m_script.init(allocAligned, nullptr));
+		m_script.setSceneGraph(&m_scene);
+
+		ANKI_CHECK(m_scene.init(allocAligned, nullptr, &m_hive, nullptr, &m_physics, nullptr, &m_script, nullptr,
+								&m_config, &m_globalTimestamp, nullptr, nullptr));
+		m_scene.getSectorStreamer().init(&m_scene, &m_loader, &m_fs);
+
+		return Error::kNone;
+	}
+
+	/// Advance the time by a frame and update the scene.
+	Error update()
+	{
+		++m_globalTimestamp;
+		const Second prevTime = m_time;
+		m_time += 1.0 / 60.0;
+		return m_scene.update(prevTime, m_time);
+	}
+
+	SceneNode& getCamera()
+	{
+		return m_scene.getActiveCameraNode();
+	}
+};
+
+} // end namespace anki
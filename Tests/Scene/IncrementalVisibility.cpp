@@ -0,0 +1,90 @@
+// Copyright (C) 2009-2022, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <Tests/Scene/HeadlessSceneGraph.h>
+#include <AnKi/Renderer/RenderQueue.h>
+
+using namespace anki;
+
+static Bool cacheContains(const FrustumComponent& frc, const SceneNode& node)
+{
+	const SpatialComponent* spatial = &node.getFirstComponentOfType<SpatialComponent>();
+	for(const SpatialComponent* s : frc.getVisibleSpatialsCache().m_spatials)
+	{
+		if(s == spatial)
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+ANKI_TEST(Scene, IncrementalVisibility)
+{
+	HeadlessSceneGraph headless;
+	headless.m_config.setSceneIncrementalVisibility(true);
+	ANKI_TEST_EXPECT_NO_ERR(headless.init());
+	SceneGraph& scene = headless.m_scene;
+
+	// The camera is at the origin and looks at -Z
+	const FrustumComponent& frc = headless.getCamera().getFirstComponentOfType<FrustumComponent>();
+
+	FogDensityNode* staticNode;
+	ANKI_TEST_EXPECT_NO_ERR(scene.newSceneNode("static", staticNode));
+	staticNode->getFirstComponentOfType<MoveComponent>().setLocalOrigin(Vec4(0.0f, 0.0f, -20.0f, 0.0f));
+
+	FogDensityNode* movingNode;
+	ANKI_TEST_EXPECT_NO_ERR(scene.newSceneNode("moving", movingNode));
+	MoveComponent& movingMove = movingNode->getFirstComponentOfType<MoveComponent>();
+	movingMove.setLocalOrigin(Vec4(5.0f, 0.0f, -20.0f, 0.0f));
+
+	auto updateAndTest = [&]() -> U32 {
+		ANKI_TEST_EXPECT_NO_ERR(headless.update());
+		RenderQueue rqueue;
+		scene.doVisibilityTests(rqueue);
+		return rqueue.m_fogDensityVolumes.getSize();
+	};
+
+	// 1st frame, everything is tested
+	ANKI_TEST_EXPECT_EQ(updateAndTest(), 2);
+	ANKI_TEST_EXPECT_EQ(frc.getVisibleSpatialsCache().m_reusedSpatialCount, 0);
+	ANKI_TEST_EXPECT_EQ(cacheContains(frc, *staticNode), true);
+	ANKI_TEST_EXPECT_EQ(cacheContains(frc, *movingNode), true);
+
+	// Nothing moved, everything is re-used
+	ANKI_TEST_EXPECT_EQ(updateAndTest(), 2);
+	ANKI_TEST_EXPECT_EQ(frc.getVisibleSpatialsCache().m_reusedSpatialCount, 2);
+
+	// Move a node behind the camera. It's tested again and rejected. The static one is re-used
+	movingMove.setLocalOrigin(Vec4(5.0f, 0.0f, 20.0f, 0.0f));
+	ANKI_TEST_EXPECT_EQ(updateAndTest(), 1);
+	ANKI_TEST_EXPECT_EQ(frc.getVisibleSpatialsCache().m_reusedSpatialCount, 1);
+	ANKI_TEST_EXPECT_EQ(cacheContains(frc, *staticNode), true);
+	ANKI_TEST_EXPECT_EQ(cacheContains(frc, *movingNode), false);
+
+	// Still outside, still not visible
+	ANKI_TEST_EXPECT_EQ(updateAndTest(), 1);
+	ANKI_TEST_EXPECT_EQ(frc.getVisibleSpatialsCache().m_reusedSpatialCount, 1);
+
+	// Move it back. It's found even though it wasn't in the cache
+	movingMove.setLocalOrigin(Vec4(-5.0f, 0.0f, -20.0f, 0.0f));
+	ANKI_TEST_EXPECT_EQ(updateAndTest(), 2);
+	ANKI_TEST_EXPECT_EQ(frc.getVisibleSpatialsCache().m_reusedSpatialCount, 1);
+	ANKI_TEST_EXPECT_EQ(cacheContains(frc, *movingNode), true);
+
+	// Deleting a node drops the cache
+	staticNode->setMarkedForDeletion();
+	ANKI_TEST_EXPECT_EQ(updateAndTest(), 1);
+	ANKI_TEST_EXPECT_EQ(frc.getVisibleSpatialsCache().m_reusedSpatialCount, 0);
+	ANKI_TEST_EXPECT_EQ(updateAndTest(), 1);
+	ANKI_TEST_EXPECT_EQ(frc.getVisibleSpatialsCache().m_reusedSpatialCount, 1);
+
+	// Turn the camera around. Nothing can be re-used and nothing is visible
+	headless.getCamera().getFirstComponentOfType<MoveComponent>().rotateLocalY(toRad(180.0f));
+	ANKI_TEST_EXPECT_EQ(updateAndTest(), 0);
+	ANKI_TEST_EXPECT_EQ(frc.getVisibleSpatialsCache().m_reusedSpatialCount, 0);
+	ANKI_TEST_EXPECT_EQ(cacheContains(frc, *movingNode), false);
+}
@@ -0,0 +1,73 @@
+// Copyright (C) 2009-2022, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <Tests/Framework/Framework.h>
+#include <AnKi/Scene/LodPolicy.h>
+
+using namespace anki;
+
+ANKI_TEST(Scene, LodPolicy)
+{
+	const Mat4 proj = Mat4::calculatePerspectiveProjectionMatrix(toRad(90.0f), toRad(90.0f), 0.1f, 1000.0f);
+	const Array<F32, 3> errors = {0.01f, 0.05f, 0.2f};
+	const ConstWeakArray<F32> lodErrors(errors);
+
+	LodPolicy policy;
+	policy.setParameters(2.0f, 0.2f, 0);
+	policy.beginFrame(proj, Vec3(0.0f), 1000);
+
+	// With 90 degrees of FOV and 1000 pixels a unit sphere at distance d has a radius of 500 / d pixels
+	auto selectAt = [&](F32 dist, U8 prevLod) {
+		return policy.selectLod(lodErrors, Vec3(0.0f, 0.0f, -(dist + 1.0f)), 1.0f, prevLod);
+	};
+
+	// LOD 1 projects 25px at d=1 and 2px at d=12.5. LOD 2 projects 2px at d=50
+	ANKI_TEST_EXPECT_EQ(selectAt(0.5f, kMaxU8), 0);
+	ANKI_TEST_EXPECT_EQ(selectAt(20.0f, kMaxU8), 1);
+	ANKI_TEST_EXPECT_EQ(selectAt(100.0f, kMaxU8), 2);
+
+	// Camera inside the sphere
+	ANKI_TEST_EXPECT_EQ(policy.selectLod(lodErrors, Vec3(0.0f), 1.0f, kMaxU8), 0);
+
+	// Hysteresis. Close to the boundary of LOD 1 and 2 keep the previous LOD
+	ANKI_TEST_EXPECT_EQ(selectAt(48.0f, kMaxU8), 1);
+	ANKI_TEST_EXPECT_EQ(selectAt(48.0f, 2), 2);
+	ANKI_TEST_EXPECT_EQ(selectAt(52.0f, kMaxU8), 2);
+	ANKI_TEST_EXPECT_EQ(selectAt(52.0f, 1), 1);
+
+	// Outside of the band switch
+	ANKI_TEST_EXPECT_EQ(selectAt(30.0f, 2), 1);
+	ANKI_TEST_EXPECT_EQ(selectAt(80.0f, 1), 2);
+	ANKI_TEST_EXPECT_EQ(selectAt(0.5f, 2), 0);
+
+	// Budget. Over budget increases the bias and that selects coarser LODs
+	policy.setParameters(2.0f, 0.0f, 1000);
+	policy.endFrame(500);
+	ANKI_TEST_EXPECT_EQ(policy.getBias(), 0.0f);
+	ANKI_TEST_EXPECT_EQ(selectAt(40.0f, kMaxU8), 1);
+
+	policy.endFrame(4000);
+	ANKI_TEST_EXPECT_GT(policy.getBias(), 0.0f);
+	ANKI_TEST_EXPECT_EQ(selectAt(40.0f, kMaxU8), 2);
+
+	for(U32 i = 0; i < 100; ++i)
+	{
+		policy.endFrame(1000000);
+	}
+	ANKI_TEST_EXPECT_EQ(policy.getBias(), LodPolicy::kMaxBias);
+
+	// Under budget goes back to zero
+	for(U32 i = 0; i < 100; ++i)
+	{
+		policy.endFrame(100);
+	}
+	ANKI_TEST_EXPECT_EQ(policy.getBias(), 0.0f);
+
+	// Disabled budget
+	policy.endFrame(1000000);
+	policy.setParameters(2.0f, 0.0f, 0);
+	policy.endFrame(1000000);
+	ANKI_TEST_EXPECT_EQ(policy.getBias(), 0.0f);
+}
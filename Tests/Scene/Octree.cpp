@@ -5,6 +5,9 @@
 
 #include <Tests/Framework/Framework.h>
 #include <AnKi/Scene/Octree.h>
+#include <AnKi/Collision/Functions.h>
+#include <AnKi/Util/System.h>
+#include <AnKi/Util/HighRezTimer.h>
 
 ANKI_TEST(Scene, Octree)
 {
@@ -82,3 +85,343 @@ ANKI_TEST(Scene, Octree)
 	}
 #endif
 }
+
+ANKI_TEST(Scene, OctreeDeferredPlacement)
+{
+	HeapMemoryPool pool(allocAligned, nullptr);
+	ThreadHive hive(getCpuCoresCount(), &pool);
+
+	constexpr U32 kPlaceableCount = 2000;
+	constexpr F32 kWorldSize = 100.0f;
+	const Vec3 sceneMin(-kWorldSize);
+	const Vec3 sceneMax(kWorldSize);
+
+	// Place the same things in 2 octrees, one immediately and one deferred, and compare the results
+	Octree immediate(&pool);
+	immediate.init(sceneMin, sceneMax, 5);
+	Octree deferred(&pool);
+	deferred.init(sceneMin, sceneMax, 5, OctreeFlag::kDeferredPlacement);
+	ANKI_TEST_EXPECT_EQ(deferred.getDeferredPlacementEnabled(), true);
+
+	OctreePlaceable* immediatePlaceables = newArray<OctreePlaceable>(pool, kPlaceableCount);
+	OctreePlaceable* deferredPlaceables = newArray<OctreePlaceable>(pool, kPlaceableCount);
+	for(U32 i = 0; i < kPlaceableCount; ++i)
+	{
+		immediatePlaceables[i].m_userData = numberToPtr<void*>(i + 1);
+		deferredPlaceables[i].m_userData = numberToPtr<void*>(i + 1);
+	}
+
+	DynamicArrayRaii<U8> immediateFound(&pool, kPlaceableCount);
+	DynamicArrayRaii<U8> deferredFound(&pool, kPlaceableCount);
+
+	for(U32 iteration = 0; iteration < 4; ++iteration)
+	{
+		// Move everything. Some objects are huge and some always visible so that they go to the root
+		for(U32 i = 0; i < kPlaceableCount; ++i)
+		{
+			const U32 threadId = i % hive.getThreadCount();
+			if(i % 97 == 0)
+			{
+				immediate.placeAlwaysVisible(&immediatePlaceables[i]);
+				deferred.placeAlwaysVisibleDeferred(&deferredPlaceables[i], threadId);
+				continue;
+			}
+
+			const F32 size = (i % 13 == 0) ? kWorldSize : getRandomRange(0.1f, 5.0f);
+			const Vec3 center(getRandomRange(-kWorldSize + size, kWorldSize - size),
+							  getRandomRange(-kWorldSize + size, kWorldSize - size),
+							  getRandomRange(-kWorldSize + size, kWorldSize - size));
+			const Aabb volume(center - size, center + size);
+
+			immediate.place(volume, &immediatePlaceables[i], true);
+			deferred.placeDeferred(volume, &deferredPlaceables[i], true, threadId);
+		}
+
+		deferred.commitDeferredPlacements(hive);
+
+		Vec3 immediateMin, immediateMax, deferredMin, deferredMax;
+		immediate.getActualSceneBounds(immediateMin, immediateMax);
+		deferred.getActualSceneBounds(deferredMin, deferredMax);
+		ANKI_TEST_EXPECT_EQ(immediateMin, deferredMin);
+		ANKI_TEST_EXPECT_EQ(immediateMax, deferredMax);
+
+		// Query both
+		for(U32 query = 0; query < 10; ++query)
+		{
+			const Vec3 center(getRandomRange(-kWorldSize, kWorldSize), getRandomRange(-kWorldSize, kWorldSize),
+							  getRandomRange(-kWorldSize, kWorldSize));
+			const Aabb queryBox(center - 20.0f, center + 20.0f);
+			const U32 testId = (iteration * 10 + query) % 128;
+
+			for(U32 i = 0; i < kPlaceableCount; ++i)
+			{
+				immediatePlaceables[i].reset();
+				deferredPlaceables[i].reset();
+			}
+
+			memset(&immediateFound[0], 0, immediateFound.getSizeInBytes());
+			memset(&deferredFound[0], 0, deferredFound.getSizeInBytes());
+
+			auto testFunc = [&](const Aabb& box) {
+				return testCollision(box, queryBox);
+			};
+
+			immediate.walkTree(testId, testFunc, [&](void* userData) {
+				++immediateFound[U32(ptrToNumber(userData) - 1)];
+			});
+			deferred.walkTree(testId, testFunc, [&](void* userData) {
+				++deferredFound[U32(ptrToNumber(userData) - 1)];
+			});
+
+			for(U32 i = 0; i < kPlaceableCount; ++i)
+			{
+				ANKI_TEST_EXPECT_EQ(immediateFound[i], deferredFound[i]);
+			}
+		}
+	}
+
+	for(U32 i = 0; i < kPlaceableCount; ++i)
+	{
+		immediate.remove(immediatePlaceables[i]);
+		deferred.remove(deferredPlaceables[i]);
+	}
+
+	deleteArray(pool, immediatePlaceables, kPlaceableCount);
+	deleteArray(pool, deferredPlaceables, kPlaceableCount);
+}
+
+ANKI_TEST(Scene, OctreeWalkTreeMulti)
+{
+	HeapMemoryPool pool(allocAligned, nullptr);
+
+	constexpr U32 kPlaceableCount = 2000;
+	constexpr U32 kQueryCount = 6;
+	constexpr F32 kWorldSize = 100.0f;
+
+	Octree octree(&pool);
+	octree.init(Vec3(-kWorldSize), Vec3(kWorldSize), 5);
+
+	OctreePlaceable* placeables = newArray<OctreePlaceable>(pool, kPlaceableCount);
+	for(U32 i = 0; i < kPlaceableCount; ++i)
+	{
+		placeables[i].m_userData = numberToPtr<void*>(i + 1);
+
+		const F32 size = (i % 13 == 0) ? kWorldSize / 2.0f : getRandomRange(0.1f, 5.0f);
+		const Vec3 center(getRandomRange(-kWorldSize + size, kWorldSize - size),
+						  getRandomRange(-kWorldSize + size, kWorldSize - size),
+						  getRandomRange(-kWorldSize + size, kWorldSize - size));
+		octree.place(Aabb(center - size, center + size), &placeables[i], true);
+	}
+
+	// Overlapping queries like the faces of a point light
+	Array<Vec3, kQueryCount> queryMins;
+	Array<Vec3, kQueryCount> queryMaxs;
+	const Vec3 origin(getRandomRange(-10.0f, 10.0f), getRandomRange(-10.0f, 10.0f), getRandomRange(-10.0f, 10.0f));
+	for(U32 q = 0; q < kQueryCount; ++q)
+	{
+		Vec3 offset(0.0f);
+		offset[q / 2] = (q % 2) ? -25.0f : 25.0f;
+		queryMins[q] = origin + offset - 30.0f;
+		queryMaxs[q] = origin + offset + 30.0f;
+	}
+
+	// One walk per query
+	DynamicArrayRaii<U8> singleFound(&pool, kPlaceableCount * kQueryCount, 0);
+	for(U32 q = 0; q < kQueryCount; ++q)
+	{
+		const Aabb queryBox(queryMins[q], queryMaxs[q]);
+		octree.walkTree(
+			q,
+			[&](const Aabb& box) {
+				return testCollision(box, queryBox);
+			},
+			[&](void* userData) {
+				++singleFound[U32(ptrToNumber(userData) - 1) * kQueryCount + q];
+			});
+	}
+
+	// One walk for all
+	for(U32 i = 0; i < kPlaceableCount; ++i)
+	{
+		placeables[i].reset();
+	}
+
+	DynamicArrayRaii<U8> multiFound(&pool, kPlaceableCount * kQueryCount, 0);
+	octree.walkTreeMulti(
+		10, kQueryCount,
+		[&](const Aabb& box, U32 testMask) {
+			U32 out = 0;
+			for(U32 q = 0; q < kQueryCount; ++q)
+			{
+				if((testMask & (1u << q)) && testCollision(box, Aabb(queryMins[q], queryMaxs[q])))
+				{
+					out |= 1u << q;
+				}
+			}
+			return out;
+		},
+		[&](void* userData, U32 testMask) {
+			ANKI_TEST_EXPECT_NEQ(testMask, 0);
+			for(U32 q = 0; q < kQueryCount; ++q)
+			{
+				multiFound[U32(ptrToNumber(userData) - 1) * kQueryCount + q] += (testMask >> q) & 1u;
+			}
+		});
+
+	for(U32 i = 0; i < kPlaceableCount * kQueryCount; ++i)
+	{
+		ANKI_TEST_EXPECT_LEQ(singleFound[i], 1);
+		ANKI_TEST_EXPECT_EQ(singleFound[i], multiFound[i]);
+	}
+
+	for(U32 i = 0; i < kPlaceableCount; ++i)
+	{
+		octree.remove(placeables[i]);
+	}
+
+	deleteArray(pool, placeables, kPlaceableCount);
+}
+
+ANKI_TEST(Scene, OctreeLooseBenchmark)
+{
+	HeapMemoryPool pool(allocAligned, nullptr);
+	ThreadHive hive(getCpuCoresCount(), &pool);
+
+	constexpr U32 kPlaceableCount = 100000;
+	constexpr U32 kFrameCount = 8;
+	constexpr U32 kQueryCount = 64;
+	constexpr F32 kWorldSize = 1000.0f;
+	const Vec3 sceneMin(-kWorldSize);
+	const Vec3 sceneMax(kWorldSize);
+
+	// Generate the same moving objects for all the octree flavors
+	DynamicArrayRaii<Vec3> centers(&pool, kPlaceableCount);
+	DynamicArrayRaii<Vec3> velocities(&pool, kPlaceableCount);
+	DynamicArrayRaii<F32> sizes(&pool, kPlaceableCount);
+	for(U32 i = 0; i < kPlaceableCount; ++i)
+	{
+		sizes[i] = (i % 101 == 0) ? getRandomRange(20.0f, 100.0f) : getRandomRange(0.5f, 4.0f);
+		const F32 range = kWorldSize - sizes[i];
+		centers[i] = Vec3(getRandomRange(-range, range), getRandomRange(-range, range), getRandomRange(-range, range));
+		velocities[i] =
+			Vec3(getRandomRange(-1.0f, 1.0f), getRandomRange(-1.0f, 1.0f), getRandomRange(-1.0f, 1.0f)) * 2.0f;
+	}
+
+	DynamicArrayRaii<Vec3> queryCenters(&pool, kQueryCount);
+	for(Vec3& center : queryCenters)
+	{
+		center = Vec3(getRandomRange(-kWorldSize, kWorldSize), getRandomRange(-kWorldSize, kWorldSize),
+					  getRandomRange(-kWorldSize, kWorldSize));
+	}
+
+	OctreePlaceable* placeables = newArray<OctreePlaceable>(pool, kPlaceableCount);
+	for(U32 i = 0; i < kPlaceableCount; ++i)
+	{
+		placeables[i].m_userData = numberToPtr<void*>(i + 1);
+	}
+
+	DynamicArrayRaii<Vec3> crntCenters(&pool, kPlaceableCount);
+	DynamicArrayRaii<U8> found(&pool, kPlaceableCount);
+
+	const Array<OctreeFlag, 3> allFlags = {OctreeFlag::kNone, OctreeFlag::kLoose,
+										   OctreeFlag::kLoose | OctreeFlag::kDeferredPlacement};
+	const Array<CString, 3> names = {"Octree", "Loose octree", "Loose octree deferred"};
+	for(U32 flavor = 0; flavor < allFlags.getSize(); ++flavor)
+	{
+		Octree octree(&pool);
+		octree.init(sceneMin, sceneMax, 6, allFlags[flavor]);
+		const Bool deferred = octree.getDeferredPlacementEnabled();
+
+		auto placeAll = [&]() {
+			for(U32 i = 0; i < kPlaceableCount; ++i)
+			{
+				const Aabb volume(crntCenters[i] - sizes[i], crntCenters[i] + sizes[i]);
+				if(deferred)
+				{
+					octree.placeDeferred(volume, &placeables[i], false, i % hive.getThreadCount());
+				}
+				else
+				{
+					octree.place(volume, &placeables[i], false);
+				}
+			}
+
+			if(deferred)
+			{
+				octree.commitDeferredPlacements(hive);
+			}
+		};
+
+		for(U32 i = 0; i < kPlaceableCount; ++i)
+		{
+			crntCenters[i] = centers[i];
+			placeables[i].reset();
+		}
+
+		// Insert
+		F64 begin = HighRezTimer::getCurrentTime();
+		placeAll();
+		const F64 insertTime = HighRezTimer::getCurrentTime() - begin;
+
+		// Move
+		F64 moveTime = 0.0;
+		for(U32 frame = 0; frame < kFrameCount; ++frame)
+		{
+			for(U32 i = 0; i < kPlaceableCount; ++i)
+			{
+				crntCenters[i] = (crntCenters[i] + velocities[i]).max(sceneMin).min(sceneMax);
+			}
+
+			begin = HighRezTimer::getCurrentTime();
+			placeAll();
+			moveTime += HighRezTimer::getCurrentTime() - begin;
+		}
+
+		// Query
+		F64 queryTime = 0.0;
+		U64 visitedCount = 0;
+		for(U32 q = 0; q < kQueryCount; ++q)
+		{
+			const Aabb query(queryCenters[q] - 50.0f, queryCenters[q] + 50.0f);
+			memset(&found[0], 0, found.getSizeInBytes());
+
+			begin = HighRezTimer::getCurrentTime();
+			octree.walkTree(
+				q % 128,
+				[&](const Aabb& box) {
+					return testCollision(box, query);
+				},
+				[&](void* userData) {
+					++found[U32(ptrToNumber(userData) - 1)];
+					++visitedCount;
+				});
+			queryTime += HighRezTimer::getCurrentTime() - begin;
+
+			// The results should be conservative
+			if(q % 8 == 0)
+			{
+				for(U32 i = 0; i < kPlaceableCount; ++i)
+				{
+					ANKI_TEST_EXPECT_LEQ(found[i], 1);
+
+					const Aabb volume(crntCenters[i] - sizes[i], crntCenters[i] + sizes[i]);
+					if(testCollision(volume, query))
+					{
+						ANKI_TEST_EXPECT_EQ(found[i], 1);
+					}
+				}
+			}
+		}
+
+		ANKI_TEST_LOGI("%s: insert %fms, move %fms/frame, query %fms/query, %f placeables visited/query",
+					   names[flavor].cstr(), insertTime * 1000.0, moveTime * 1000.0 / kFrameCount,
+					   queryTime * 1000.0 / kQueryCount, F64(visitedCount) / kQueryCount);
+
+		for(U32 i = 0; i < kPlaceableCount; ++i)
+		{
+			octree.remove(placeables[i]);
+		}
+	}
+
+	deleteArray(pool, placeables, kPlaceableCount);
+}
@@ -0,0 +1,116 @@
+// Copyright (C) 2009-2022, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <Tests/Framework/Framework.h>
+#include <AnKi/Scene/ParticleSimulation.h>
+#include <AnKi/Resource/ParticleEmitterResource.h>
+
+using namespace anki;
+
+ANKI_TEST(Scene, ParticleSimulation)
+{
+	HeapMemoryPool pool(allocAligned, nullptr);
+
+	constexpr U32 kMaxParticles = 10;
+	Array<F32, kMaxParticles * ParticleSimulation::kVertexSize / sizeof(F32)> verts;
+	Vec3 aabbMin, aabbMax;
+	F32 maxSize;
+
+	ParticleEmitterProperties props;
+	props.m_particle.m_minLife = 1.0;
+	props.m_particle.m_maxLife = 1.0;
+	props.m_particle.m_minInitialSize = props.m_particle.m_maxInitialSize = 1.0f;
+	props.m_particle.m_minFinalSize = props.m_particle.m_maxFinalSize = 3.0f;
+	props.m_particle.m_minGravity = props.m_particle.m_maxGravity = Vec3(0.0f, -10.0f, 0.0f);
+
+	// Random values stay in range
+	{
+		SimdRandom rand;
+		rand.seed(123);
+		for(U32 i = 0; i < 1000; ++i)
+		{
+			const Vec4 r = rand.getRandom();
+			for(U32 j = 0; j < 4; ++j)
+			{
+				ANKI_TEST_EXPECT_GEQ(r[j], 0.0f);
+				ANKI_TEST_EXPECT_LT(r[j], 1.0f);
+			}
+		}
+	}
+
+	{
+		ParticleSimulation sim;
+		sim.init(&pool, kMaxParticles, 1);
+
+		// Can't emit more than the max
+		sim.emit(props, Vec3(1.0f, 2.0f, 3.0f), 6);
+		ANKI_TEST_EXPECT_EQ(sim.getAliveParticleCount(), 6);
+
+		props.m_particle.m_minLife = props.m_particle.m_maxLife = 0.3;
+		sim.emit(props, Vec3(1.0f, 2.0f, 3.0f), 6);
+		ANKI_TEST_EXPECT_EQ(sim.getAliveParticleCount(), kMaxParticles);
+
+		// Integrate
+		ANKI_TEST_EXPECT_EQ(sim.simulate(0.25f, &verts[0], aabbMin, aabbMax, maxSize), kMaxParticles);
+		ANKI_TEST_EXPECT_NEAR(aabbMin.y(), 2.0f - 10.0f * 0.25f * 0.25f, 1.0e-5f);
+		ANKI_TEST_EXPECT_NEAR(aabbMax.x(), 1.0f, 1.0e-5f);
+		ANKI_TEST_EXPECT_NEAR(maxSize, 1.0f + 2.0f * 0.25f / 0.3f, 1.0e-5f);
+		ANKI_TEST_EXPECT_NEAR(verts[3], 1.5f, 1.0e-5f);
+
+		// The short lived ones die and the rest get compacted
+		ANKI_TEST_EXPECT_EQ(sim.simulate(0.25f, &verts[0], aabbMin, aabbMax, maxSize), 6);
+		ANKI_TEST_EXPECT_NEAR(maxSize, 2.0f, 1.0e-5f);
+		for(U32 i = 0; i < 6; ++i)
+		{
+			ANKI_TEST_EXPECT_NEAR(verts[i * 5 + 1], 2.0f - 10.0f * 0.25f * 0.25f * 3.0f, 1.0e-5f);
+			ANKI_TEST_EXPECT_NEAR(verts[i * 5 + 3], 2.0f, 1.0e-5f);
+		}
+
+		// There is space for new ones. The old ones die first
+		props.m_particle.m_minLife = props.m_particle.m_maxLife = 2.0;
+		sim.emit(props, Vec3(0.0f), 10);
+		ANKI_TEST_EXPECT_EQ(sim.getAliveParticleCount(), kMaxParticles);
+
+		ANKI_TEST_EXPECT_EQ(sim.simulate(0.6f, &verts[0], aabbMin, aabbMax, maxSize), 4);
+		ANKI_TEST_EXPECT_NEAR(aabbMax.y(), -10.0f * 0.6f * 0.6f, 1.0e-5f);
+		ANKI_TEST_EXPECT_EQ(sim.simulate(2.0f, &verts[0], aabbMin, aabbMax, maxSize), 0);
+	}
+
+	// Bounce off a plane at y=0
+	{
+		ParticleSimulation sim;
+		sim.init(&pool, kMaxParticles, 2);
+
+		auto collideWithGround = [](void* userData, WeakArray<ParticleCollisionRay> rays) {
+			U32& rayCount = *static_cast<U32*>(userData);
+			rayCount += rays.getSize();
+			for(ParticleCollisionRay& ray : rays)
+			{
+				ray.m_hit = ray.m_from.y() >= 0.0f && ray.m_to.y() < 0.0f;
+				if(ray.m_hit)
+				{
+					const F32 t = ray.m_from.y() / (ray.m_from.y() - ray.m_to.y());
+					ray.m_hitPosition = ray.m_from + (ray.m_to - ray.m_from) * t;
+					ray.m_hitNormal = Vec3(0.0f, 1.0f, 0.0f);
+				}
+			}
+		};
+
+		U32 rayCount = 0;
+		sim.setCollisionCallback(collideWithGround, &rayCount, 0.5f);
+
+		props.m_particle.m_minLife = props.m_particle.m_maxLife = 10.0;
+		sim.emit(props, Vec3(0.0f, 1.0f, 0.0f), kMaxParticles);
+
+		// Falls 1.25 units and hits the ground
+		ANKI_TEST_EXPECT_EQ(sim.simulate(0.5f, &verts[0], aabbMin, aabbMax, maxSize), kMaxParticles);
+		ANKI_TEST_EXPECT_EQ(rayCount, kMaxParticles);
+		ANKI_TEST_EXPECT_NEAR(aabbMin.y(), ParticleSimulation::kCollisionOffset, 1.0e-5f);
+
+		// Bounced up with half the speed
+		ANKI_TEST_EXPECT_EQ(sim.simulate(0.01f, &verts[0], aabbMin, aabbMax, maxSize), kMaxParticles);
+		ANKI_TEST_EXPECT_GT(aabbMin.y(), ParticleSimulation::kCollisionOffset);
+	}
+}
@@ -0,0 +1,240 @@
+// Copyright (C) 2009-2022, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <Tests/Scene/HeadlessSceneGraph.h>
+#include <AnKi/Renderer/RenderQueue.h>
+#include <AnKi/Util/Tracer.h>
+#include <cstdlib>
+
+using namespace anki;
+
+namespace {
+
+/// The knobs of the benchmark. Every one can be overridden by an environment variable so CI can run it at different
+/// sizes without a rebuild.
+class SceneBenchmarkConfig
+{
+public:
+	U32 m_volumeNodeCount = 5000; ///< Fog density volumes. They stand in for the models that need a GPU to load.
+	U32 m_lightNodeCount = 500;
+	U32 m_probeNodeCount = 50;
+	U32 m_frameCount = 120;
+	F32 m_worldSize = 500.0f; ///< The nodes are placed inside a box of that size.
+	F32 m_movingNodeFraction = 0.25f; ///< How many of the nodes move every frame.
+	F32 m_speed = 10.0f; ///< The speed of the moving nodes in units per second.
+
+	void readEnvironment()
+	{
+		readVariable("ANKI_SCENE_BENCHMARK_VOLUME_COUNT", m_volumeNodeCount);
+		readVariable("ANKI_SCENE_BENCHMARK_LIGHT_COUNT", m_lightNodeCount);
+		readVariable("ANKI_SCENE_BENCHMARK_PROBE_COUNT", m_probeNodeCount);
+		readVariable("ANKI_SCENE_BENCHMARK_FRAME_COUNT", m_frameCount);
+		readVariable("ANKI_SCENE_BENCHMARK_WORLD_SIZE", m_worldSize);
+		readVariable("ANKI_SCENE_BENCHMARK_MOVING_FRACTION", m_movingNodeFraction);
+		readVariable("ANKI_SCENE_BENCHMARK_SPEED", m_speed);
+
+		m_frameCount = max(m_frameCount, 2u);
+	}
+
+private:
+	template<typename T>
+	static void readVariable(const Char* name, T& value)
+	{
+		const Char* str = getenv(name);
+		if(str && CString(str).toNumber(value))
+		{
+			ANKI_TEST_LOGW("Ignoring %s because it's not a number: %s", name, str);
+		}
+	}
+};
+
+/// The time of a tracer event over all frames.
+class PhaseTiming
+{
+public:
+	CString m_name;
+	Second m_duration = 0.0;
+	U32 m_count = 0;
+};
+
+class MovingNode
+{
+public:
+	MoveComponent* m_move;
+	Vec3 m_velocity;
+};
+
+} // end namespace
+
+#if ANKI_ENABLE_TRACE
+static void accumulateTracerEvents(void* userData, [[maybe_unused]] ThreadId tid, ConstWeakArray<TracerEvent> events,
+								   [[maybe_unused]] ConstWeakArray<TracerCounter> counters)
+{
+	DynamicArrayRaii<PhaseTiming>& timings = *static_cast<DynamicArrayRaii<PhaseTiming>*>(userData);
+	for(const TracerEvent& event : events)
+	{
+		PhaseTiming* timing = nullptr;
+		for(PhaseTiming& t : timings)
+		{
+			if(t.m_name == event.m_name)
+			{
+				timing = &t;
+				break;
+			}
+		}
+
+		if(!timing)
+		{
+			timing = timings.emplaceBack();
+			timing->m_name = event.m_name;
+		}
+
+		timing->m_duration += event.m_duration;
+		++timing->m_count;
+	}
+}
+#endif
+
+/// Measures the CPU cost of SceneGraph::update() and the visibility tests. It needs no window and no GPU. Like all the
+/// benchmarks it's skipped unless it's run by name.
+ANKI_TEST_OPT_IN(Scene, SceneUpdateBenchmark)
+{
+	SceneBenchmarkConfig bench;
+	bench.readEnvironment();
+	HeapMemoryPool pool(allocAligned, nullptr);
+
+#if ANKI_ENABLE_TRACE
+	TracerSingleton::init(&pool);
+	TracerSingleton::get().setEnabled(true);
+#endif
+
+	HeadlessSceneGraph* headless = new HeadlessSceneGraph();
+	ANKI_TEST_EXPECT_NO_ERR(headless->init());
+	SceneGraph& scene = headless->m_scene;
+
+	// Populate
+	DynamicArrayRaii<MovingNode> movingNodes(&pool);
+	const F32 halfSize = bench.m_worldSize / 2.0f;
+	auto placeNode = [&](SceneNode& node) {
+		MoveComponent& move = node.getFirstComponentOfType<MoveComponent>();
+		move.setLocalOrigin(Vec4(getRandomRange(-halfSize, halfSize), getRandomRange(-halfSize, halfSize),
+								 getRandomRange(-halfSize, halfSize), 0.0f));
+
+		if(getRandomRange(0.0f, 1.0f) < bench.m_movingNodeFraction)
+		{
+			MovingNode& moving = *movingNodes.emplaceBack();
+			moving.m_move = &move;
+			moving.m_velocity =
+				Vec3(getRandomRange(-1.0f, 1.0f), getRandomRange(-1.0f, 1.0f), getRandomRange(-1.0f, 1.0f))
+					.getNormalized()
+				* bench.m_speed;
+		}
+	};
+
+	for(U32 i = 0; i < bench.m_volumeNodeCount; ++i)
+	{
+		FogDensityNode* node;
+		ANKI_TEST_EXPECT_NO_ERR(scene.newSceneNode(CString(), node));
+		FogDensityComponent& fogc = node->getFirstComponentOfType<FogDensityComponent>();
+		if(i & 1)
+		{
+			fogc.setSphereVolumeRadius(getRandomRange(0.5f, 4.0f));
+		}
+		else
+		{
+			fogc.setBoxVolumeSize(Vec3(getRandomRange(1.0f, 8.0f)));
+		}
+		placeNode(*node);
+	}
+
+	for(U32 i = 0; i < bench.m_lightNodeCount; ++i)
+	{
+		PointLightNode* node;
+		ANKI_TEST_EXPECT_NO_ERR(scene.newSceneNode(CString(), node));
+		node->getFirstComponentOfType<LightComponent>().setRadius(getRandomRange(2.0f, 20.0f));
+		placeNode(*node);
+	}
+
+	for(U32 i = 0; i < bench.m_probeNodeCount; ++i)
+	{
+		ReflectionProbeNode* node;
+		ANKI_TEST_EXPECT_NO_ERR(scene.newSceneNode(CString(), node));
+		node->getFirstComponentOfType<ReflectionProbeComponent>().setBoxVolumeSize(Vec3(getRandomRange(5.0f, 30.0f)));
+		placeNode(*node);
+	}
+
+	// The camera looks at the center of the world from one side
+	headless->getCamera().getFirstComponentOfType<MoveComponent>().setLocalOrigin(Vec4(0.0f, 0.0f, halfSize, 0.0f));
+
+	// Run the frames
+	DynamicArrayRaii<PhaseTiming> tracerTimings(&pool);
+	Second updateTime = 0.0;
+	Second visibilityTime = 0.0;
+	Second physicsTime = 0.0;
+	constexpr Second kDt = 1.0 / 60.0;
+	for(U32 frame = 0; frame < bench.m_frameCount; ++frame)
+	{
+		for(MovingNode& moving : movingNodes)
+		{
+			Vec3 pos = moving.m_move->getLocalTransform().getOrigin().xyz() + moving.m_velocity * F32(kDt);
+			for(U32 i = 0; i < 3; ++i)
+			{
+				if(absolute(pos[i]) > halfSize)
+				{
+					// Bounce off the walls of the world
+					pos[i] = clamp(pos[i], -halfSize, halfSize);
+					moving.m_velocity[i] = -moving.m_velocity[i];
+				}
+			}
+			moving.m_move->setLocalOrigin(pos.xyz0());
+		}
+
+		ANKI_TEST_EXPECT_NO_ERR(headless->update());
+
+		RenderQueue rqueue;
+		scene.doVisibilityTests(rqueue);
+
+		// The first frame does the initial placement of everything so don't count it
+		if(frame > 0)
+		{
+			updateTime += scene.getStats().m_updateTime;
+			visibilityTime += scene.getStats().m_visibilityTestsTime;
+			physicsTime += scene.getStats().m_physicsUpdate;
+		}
+
+#if ANKI_ENABLE_TRACE
+		if(frame > 0)
+		{
+			TracerSingleton::get().flush(accumulateTracerEvents, &tracerTimings);
+		}
+		else
+		{
+			TracerSingleton::get().flush([](void*, ThreadId, ConstWeakArray<TracerEvent>,
+											ConstWeakArray<TracerCounter>) {},
+										 nullptr);
+		}
+#endif
+	}
+
+	// Report
+	const F64 measuredFrames = F64(bench.m_frameCount - 1);
+	ANKI_TEST_LOGI("Scene benchmark: %u volumes, %u lights, %u probes, %u moving nodes, %u frames",
+				   bench.m_volumeNodeCount, bench.m_lightNodeCount, bench.m_probeNodeCount, movingNodes.getSize(),
+				   bench.m_frameCount);
+	ANKI_TEST_LOGI("\tUpdate %f ms/frame (physics %f ms/frame)", updateTime / measuredFrames * 1000.0,
+				   physicsTime / measuredFrames * 1000.0);
+	ANKI_TEST_LOGI("\tVisibility tests %f ms/frame", visibilityTime / measuredFrames * 1000.0);
+	for(const PhaseTiming& timing : tracerTimings)
+	{
+		ANKI_TEST_LOGI("\t%s %f ms/frame (%u events)", timing.m_name.cstr(),
+					   timing.m_duration / measuredFrames * 1000.0, timing.m_count);
+	}
+
+	// Cleanup
+	delete headless;
+#if ANKI_ENABLE_TRACE
+	TracerSingleton::destroy();
+#endif
+}
@@ -0,0 +1,188 @@
+// Copyright (C) 2009-2022, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <Tests/Scene/HeadlessSceneGraph.h>
+#include <AnKi/Scene/SceneBinaryLoader.h>
+#include <AnKi/Importer/SceneConverter.h>
+#include <AnKi/Util/Filesystem.h>
+#include <AnKi/Util/File.h>
+#include <AnKi/Util/Serializer.h>
+
+using namespace anki;
+
+/// The nodes are created out of the order of their types so the converter has to sort them.
+static constexpr const char* kScript = R"(
+local scene = getSceneGraph()
+
+local function setTransform(node, x, y, z, rotation, scale)
+	local trf = Transform.new()
+	trf:setOrigin(Vec4.new(x, y, z, 0))
+	local rot = Mat3x4.new()
+	rot:setAll(table.unpack(rotation))
+	trf:setRotation(rot)
+	trf:setScale(scale)
+	node:getSceneNodeBase():getMoveComponent():setLocalTransform(trf)
+end
+
+local identity = {1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0}
+local rotY90 = {0, 0, 1, 0, 0, 1, 0, 0, -1, 0, 0, 0}
+
+local camera = scene:newPerspectiveCameraNode("camera")
+setTransform(camera, 0, 1, 10, identity, 1)
+scene:setActiveCameraNode(camera:getSceneNodeBase())
+
+local spot = scene:newSpotLightNode("spot")
+setTransform(spot, 0, 0, 1, identity, 1)
+
+local light = scene:newPointLightNode("light")
+light:getSceneNodeBase():getLightComponent():setRadius(5)
+setTransform(light, 1, 2, 3, rotY90, 2)
+light:getSceneNodeBase():addChild(spot:getSceneNodeBase())
+
+local probe = scene:newReflectionProbeNode("probe")
+probe:getSceneNodeBase():getReflectionProbeComponent():setBoxVolumeSize(Vec3.new(4, 5, 6))
+setTransform(probe, 0, 0, -10, identity, 1)
+probe:getSceneNodeBase():addChild(light:getSceneNodeBase())
+)";
+
+static Bool transformsEqual(const Transform& a, const Transform& b)
+{
+	const F32 epsilon = 0.0001f;
+	Bool equal = (a.getOrigin() - b.getOrigin()).getLength() < epsilon;
+	equal = equal && absolute(a.getScale() - b.getScale()) < epsilon;
+	for(U32 i = 0; i < 12; ++i)
+	{
+		equal = equal && absolute(a.getRotation()[i] - b.getRotation()[i]) < epsilon;
+	}
+
+	return equal;
+}
+
+ANKI_TEST(Scene, SceneBinary)
+{
+	HeadlessSceneGraph headless;
+	ANKI_TEST_EXPECT_NO_ERR(headless.init());
+	SceneGraph& scene = headless.m_scene;
+	HeapMemoryPool pool(allocAligned, nullptr);
+
+	StringRaii dir(&pool);
+	ANKI_TEST_EXPECT_NO_ERR(getTempDirectory(dir));
+	dir.append("/SceneBinaryTest");
+	if(directoryExists(dir))
+	{
+		ANKI_TEST_EXPECT_NO_ERR(removeDirectory(dir, pool));
+	}
+	ANKI_TEST_EXPECT_NO_ERR(createDirectory(dir));
+
+	// Convert the script
+	{
+		StringRaii scriptFilename(&pool);
+		scriptFilename.sprintf("%s/scene.lua", dir.cstr());
+		File file;
+		ANKI_TEST_EXPECT_NO_ERR(file.open(scriptFilename, FileOpenFlag::kWrite));
+		ANKI_TEST_EXPECT_NO_ERR(file.writeText(kScript));
+		file.close();
+
+		StringRaii binaryFilename(&pool);
+		binaryFilename.sprintf("%s/scene.ankiscene", dir.cstr());
+		SceneConverterConfig config;
+		config.m_inputFilename = scriptFilename;
+		config.m_outFilename = binaryFilename;
+		ANKI_TEST_EXPECT_NO_ERR(convertScene(config));
+	}
+
+	{
+		// The 2nd and the 3rd node are each other's parent
+		Array<SceneBinaryNode, 3> nodes;
+		for(U32 i = 0; i < nodes.getSize(); ++i)
+		{
+			nodes[i].m_type = SceneBinaryNodeType::kPointLight;
+			nodes[i].m_name = kMaxU32;
+			nodes[i].m_localTransform = kMaxU32;
+			nodes[i].m_firstProperty = 0;
+			nodes[i].m_propertyCount = 0;
+		}
+		nodes[0].m_parent = kMaxU32;
+		nodes[1].m_parent = 2;
+		nodes[2].m_parent = 1;
+
+		SceneBinary binary;
+		memcpy(&binary.m_magic[0], kSceneBinaryMagic, sizeof(binary.m_magic));
+		binary.m_nodes = WeakArray<SceneBinaryNode>(nodes);
+		binary.m_activeCameraNode = kMaxU32;
+
+		StringRaii binaryFilename(&pool);
+		binaryFilename.sprintf("%s/cycle.ankiscene", dir.cstr());
+		File file;
+		ANKI_TEST_EXPECT_NO_ERR(file.open(binaryFilename, FileOpenFlag::kWrite | FileOpenFlag::kBinary));
+		BinarySerializer serializer;
+		ANKI_TEST_EXPECT_NO_ERR(serializer.serialize(binary, pool, file));
+	}
+
+	ANKI_TEST_EXPECT_NO_ERR(headless.m_fs.addNewPath(dir, StringListRaii(&pool)));
+
+	// Load the converted one
+	{
+		ResourceFilePtr file;
+		ANKI_TEST_EXPECT_NO_ERR(headless.m_fs.openFile("scene.ankiscene", file));
+		SceneBinaryLoader loader(&scene);
+		ANKI_TEST_EXPECT_NO_ERR(loader.load(*file));
+
+		// Sorted by type
+		ConstWeakArray<SceneNode*> nodes = loader.getNodes();
+		ANKI_TEST_EXPECT_EQ(nodes.getSize(), 4);
+		ANKI_TEST_EXPECT_NEQ(dynamic_cast<PointLightNode*>(nodes[0]), nullptr);
+		ANKI_TEST_EXPECT_NEQ(dynamic_cast<SpotLightNode*>(nodes[1]), nullptr);
+		ANKI_TEST_EXPECT_NEQ(dynamic_cast<ReflectionProbeNode*>(nodes[2]), nullptr);
+		ANKI_TEST_EXPECT_NEQ(dynamic_cast<PerspectiveCameraNode*>(nodes[3]), nullptr);
+		ANKI_TEST_EXPECT_EQ(nodes[0]->getName(), "light");
+		ANKI_TEST_EXPECT_EQ(nodes[1]->getName(), "spot");
+		ANKI_TEST_EXPECT_EQ(nodes[2]->getName(), "probe");
+		ANKI_TEST_EXPECT_EQ(nodes[3]->getName(), "camera");
+
+		SceneNode& light = *nodes[0];
+		SceneNode& spot = *nodes[1];
+		SceneNode& probe = *nodes[2];
+		SceneNode& camera = *nodes[3];
+
+		ANKI_TEST_EXPECT_EQ(light.getParent(), &probe);
+		ANKI_TEST_EXPECT_EQ(spot.getParent(), &light);
+		ANKI_TEST_EXPECT_EQ(probe.getParent(), nullptr);
+		ANKI_TEST_EXPECT_EQ(camera.getParent(), nullptr);
+		ANKI_TEST_EXPECT_EQ(&scene.getActiveCameraNode(), &camera);
+
+		ANKI_TEST_EXPECT_EQ(light.getFirstComponentOfType<LightComponent>().getRadius(), 5.0f);
+		ANKI_TEST_EXPECT_EQ(probe.getFirstComponentOfType<ReflectionProbeComponent>().getBoxVolumeSize(),
+							Vec3(4.0f, 5.0f, 6.0f));
+
+		const Transform lightTrf(Vec4(1.0f, 2.0f, 3.0f, 0.0f),
+								 Mat3x4(0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, -1.0f, 0.0f, 0.0f, 0.0f), 2.0f);
+		const Transform spotTrf(Vec4(0.0f, 0.0f, 1.0f, 0.0f), Mat3x4::getIdentity(), 1.0f);
+		const Transform probeTrf(Vec4(0.0f, 0.0f, -10.0f, 0.0f), Mat3x4::getIdentity(), 1.0f);
+		const MoveComponent& lightMove = light.getFirstComponentOfType<MoveComponent>();
+		const MoveComponent& spotMove = spot.getFirstComponentOfType<MoveComponent>();
+		const MoveComponent& probeMove = probe.getFirstComponentOfType<MoveComponent>();
+		ANKI_TEST_EXPECT_EQ(transformsEqual(lightMove.getLocalTransform(), lightTrf), true);
+		ANKI_TEST_EXPECT_EQ(transformsEqual(spotMove.getLocalTransform(), spotTrf), true);
+		ANKI_TEST_EXPECT_EQ(transformsEqual(probeMove.getLocalTransform(), probeTrf), true);
+
+		// The hierarchy is in place
+		ANKI_TEST_EXPECT_NO_ERR(headless.update());
+		const Transform spotWorldTrf = probeTrf.combineTransformations(lightTrf).combineTransformations(spotTrf);
+		ANKI_TEST_EXPECT_EQ(transformsEqual(spotMove.getWorldTransform(), spotWorldTrf), true);
+	}
+
+	// A cycle of parents is rejected before any node is created
+	{
+		const U32 nodeCount = scene.getSceneNodesCount();
+		ResourceFilePtr file;
+		ANKI_TEST_EXPECT_NO_ERR(headless.m_fs.openFile("cycle.ankiscene", file));
+		SceneBinaryLoader loader(&scene);
+		ANKI_TEST_EXPECT_EQ(!!loader.load(*file), true);
+		ANKI_TEST_EXPECT_EQ(scene.getSceneNodesCount(), nodeCount);
+	}
+
+	ANKI_TEST_EXPECT_NO_ERR(removeDirectory(dir, pool));
+}
@@ -0,0 +1,114 @@
+// Copyright (C) 2009-2022, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <Tests/Framework/Framework.h>
+#include <AnKi/Scene/SceneComponentStorage.h>
+
+using namespace anki;
+
+namespace {
+
+class StorageTestComponent : public SceneComponent
+{
+	ANKI_SCENE_COMPONENT(StorageTestComponent)
+
+public:
+	U32 m_value = 0;
+
+	StorageTestComponent(SceneNode* node)
+		: SceneComponent(node, getStaticClassId())
+	{
+	}
+};
+
+} // end anonymous namespace
+
+ANKI_SCENE_COMPONENT_STATICS(StorageTestComponent)
+
+ANKI_TEST(Scene, SceneComponentStorage)
+{
+	HeapMemoryPool pool(allocAligned, nullptr);
+	const U8 classId = StorageTestComponent::getStaticClassId();
+	SceneNode* fakeNode = numberToPtr<SceneNode*>(0x1000); // Never dereferenced
+
+	for(U32 chunkAllocation = 0; chunkAllocation < 2; ++chunkAllocation)
+	{
+		SceneComponentStorage storage;
+		storage.init(&pool, chunkAllocation);
+
+		constexpr U32 kCount = 1000;
+		DynamicArrayRaii<StorageTestComponent*> comps(&pool);
+		for(U32 i = 0; i < kCount; ++i)
+		{
+			StorageTestComponent* comp = storage.newComponent<StorageTestComponent>(fakeNode);
+			comp->m_value = i;
+			comps.emplaceBack(comp);
+		}
+		ANKI_TEST_EXPECT_EQ(storage.getComponentCount(classId), kCount);
+
+		if(chunkAllocation)
+		{
+			// The 1st component is at the start of a chunk
+			ANKI_TEST_EXPECT_EQ(ptrToNumber(comps[0]) % ANKI_CACHE_LINE_SIZE, 0);
+		}
+
+		// Delete every 3rd component
+		U64 expectedSum = 0;
+		for(U32 i = 0; i < kCount; ++i)
+		{
+			if(i % 3 == 0)
+			{
+				storage.deleteComponent(comps[i]);
+			}
+			else
+			{
+				expectedSum += i;
+			}
+		}
+
+		U32 count = 0;
+		U64 sum = 0;
+		storage.forEachComponent<StorageTestComponent>([&](StorageTestComponent& comp, SceneNode& node) {
+			ANKI_TEST_EXPECT_EQ(&node, fakeNode);
+			ANKI_TEST_EXPECT_NEQ(comp.m_value % 3, 0);
+			++count;
+			sum += comp.m_value;
+		});
+		ANKI_TEST_EXPECT_EQ(count, storage.getComponentCount(classId));
+		ANKI_TEST_EXPECT_EQ(sum, expectedSum);
+
+		// Re-create some. With chunk allocation they should reuse the free slots
+		for(U32 i = 0; i < kCount; i += 3)
+		{
+			comps[i] = storage.newComponent<StorageTestComponent>(fakeNode);
+			comps[i]->m_value = i;
+		}
+		ANKI_TEST_EXPECT_EQ(storage.getComponentCount(classId), kCount);
+
+		for(StorageTestComponent* comp : comps)
+		{
+			storage.deleteComponent(comp);
+		}
+		ANKI_TEST_EXPECT_EQ(storage.getComponentCount(classId), 0);
+
+		// Create in bulk. The dense array shouldn't grow after reserve
+		constexpr U32 kBulkCount = SceneComponentStorage::kComponentsPerChunk * 2 + 1;
+		storage.reserve(classId, kBulkCount);
+		comps.resize(kBulkCount);
+		comps[0] = storage.newComponent<StorageTestComponent>(fakeNode);
+		const SceneComponent* const* denseArray = storage.getComponents(classId).getBegin();
+		for(U32 i = 1; i < kBulkCount; ++i)
+		{
+			comps[i] = storage.newComponent<StorageTestComponent>(fakeNode);
+		}
+		ANKI_TEST_EXPECT_EQ(storage.getComponents(classId).getBegin(), denseArray);
+		ANKI_TEST_EXPECT_EQ(storage.getComponentCount(classId), kBulkCount);
+
+		for(StorageTestComponent* comp : comps)
+		{
+			storage.deleteComponent(comp);
+		}
+	}
+}
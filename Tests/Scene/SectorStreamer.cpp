@@ -0,0 +1,172 @@
+// Copyright (C) 2009-2022, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <Tests/Scene/HeadlessSceneGraph.h>
+#include <AnKi/Util/Filesystem.h>
+#include <AnKi/Util/File.h>
+#include <AnKi/Util/HighRezTimer.h>
+
+using namespace anki;
+
+ANKI_TEST(Scene, SectorStreamer)
+{
+	HeadlessSceneGraph headless;
+	ANKI_TEST_EXPECT_NO_ERR(headless.init());
+	SceneGraph& scene = headless.m_scene;
+	SectorStreamer& streamer = scene.getSectorStreamer();
+	HeapMemoryPool pool(allocAligned, nullptr);
+
+	// 3 sectors along +X, 10 units wide and 10 units apart. Every script creates 2 nodes that don't load resources
+	StringRaii dir(&pool);
+	ANKI_TEST_EXPECT_NO_ERR(getTempDirectory(dir));
+	dir.append("/SectorStreamerTest");
+	if(directoryExists(dir))
+	{
+		ANKI_TEST_EXPECT_NO_ERR(removeDirectory(dir, pool));
+	}
+	ANKI_TEST_EXPECT_NO_ERR(createDirectory(dir));
+
+	constexpr U32 kSectorCount = 3;
+	for(U32 i = 0; i < kSectorCount; ++i)
+	{
+		StringRaii filename(&pool);
+		filename.sprintf("%s/sector%u.lua", dir.cstr(), i);
+		File file;
+		ANKI_TEST_EXPECT_NO_ERR(file.open(filename, FileOpenFlag::kWrite));
+		ANKI_TEST_EXPECT_NO_ERR(file.writeTextf("local scene = getSceneGraph()\n"
+												"scene:newModelNode(\"s%ua\")\n"
+												"scene:newModelNode(\"s%ub\")\n",
+												i, i));
+	}
+
+	ANKI_TEST_EXPECT_NO_ERR(headless.m_fs.addNewPath(dir, StringListRaii(&pool)));
+
+	for(U32 i = 0; i < kSectorCount; ++i)
+	{
+		StringRaii filename(&pool);
+		filename.sprintf("sector%u.lua", i);
+		const F32 minX = F32(i) * 20.0f;
+		streamer.addSector(filename, Aabb(Vec3(minX, -5.0f, -5.0f), Vec3(minX + 10.0f, 5.0f, 5.0f)), 1_MB);
+	}
+
+	streamer.setLoadDistance(10.0f);
+	streamer.setUnloadDistance(20.0f);
+	streamer.setMaxCommitsPerUpdate(1);
+
+	auto waitForState = [&](U32 sector, SectorState state) {
+		for(U32 i = 0; i < 10000 && streamer.getSectorState(sector) != state; ++i)
+		{
+			HighRezTimer::sleep(1.0_ms);
+		}
+
+		return streamer.getSectorState(sector) == state;
+	};
+
+	auto nodesExist = [&](U32 sector) {
+		StringRaii nameA(&pool);
+		nameA.sprintf("s%ua", sector);
+		StringRaii nameB(&pool);
+		nameB.sprintf("s%ub", sector);
+		const SceneNode* a = scene.tryFindSceneNode(nameA);
+		const SceneNode* b = scene.tryFindSceneNode(nameB);
+		ANKI_TEST_EXPECT_EQ(a == nullptr, b == nullptr);
+		return a != nullptr;
+	};
+
+	// Load the 1st sector while the loader is paused. It stays in the loader until it's resumed
+	headless.m_loader.pause();
+	streamer.update(Vec3(5.0f, 0.0f, 0.0f));
+	ANKI_TEST_EXPECT_EQ(streamer.getSectorState(0), SectorState::kLoading);
+	ANKI_TEST_EXPECT_EQ(streamer.getSectorState(1), SectorState::kUnloaded);
+	ANKI_TEST_EXPECT_EQ(streamer.getSectorState(2), SectorState::kUnloaded);
+	ANKI_TEST_EXPECT_EQ(streamer.getResidentMemory(), 1_MB);
+	ANKI_TEST_EXPECT_EQ(streamer.getCommittedSectorCount(), 0);
+
+	// The nodes are created by the next update, not by the loader
+	headless.m_loader.resume();
+	ANKI_TEST_EXPECT_EQ(waitForState(0, SectorState::kStaged), true);
+	ANKI_TEST_EXPECT_EQ(nodesExist(0), false);
+	streamer.update(Vec3(5.0f, 0.0f, 0.0f));
+	ANKI_TEST_EXPECT_EQ(streamer.getSectorState(0), SectorState::kCommitted);
+	ANKI_TEST_EXPECT_EQ(streamer.getCommittedSectorCount(), 1);
+	ANKI_TEST_EXPECT_EQ(nodesExist(0), true);
+
+	// A node that is created between the sectors doesn't belong to any of them
+	ModelNode* outsider;
+	ANKI_TEST_EXPECT_NO_ERR(scene.newSceneNode("outsider", outsider));
+
+	// Between the 2 distances the loaded sector stays
+	streamer.update(Vec3(-12.0f, 0.0f, 0.0f));
+	ANKI_TEST_EXPECT_EQ(streamer.getSectorState(0), SectorState::kCommitted);
+	streamer.update(Vec3(-18.0f, 0.0f, 0.0f));
+	ANKI_TEST_EXPECT_EQ(streamer.getSectorState(0), SectorState::kCommitted);
+	ANKI_TEST_EXPECT_EQ(streamer.getSectorState(1), SectorState::kUnloaded);
+	ANKI_TEST_EXPECT_EQ(streamer.getSectorState(2), SectorState::kUnloaded);
+
+	// Load the 2nd sector as well. Pause the loader so it doesn't finish before the update commits the staged sectors
+	headless.m_loader.pause();
+	streamer.update(Vec3(15.0f, 0.0f, 0.0f));
+	ANKI_TEST_EXPECT_EQ(streamer.getSectorState(1), SectorState::kLoading);
+	headless.m_loader.resume();
+	ANKI_TEST_EXPECT_EQ(waitForState(1, SectorState::kStaged), true);
+	streamer.update(Vec3(15.0f, 0.0f, 0.0f));
+	ANKI_TEST_EXPECT_EQ(streamer.getSectorState(0), SectorState::kCommitted);
+	ANKI_TEST_EXPECT_EQ(streamer.getSectorState(1), SectorState::kCommitted);
+	ANKI_TEST_EXPECT_EQ(streamer.getCommittedSectorCount(), 2);
+	ANKI_TEST_EXPECT_EQ(streamer.getResidentMemory(), 2_MB);
+	ANKI_TEST_EXPECT_EQ(nodesExist(1), true);
+
+	// Something else deletes a node of the sector. The sector doesn't delete it again when it's unloaded
+	scene.deleteSceneNode(&scene.findSceneNode("s1a"));
+	scene.deleteNodesMarkedForDeletion();
+	ANKI_TEST_EXPECT_EQ(scene.tryFindSceneNode("s1a"), nullptr);
+
+	// The budget fits only one. The far sector is dropped and the near one stays
+	streamer.setMemoryBudget(1_MB + 512_KB);
+	streamer.update(Vec3(12.0f, 0.0f, 0.0f));
+	ANKI_TEST_EXPECT_EQ(streamer.getSectorState(0), SectorState::kCommitted);
+	ANKI_TEST_EXPECT_EQ(streamer.getSectorState(1), SectorState::kUnloaded);
+	ANKI_TEST_EXPECT_EQ(streamer.getCommittedSectorCount(), 1);
+	ANKI_TEST_EXPECT_EQ(streamer.getResidentMemory(), 1_MB);
+
+	// Only the nodes of the unloaded sector are deleted
+	scene.deleteNodesMarkedForDeletion();
+	ANKI_TEST_EXPECT_EQ(nodesExist(0), true);
+	ANKI_TEST_EXPECT_EQ(nodesExist(1), false);
+	ANKI_TEST_EXPECT_NEQ(scene.tryFindSceneNode("outsider"), nullptr);
+
+	// The nearest sector is always loaded even if it doesn't fit
+	streamer.setMemoryBudget(512_KB);
+	streamer.update(Vec3(12.0f, 0.0f, 0.0f));
+	ANKI_TEST_EXPECT_EQ(streamer.getSectorState(0), SectorState::kCommitted);
+	streamer.setMemoryBudget(kMaxPtrSize);
+
+	// Move away. Everything is unloaded
+	streamer.update(Vec3(-25.0f, 0.0f, 0.0f));
+	ANKI_TEST_EXPECT_EQ(streamer.getSectorState(0), SectorState::kUnloaded);
+	ANKI_TEST_EXPECT_EQ(streamer.getCommittedSectorCount(), 0);
+	ANKI_TEST_EXPECT_EQ(streamer.getResidentMemory(), 0);
+	scene.deleteNodesMarkedForDeletion();
+	ANKI_TEST_EXPECT_EQ(nodesExist(0), false);
+	ANKI_TEST_EXPECT_NEQ(scene.tryFindSceneNode("outsider"), nullptr);
+
+	// Come back but stay between the 2 distances. It doesn't load again
+	streamer.update(Vec3(-12.0f, 0.0f, 0.0f));
+	ANKI_TEST_EXPECT_EQ(streamer.getSectorState(0), SectorState::kUnloaded);
+
+	// Leave a sector while it loads. The loader lets go of it
+	headless.m_loader.pause();
+	streamer.update(Vec3(45.0f, 0.0f, 0.0f));
+	ANKI_TEST_EXPECT_EQ(streamer.getSectorState(2), SectorState::kLoading);
+	streamer.update(Vec3(100.0f, 0.0f, 0.0f));
+	ANKI_TEST_EXPECT_EQ(streamer.getResidentMemory(), 1_MB);
+	headless.m_loader.resume();
+	ANKI_TEST_EXPECT_EQ(waitForState(2, SectorState::kUnloaded), true);
+	streamer.update(Vec3(100.0f, 0.0f, 0.0f));
+	ANKI_TEST_EXPECT_EQ(streamer.getResidentMemory(), 0);
+	ANKI_TEST_EXPECT_EQ(nodesExist(2), false);
+
+	ANKI_TEST_EXPECT_NO_ERR(removeDirectory(dir, pool));
+}
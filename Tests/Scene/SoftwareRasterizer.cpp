@@ -0,0 +1,268 @@
+// Copyright (C) 2009-2022, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <Tests/Framework/Framework.h>
+#include <AnKi/Scene/SoftwareRasterizer.h>
+#include <AnKi/Collision/Aabb.h>
+#include <AnKi/Util/System.h>
+#include <AnKi/Util/HighRezTimer.h>
+
+using namespace anki;
+
+namespace {
+
+/// Append the 12 triangles of a box. Counter-clockwise when seen from outside.
+void appendBoxTriangles(const Vec3& boxMin, const Vec3& boxMax, DynamicArrayRaii<Vec3>& verts)
+{
+	constexpr Array<U8, 24> kFaces = {0, 4, 6, 2, 1, 3, 7, 5, 0, 1, 5, 4, 2, 6, 7, 3, 0, 2, 3, 1, 4, 5, 7, 6};
+
+	auto corner = [&](U32 bits) {
+		return Vec3((bits & 1) ? boxMax.x() : boxMin.x(), (bits & 2) ? boxMax.y() : boxMin.y(),
+					(bits & 4) ? boxMax.z() : boxMin.z());
+	};
+
+	for(U32 face = 0; face < 6; ++face)
+	{
+		const U8* quad = &kFaces[face * 4];
+		for(U32 idx : {0, 1, 2, 0, 2, 3})
+		{
+			verts.emplaceBack(corner(quad[idx]));
+		}
+	}
+}
+
+} // end anonymous namespace
+
+ANKI_TEST(Scene, SoftwareRasterizer)
+{
+	HeapMemoryPool pool(allocAligned, nullptr);
+	ThreadHive hive(getCpuCoresCount(), &pool);
+
+	const Mat4 proj = Mat4::calculatePerspectiveProjectionMatrix(toRad(90.0f), toRad(60.0f), 0.1f, 100.0f);
+
+	// Rasterize a quad at z=-10 that faces the camera
+	{
+		SoftwareRasterizer r;
+		r.init(&pool);
+		r.prepare(Mat4::getIdentity(), proj, 256, 128);
+
+		const Array<Vec3, 6> quad = {Vec3(-5.0f, -5.0f, -10.0f), Vec3(5.0f, -5.0f, -10.0f),
+									 Vec3(5.0f, 5.0f, -10.0f),   Vec3(-5.0f, -5.0f, -10.0f),
+									 Vec3(5.0f, 5.0f, -10.0f),   Vec3(-5.0f, 5.0f, -10.0f)};
+		r.draw(&quad[0][0], 6, sizeof(Vec3), true);
+		r.rasterizeBins(hive);
+
+		// Behind the quad
+		ANKI_TEST_EXPECT_EQ(r.visibilityTest(Aabb(Vec3(-1.0f, -1.0f, -20.0f), Vec3(1.0f, 1.0f, -19.0f))), false);
+
+		// In front of the quad
+		ANKI_TEST_EXPECT_EQ(r.visibilityTest(Aabb(Vec3(-1.0f, -1.0f, -5.0f), Vec3(1.0f, 1.0f, -4.0f))), true);
+
+		// Behind the quad but next to it
+		ANKI_TEST_EXPECT_EQ(r.visibilityTest(Aabb(Vec3(-13.0f, -1.0f, -20.0f), Vec3(-11.0f, 1.0f, -19.0f))), true);
+
+		// Behind the quad and partially covered
+		ANKI_TEST_EXPECT_EQ(r.visibilityTest(Aabb(Vec3(8.0f, -1.0f, -20.0f), Vec3(12.0f, 1.0f, -19.0f))), true);
+
+		// Crossing the near plane
+		ANKI_TEST_EXPECT_EQ(r.visibilityTest(Aabb(Vec3(-1.0f, -1.0f, -20.0f), Vec3(1.0f, 1.0f, 1.0f))), true);
+	}
+
+	// The same quad but back facing
+	{
+		SoftwareRasterizer r;
+		r.init(&pool);
+		r.prepare(Mat4::getIdentity(), proj, 256, 128);
+
+		const Array<Vec3, 3> tri = {Vec3(-5.0f, -5.0f, -10.0f), Vec3(5.0f, 5.0f, -10.0f), Vec3(5.0f, -5.0f, -10.0f)};
+		r.draw(&tri[0][0], 3, sizeof(Vec3), true);
+		r.rasterizeBins(hive);
+
+		ANKI_TEST_EXPECT_EQ(r.visibilityTest(Aabb(Vec3(1.0f, -2.0f, -20.0f), Vec3(2.0f, -1.0f, -19.0f))), true);
+	}
+
+	// Fill the depth buffer: The left half is at z=-10 and the right half is empty
+	{
+		constexpr U32 kWidth = 100;
+		constexpr U32 kHeight = 60;
+		const Vec4 clip = proj * Vec4(0.0f, 0.0f, -10.0f, 1.0f);
+		const F32 depth = clip.z() / clip.w();
+
+		DynamicArrayRaii<F32> depths(&pool, kWidth * kHeight);
+		for(U32 y = 0; y < kHeight; ++y)
+		{
+			for(U32 x = 0; x < kWidth; ++x)
+			{
+				depths[y * kWidth + x] = (x < kWidth / 2) ? depth : 1.0f;
+			}
+		}
+
+		SoftwareRasterizer r;
+		r.init(&pool);
+		r.prepare(Mat4::getIdentity(), proj, kWidth, kHeight);
+		r.fillDepthBuffer(depths);
+
+		ANKI_TEST_EXPECT_EQ(r.visibilityTest(Aabb(Vec3(-5.0f, -1.0f, -20.0f), Vec3(-4.0f, 1.0f, -19.0f))), false);
+		ANKI_TEST_EXPECT_EQ(r.visibilityTest(Aabb(Vec3(4.0f, -1.0f, -20.0f), Vec3(5.0f, 1.0f, -19.0f))), true);
+		ANKI_TEST_EXPECT_EQ(r.visibilityTest(Aabb(Vec3(-5.0f, -1.0f, -5.0f), Vec3(-4.0f, 1.0f, -4.0f))), true);
+	}
+
+	// Fill the depth buffer: The edge of the occluder is inside a tile. Both sides of the edge keep their depth
+	{
+		constexpr U32 kWidth = 96;
+		constexpr U32 kHeight = 64;
+		const Vec4 clip = proj * Vec4(0.0f, 0.0f, -10.0f, 1.0f);
+		const F32 depth = clip.z() / clip.w();
+
+		DynamicArrayRaii<F32> depths(&pool, kWidth * kHeight);
+		for(U32 y = 0; y < kHeight; ++y)
+		{
+			for(U32 x = 0; x < kWidth; ++x)
+			{
+				depths[y * kWidth + x] = (x < kWidth / 2 + 4) ? depth : 1.0f;
+			}
+		}
+
+		SoftwareRasterizer r;
+		r.init(&pool);
+		r.prepare(Mat4::getIdentity(), proj, kWidth, kHeight);
+		r.fillDepthBuffer(depths);
+
+		// Behind the near pixels of the tile
+		ANKI_TEST_EXPECT_EQ(r.visibilityTest(Aabb(Vec3(-0.2f, -1.0f, -20.0f), Vec3(0.2f, 1.0f, -19.0f))), false);
+
+		// Behind the far pixels of the same tile
+		ANKI_TEST_EXPECT_EQ(r.visibilityTest(Aabb(Vec3(1.5f, -1.0f, -20.0f), Vec3(1.9f, 1.0f, -19.0f))), true);
+	}
+}
+
+ANKI_TEST(Scene, SoftwareRasterizerBenchmark)
+{
+	HeapMemoryPool pool(allocAligned, nullptr);
+	ThreadHive hive(getCpuCoresCount(), &pool);
+
+	constexpr U32 kOccluderCount = 1000;
+	constexpr U32 kQueryCount = 50000;
+	constexpr U32 kTasksPerThread = 4;
+
+	const Mat4 proj = Mat4::calculatePerspectiveProjectionMatrix(toRad(90.0f), toRad(60.0f), 0.1f, 200.0f);
+
+	// Occluders in the middle of the view
+	DynamicArrayRaii<Vec3> verts(&pool);
+	for(U32 i = 0; i < kOccluderCount; ++i)
+	{
+		const F32 z = getRandomRange(-40.0f, -15.0f);
+		const Vec3 center(getRandomRange(-0.5f, 0.5f) * -z, getRandomRange(-0.4f, 0.4f) * -z, z);
+		const Vec3 halfSize(getRandomRange(0.5f, 2.0f), getRandomRange(0.5f, 2.0f), getRandomRange(0.5f, 2.0f));
+		appendBoxTriangles(center - halfSize, center + halfSize, verts);
+	}
+
+	// Half of the queries are in front of all occluders. The rest are behind but not all of them are covered
+	DynamicArrayRaii<Vec3> queryMins(&pool, kQueryCount);
+	DynamicArrayRaii<Vec3> queryMaxs(&pool, kQueryCount);
+	for(U32 i = 0; i < kQueryCount; ++i)
+	{
+		const Bool front = i % 2 == 0;
+		const F32 z = (front) ? getRandomRange(-8.0f, -2.0f) : getRandomRange(-90.0f, -45.0f);
+		const F32 size = (front) ? getRandomRange(0.05f, 0.3f) : getRandomRange(0.2f, 1.0f);
+		const F32 spread = (front) ? 0.4f : 0.8f;
+		const Vec3 center(getRandomRange(-spread, spread) * -z, getRandomRange(-0.3f, 0.3f) * -z, z);
+		queryMins[i] = center - size;
+		queryMaxs[i] = center + size;
+	}
+
+	DynamicArrayRaii<U8> visible(&pool, kQueryCount);
+
+	class Ctx
+	{
+	public:
+		SoftwareRasterizer* m_r;
+		const DynamicArrayRaii<Vec3>* m_verts;
+		const DynamicArrayRaii<Vec3>* m_queryMins;
+		const DynamicArrayRaii<Vec3>* m_queryMaxs;
+		DynamicArrayRaii<U8>* m_visible;
+		U32 m_taskCount;
+		Atomic<U32> m_drawTaskIdx = {0};
+		Atomic<U32> m_queryTaskIdx = {0};
+	};
+
+	SoftwareRasterizer r;
+	r.init(&pool);
+
+	for(U32 frame = 0; frame < 4; ++frame)
+	{
+		Ctx ctx;
+		ctx.m_r = &r;
+		ctx.m_verts = &verts;
+		ctx.m_queryMins = &queryMins;
+		ctx.m_queryMaxs = &queryMaxs;
+		ctx.m_visible = &visible;
+		ctx.m_taskCount = hive.getThreadCount() * kTasksPerThread;
+
+		// Rasterize
+		const F64 rasterBegin = HighRezTimer::getCurrentTime();
+		r.prepare(Mat4::getIdentity(), proj, 512, 256);
+
+		DynamicArrayRaii<ThreadHiveTask> tasks(&pool, ctx.m_taskCount);
+		for(ThreadHiveTask& task : tasks)
+		{
+			task = ANKI_THREAD_HIVE_TASK(
+				{
+					const U32 taskIdx = self->m_drawTaskIdx.fetchAdd(1);
+					const U32 triCount = self->m_verts->getSize() / 3;
+					const U32 begin = triCount * taskIdx / self->m_taskCount;
+					const U32 end = triCount * (taskIdx + 1) / self->m_taskCount;
+					if(begin < end)
+					{
+						self->m_r->draw(&(*self->m_verts)[begin * 3][0], (end - begin) * 3, sizeof(Vec3), true,
+										threadId);
+					}
+				},
+				&ctx, nullptr, nullptr);
+		}
+		hive.submitTasks(&tasks[0], tasks.getSize());
+		hive.waitAllTasks();
+
+		r.rasterizeBins(hive);
+		const F64 rasterTime = HighRezTimer::getCurrentTime() - rasterBegin;
+
+		// Query
+		const F64 queryBegin = HighRezTimer::getCurrentTime();
+		for(ThreadHiveTask& task : tasks)
+		{
+			task = ANKI_THREAD_HIVE_TASK(
+				{
+					const U32 taskIdx = self->m_queryTaskIdx.fetchAdd(1);
+					const U32 begin = kQueryCount * taskIdx / self->m_taskCount;
+					const U32 end = kQueryCount * (taskIdx + 1) / self->m_taskCount;
+					for(U32 i = begin; i < end; ++i)
+					{
+						(*self->m_visible)[i] =
+							self->m_r->visibilityTest(Aabb((*self->m_queryMins)[i], (*self->m_queryMaxs)[i]));
+					}
+				},
+				&ctx, nullptr, nullptr);
+		}
+		hive.submitTasks(&tasks[0], tasks.getSize());
+		hive.waitAllTasks();
+		const F64 queryTime = HighRezTimer::getCurrentTime() - queryBegin;
+
+		// Everything in front of the occluders should be visible
+		U32 frontVisibleCount = 0;
+		U32 backVisibleCount = 0;
+		for(U32 i = 0; i < kQueryCount; ++i)
+		{
+			frontVisibleCount += (i % 2 == 0) ? visible[i] : 0;
+			backVisibleCount += (i % 2 == 1) ? visible[i] : 0;
+		}
+		ANKI_TEST_EXPECT_EQ(frontVisibleCount, kQueryCount / 2);
+		ANKI_TEST_EXPECT_GT(backVisibleCount, 0);
+		ANKI_TEST_EXPECT_LT(backVisibleCount, kQueryCount / 2);
+
+		ANKI_TEST_LOGI("Rasterization of %u triangles %fms, %u queries %fms (%u of the %u behind the occluders culled)",
+					   verts.getSize() / 3, rasterTime * 1000.0, kQueryCount, queryTime * 1000.0,
+					   kQueryCount / 2 - backVisibleCount, kQueryCount / 2);
+	}
+}
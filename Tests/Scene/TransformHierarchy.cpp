@@ -0,0 +1,115 @@
+// Copyright (C) 2009-2022, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <Tests/Scene/HeadlessSceneGraph.h>
+
+using namespace anki;
+
+namespace {
+
+class MoveNode : public SceneNode
+{
+public:
+	MoveNode(SceneGraph* scene, CString name)
+		: SceneNode(scene, name)
+	{
+		newComponent<MoveComponent>();
+	}
+
+	MoveComponent& getMove()
+	{
+		return getFirstComponentOfType<MoveComponent>();
+	}
+
+	Vec3 getWorldOrigin() const
+	{
+		return getFirstComponentOfType<MoveComponent>().getWorldTransform().getOrigin().xyz();
+	}
+};
+
+} // end anonymous namespace
+
+#define ANKI_TEST_EXPECT_VEC3(v, x_, y_, z_) \
+	do \
+	{ \
+		ANKI_TEST_EXPECT_NEAR((v).x(), x_, kEpsilonf * 10.0f); \
+		ANKI_TEST_EXPECT_NEAR((v).y(), y_, kEpsilonf * 10.0f); \
+		ANKI_TEST_EXPECT_NEAR((v).z(), z_, kEpsilonf * 10.0f); \
+	} while(0)
+
+ANKI_TEST(Scene, TransformHierarchy)
+{
+	HeadlessSceneGraph headless;
+	ANKI_TEST_EXPECT_NO_ERR(headless.init());
+	SceneGraph& scene = headless.m_scene;
+
+	// Create the children before the parents so their components come first in the storage
+	MoveNode* grandchild;
+	ANKI_TEST_EXPECT_NO_ERR(scene.newSceneNode("grandchild", grandchild));
+	MoveNode* child;
+	ANKI_TEST_EXPECT_NO_ERR(scene.newSceneNode("child", child));
+	MoveNode* root;
+	ANKI_TEST_EXPECT_NO_ERR(scene.newSceneNode("root", root));
+	MoveNode* other;
+	ANKI_TEST_EXPECT_NO_ERR(scene.newSceneNode("other", other));
+
+	root->addChild(child);
+	child->addChild(grandchild);
+
+	root->getMove().setLocalOrigin(Vec4(10.0f, 0.0f, 0.0f, 0.0f));
+	child->getMove().setLocalOrigin(Vec4(1.0f, 0.0f, 0.0f, 0.0f));
+	grandchild->getMove().setLocalOrigin(Vec4(0.0f, 1.0f, 0.0f, 0.0f));
+	other->getMove().setLocalOrigin(Vec4(0.0f, 0.0f, 5.0f, 0.0f));
+	other->getMove().setLocalScale(2.0f);
+
+	// Parents are updated before their children no matter the order of the components
+	ANKI_TEST_EXPECT_NO_ERR(headless.update());
+	ANKI_TEST_EXPECT_EQ(scene.m_transformHierarchy.getLevelCount(), 3);
+	ANKI_TEST_EXPECT_VEC3(root->getWorldOrigin(), 10.0f, 0.0f, 0.0f);
+	ANKI_TEST_EXPECT_VEC3(child->getWorldOrigin(), 11.0f, 0.0f, 0.0f);
+	ANKI_TEST_EXPECT_VEC3(grandchild->getWorldOrigin(), 11.0f, 1.0f, 0.0f);
+	ANKI_TEST_EXPECT_VEC3(other->getWorldOrigin(), 0.0f, 0.0f, 5.0f);
+
+	// Move the root only. The whole hierarchy follows and the unrelated node stays clean
+	root->getMove().setLocalOrigin(Vec4(20.0f, 0.0f, 0.0f, 0.0f));
+	ANKI_TEST_EXPECT_NO_ERR(headless.update());
+	ANKI_TEST_EXPECT_VEC3(child->getWorldOrigin(), 21.0f, 0.0f, 0.0f);
+	ANKI_TEST_EXPECT_VEC3(grandchild->getWorldOrigin(), 21.0f, 1.0f, 0.0f);
+	ANKI_TEST_EXPECT_EQ(root->getMove().getTimestamp(), headless.m_globalTimestamp);
+	ANKI_TEST_EXPECT_EQ(child->getMove().getTimestamp(), headless.m_globalTimestamp);
+	ANKI_TEST_EXPECT_EQ(grandchild->getMove().getTimestamp(), headless.m_globalTimestamp);
+	ANKI_TEST_EXPECT_NEQ(other->getMove().getTimestamp(), headless.m_globalTimestamp);
+	ANKI_TEST_EXPECT_VEC3(child->getMove().getPreviousWorldTransform().getOrigin().xyz(), 11.0f, 0.0f, 0.0f);
+
+	// Nothing moves, nothing is updated
+	ANKI_TEST_EXPECT_NO_ERR(headless.update());
+	ANKI_TEST_EXPECT_NEQ(root->getMove().getTimestamp(), headless.m_globalTimestamp);
+	ANKI_TEST_EXPECT_NEQ(child->getMove().getTimestamp(), headless.m_globalTimestamp);
+	ANKI_TEST_EXPECT_NEQ(grandchild->getMove().getTimestamp(), headless.m_globalTimestamp);
+	ANKI_TEST_EXPECT_VEC3(grandchild->getWorldOrigin(), 21.0f, 1.0f, 0.0f);
+
+	// Move the child to the other parent without touching any transform
+	root->removeChild(child);
+	other->addChild(child);
+	ANKI_TEST_EXPECT_NO_ERR(headless.update());
+	ANKI_TEST_EXPECT_EQ(scene.m_transformHierarchy.getLevelCount(), 3);
+	ANKI_TEST_EXPECT_VEC3(child->getWorldOrigin(), 2.0f, 0.0f, 5.0f);
+	ANKI_TEST_EXPECT_VEC3(grandchild->getWorldOrigin(), 2.0f, 2.0f, 5.0f);
+	ANKI_TEST_EXPECT_NEQ(root->getMove().getTimestamp(), headless.m_globalTimestamp);
+
+	// The old parent doesn't affect it anymore
+	root->getMove().setLocalOrigin(Vec4(-20.0f, 0.0f, 0.0f, 0.0f));
+	other->getMove().setLocalOrigin(Vec4(0.0f, 0.0f, -5.0f, 0.0f));
+	ANKI_TEST_EXPECT_NO_ERR(headless.update());
+	ANKI_TEST_EXPECT_VEC3(child->getWorldOrigin(), 2.0f, 0.0f, -5.0f);
+	ANKI_TEST_EXPECT_VEC3(grandchild->getWorldOrigin(), 2.0f, 2.0f, -5.0f);
+
+	// Detach the child. It becomes a root
+	other->removeChild(child);
+	ANKI_TEST_EXPECT_NO_ERR(headless.update());
+	ANKI_TEST_EXPECT_EQ(scene.m_transformHierarchy.getLevelCount(), 2);
+	ANKI_TEST_EXPECT_VEC3(child->getWorldOrigin(), 1.0f, 0.0f, 0.0f);
+	ANKI_TEST_EXPECT_VEC3(grandchild->getWorldOrigin(), 1.0f, 1.0f, 0.0f);
+}
@@ -0,0 +1,50 @@
+// Copyright (C) 2009-2022, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <Tests/Scene/HeadlessSceneGraph.h>
+#include <AnKi/Renderer/RenderQueue.h>
+
+using namespace anki;
+
+ANKI_TEST(Scene, VisibilityManyFrustums)
+{
+	HeadlessSceneGraph headless;
+	ANKI_TEST_EXPECT_NO_ERR(headless.init());
+	SceneGraph& scene = headless.m_scene;
+
+	// Many more shadow frustums than the tests of the octree. They share the walks
+	constexpr U32 kLightCount = 40;
+	for(U32 i = 0; i < kLightCount; ++i)
+	{
+		PointLightNode* light;
+		ANKI_TEST_EXPECT_NO_ERR(scene.newSceneNode(CString(), light));
+		LightComponent& lightc = light->getFirstComponentOfType<LightComponent>();
+		lightc.setRadius(5.0f);
+		lightc.setShadowEnabled(true);
+		light->getFirstComponentOfType<MoveComponent>().setLocalOrigin(
+			Vec4(F32(i % 8) * 4.0f - 14.0f, F32(i / 8) * 4.0f - 8.0f, -30.0f, 0.0f));
+	}
+
+	FogDensityNode* fog;
+	ANKI_TEST_EXPECT_NO_ERR(scene.newSceneNode("fog", fog));
+	fog->getFirstComponentOfType<MoveComponent>().setLocalOrigin(Vec4(0.0f, 0.0f, -20.0f, 0.0f));
+
+	for(U32 frame = 0; frame < 3; ++frame)
+	{
+		ANKI_TEST_EXPECT_NO_ERR(headless.update());
+		RenderQueue rqueue;
+		scene.doVisibilityTests(rqueue);
+
+		ANKI_TEST_EXPECT_EQ(rqueue.m_fogDensityVolumes.getSize(), 1);
+		ANKI_TEST_EXPECT_EQ(rqueue.m_pointLights.getSize(), kLightCount);
+		for(const PointLightQueueElement& el : rqueue.m_pointLights)
+		{
+			for(const RenderQueue* shadowQueue : el.m_shadowRenderQueues)
+			{
+				ANKI_TEST_EXPECT_NEQ(shadowQueue, nullptr);
+			}
+		}
+	}
+}
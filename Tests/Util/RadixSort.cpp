@@ -0,0 +1,126 @@
+// Copyright (C) 2009-2022, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <Tests/Framework/Framework.h>
+#include <AnKi/Util/RadixSort.h>
+#include <AnKi/Util/System.h>
+#include <algorithm>
+
+using namespace anki;
+
+ANKI_TEST(Util, RadixSort)
+{
+	HeapMemoryPool pool(allocAligned, nullptr);
+	ThreadHive hive(getCpuCoresCount(), &pool);
+
+	for(U32 count : {1u, 100u, 50000u})
+	{
+		for(U32 parallel = 0; parallel < 2; ++parallel)
+		{
+			std::vector<U64> keys(count);
+			std::vector<U32> values(count);
+			std::vector<std::pair<U64, U32>> ref(count);
+			for(U32 i = 0; i < count; ++i)
+			{
+				keys[i] = getRandom() & ((1_U64 << 40) - 1);
+				values[i] = i;
+				ref[i] = {keys[i], i};
+			}
+
+			std::stable_sort(ref.begin(), ref.end(), [](const std::pair<U64, U32>& a, const std::pair<U64, U32>& b) {
+				return a.first < b.first;
+			});
+
+			std::vector<U64> tmpKeys(count);
+			std::vector<U32> tmpValues(count);
+			radixSort(WeakArray<U64>(&keys[0], count), WeakArray<U32>(&values[0], count),
+					  WeakArray<U64>(&tmpKeys[0], count), WeakArray<U32>(&tmpValues[0], count),
+					  (parallel) ? &hive : nullptr, 40);
+
+			for(U32 i = 0; i < count; ++i)
+			{
+				ANKI_TEST_EXPECT_EQ(keys[i], ref[i].first);
+				ANKI_TEST_EXPECT_EQ(values[i], ref[i].second);
+			}
+		}
+	}
+}
+
+ANKI_TEST(Util, RadixSortAsync)
+{
+	HeapMemoryPool pool(allocAligned, nullptr);
+	ThreadHive hive(getCpuCoresCount(), &pool);
+
+	class Sort
+	{
+	public:
+		std::vector<U64> m_keys;
+		std::vector<U32> m_values;
+		std::vector<U64> m_tmpKeys;
+		std::vector<U32> m_tmpValues;
+		std::vector<std::pair<U64, U32>> m_ref;
+		Bool m_doneBeforeSignal = false;
+	};
+
+	// Some sorts have keys with constant bytes to test the skipped passes
+	const Array<U32, 4> counts = {1u, 100u, 50000u, 50000u};
+	const Array<U64, 4> masks = {kMaxU64, kMaxU64, kMaxU64, 0xFF00FF};
+	Array<Sort, 4> sorts;
+	for(U32 s = 0; s < sorts.getSize(); ++s)
+	{
+		Sort& sort = sorts[s];
+		const U32 count = counts[s];
+		sort.m_keys.resize(count);
+		sort.m_values.resize(count);
+		sort.m_tmpKeys.resize(count);
+		sort.m_tmpValues.resize(count);
+		for(U32 i = 0; i < count; ++i)
+		{
+			sort.m_keys[i] = getRandom() & masks[s];
+			sort.m_values[i] = i;
+			sort.m_ref.push_back({sort.m_keys[i], i});
+		}
+
+		std::stable_sort(sort.m_ref.begin(), sort.m_ref.end(),
+						 [](const std::pair<U64, U32>& a, const std::pair<U64, U32>& b) {
+							 return a.first < b.first;
+						 });
+	}
+
+	// Start the sorts from a task and check them from tasks that wait on the semaphore
+	ThreadHiveTask task = ANKI_THREAD_HIVE_TASK(
+		{
+			for(Sort& sort : *self)
+			{
+				const U32 count = U32(sort.m_keys.size());
+				ThreadHiveSemaphore* sem = hive.newSemaphore(1);
+				radixSortAsync(WeakArray<U64>(sort.m_keys.data(), count), WeakArray<U32>(sort.m_values.data(), count),
+							   WeakArray<U64>(sort.m_tmpKeys.data(), count),
+							   WeakArray<U32>(sort.m_tmpValues.data(), count), hive, sem);
+
+				ThreadHiveTask checkTask = ANKI_THREAD_HIVE_TASK(
+					{
+						Bool sorted = true;
+						for(U32 i = 0; i < self->m_keys.size(); ++i)
+						{
+							sorted = sorted && self->m_keys[i] == self->m_ref[i].first
+									 && self->m_values[i] == self->m_ref[i].second;
+						}
+						self->m_doneBeforeSignal = sorted;
+					},
+					&sort, sem, nullptr);
+				hive.submitTasks(&checkTask, 1);
+			}
+		},
+		&sorts, nullptr, nullptr);
+
+	hive.submitTasks(&task, 1);
+	hive.waitAllTasks();
+
+	for(const Sort& sort : sorts)
+	{
+		ANKI_TEST_EXPECT_EQ(sort.m_doneBeforeSignal, true);
+	}
+}
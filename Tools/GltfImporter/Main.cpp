@@ -13,6 +13,7 @@ Options:
 -texrpath <string>         : Same as rpath but for textures
 -optimize-meshes <0|1>     : Optimize meshes. Default is 1
 -optimize-animations <0|1> : Optimize animations. Default is 1
+-compress-animations <0|1> : Write compressed animation binaries. Default is 0
 -j <thread_count>          : Number of threads. Defaults to system's max
 -lod-count <1|2|3>         : The number of geometry LODs to generate. Default is 1
 -lod-factor <float>        : The decimate factor for each LOD. Default 0.25
@@ -31,6 +32,7 @@ public:
 	StringRaii m_texRpath = {&m_pool};
 	Bool m_optimizeMeshes = true;
 	Bool m_optimizeAnimations = true;
+	Bool m_compressAnimations = false;
 	Bool m_importTextures = false;
 	U32 m_threadCount = kMaxU32;
 	U32 m_lodCount = 1;
@@ -184,6 +186,21 @@ static Error parseCommandLineArgs(int argc, char** argv, CmdLineArgs& info)
 				return Error::kUserData;
 			}
 		}
+		else if(strcmp(argv[i], "-compress-animations") == 0)
+		{
+			++i;
+
+			if(i < argc)
+			{
+				I compress = 0;
+				ANKI_CHECK(CString(argv[i]).toNumber(compress));
+				info.m_compressAnimations = compress != 0;
+			}
+			else
+			{
+				return Error::kUserData;
+			}
+		}
 		else if(strcmp(argv[i], "-import-textures") == 0)
 		{
 			++i;
@@ -254,6 +271,7 @@ int myMain(int argc, char** argv)
 	initInfo.m_texrpath = cmdArgs.m_texRpath;
 	initInfo.m_optimizeMeshes = cmdArgs.m_optimizeMeshes;
 	initInfo.m_optimizeAnimations = cmdArgs.m_optimizeAnimations;
+	initInfo.m_compressAnimations = cmdArgs.m_compressAnimations;
 	initInfo.m_lodFactor = cmdArgs.m_lodFactor;
 	initInfo.m_lodCount = cmdArgs.m_lodCount;
 	initInfo.m_lightIntensityScale = cmdArgs.m_lightIntensityScale;
@@ -0,0 +1,32 @@
+// Copyright (C) 2009-2022, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <AnKi/Importer/SceneConverter.h>
+
+using namespace anki;
+
+static constexpr const char* kUsage = R"(Convert a level script to a scene binary
+Usage: %s input_script output_binary
+)";
+
+int main(int argc, char** argv)
+{
+	if(argc != 3)
+	{
+		ANKI_LOGE(kUsage, argv[0]);
+		return 1;
+	}
+
+	SceneConverterConfig config;
+	config.m_inputFilename = argv[1];
+	config.m_outFilename = argv[2];
+	if(convertScene(config))
+	{
+		ANKI_LOGE("Failed");
+		return 1;
+	}
+
+	return 0;
+}